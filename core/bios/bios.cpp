@@ -5,15 +5,13 @@
 /**
  * @brief Construct a new BIOS:: BIOS object
  * 
+ * @param arena Arena of the machine, which must have arena_size() bytes left
  * @param path Path to the BIOS file
  * 
  * @throw std::runtime_error If the BIOS size is invalid
  */
-BIOS::BIOS(std::string path)
+BIOS::BIOS(Arena& arena, std::string path) : data(arena, BIOS_SIZE)
 {
-    //Make data a vector of size 512KB
-    data.resize(512 * 1024);
-
     //Open the file
     std::ifstream file(path, std::ios::binary);
 
@@ -27,10 +25,35 @@ BIOS::BIOS(std::string path)
 
     //Read the file
     file.seekg(0, std::ios::beg);
-    file.read((char *)data.data(), fileSize);
+    file.read((char *)data.get_data(), fileSize);
     file.close();
 }
 
+/**
+ * @brief Construct a new BIOS:: BIOS object forked from another BIOS
+ * 
+ * The image is read-only, so it stays shared with the parent.
+ * 
+ * @param arena Arena of the new machine, which must have arena_size() bytes left
+ * @param parent BIOS to fork
+ */
+BIOS::BIOS(Arena& arena, BIOS& parent) : data(arena, BIOS_SIZE)
+{
+    data.fork_from(parent.data);
+}
+
+/**
+ * @brief Returns the space the image of a BIOS takes in an arena.
+ * 
+ * The BIOS object itself is not included.
+ * 
+ * @return size_t Size in bytes
+ */
+size_t BIOS::arena_size()
+{
+    return CowMemory::arena_size(BIOS_SIZE);
+}
+
 /**
  * @brief Reads a 32-bit word from the BIOS.
  * 
@@ -40,7 +63,7 @@ BIOS::BIOS(std::string path)
 uint32_t BIOS::read32_cpu(uint32_t offset)
 {
     //since the system is little endian, we can do this
-    return *(uint32_t *)&data[offset];
+    return *(const uint32_t *)data.read_ptr(offset);
 
     //TODO: add compatibility for big endian systems
 }
@@ -53,5 +76,5 @@ uint32_t BIOS::read32_cpu(uint32_t offset)
  */
 uint8_t BIOS::read8_cpu(uint32_t offset)
 {
-    return data[offset];
+    return *data.read_ptr(offset);
 }
\ No newline at end of file
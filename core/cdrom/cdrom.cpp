@@ -0,0 +1,628 @@
+#include <algorithm>
+#include <cstring>
+
+#include "core/cdrom/cdrom.hpp"
+#include "core/interconnect/bus.hpp"
+#include "core/logging/logging.hpp"
+
+/**
+ * @brief Construct a new CDROM:: CDROM object
+ * 
+ * The drive starts without a disc.
+ */
+CDROM::CDROM()
+{
+    bus = nullptr;
+    index = 0;
+    int_enable = 0;
+    int_flag = 0;
+    data_index = 0;
+    command = 0;
+    busy = false;
+    second_command = 0;
+    mode = 0;
+    state = DRIVE_IDLE;
+    seek_target = 0;
+    seek_pending = false;
+    position = 0;
+    memset(sector, 0, CD_SECTOR_SIZE);
+    motor_on = false;
+    deterministic = false;
+}
+
+/**
+ * @brief Construct a new CDROM:: CDROM object forked from another CDROM
+ * 
+ * Copies the registers, FIFOs and drive state. The disc is read through a new reader over the image of the parent, so that the two drives keep their own read-ahead windows. The new CDROM has no Bus.
+ * 
+ * @param parent CDROM to fork
+ * 
+ * \b References:
+ * @ref DiscReader::DiscReader
+ */
+CDROM::CDROM(CDROM& parent)
+{
+    bus = nullptr;
+    if(parent.reader)
+        reader.reset(new DiscReader(*parent.reader));
+    index = parent.index;
+    int_enable = parent.int_enable;
+    int_flag = parent.int_flag;
+    params = parent.params;
+    response = parent.response;
+    queued = parent.queued;
+    data_fifo = parent.data_fifo;
+    data_index = parent.data_index;
+    command = parent.command;
+    busy = parent.busy;
+    second_command = parent.second_command;
+    mode = parent.mode;
+    state = parent.state;
+    seek_target = parent.seek_target;
+    seek_pending = parent.seek_pending;
+    position = parent.position;
+    memcpy(sector, parent.sector, CD_SECTOR_SIZE);
+    motor_on = parent.motor_on;
+    deterministic = parent.deterministic;
+}
+
+/**
+ * @brief Inserts a disc into the drive.
+ * 
+ * Starts the reader thread of the disc, replacing the previous disc.
+ * 
+ * @param disc Disc image to insert
+ * @param read_ahead Number of sectors read ahead of the drive head
+ */
+void CDROM::insert_disc(std::unique_ptr<Disc> disc, uint32_t read_ahead)
+{
+    reader.reset(new DiscReader(std::move(disc), read_ahead));
+    motor_on = true;
+    state = DRIVE_IDLE;
+    position = 0;
+}
+
+/**
+ * @brief Reads one of the CD-ROM registers.
+ * 
+ * @param offset Offset from the start of the CD-ROM range
+ * @return uint8_t Value of the register in the selected bank
+ */
+uint8_t CDROM::read8_cpu(uint32_t offset)
+{
+    switch(offset)
+    {
+        case 0:
+        {
+            uint8_t status = index;
+            if(params.empty()) status |= CDROM_STATUS_PRMEMPT;
+            if(params.size() < CDROM_FIFO_SIZE) status |= CDROM_STATUS_PRMWRDY;
+            if(!response.empty()) status |= CDROM_STATUS_RSLRRDY;
+            if(data_index < data_fifo.size()) status |= CDROM_STATUS_DRQSTS;
+            if(busy) status |= CDROM_STATUS_BUSYSTS;
+            return status;
+        }
+        case 1:
+        {
+            if(response.empty()) return 0;
+            uint8_t value = response.front();
+            response.pop_front();
+            return value;
+        }
+        case 2:
+            return data_index < data_fifo.size() ? data_fifo[data_index++] : 0;
+        default:
+            //the upper three bits always read as 1
+            return ((index & 1) ? int_flag : int_enable) | 0xe0;
+    }
+}
+
+/**
+ * @brief Writes one of the CD-ROM registers.
+ * 
+ * TODO: Implement the audio volume and sound map registers.
+ * 
+ * @param offset Offset from the start of the CD-ROM range
+ * @param data Data to write to the register in the selected bank
+ * 
+ * \b References:
+ * @ref write_command
+ * @ref load_data_fifo
+ * @ref acknowledge
+ */
+void CDROM::write8_cpu(uint32_t offset, uint8_t data)
+{
+    switch(offset)
+    {
+        case 0:
+            index = data & 3;
+            break;
+        case 1:
+            if(index == 0) write_command(data);
+            break;
+        case 2:
+            if(index == 0)
+            {
+                if(params.size() < CDROM_FIFO_SIZE) params.push_back(data);
+            }
+            else if(index == 1)
+            {
+                int_enable = data & CDROM_INT_ACK_MASK;
+            }
+            else
+            {
+                LOG_LIMIT(8, LOG_LEVEL_DEBUG, LOG_CDROM, "Ignoring write to audio volume register 2.{}: 0x{:x}", index, data);
+            }
+            break;
+        default:
+            if(index == 0)
+            {
+                if(data & CDROM_REQUEST_BFRD) load_data_fifo();
+                else data_fifo.clear();
+            }
+            else if(index == 1)
+            {
+                acknowledge(data);
+            }
+            else
+            {
+                LOG_LIMIT(8, LOG_LEVEL_DEBUG, LOG_CDROM, "Ignoring write to audio register 3.{}: 0x{:x}", index, data);
+            }
+            break;
+    }
+}
+
+/**
+ * @brief Reads a 32-bit word from the data FIFO.
+ * 
+ * Used by DMA channel 3.
+ * 
+ * @return uint32_t Four bytes of the data FIFO, little endian
+ * 
+ * \b References:
+ * @ref read8_cpu
+ */
+uint32_t CDROM::read_data32()
+{
+    uint32_t value = 0;
+    for(int i = 0; i < 4; i++)
+        value |= uint32_t(read8_cpu(2)) << (i * 8);
+    return value;
+}
+
+/**
+ * @brief Starts a command.
+ * 
+ * The command is executed when its first response is due.
+ * 
+ * @param command Command byte
+ * 
+ * \b References:
+ * @ref Bus::schedule_event
+ */
+void CDROM::write_command(uint8_t command)
+{
+    this->command = command;
+    busy = true;
+    response.clear();
+    uint64_t delay = command == CDROM_CMD_INIT ? CDROM_INIT_RESPONSE_CYCLES : CDROM_FIRST_RESPONSE_CYCLES;
+    bus->schedule_event(EVENT_CDROM_COMMAND, bus->get_cycles() + delay);
+}
+
+/**
+ * @brief Handles the event of the first response of a command.
+ * 
+ * \b References:
+ * @ref execute_command
+ */
+void CDROM::handle_command_event()
+{
+    busy = false;
+    execute_command();
+    params.clear();
+}
+
+/**
+ * @brief Returns the number of parameters a command takes.
+ * 
+ * @param command Command byte
+ * @return size_t Number of parameters
+ */
+static size_t param_count(uint8_t command)
+{
+    switch(command)
+    {
+        case CDROM_CMD_SETLOC:
+            return 3;
+        case CDROM_CMD_SETFILTER:
+            return 2;
+        case CDROM_CMD_SETMODE:
+        case CDROM_CMD_GETTD:
+        case CDROM_CMD_TEST:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Executes the pending command and queues its first response.
+ * 
+ * Commands with a second response (or that start reading) schedule the drive event.
+ * 
+ * \b References:
+ * @ref push_response
+ * @ref start_reading
+ * @ref Bus::schedule_event
+ * @ref Bus::cancel_event
+ */
+void CDROM::execute_command()
+{
+    if(params.size() < param_count(command))
+    {
+        push_response(CDROM_INT_ERROR, {uint8_t(stat() | CDROM_STAT_ERROR), 0x20});
+        return;
+    }
+
+    bool needs_disc = command == CDROM_CMD_READN || command == CDROM_CMD_READS || command == CDROM_CMD_SEEKL
+        || command == CDROM_CMD_SEEKP || command == CDROM_CMD_GETTN || command == CDROM_CMD_GETTD
+        || command == CDROM_CMD_GETLOCL || command == CDROM_CMD_GETLOCP || command == CDROM_CMD_READTOC;
+    if(needs_disc && !reader)
+    {
+        push_response(CDROM_INT_ERROR, {uint8_t(stat() | CDROM_STAT_ERROR), 0x80});
+        return;
+    }
+
+    uint64_t now = bus->get_cycles();
+
+    switch(command)
+    {
+        case CDROM_CMD_GETSTAT:
+        case CDROM_CMD_MUTE:
+        case CDROM_CMD_DEMUTE:
+            push_response(CDROM_INT_ACKNOWLEDGE, {stat()});
+            break;
+        case CDROM_CMD_SETLOC:
+        {
+            uint32_t msf = (from_bcd(params[0]) * 60 + from_bcd(params[1])) * CD_SECTORS_PER_SECOND + from_bcd(params[2]);
+            seek_target = msf >= CD_PREGAP_SECTORS ? msf - CD_PREGAP_SECTORS : 0;
+            seek_pending = true;
+            push_response(CDROM_INT_ACKNOWLEDGE, {stat()});
+            break;
+        }
+        case CDROM_CMD_PLAY:
+            //TODO: Implement CD audio playback
+            LOG_ONCE(LOG_LEVEL_WARN, LOG_CDROM, "Play is not implemented, CD audio is silent");
+            push_response(CDROM_INT_ACKNOWLEDGE, {stat()});
+            break;
+        case CDROM_CMD_READN:
+        case CDROM_CMD_READS:
+            push_response(CDROM_INT_ACKNOWLEDGE, {stat()});
+            start_reading();
+            break;
+        case CDROM_CMD_STOP:
+        case CDROM_CMD_PAUSE:
+            push_response(CDROM_INT_ACKNOWLEDGE, {stat()});
+            state = DRIVE_IDLE;
+            second_command = command;
+            bus->schedule_event(EVENT_CDROM_DRIVE, now + read_cycles());
+            break;
+        case CDROM_CMD_INIT:
+            mode = 0;
+            motor_on = reader != nullptr;
+            state = DRIVE_IDLE;
+            push_response(CDROM_INT_ACKNOWLEDGE, {stat()});
+            second_command = command;
+            bus->schedule_event(EVENT_CDROM_DRIVE, now + CDROM_SECOND_RESPONSE_CYCLES);
+            break;
+        case CDROM_CMD_SETFILTER:
+            //TODO: Implement the XA-ADPCM filter
+            LOG_ONCE(LOG_LEVEL_WARN, LOG_CDROM, "SetFilter is not implemented, XA-ADPCM sectors are not filtered");
+            push_response(CDROM_INT_ACKNOWLEDGE, {stat()});
+            break;
+        case CDROM_CMD_SETMODE:
+            mode = params[0];
+            push_response(CDROM_INT_ACKNOWLEDGE, {stat()});
+            break;
+        case CDROM_CMD_GETPARAM:
+            push_response(CDROM_INT_ACKNOWLEDGE, {stat(), mode, 0, 0, 0});
+            break;
+        case CDROM_CMD_GETLOCL:
+            push_response(CDROM_INT_ACKNOWLEDGE, std::vector<uint8_t>(sector + 12, sector + 20));
+            break;
+        case CDROM_CMD_GETLOCP:
+        {
+            const Track* track = reader->get_disc()->find_track(position);
+            uint32_t relative = track ? position - track->start : 0;
+            uint32_t absolute = position + CD_PREGAP_SECTORS;
+            push_response(CDROM_INT_ACKNOWLEDGE, {
+                to_bcd(track ? track->number : 0), 1,
+                to_bcd(relative / (60 * CD_SECTORS_PER_SECOND)), to_bcd((relative / CD_SECTORS_PER_SECOND) % 60), to_bcd(relative % CD_SECTORS_PER_SECOND),
+                to_bcd(absolute / (60 * CD_SECTORS_PER_SECOND)), to_bcd((absolute / CD_SECTORS_PER_SECOND) % 60), to_bcd(absolute % CD_SECTORS_PER_SECOND)
+            });
+            break;
+        }
+        case CDROM_CMD_GETTN:
+        {
+            const std::vector<Track>& tracks = reader->get_disc()->get_tracks();
+            push_response(CDROM_INT_ACKNOWLEDGE, {stat(), to_bcd(tracks.front().number), to_bcd(tracks.back().number)});
+            break;
+        }
+        case CDROM_CMD_GETTD:
+        {
+            Disc* disc = reader->get_disc();
+            uint8_t number = from_bcd(params[0]);
+            uint32_t start = disc->sector_count();
+            bool found = number == 0;
+            for(const Track& track : disc->get_tracks())
+            {
+                if(track.number == number)
+                {
+                    start = track.start;
+                    found = true;
+                }
+            }
+            if(!found)
+            {
+                push_response(CDROM_INT_ERROR, {uint8_t(stat() | CDROM_STAT_ERROR), 0x10});
+                break;
+            }
+            start += CD_PREGAP_SECTORS;
+            push_response(CDROM_INT_ACKNOWLEDGE, {stat(), to_bcd(start / (60 * CD_SECTORS_PER_SECOND)), to_bcd((start / CD_SECTORS_PER_SECOND) % 60)});
+            break;
+        }
+        case CDROM_CMD_SEEKL:
+        case CDROM_CMD_SEEKP:
+            bus->cancel_event(EVENT_CDROM_DRIVE);
+            reader->seek(seek_target);
+            seek_pending = false;
+            state = DRIVE_SEEKING;
+            push_response(CDROM_INT_ACKNOWLEDGE, {stat()});
+            second_command = command;
+            bus->schedule_event(EVENT_CDROM_DRIVE, now + CDROM_SEEK_CYCLES);
+            break;
+        case CDROM_CMD_TEST:
+            if(params[0] == 0x20)
+            {
+                //date and version of the controller BIOS
+                push_response(CDROM_INT_ACKNOWLEDGE, {0x94, 0x09, 0x19, 0xc0});
+            }
+            else
+            {
+                push_response(CDROM_INT_ERROR, {uint8_t(stat() | CDROM_STAT_ERROR), 0x10});
+            }
+            break;
+        case CDROM_CMD_GETID:
+        case CDROM_CMD_READTOC:
+            push_response(CDROM_INT_ACKNOWLEDGE, {stat()});
+            second_command = command;
+            bus->schedule_event(EVENT_CDROM_DRIVE, now + CDROM_SECOND_RESPONSE_CYCLES);
+            break;
+        default:
+            push_response(CDROM_INT_ERROR, {uint8_t(stat() | CDROM_STAT_ERROR), 0x40});
+            break;
+    }
+}
+
+/**
+ * @brief Handles the event of the drive mechanism.
+ * 
+ * Either completes the pending command with its second response or delivers the next sector.
+ * 
+ * \b References:
+ * @ref finish_command
+ * @ref deliver_sector
+ */
+void CDROM::handle_drive_event()
+{
+    if(second_command)
+        finish_command();
+    else if(state == DRIVE_READING)
+        deliver_sector();
+}
+
+/**
+ * @brief Queues the second response of the pending command.
+ * 
+ * The disc is always reported as a licensed NTSC-U disc.
+ * 
+ * \b References:
+ * @ref push_response
+ */
+void CDROM::finish_command()
+{
+    uint8_t command = second_command;
+    second_command = 0;
+
+    switch(command)
+    {
+        case CDROM_CMD_GETID:
+            if(!reader)
+                push_response(CDROM_INT_ERROR, {0x08, 0x40, 0, 0, 0, 0, 0, 0});
+            else
+                push_response(CDROM_INT_COMPLETE, {stat(), 0x00, 0x20, 0x00, 'S', 'C', 'E', 'A'});
+            break;
+        case CDROM_CMD_SEEKL:
+        case CDROM_CMD_SEEKP:
+            position = seek_target;
+            state = DRIVE_IDLE;
+            push_response(CDROM_INT_COMPLETE, {stat()});
+            break;
+        case CDROM_CMD_STOP:
+            motor_on = false;
+            push_response(CDROM_INT_COMPLETE, {stat()});
+            break;
+        default:
+            push_response(CDROM_INT_COMPLETE, {stat()});
+            break;
+    }
+}
+
+/**
+ * @brief Starts reading sectors from the target of the last Setloc, or from the current position.
+ * 
+ * The reader is moved to the target right away so that the first sectors are read during the emulated seek.
+ * 
+ * \b References:
+ * @ref DiscReader::seek
+ * @ref Bus::schedule_event
+ */
+void CDROM::start_reading()
+{
+    uint64_t delay = read_cycles();
+    if(seek_pending)
+    {
+        position = seek_target;
+        seek_pending = false;
+        delay += CDROM_SEEK_CYCLES;
+    }
+    reader->seek(position);
+    second_command = 0;
+    state = DRIVE_READING;
+    bus->schedule_event(EVENT_CDROM_DRIVE, bus->get_cycles() + delay);
+}
+
+/**
+ * @brief Delivers the sector under the head and schedules the next one.
+ * 
+ * If the reader has not read the sector yet the drive tries again a little later, so the emulation never waits for the disc image. In deterministic mode it waits instead, so the sector is always delivered at the same cycle.
+ * 
+ * \b References:
+ * @ref DiscReader::read
+ * @ref DiscReader::read_wait
+ * @ref push_response
+ * @ref Bus::schedule_event
+ */
+void CDROM::deliver_sector()
+{
+    uint64_t now = bus->get_cycles();
+
+    if(position >= reader->get_disc()->sector_count())
+    {
+        state = DRIVE_IDLE;
+        push_response(CDROM_INT_DATA_END, {stat()});
+        return;
+    }
+
+    if(deterministic)
+        reader->read_wait(position, sector);
+    else if(!reader->read(position, sector))
+    {
+        bus->schedule_event(EVENT_CDROM_DRIVE, now + CDROM_READ_RETRY_CYCLES);
+        return;
+    }
+
+    position++;
+    push_response(CDROM_INT_DATA_READY, {stat()});
+    bus->schedule_event(EVENT_CDROM_DRIVE, now + read_cycles());
+}
+
+/**
+ * @brief Copies the last sector read into the data FIFO.
+ * 
+ * Depending on the mode either the 2048 bytes of user data or the whole sector after the sync pattern (0x924 bytes) are transferred.
+ */
+void CDROM::load_data_fifo()
+{
+    if(mode & CDROM_MODE_SECTOR_SIZE)
+        data_fifo.assign(sector + 12, sector + 12 + 0x924);
+    else
+        data_fifo.assign(sector + 24, sector + 24 + CD_DATA_SIZE);
+    data_index = 0;
+}
+
+/**
+ * @brief Raises an interrupt with its response, or queues it if the previous interrupt is not acknowledged yet.
+ * 
+ * Only the latest unacknowledged sector is kept, older ones are lost like on hardware.
+ * 
+ * @param irq Interrupt to raise
+ * @param data Response bytes
+ * 
+ * \b References:
+ * @ref deliver
+ */
+void CDROM::push_response(CDROMInterrupt irq, std::vector<uint8_t> data)
+{
+    CDROMResponse r = {irq, std::move(data)};
+
+    if((int_flag & 7) == 0)
+    {
+        deliver(r);
+        return;
+    }
+
+    if(irq == CDROM_INT_DATA_READY)
+    {
+        for(CDROMResponse& q : queued)
+        {
+            if(q.irq == CDROM_INT_DATA_READY)
+            {
+                q = r;
+                return;
+            }
+        }
+    }
+    queued.push_back(r);
+}
+
+/**
+ * @brief Sets the interrupt flag and the response FIFO and signals the interrupt controller.
+ * 
+ * @param r Interrupt and response
+ * 
+ * \b References:
+ * @ref Bus::raise_irq
+ */
+void CDROM::deliver(CDROMResponse& r)
+{
+    response.assign(r.data.begin(), r.data.begin() + std::min<size_t>(r.data.size(), CDROM_FIFO_SIZE));
+    int_flag = (int_flag & ~7) | r.irq;
+    if(int_flag & int_enable & CDROM_INT_ACK_MASK)
+        bus->raise_irq(IRQ_CDROM);
+}
+
+/**
+ * @brief Acknowledges interrupts and delivers the next queued response.
+ * 
+ * @param bits Bits written to the interrupt flag register
+ * 
+ * \b References:
+ * @ref deliver
+ */
+void CDROM::acknowledge(uint8_t bits)
+{
+    int_flag &= ~(bits & CDROM_INT_ACK_MASK);
+    if(bits & CDROM_INT_CLEAR_PARAMS) params.clear();
+
+    if((int_flag & 7) == 0 && !queued.empty())
+    {
+        CDROMResponse r = queued.front();
+        queued.pop_front();
+        deliver(r);
+    }
+}
+
+/**
+ * @brief Returns the status byte of the drive.
+ * 
+ * @return uint8_t Status byte
+ */
+uint8_t CDROM::stat()
+{
+    uint8_t value = 0;
+    if(motor_on) value |= CDROM_STAT_MOTOR;
+    if(state == DRIVE_READING) value |= CDROM_STAT_READING;
+    if(state == DRIVE_SEEKING) value |= CDROM_STAT_SEEKING;
+    return value;
+}
+
+/**
+ * @brief Returns the time the drive takes to read a sector at the selected speed.
+ * 
+ * @return uint64_t Number of CPU cycles per sector
+ */
+uint64_t CDROM::read_cycles()
+{
+    return (mode & CDROM_MODE_DOUBLE_SPEED) ? CDROM_READ_CYCLES_DOUBLE : CDROM_READ_CYCLES_SINGLE;
+}
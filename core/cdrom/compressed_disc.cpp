@@ -0,0 +1,499 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <zlib.h>
+#ifdef WOLPSX_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "core/cdrom/compressed_disc.hpp"
+
+#define CDZ_HEADER_SIZE 32
+#define CDZ_TRACK_SIZE 12
+#define CDZ_INDEX_ENTRY_SIZE 16
+#define CDZ_ZLIB_LEVEL 9
+#define CDZ_ZSTD_LEVEL 19
+
+/**
+ * @brief Appends a field of the image to a buffer, in little endian.
+ * 
+ * Since the system is little endian, the value is copied as is.
+ * 
+ * @tparam T Type of the field
+ * @param buffer Buffer to append to
+ * @param value Value of the field
+ */
+template <typename T>
+static void put(std::vector<uint8_t>& buffer, T value)
+{
+    //TODO: add compatibility for big endian systems
+    uint8_t bytes[sizeof(T)];
+    memcpy(bytes, &value, sizeof(T));
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+/**
+ * @brief Reads a field of the image from a buffer, in little endian.
+ * 
+ * Since the system is little endian, the value is copied as is.
+ * 
+ * @tparam T Type of the field
+ * @param buffer Start of the field
+ * @return T Value of the field
+ */
+template <typename T>
+static T get(const uint8_t* buffer)
+{
+    T value;
+    memcpy(&value, buffer, sizeof(T));
+    return value;
+}
+
+/**
+ * @brief Construct a new CompressedDisc:: CompressedDisc object
+ * 
+ * Reads the header, track table and hunk index. Hunks are only decoded when they are read.
+ * 
+ * @param path Path to the compressed image
+ * @param cache_hunks Maximum number of decoded hunks kept in memory
+ * @param threads Number of threads decoding hunks ahead of the reads, 0 to use one per hardware thread
+ * 
+ * @throw std::runtime_error If the file cannot be opened or is not a valid compressed image
+ * @throw std::runtime_error If the image uses a compression method that was not compiled in
+ */
+CompressedDisc::CompressedDisc(std::string path, uint32_t cache_hunks, unsigned int threads)
+{
+    file.open(path, std::ios::binary);
+    if(!file)
+    {
+        throw std::runtime_error("Unable to open compressed disc image: " + path);
+    }
+
+    uint8_t header[CDZ_HEADER_SIZE];
+    file.read((char*)header, CDZ_HEADER_SIZE);
+    if(!file || memcmp(header, CDZ_MAGIC, sizeof(CDZ_MAGIC)) != 0 || get<uint32_t>(header + 8) != CDZ_VERSION)
+    {
+        throw std::runtime_error("Invalid compressed disc image: " + path);
+    }
+
+    hunk_sectors = get<uint32_t>(header + 12);
+    sectors = get<uint32_t>(header + 16);
+    uint32_t track_count = get<uint32_t>(header + 20);
+    compression = CDZCompression(get<uint32_t>(header + 24));
+
+    if(hunk_sectors == 0 || track_count == 0)
+    {
+        throw std::runtime_error("Invalid compressed disc image: " + path);
+    }
+#ifndef WOLPSX_HAVE_ZSTD
+    if(compression == CDZ_COMPRESSION_ZSTD)
+    {
+        throw std::runtime_error("Compressed disc image uses zstd, which is not supported by this build: " + path);
+    }
+#endif
+
+    std::vector<uint8_t> table(track_count * CDZ_TRACK_SIZE);
+    file.read((char*)table.data(), table.size());
+    for(uint32_t i = 0; i < track_count; i++)
+    {
+        const uint8_t* entry = table.data() + i * CDZ_TRACK_SIZE;
+        Track t;
+        t.number = entry[0];
+        t.audio = entry[1];
+        t.start = get<uint32_t>(entry + 4);
+        t.length = get<uint32_t>(entry + 8);
+        t.file = 0;
+        t.file_sector = t.start;
+        t.file_length = t.length;
+        tracks.push_back(t);
+    }
+
+    uint32_t hunk_count = (sectors + hunk_sectors - 1) / hunk_sectors;
+    std::vector<uint8_t> index(hunk_count * CDZ_INDEX_ENTRY_SIZE);
+    file.read((char*)index.data(), index.size());
+    if(!file)
+    {
+        throw std::runtime_error("Truncated compressed disc image: " + path);
+    }
+    for(uint32_t i = 0; i < hunk_count; i++)
+    {
+        const uint8_t* entry = index.data() + i * CDZ_INDEX_ENTRY_SIZE;
+        hunks.push_back({get<uint64_t>(entry), get<uint32_t>(entry + 8), get<uint32_t>(entry + 12)});
+    }
+
+    this->cache_hunks = std::max<uint32_t>(cache_hunks, 2 * CDZ_PREFETCH_HUNKS);
+    pool.reset(new ThreadPool(threads));
+}
+
+/**
+ * @brief Destroy the CompressedDisc:: CompressedDisc object
+ * 
+ * Stops the decoding threads before the cache is destroyed.
+ */
+CompressedDisc::~CompressedDisc()
+{
+    pool.reset();
+}
+
+/**
+ * @brief Reads a raw sector of the disc.
+ * 
+ * Queues the decoding of the hunks that follow the one of the sector.
+ * 
+ * @param lba Sector to read, relative to 00:02:00
+ * @param out Buffer of CD_SECTOR_SIZE bytes
+ * @return true The sector was read
+ * @return false The sector is outside of the disc or its hunk is corrupt
+ * 
+ * \b References:
+ * @ref prefetch
+ * @ref get_hunk
+ */
+bool CompressedDisc::read_sector(uint32_t lba, uint8_t* out)
+{
+    if(lba >= sectors) return false;
+
+    uint32_t hunk = lba / hunk_sectors;
+    uint32_t ahead = std::max<uint32_t>(CDZ_PREFETCH_HUNKS, pool->size());
+    for(uint32_t i = 1; i <= ahead; i++)
+        prefetch(hunk + i);
+
+    std::shared_ptr<std::vector<uint8_t>> data = get_hunk(hunk);
+    if(!data) return false;
+
+    memcpy(out, data->data() + (lba % hunk_sectors) * CD_SECTOR_SIZE, CD_SECTOR_SIZE);
+    return true;
+}
+
+/**
+ * @brief Returns a decoded hunk.
+ * 
+ * Waits if the hunk is being decoded by the pool, and decodes it on the calling thread if it is not in the cache.
+ * 
+ * @param hunk Index of the hunk
+ * @return std::shared_ptr<std::vector<uint8_t>> Raw sectors of the hunk, nullptr if it is corrupt
+ * 
+ * \b References:
+ * @ref decode
+ * @ref insert
+ */
+std::shared_ptr<std::vector<uint8_t>> CompressedDisc::get_hunk(uint32_t hunk)
+{
+    std::unique_lock<std::mutex> lock(cache_mutex);
+
+    //once decoded, the hunk may be evicted again before this thread wakes up
+    decoded.wait(lock, [this, hunk] {
+        auto it = cache.find(hunk);
+        return it == cache.end() || it->second.ready;
+    });
+
+    auto it = cache.find(hunk);
+    if(it != cache.end())
+    {
+        lru.splice(lru.begin(), lru, it->second.lru);
+        return it->second.data;
+    }
+
+    lru.push_front(hunk);
+    cache[hunk] = {nullptr, false, lru.begin()};
+    lock.unlock();
+
+    std::shared_ptr<std::vector<uint8_t>> data = decode(hunk);
+    insert(hunk, data);
+    return data;
+}
+
+/**
+ * @brief Queues the decoding of a hunk on the pool if it is not in the cache.
+ * 
+ * @param hunk Index of the hunk
+ * 
+ * \b References:
+ * @ref ThreadPool::submit
+ * @ref decode
+ * @ref insert
+ */
+void CompressedDisc::prefetch(uint32_t hunk)
+{
+    if(hunk >= hunks.size()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        if(cache.count(hunk)) return;
+        lru.push_front(hunk);
+        cache[hunk] = {nullptr, false, lru.begin()};
+        evict();
+    }
+
+    pool->submit([this, hunk] { insert(hunk, decode(hunk)); });
+}
+
+/**
+ * @brief Stores a decoded hunk in its cache entry and wakes up the readers waiting for it.
+ * 
+ * @param hunk Index of the hunk
+ * @param data Raw sectors of the hunk, nullptr if it is corrupt
+ * 
+ * \b References:
+ * @ref evict
+ */
+void CompressedDisc::insert(uint32_t hunk, std::shared_ptr<std::vector<uint8_t>> data)
+{
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        CachedHunk& entry = cache.at(hunk);
+        entry.data = data;
+        entry.ready = true;
+        evict();
+    }
+    decoded.notify_all();
+}
+
+/**
+ * @brief Removes the least recently used decoded hunks until the cache fits its capacity.
+ * 
+ * Must be called with the cache mutex held.
+ */
+void CompressedDisc::evict()
+{
+    auto it = lru.end();
+    while(cache.size() > cache_hunks && it != lru.begin())
+    {
+        it--;
+        auto entry = cache.find(*it);
+        if(!entry->second.ready) continue;
+        cache.erase(entry);
+        it = lru.erase(it);
+    }
+}
+
+/**
+ * @brief Reads and decompresses a hunk.
+ * 
+ * Only the read of the compressed data is serialized, the decompression runs in parallel.
+ * 
+ * @param hunk Index of the hunk
+ * @return std::shared_ptr<std::vector<uint8_t>> Raw sectors of the hunk, nullptr if it is corrupt
+ */
+std::shared_ptr<std::vector<uint8_t>> CompressedDisc::decode(uint32_t hunk)
+{
+    const CDZHunk& info = hunks[hunk];
+    std::vector<uint8_t> packed(info.size);
+    {
+        std::lock_guard<std::mutex> lock(file_mutex);
+        file.clear();
+        file.seekg(info.offset, std::ios::beg);
+        file.read((char*)packed.data(), packed.size());
+        if(!file) return nullptr;
+    }
+
+    uint32_t count = std::min(hunk_sectors, sectors - hunk * hunk_sectors);
+    std::shared_ptr<std::vector<uint8_t>> data = std::make_shared<std::vector<uint8_t>>(count * CD_SECTOR_SIZE);
+
+    if(info.flags & CDZ_HUNK_STORED)
+    {
+        if(packed.size() != data->size()) return nullptr;
+        memcpy(data->data(), packed.data(), packed.size());
+        return data;
+    }
+
+    switch(compression)
+    {
+        case CDZ_COMPRESSION_ZLIB:
+        {
+            uLongf size = data->size();
+            if(uncompress(data->data(), &size, packed.data(), packed.size()) != Z_OK || size != data->size())
+                return nullptr;
+            return data;
+        }
+#ifdef WOLPSX_HAVE_ZSTD
+        case CDZ_COMPRESSION_ZSTD:
+        {
+            size_t size = ZSTD_decompress(data->data(), data->size(), packed.data(), packed.size());
+            if(ZSTD_isError(size) || size != data->size())
+                return nullptr;
+            return data;
+        }
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+/**
+ * @brief Compresses a hunk.
+ * 
+ * @param raw Raw sectors of the hunk
+ * @param compression Compression method
+ * @param packed Set to the compressed hunk, or to the raw sectors if they do not compress
+ * @return uint32_t Flags of the hunk
+ * 
+ * @throw std::runtime_error If the compression fails
+ */
+static uint32_t compress_hunk(const std::vector<uint8_t>& raw, CDZCompression compression, std::vector<uint8_t>& packed)
+{
+    size_t size = 0;
+    switch(compression)
+    {
+        case CDZ_COMPRESSION_ZLIB:
+        {
+            uLongf bound = compressBound(raw.size());
+            packed.resize(bound);
+            if(compress2(packed.data(), &bound, raw.data(), raw.size(), CDZ_ZLIB_LEVEL) != Z_OK)
+                throw std::runtime_error("Unable to compress hunk");
+            size = bound;
+            break;
+        }
+#ifdef WOLPSX_HAVE_ZSTD
+        case CDZ_COMPRESSION_ZSTD:
+        {
+            packed.resize(ZSTD_compressBound(raw.size()));
+            size = ZSTD_compress(packed.data(), packed.size(), raw.data(), raw.size(), CDZ_ZSTD_LEVEL);
+            if(ZSTD_isError(size))
+                throw std::runtime_error("Unable to compress hunk");
+            break;
+        }
+#endif
+        default:
+            throw std::runtime_error("Unsupported compression method");
+    }
+
+    if(size >= raw.size())
+    {
+        packed = raw;
+        return CDZ_HUNK_STORED;
+    }
+    packed.resize(size);
+    return 0;
+}
+
+/**
+ * @brief Writes a disc image as a compressed image.
+ * 
+ * The sectors are read from the source on the calling thread and compressed in batches on a thread pool.
+ * 
+ * @param source Disc image to compress
+ * @param path Path of the compressed image to create
+ * @param hunk_sectors Number of sectors per hunk, larger hunks compress better but make random access slower
+ * @param compression Compression method
+ * @param threads Number of compression threads, 0 to use one per hardware thread
+ * 
+ * @throw std::runtime_error If the file cannot be created or a sector of the source cannot be read
+ * @throw std::runtime_error If the compression method was not compiled in
+ */
+void CompressedDisc::create(Disc& source, std::string path, uint32_t hunk_sectors, CDZCompression compression, unsigned int threads)
+{
+#ifndef WOLPSX_HAVE_ZSTD
+    if(compression == CDZ_COMPRESSION_ZSTD)
+    {
+        throw std::runtime_error("zstd is not supported by this build");
+    }
+#endif
+    if(hunk_sectors == 0) hunk_sectors = CDZ_DEFAULT_HUNK_SECTORS;
+
+    std::ofstream out(path, std::ios::binary);
+    if(!out)
+    {
+        throw std::runtime_error("Unable to create compressed disc image: " + path);
+    }
+
+    uint32_t sectors = source.sector_count();
+    uint32_t hunk_count = (sectors + hunk_sectors - 1) / hunk_sectors;
+    const std::vector<Track>& tracks = source.get_tracks();
+
+    std::vector<uint8_t> header;
+    header.insert(header.end(), CDZ_MAGIC, CDZ_MAGIC + sizeof(CDZ_MAGIC));
+    put<uint32_t>(header, CDZ_VERSION);
+    put<uint32_t>(header, hunk_sectors);
+    put<uint32_t>(header, sectors);
+    put<uint32_t>(header, tracks.size());
+    put<uint32_t>(header, compression);
+    put<uint32_t>(header, 0);
+    for(const Track& t : tracks)
+    {
+        put<uint8_t>(header, t.number);
+        put<uint8_t>(header, t.audio);
+        put<uint16_t>(header, 0);
+        put<uint32_t>(header, t.start);
+        put<uint32_t>(header, t.length);
+    }
+    out.write((const char*)header.data(), header.size());
+
+    //the index is written once the sizes of the hunks are known
+    uint64_t index_offset = header.size();
+    uint64_t offset = index_offset + uint64_t(hunk_count) * CDZ_INDEX_ENTRY_SIZE;
+    out.seekp(offset, std::ios::beg);
+
+    ThreadPool pool(threads);
+    uint32_t batch = pool.size() * 4;
+    std::vector<uint8_t> index;
+
+    for(uint32_t first = 0; first < hunk_count; first += batch)
+    {
+        uint32_t count = std::min(batch, hunk_count - first);
+        std::vector<std::vector<uint8_t>> raw(count), packed(count);
+        std::vector<uint32_t> flags(count);
+
+        for(uint32_t i = 0; i < count; i++)
+        {
+            uint32_t lba = (first + i) * hunk_sectors;
+            uint32_t n = std::min(hunk_sectors, sectors - lba);
+            raw[i].resize(n * CD_SECTOR_SIZE);
+            for(uint32_t s = 0; s < n; s++)
+            {
+                if(!source.read_sector(lba + s, raw[i].data() + s * CD_SECTOR_SIZE))
+                {
+                    throw std::runtime_error("Unable to read sector of the source disc image");
+                }
+            }
+        }
+
+        std::mutex mutex;
+        std::condition_variable done;
+        uint32_t finished = 0;
+        bool failed = false;
+        for(uint32_t i = 0; i < count; i++)
+        {
+            pool.submit([&, i] {
+                bool ok = true;
+                try
+                {
+                    flags[i] = compress_hunk(raw[i], compression, packed[i]);
+                }
+                catch(const std::exception&)
+                {
+                    ok = false;
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                failed |= !ok;
+                finished++;
+                done.notify_one();
+            });
+        }
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [&] { return finished == count; });
+        }
+        if(failed)
+        {
+            throw std::runtime_error("Unable to compress hunk");
+        }
+
+        for(uint32_t i = 0; i < count; i++)
+        {
+            out.write((const char*)packed[i].data(), packed[i].size());
+            put<uint64_t>(index, offset);
+            put<uint32_t>(index, packed[i].size());
+            put<uint32_t>(index, flags[i]);
+            offset += packed[i].size();
+        }
+    }
+
+    out.seekp(index_offset, std::ios::beg);
+    out.write((const char*)index.data(), index.size());
+    if(!out)
+    {
+        throw std::runtime_error("Unable to write compressed disc image: " + path);
+    }
+}
@@ -0,0 +1,321 @@
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include "core/cdrom/disc.hpp"
+#include "core/cdrom/compressed_disc.hpp"
+
+/**
+ * @brief Converts a binary value (0 - 99) to BCD.
+ * 
+ * @param value Binary value
+ * @return uint8_t BCD value
+ */
+uint8_t to_bcd(uint8_t value)
+{
+    return ((value / 10) << 4) | (value % 10);
+}
+
+/**
+ * @brief Converts a BCD value to binary.
+ * 
+ * @param value BCD value
+ * @return uint8_t Binary value
+ */
+uint8_t from_bcd(uint8_t value)
+{
+    return (value >> 4) * 10 + (value & 0xf);
+}
+
+/**
+ * @brief Returns the number of sectors of the disc.
+ * 
+ * @return uint32_t Number of sectors, starting from 00:02:00
+ */
+uint32_t Disc::sector_count()
+{
+    if(tracks.empty()) return 0;
+    return tracks.back().start + tracks.back().length;
+}
+
+/**
+ * @brief Finds the track that contains a sector.
+ * 
+ * @param lba Sector relative to 00:02:00
+ * @return const Track* Track containing the sector, nullptr if the sector is outside of the disc
+ */
+const Track* Disc::find_track(uint32_t lba)
+{
+    for(auto it = tracks.rbegin(); it != tracks.rend(); it++)
+    {
+        if(lba >= it->start)
+            return lba < it->start + it->length ? &*it : nullptr;
+    }
+    return tracks.empty() ? nullptr : &tracks.front();
+}
+
+/**
+ * @brief Parses a mm:ss:ff timestamp of a CUE sheet.
+ * 
+ * @param msf Timestamp
+ * @return uint32_t Number of sectors
+ * 
+ * @throw std::runtime_error If the timestamp is malformed
+ */
+static uint32_t parse_msf(const std::string& msf)
+{
+    unsigned int m, s, f;
+    char c1, c2;
+    std::stringstream ss(msf);
+    if(!(ss >> m >> c1 >> s >> c2 >> f) || c1 != ':' || c2 != ':')
+    {
+        throw std::runtime_error("Invalid CUE timestamp: " + msf);
+    }
+    return (m * 60 + s) * CD_SECTORS_PER_SECOND + f;
+}
+
+/**
+ * @brief Construct a new BinCueDisc:: BinCueDisc object
+ * 
+ * Supports the FILE (BINARY), TRACK (MODE1/2352, MODE2/2352, AUDIO), INDEX and PREGAP commands. Pregaps given with PREGAP are not stored in the BIN file and read as zeros.
+ * 
+ * @param cue_path Path to the CUE sheet
+ * 
+ * @throw std::runtime_error If the CUE sheet or one of the BIN files cannot be opened
+ * @throw std::runtime_error If the CUE sheet is malformed
+ */
+BinCueDisc::BinCueDisc(std::string cue_path)
+{
+    std::ifstream cue(cue_path);
+    if(!cue)
+    {
+        throw std::runtime_error("Unable to open CUE sheet: " + cue_path);
+    }
+
+    std::string directory;
+    size_t slash = cue_path.find_last_of("/\\");
+    if(slash != std::string::npos) directory = cue_path.substr(0, slash + 1);
+
+    //sector of the disc where the current file starts
+    uint32_t file_start = 0;
+    //pregaps not stored in the files so far
+    uint32_t gap_total = 0;
+    Track* track = nullptr;
+
+    std::string line;
+    while(std::getline(cue, line))
+    {
+        std::stringstream ss(line);
+        std::string command;
+        ss >> command;
+        std::transform(command.begin(), command.end(), command.begin(), ::toupper);
+
+        if(command == "FILE")
+        {
+            std::string rest;
+            std::getline(ss, rest);
+            size_t first = rest.find('"');
+            size_t last = rest.rfind('"');
+            std::string name;
+            if(first != std::string::npos && last > first)
+                name = rest.substr(first + 1, last - first - 1);
+            else
+                std::stringstream(rest) >> name;
+
+            if(!files.empty()) file_start += file_sectors.back();
+            add_file(directory + name);
+            track = nullptr;
+        }
+        else if(command == "TRACK")
+        {
+            if(files.empty())
+            {
+                throw std::runtime_error("TRACK before FILE in CUE sheet: " + cue_path);
+            }
+            unsigned int number;
+            std::string type;
+            ss >> number >> type;
+            std::transform(type.begin(), type.end(), type.begin(), ::toupper);
+            if(type != "AUDIO" && type != "MODE1/2352" && type != "MODE2/2352")
+            {
+                throw std::runtime_error("Unsupported track type in CUE sheet: " + type);
+            }
+
+            Track t;
+            t.number = number;
+            t.audio = type == "AUDIO";
+            t.start = 0;
+            t.length = 0;
+            t.file = files.size() - 1;
+            t.file_sector = 0;
+            t.file_length = 0;
+            tracks.push_back(t);
+            track = &tracks.back();
+        }
+        else if(command == "PREGAP" && track)
+        {
+            std::string msf;
+            ss >> msf;
+            gap_total += parse_msf(msf);
+        }
+        else if(command == "INDEX" && track)
+        {
+            unsigned int index;
+            std::string msf;
+            ss >> index >> msf;
+            if(index == 1)
+            {
+                track->file_sector = parse_msf(msf);
+                track->start = file_start + gap_total + track->file_sector;
+            }
+        }
+    }
+
+    if(tracks.empty())
+    {
+        throw std::runtime_error("No tracks in CUE sheet: " + cue_path);
+    }
+
+    //each track extends up to the start of the next one, the last one up to the end of its file
+    for(size_t i = 0; i < tracks.size(); i++)
+    {
+        Track& t = tracks[i];
+        bool same_file = i + 1 < tracks.size() && tracks[i + 1].file == t.file;
+        t.file_length = (same_file ? tracks[i + 1].file_sector : file_sectors[t.file]) - t.file_sector;
+        t.length = i + 1 < tracks.size() ? tracks[i + 1].start - t.start : t.file_length;
+    }
+}
+
+/**
+ * @brief Opens a BIN file referenced by the CUE sheet.
+ * 
+ * @param path Path to the BIN file
+ * 
+ * @throw std::runtime_error If the file cannot be opened
+ */
+void BinCueDisc::add_file(std::string path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if(!file)
+    {
+        throw std::runtime_error("Unable to open BIN file: " + path);
+    }
+    file.seekg(0, std::ios::end);
+    file_sectors.push_back(file.tellg() / CD_SECTOR_SIZE);
+    files.push_back(std::move(file));
+}
+
+/**
+ * @brief Reads a raw sector of the disc.
+ * 
+ * @param lba Sector to read, relative to 00:02:00
+ * @param out Buffer of CD_SECTOR_SIZE bytes
+ * @return true The sector was read
+ * @return false The sector is outside of the disc
+ */
+bool BinCueDisc::read_sector(uint32_t lba, uint8_t* out)
+{
+    const Track* track = find_track(lba);
+    if(!track) return false;
+
+    //pregaps of the following track are not stored in the file
+    uint32_t offset = lba - track->start;
+    if(offset >= track->file_length)
+    {
+        memset(out, 0, CD_SECTOR_SIZE);
+        return true;
+    }
+
+    std::ifstream& file = files[track->file];
+    file.clear();
+    file.seekg(uint64_t(track->file_sector + offset) * CD_SECTOR_SIZE, std::ios::beg);
+    file.read((char*)out, CD_SECTOR_SIZE);
+    return bool(file);
+}
+
+/**
+ * @brief Construct a new IsoDisc:: IsoDisc object
+ * 
+ * @param path Path to the ISO file
+ * 
+ * @throw std::runtime_error If the file cannot be opened
+ */
+IsoDisc::IsoDisc(std::string path)
+{
+    file.open(path, std::ios::binary);
+    if(!file)
+    {
+        throw std::runtime_error("Unable to open ISO file: " + path);
+    }
+    file.seekg(0, std::ios::end);
+
+    Track t;
+    t.number = 1;
+    t.audio = false;
+    t.start = 0;
+    t.length = file.tellg() / CD_DATA_SIZE;
+    t.file = 0;
+    t.file_sector = 0;
+    t.file_length = t.length;
+    tracks.push_back(t);
+}
+
+/**
+ * @brief Reads a sector of the disc and wraps it in a Mode 2 Form 1 raw sector.
+ * 
+ * @param lba Sector to read, relative to 00:02:00
+ * @param out Buffer of CD_SECTOR_SIZE bytes
+ * @return true The sector was read
+ * @return false The sector is outside of the disc
+ */
+bool IsoDisc::read_sector(uint32_t lba, uint8_t* out)
+{
+    if(lba >= sector_count()) return false;
+
+    memset(out, 0, CD_SECTOR_SIZE);
+
+    //sync pattern
+    memset(out + 1, 0xff, 10);
+
+    //header: absolute address in BCD and mode
+    uint32_t absolute = lba + CD_PREGAP_SECTORS;
+    out[12] = to_bcd(absolute / (60 * CD_SECTORS_PER_SECOND));
+    out[13] = to_bcd((absolute / CD_SECTORS_PER_SECOND) % 60);
+    out[14] = to_bcd(absolute % CD_SECTORS_PER_SECOND);
+    out[15] = 2;
+
+    //subheader (stored twice): submode data
+    out[18] = out[22] = 0x08;
+
+    file.clear();
+    file.seekg(uint64_t(lba) * CD_DATA_SIZE, std::ios::beg);
+    file.read((char*)out + 24, CD_DATA_SIZE);
+    return bool(file);
+}
+
+/**
+ * @brief Opens a disc image, selecting the format from the extension of the file.
+ * 
+ * @param path Path to the CUE sheet, ISO file or compressed image
+ * @return std::unique_ptr<Disc> Opened disc image
+ * 
+ * @throw std::runtime_error If the format is not supported or the image cannot be opened
+ */
+std::unique_ptr<Disc> open_disc(std::string path)
+{
+    std::string extension;
+    size_t dot = path.find_last_of('.');
+    if(dot != std::string::npos) extension = path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+    if(extension == "cue")
+        return std::unique_ptr<Disc>(new BinCueDisc(path));
+    else if(extension == "iso")
+        return std::unique_ptr<Disc>(new IsoDisc(path));
+    else if(extension == "cdz")
+        return std::unique_ptr<Disc>(new CompressedDisc(path));
+
+    throw std::runtime_error("Unsupported disc image format: " + path);
+}
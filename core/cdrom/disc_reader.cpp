@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <cstring>
+
+#include "core/cdrom/disc_reader.hpp"
+
+/**
+ * @brief Construct a new DiscReader:: DiscReader object
+ * 
+ * Starts the worker thread, which begins reading from the start of the disc.
+ * 
+ * @param disc Disc image to read, owned by the reader
+ * @param read_ahead Number of sectors to read ahead of the last requested sector
+ */
+DiscReader::DiscReader(std::unique_ptr<Disc> disc, uint32_t read_ahead) : image(std::make_shared<SharedDisc>())
+{
+    image->disc = std::move(disc);
+    head = 0;
+    stop = false;
+    this->read_ahead = read_ahead ? read_ahead : 1;
+    cache.resize(this->read_ahead * 2);
+    for(CachedSector& sector : cache)
+        sector.valid = false;
+
+    thread = std::thread(&DiscReader::worker, this);
+}
+
+/**
+ * @brief Construct a new DiscReader:: DiscReader object forked from another reader
+ * 
+ * Reads the same image with the window of the parent, starting with an empty cache. The worker thread starts right away.
+ * 
+ * @param parent Reader to fork
+ */
+DiscReader::DiscReader(DiscReader& parent) : image(parent.image)
+{
+    {
+        std::lock_guard<std::mutex> lock(parent.mutex);
+        head = parent.head;
+        read_ahead = parent.read_ahead;
+    }
+    stop = false;
+    cache.resize(read_ahead * 2);
+    for(CachedSector& sector : cache)
+        sector.valid = false;
+
+    thread = std::thread(&DiscReader::worker, this);
+}
+
+/**
+ * @brief Destroy the DiscReader:: DiscReader object
+ * 
+ * Stops the worker thread after the sector it is reading.
+ */
+DiscReader::~DiscReader()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+/**
+ * @brief Moves the read-ahead window to start at the given sector.
+ * 
+ * Used when the drive seeks so that the sectors are read while the seek is emulated.
+ * 
+ * @param lba Sector relative to 00:02:00
+ */
+void DiscReader::seek(uint32_t lba)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(head == lba) return;
+        head = lba;
+    }
+    wake.notify_one();
+}
+
+/**
+ * @brief Copies a sector out of the cache without waiting for it to be read.
+ * 
+ * The window is moved to the requested sector, so a miss is read next.
+ * 
+ * @param lba Sector relative to 00:02:00
+ * @param out Buffer of CD_SECTOR_SIZE bytes
+ * @return true The sector was copied
+ * @return false The sector has not been read yet
+ * 
+ * \b References:
+ * @ref seek
+ */
+bool DiscReader::read(uint32_t lba, uint8_t* out)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        CachedSector& sector = cache[lba % cache.size()];
+        if(sector.valid && sector.lba == lba)
+        {
+            memcpy(out, sector.data, CD_SECTOR_SIZE);
+            if(head != lba)
+            {
+                head = lba;
+                wake.notify_one();
+            }
+            return true;
+        }
+    }
+    seek(lba);
+    return false;
+}
+
+/**
+ * @brief Copies a sector out of the cache, waiting for the worker to read it if needed.
+ * 
+ * Used in deterministic mode, where the emulated timing must not depend on how fast the host reads the image. The sector must be on the disc.
+ * 
+ * @param lba Sector relative to 00:02:00
+ * @param out Buffer of CD_SECTOR_SIZE bytes
+ */
+void DiscReader::read_wait(uint32_t lba, uint8_t* out)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    //the slot is looked up again after every wait, set_read_ahead may have resized the cache meanwhile
+    while(!cache[lba % cache.size()].valid || cache[lba % cache.size()].lba != lba)
+    {
+        if(head != lba)
+        {
+            head = lba;
+            wake.notify_one();
+        }
+        filled.wait(lock);
+    }
+    memcpy(out, cache[lba % cache.size()].data, CD_SECTOR_SIZE);
+}
+
+/**
+ * @brief Changes the size of the read-ahead window.
+ * 
+ * The cache is cleared.
+ * 
+ * @param sectors Number of sectors to read ahead of the last requested sector
+ */
+void DiscReader::set_read_ahead(uint32_t sectors)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        read_ahead = sectors ? sectors : 1;
+        cache.assign(read_ahead * 2, CachedSector());
+        for(CachedSector& sector : cache)
+            sector.valid = false;
+    }
+    wake.notify_one();
+}
+
+/**
+ * @brief Finds the first sector of the window that is not cached.
+ * 
+ * Must be called with the mutex held.
+ * 
+ * @param lba Set to the sector to read
+ * @return true A sector has to be read
+ * @return false The whole window is cached
+ */
+bool DiscReader::next_missing(uint32_t& lba)
+{
+    uint32_t end = std::min(head + read_ahead, image->disc->sector_count());
+    for(uint32_t i = head; i < end; i++)
+    {
+        CachedSector& sector = cache[i % cache.size()];
+        if(!sector.valid || sector.lba != i)
+        {
+            lba = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Main loop of the worker thread.
+ * 
+ * Reads the missing sectors of the window one at a time with the mutex released, and sleeps when the window is full. The image is locked during a read, since the readers of forked machines share it.
+ * 
+ * \b References:
+ * @ref next_missing
+ * @ref Disc::read_sector
+ */
+void DiscReader::worker()
+{
+    uint8_t buffer[CD_SECTOR_SIZE];
+    std::unique_lock<std::mutex> lock(mutex);
+    while(!stop)
+    {
+        uint32_t lba;
+        if(!next_missing(lba))
+        {
+            wake.wait(lock);
+            continue;
+        }
+
+        lock.unlock();
+        bool ok;
+        {
+            std::lock_guard<std::mutex> image_lock(image->mutex);
+            ok = image->disc->read_sector(lba, buffer);
+        }
+        lock.lock();
+
+        if(!ok) memset(buffer, 0, CD_SECTOR_SIZE);
+
+        //the window may have moved while the sector was read
+        if(lba - head < read_ahead)
+        {
+            CachedSector& sector = cache[lba % cache.size()];
+            memcpy(sector.data, buffer, CD_SECTOR_SIZE);
+            sector.lba = lba;
+            sector.valid = true;
+        }
+        filled.notify_all();
+    }
+}
@@ -0,0 +1,273 @@
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <core/interconnect/bus.hpp>
+#include <core/cdrom/cdrom.hpp>
+#include <core/cdrom/compressed_disc.hpp>
+#include <test_bios.hpp>
+
+#define TEST_BIOS_PATH "cdrom_test_bios.bin"
+#define TEST_ISO_PATH "cdrom_test.iso"
+#define TEST_BIN_PATH "cdrom_test.bin"
+#define TEST_CUE_PATH "cdrom_test.cue"
+#define TEST_CDZ_PATH "cdrom_test.cdz"
+#define TEST_SECTORS 32
+
+/**
+ * @brief Creates an ISO image where every byte of a sector holds the number of the sector
+ * 
+ */
+void create_test_iso()
+{
+    std::ofstream file(TEST_ISO_PATH, std::ios::binary);
+    for(int i = 0; i < TEST_SECTORS; i++)
+    {
+        std::vector<char> data(CD_DATA_SIZE, char(i));
+        file.write(data.data(), data.size());
+    }
+}
+
+/**
+ * @brief Creates a BIN/CUE image with a data track and an audio track with a two second pregap
+ * 
+ */
+void create_test_bincue()
+{
+    std::ofstream bin(TEST_BIN_PATH, std::ios::binary);
+    for(int i = 0; i < TEST_SECTORS; i++)
+    {
+        std::vector<char> data(CD_SECTOR_SIZE, char(i));
+        bin.write(data.data(), data.size());
+    }
+
+    std::ofstream cue(TEST_CUE_PATH);
+    cue << "FILE \"" << TEST_BIN_PATH << "\" BINARY\n";
+    cue << "  TRACK 01 MODE2/2352\n";
+    cue << "    INDEX 01 00:00:00\n";
+    cue << "  TRACK 02 AUDIO\n";
+    cue << "    PREGAP 00:02:00\n";
+    cue << "    INDEX 01 00:00:16\n";
+}
+
+/**
+ * @brief Reads a sector through the reader, waiting for the worker thread
+ * 
+ * @param reader
+ * @param lba
+ * @param out
+ * @return true The sector was read within a second
+ */
+bool read_blocking(DiscReader& reader, uint32_t lba, uint8_t* out)
+{
+    for(int i = 0; i < 1000; i++)
+    {
+        if(reader.read(lba, out)) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+/**
+ * @brief Tests that the reader serves the sectors of an ISO image wrapped in raw sectors
+ * 
+ */
+void test_cdrom_iso_reader()
+{
+    std::cout << "CD-ROM ISO Reader: ";
+    DiscReader reader(open_disc(TEST_ISO_PATH), 8);
+    uint8_t sector[CD_SECTOR_SIZE];
+    bool ok = read_blocking(reader, 20, sector);
+    bool data = sector[24] == 20 && sector[24 + CD_DATA_SIZE - 1] == 20;
+    //00:02:20 in BCD, mode 2
+    bool header = sector[12] == 0x00 && sector[13] == 0x02 && sector[14] == 0x20 && sector[15] == 2;
+    bool size = reader.get_disc()->sector_count() == TEST_SECTORS;
+    if(ok && data && header && size) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+/**
+ * @brief Tests that a forked reader and its parent read the same image with their own windows, and that the fork outlives its parent
+ * 
+ */
+void test_cdrom_forked_reader()
+{
+    std::cout << "CD-ROM Forked Reader: ";
+    DiscReader* parent = new DiscReader(open_disc(TEST_ISO_PATH), 4);
+    DiscReader child(*parent);
+    uint8_t sector[CD_SECTOR_SIZE];
+    bool ok = child.get_disc() == parent->get_disc();
+    //both read sequentially from different places, each waiting for its own window
+    for(uint32_t i = 0; i < TEST_SECTORS / 2; i++)
+    {
+        parent->read_wait(i, sector);
+        ok = ok && sector[24] == i;
+        child.read_wait(TEST_SECTORS / 2 + i, sector);
+        ok = ok && sector[24] == TEST_SECTORS / 2 + i;
+    }
+    delete parent;
+    child.read_wait(3, sector);
+    ok = ok && sector[24] == 3;
+    if(ok) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+/**
+ * @brief Tests the track layout of a CUE sheet and the pregap that is not stored in the BIN file
+ * 
+ */
+void test_cdrom_cue_tracks()
+{
+    std::cout << "CD-ROM CUE Tracks: ";
+    DiscReader reader(open_disc(TEST_CUE_PATH), 8);
+    Disc* disc = reader.get_disc();
+    const std::vector<Track>& tracks = disc->get_tracks();
+    bool layout = tracks.size() == 2 && tracks[0].start == 0 && tracks[1].start == 16 + 150 && tracks[1].audio;
+    bool count = disc->sector_count() == TEST_SECTORS + 150;
+    uint8_t sector[CD_SECTOR_SIZE];
+    bool gap = read_blocking(reader, 100, sector) && sector[0] == 0;
+    bool audio = read_blocking(reader, 16 + 150, sector) && sector[0] == 16;
+    if(layout && count && gap && audio) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+/**
+ * @brief Tests that a compressed image returns the same sectors as its source, in sequential and random order
+ * 
+ */
+void test_cdrom_compressed()
+{
+    std::cout << "CD-ROM Compressed Image: ";
+    std::unique_ptr<Disc> source = open_disc(TEST_CUE_PATH);
+    CompressedDisc::create(*source, TEST_CDZ_PATH, 4, CDZ_COMPRESSION_ZLIB, 2);
+    CompressedDisc disc(TEST_CDZ_PATH, 16, 2);
+
+    bool same = disc.sector_count() == source->sector_count() && disc.get_tracks().size() == 2;
+    uint8_t expected[CD_SECTOR_SIZE];
+    uint8_t sector[CD_SECTOR_SIZE];
+    for(uint32_t i = 0; i < source->sector_count() && same; i++)
+    {
+        source->read_sector(i, expected);
+        same &= disc.read_sector(i, sector) && memcmp(expected, sector, CD_SECTOR_SIZE) == 0;
+    }
+    for(uint32_t i = 0; i < source->sector_count() && same; i++)
+    {
+        uint32_t lba = (i * 97) % source->sector_count();
+        source->read_sector(lba, expected);
+        same &= disc.read_sector(lba, sector) && memcmp(expected, sector, CD_SECTOR_SIZE) == 0;
+    }
+    bool outside = !disc.read_sector(source->sector_count(), sector);
+    if(same && outside) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+/**
+ * @brief Clocks the bus until the CD-ROM raises an interrupt and returns it
+ * 
+ * @param bus
+ * @return uint8_t Interrupt number, 0 if none was raised
+ */
+uint8_t wait_cdrom_irq(Bus& bus)
+{
+    bus.write8_cpu(0x1f801800, 1);
+    for(int i = 0; i < 1000000; i++)
+    {
+        uint8_t flag = bus.read8_cpu(0x1f801803) & 7;
+        if(flag) return flag;
+        for(int j = 0; j < 64; j++)
+            bus.clock();
+    }
+    return 0;
+}
+
+/**
+ * @brief Acknowledges the interrupt of the CD-ROM
+ * 
+ * @param bus
+ */
+void ack_cdrom_irq(Bus& bus)
+{
+    bus.write8_cpu(0x1f801800, 1);
+    bus.write8_cpu(0x1f801803, 0x1f);
+    bus.write8_cpu(0x1f801800, 0);
+}
+
+/**
+ * @brief Sends a command with its parameters to the CD-ROM
+ * 
+ * @param bus
+ * @param command
+ * @param params
+ */
+void send_command(Bus& bus, uint8_t command, std::vector<uint8_t> params)
+{
+    bus.write8_cpu(0x1f801800, 0);
+    for(uint8_t param : params)
+        bus.write8_cpu(0x1f801802, param);
+    bus.write8_cpu(0x1f801801, command);
+}
+
+/**
+ * @brief Tests Setloc, Setmode and ReadN through the registers, including the data FIFO
+ * 
+ * @param bus
+ */
+void test_cdrom_readn(Bus& bus)
+{
+    std::cout << "CD-ROM ReadN: ";
+    bus.write8_cpu(0x1f801800, 1);
+    bus.write8_cpu(0x1f801802, 0x1f);
+
+    send_command(bus, CDROM_CMD_SETLOC, {0x00, 0x02, 0x05});
+    bool setloc = wait_cdrom_irq(bus) == CDROM_INT_ACKNOWLEDGE;
+    ack_cdrom_irq(bus);
+
+    send_command(bus, CDROM_CMD_SETMODE, {CDROM_MODE_DOUBLE_SPEED});
+    bool setmode = wait_cdrom_irq(bus) == CDROM_INT_ACKNOWLEDGE;
+    ack_cdrom_irq(bus);
+
+    send_command(bus, CDROM_CMD_READN, {});
+    bool readn = wait_cdrom_irq(bus) == CDROM_INT_ACKNOWLEDGE;
+    ack_cdrom_irq(bus);
+
+    bool ready = wait_cdrom_irq(bus) == CDROM_INT_DATA_READY;
+    uint8_t stat = bus.read8_cpu(0x1f801801);
+    ack_cdrom_irq(bus);
+
+    bus.write8_cpu(0x1f801803, CDROM_REQUEST_BFRD);
+    bool drq = bus.read8_cpu(0x1f801800) & CDROM_STATUS_DRQSTS;
+    bool data = true;
+    for(int i = 0; i < CD_DATA_SIZE; i++)
+        data &= bus.read8_cpu(0x1f801802) == 5;
+
+    bool next = wait_cdrom_irq(bus) == CDROM_INT_DATA_READY;
+    ack_cdrom_irq(bus);
+    bus.write8_cpu(0x1f801803, CDROM_REQUEST_BFRD);
+    next &= bus.read8_cpu(0x1f801802) == 6;
+
+    if(setloc && setmode && readn && ready && (stat & CDROM_STAT_READING) && drq && data && next) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+int main()
+{
+    write_test_bios(TEST_BIOS_PATH, {0x0bf00000, 0x00000000}); //j 0xbfc00000
+    create_test_iso();
+    create_test_bincue();
+
+    test_cdrom_iso_reader();
+    test_cdrom_forked_reader();
+    test_cdrom_cue_tracks();
+    test_cdrom_compressed();
+
+    Bus bus(TEST_BIOS_PATH);
+    //the test polls the registers from the host between instructions, so time must not jump past several events
+    bus.set_idle_skip(false);
+    bus.load_disc(TEST_ISO_PATH, 8);
+    test_cdrom_readn(bus);
+
+    return 0;
+}
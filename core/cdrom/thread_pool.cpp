@@ -0,0 +1,67 @@
+#include "core/cdrom/thread_pool.hpp"
+
+/**
+ * @brief Construct a new ThreadPool:: ThreadPool object
+ * 
+ * @param threads Number of worker threads, 0 to use one per hardware thread
+ */
+ThreadPool::ThreadPool(unsigned int threads)
+{
+    stop = false;
+    if(threads == 0) threads = std::thread::hardware_concurrency();
+    if(threads == 0) threads = 1;
+    for(unsigned int i = 0; i < threads; i++)
+        workers.emplace_back(&ThreadPool::worker, this);
+}
+
+/**
+ * @brief Destroy the ThreadPool:: ThreadPool object
+ * 
+ * Waits for the running tasks to finish.
+ */
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+        tasks.clear();
+    }
+    wake.notify_all();
+    for(std::thread& thread : workers)
+        thread.join();
+}
+
+/**
+ * @brief Queues a task to be run by one of the workers.
+ * 
+ * @param task Task to run
+ */
+void ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    wake.notify_one();
+}
+
+/**
+ * @brief Main loop of the worker threads.
+ * 
+ */
+void ThreadPool::worker()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while(true)
+    {
+        wake.wait(lock, [this] { return stop || !tasks.empty(); });
+        if(stop) return;
+
+        std::function<void()> task = std::move(tasks.front());
+        tasks.pop_front();
+
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
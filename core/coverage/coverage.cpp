@@ -0,0 +1,142 @@
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <core/coverage/coverage.hpp>
+
+/**
+ * @brief Counts the set bits of a bitmap.
+ * 
+ * @param bits Bitmap
+ * @param size Size of the bitmap in bytes
+ * @return uint32_t Number of set bits
+ */
+static uint32_t count_bits(const uint8_t* bits, uint32_t size)
+{
+    uint32_t count = 0;
+    for(uint32_t i = 0; i < size; i++)
+        for(uint8_t byte = bits[i]; byte; byte &= byte - 1)
+            count++;
+    return count;
+}
+
+/**
+ * @brief Construct a new CodeCoverage object
+ * 
+ * No word is covered yet.
+ */
+CodeCoverage::CodeCoverage()
+{
+    clear();
+}
+
+/**
+ * @brief Checks whether the word at the given address has been executed.
+ * 
+ * @param addr Virtual address of the word
+ * @return true The word has been executed
+ * @return false The word has not been executed, or is outside RAM and BIOS
+ */
+bool CodeCoverage::is_covered(uint32_t addr)
+{
+    uint32_t phys = addr & 0x1fffffff;
+    if(phys < COVERAGE_RAM_SIZE)
+        return (ram[phys >> 5] >> ((phys >> 2) & 7)) & 1;
+    if(phys - COVERAGE_BIOS_START < COVERAGE_BIOS_SIZE)
+        return (bios[(phys - COVERAGE_BIOS_START) >> 5] >> ((phys >> 2) & 7)) & 1;
+    return false;
+}
+
+/**
+ * @brief Returns the number of words of RAM executed.
+ * 
+ * @return uint32_t Number of words
+ */
+uint32_t CodeCoverage::count_ram()
+{
+    return count_bits(ram, COVERAGE_RAM_BYTES);
+}
+
+/**
+ * @brief Returns the number of words of BIOS executed.
+ * 
+ * @return uint32_t Number of words
+ */
+uint32_t CodeCoverage::count_bios()
+{
+    return count_bits(bios, COVERAGE_BIOS_BYTES);
+}
+
+/**
+ * @brief Marks every word as not executed.
+ * 
+ */
+void CodeCoverage::clear()
+{
+    memset(ram, 0, sizeof(ram));
+    memset(bios, 0, sizeof(bios));
+}
+
+/**
+ * @brief Adds the words executed in another map to this one.
+ * 
+ * @param other Map to merge
+ */
+void CodeCoverage::merge(const CodeCoverage& other)
+{
+    for(uint32_t i = 0; i < COVERAGE_RAM_BYTES; i++)
+        ram[i] |= other.ram[i];
+    for(uint32_t i = 0; i < COVERAGE_BIOS_BYTES; i++)
+        bios[i] |= other.bios[i];
+}
+
+/**
+ * @brief Saves the map to a file.
+ * 
+ * @param path Path of the file
+ * 
+ * @throw std::runtime_error If the file could not be written
+ */
+void CodeCoverage::save(const std::string& path)
+{
+    std::ofstream file(path, std::ios::binary);
+    file.write(COVERAGE_MAGIC, COVERAGE_MAGIC_SIZE);
+    file.write((const char*)ram, sizeof(ram));
+    file.write((const char*)bios, sizeof(bios));
+    if(!file)
+    {
+        std::stringstream ss;
+        ss << "Could not write coverage map: " << path;
+        throw std::runtime_error(ss.str());
+    }
+}
+
+/**
+ * @brief Replaces the map with one saved to a file.
+ * 
+ * @param path Path of the file
+ * 
+ * @throw std::runtime_error If the file could not be read or is not a coverage map
+ */
+void CodeCoverage::load(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    char magic[COVERAGE_MAGIC_SIZE];
+    file.read(magic, COVERAGE_MAGIC_SIZE);
+    if(!file || memcmp(magic, COVERAGE_MAGIC, COVERAGE_MAGIC_SIZE) != 0)
+    {
+        std::stringstream ss;
+        ss << "Not a coverage map: " << path;
+        throw std::runtime_error(ss.str());
+    }
+    file.read((char*)ram, sizeof(ram));
+    file.read((char*)bios, sizeof(bios));
+    if(!file)
+    {
+        clear();
+        std::stringstream ss;
+        ss << "Truncated coverage map: " << path;
+        throw std::runtime_error(ss.str());
+    }
+}
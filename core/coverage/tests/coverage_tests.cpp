@@ -0,0 +1,104 @@
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#include <core/coverage/coverage.hpp>
+#include <core/interconnect/bus.hpp>
+#include <test_bios.hpp>
+
+#define TEST_BIOS_PATH "coverage_test_bios.bin"
+#define TEST_MAP_PATH "coverage_test_map.bin"
+
+/**
+ * @brief Creates a BIOS that jumps to 0x00001000 with the instruction cache disabled
+ * 
+ */
+void create_test_bios()
+{
+    std::vector<uint32_t> program = {
+        0x340a1000, //ori t2, zero, 0x1000
+        0x01400008, //jr t2
+        0x00000000  //nop
+    };
+    write_test_bios(TEST_BIOS_PATH, program);
+}
+
+/**
+ * @brief Tests marking, counting, merging and saving coverage maps
+ * 
+ */
+void test_coverage_map()
+{
+    std::cout << "Coverage Map: ";
+    CodeCoverage* a = new CodeCoverage();
+    CodeCoverage* b = new CodeCoverage();
+    a->mark(0x80001000);
+    a->mark(0xa0001004);
+    a->mark(0xbfc00000);
+    a->mark(0x1f801810); //I/O, ignored
+    b->mark(0x00001000);
+    b->mark(0x00002000);
+    b->mark(0x9fc7fffc);
+
+    bool marked = a->is_covered(0x00001000) && a->is_covered(0x00001004) && !a->is_covered(0x00001008) &&
+        a->is_covered(0xbfc00000) && !a->is_covered(0x1f801810) && a->count_ram() == 2 && a->count_bios() == 1;
+
+    a->merge(*b);
+    bool merged = a->count_ram() == 3 && a->count_bios() == 2 && a->is_covered(0xbfc7fffc);
+
+    a->save(TEST_MAP_PATH);
+    b->load(TEST_MAP_PATH);
+    bool loaded = b->count_ram() == 3 && b->count_bios() == 2 && b->is_covered(0x00002000);
+    std::remove(TEST_MAP_PATH);
+
+    delete a;
+    delete b;
+    if(marked && merged && loaded) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+/**
+ * @brief Tests that the CPU marks the instructions it executes
+ * 
+ * The BIOS jumps to a loop at 0x1000 that counts down v0. The code after the loop is never reached.
+ * 
+ * @param bus
+ */
+void test_coverage_cpu(Bus& bus)
+{
+    std::cout << "Coverage CPU Execute: ";
+#ifdef WOLPSX_COVERAGE
+    bus.write32_cpu(0x1000, 0x2442ffff); //addiu v0, v0, -1
+    bus.write32_cpu(0x1004, 0x1440fffe); //bnez v0, 0x1000
+    bus.write32_cpu(0x1008, 0x00000000); //nop
+    bus.write32_cpu(0x100c, 0x1000fffc); //b 0x1000
+    bus.write32_cpu(0x1010, 0x00000000); //nop
+    bus.write32_cpu(0x1020, 0x00000000); //never executed
+
+    CodeCoverage* coverage = new CodeCoverage();
+    bus.set_coverage(coverage);
+    for(int i = 0; i < 100; i++)
+        bus.clock();
+    bus.set_coverage(nullptr);
+
+    bool bios = coverage->is_covered(0xbfc00000) && coverage->is_covered(0xbfc00004) && coverage->count_bios() == 3;
+    bool ram = coverage->is_covered(0x1000) && coverage->is_covered(0x1004) && coverage->is_covered(0x1008) &&
+        !coverage->is_covered(0x1020);
+    delete coverage;
+
+    if(bios && ram) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+#else
+    std::cout << "Success (not compiled in)" << std::endl;
+#endif
+}
+
+int main()
+{
+    create_test_bios();
+    Bus bus(TEST_BIOS_PATH);
+
+    test_coverage_map();
+    test_coverage_cpu(bus);
+    return 0;
+}
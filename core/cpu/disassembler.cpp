@@ -0,0 +1,631 @@
+#include <cstring>
+
+#include <core/cpu/disassembler.hpp>
+
+/**
+ * @brief Table of 64 instruction formats, indexed by an instruction field.
+ * 
+ */
+struct DisasmTable
+{
+    DisasmEntry entries[64];
+};
+
+/**
+ * @brief Builds a table entry.
+ * 
+ * @param name Mnemonic, at most 8 characters
+ * @param format Operand layout
+ * @return DisasmEntry Entry with the padded mnemonic and its length
+ */
+static constexpr DisasmEntry entry(const char* name, DisasmFormat format)
+{
+    DisasmEntry e{};
+    while(name[e.length])
+    {
+        e.mnemonic[e.length] = name[e.length];
+        e.length++;
+    }
+    e.format = format;
+    return e;
+}
+
+/**
+ * @brief Builds a table of names, such as register names.
+ * 
+ * @param names Names, nullptr for none
+ * @param count Number of names
+ * @return DisasmTable Table with the names
+ */
+static constexpr DisasmTable make_name_table(const char* const* names, int count)
+{
+    DisasmTable t{};
+    for(int i = 0; i < count; i++)
+        if(names[i]) t.entries[i] = entry(names[i], DISASM_NONE);
+    return t;
+}
+
+/**
+ * @brief Builds the table of the primary opcodes (bits 26-31).
+ * 
+ * @return DisasmTable Table indexed by opcode
+ */
+static constexpr DisasmTable make_primary_table()
+{
+    DisasmTable t{};
+    t.entries[0x00] = entry("special", DISASM_SPECIAL);
+    t.entries[0x01] = entry("regimm", DISASM_REGIMM);
+    t.entries[0x02] = entry("j", DISASM_JUMP);
+    t.entries[0x03] = entry("jal", DISASM_JUMP);
+    t.entries[0x04] = entry("beq", DISASM_RS_RT_BRANCH);
+    t.entries[0x05] = entry("bne", DISASM_RS_RT_BRANCH);
+    t.entries[0x06] = entry("blez", DISASM_RS_BRANCH);
+    t.entries[0x07] = entry("bgtz", DISASM_RS_BRANCH);
+    t.entries[0x08] = entry("addi", DISASM_RT_RS_IMM);
+    t.entries[0x09] = entry("addiu", DISASM_RT_RS_IMM);
+    t.entries[0x0a] = entry("slti", DISASM_RT_RS_IMM);
+    t.entries[0x0b] = entry("sltiu", DISASM_RT_RS_IMM);
+    t.entries[0x0c] = entry("andi", DISASM_RT_RS_UIMM);
+    t.entries[0x0d] = entry("ori", DISASM_RT_RS_UIMM);
+    t.entries[0x0e] = entry("xori", DISASM_RT_RS_UIMM);
+    t.entries[0x0f] = entry("lui", DISASM_RT_UIMM);
+    t.entries[0x10] = entry("cop", DISASM_COP);
+    t.entries[0x11] = entry("cop", DISASM_COP);
+    t.entries[0x12] = entry("cop", DISASM_COP);
+    t.entries[0x13] = entry("cop", DISASM_COP);
+    t.entries[0x20] = entry("lb", DISASM_RT_MEM);
+    t.entries[0x21] = entry("lh", DISASM_RT_MEM);
+    t.entries[0x22] = entry("lwl", DISASM_RT_MEM);
+    t.entries[0x23] = entry("lw", DISASM_RT_MEM);
+    t.entries[0x24] = entry("lbu", DISASM_RT_MEM);
+    t.entries[0x25] = entry("lhu", DISASM_RT_MEM);
+    t.entries[0x26] = entry("lwr", DISASM_RT_MEM);
+    t.entries[0x28] = entry("sb", DISASM_RT_MEM);
+    t.entries[0x29] = entry("sh", DISASM_RT_MEM);
+    t.entries[0x2a] = entry("swl", DISASM_RT_MEM);
+    t.entries[0x2b] = entry("sw", DISASM_RT_MEM);
+    t.entries[0x2e] = entry("swr", DISASM_RT_MEM);
+    t.entries[0x30] = entry("lwc0", DISASM_COP_MEM);
+    t.entries[0x31] = entry("lwc1", DISASM_COP_MEM);
+    t.entries[0x32] = entry("lwc2", DISASM_COP_MEM);
+    t.entries[0x33] = entry("lwc3", DISASM_COP_MEM);
+    t.entries[0x38] = entry("swc0", DISASM_COP_MEM);
+    t.entries[0x39] = entry("swc1", DISASM_COP_MEM);
+    t.entries[0x3a] = entry("swc2", DISASM_COP_MEM);
+    t.entries[0x3b] = entry("swc3", DISASM_COP_MEM);
+    return t;
+}
+
+/**
+ * @brief Builds the table of the special instructions (opcode = 0b000000), indexed by function (bits 0-5).
+ * 
+ * @return DisasmTable Table indexed by function
+ */
+static constexpr DisasmTable make_special_table()
+{
+    DisasmTable t{};
+    t.entries[0x00] = entry("sll", DISASM_RD_RT_SA);
+    t.entries[0x02] = entry("srl", DISASM_RD_RT_SA);
+    t.entries[0x03] = entry("sra", DISASM_RD_RT_SA);
+    t.entries[0x04] = entry("sllv", DISASM_RD_RT_RS);
+    t.entries[0x06] = entry("srlv", DISASM_RD_RT_RS);
+    t.entries[0x07] = entry("srav", DISASM_RD_RT_RS);
+    t.entries[0x08] = entry("jr", DISASM_RS);
+    t.entries[0x09] = entry("jalr", DISASM_RD_RS);
+    t.entries[0x0c] = entry("syscall", DISASM_CODE);
+    t.entries[0x0d] = entry("break", DISASM_CODE);
+    t.entries[0x10] = entry("mfhi", DISASM_RD);
+    t.entries[0x11] = entry("mthi", DISASM_RS);
+    t.entries[0x12] = entry("mflo", DISASM_RD);
+    t.entries[0x13] = entry("mtlo", DISASM_RS);
+    t.entries[0x18] = entry("mult", DISASM_RS_RT);
+    t.entries[0x19] = entry("multu", DISASM_RS_RT);
+    t.entries[0x1a] = entry("div", DISASM_RS_RT);
+    t.entries[0x1b] = entry("divu", DISASM_RS_RT);
+    t.entries[0x20] = entry("add", DISASM_RD_RS_RT);
+    t.entries[0x21] = entry("addu", DISASM_RD_RS_RT);
+    t.entries[0x22] = entry("sub", DISASM_RD_RS_RT);
+    t.entries[0x23] = entry("subu", DISASM_RD_RS_RT);
+    t.entries[0x24] = entry("and", DISASM_RD_RS_RT);
+    t.entries[0x25] = entry("or", DISASM_RD_RS_RT);
+    t.entries[0x26] = entry("xor", DISASM_RD_RS_RT);
+    t.entries[0x27] = entry("nor", DISASM_RD_RS_RT);
+    t.entries[0x2a] = entry("slt", DISASM_RD_RS_RT);
+    t.entries[0x2b] = entry("sltu", DISASM_RD_RS_RT);
+    return t;
+}
+
+/**
+ * @brief Builds the table of the REGIMM branches (opcode = 0b000001), indexed by rt (bits 16-20).
+ * 
+ * @return DisasmTable Table indexed by rt
+ */
+static constexpr DisasmTable make_regimm_table()
+{
+    DisasmTable t{};
+    t.entries[0x00] = entry("bltz", DISASM_RS_BRANCH);
+    t.entries[0x01] = entry("bgez", DISASM_RS_BRANCH);
+    t.entries[0x10] = entry("bltzal", DISASM_RS_BRANCH);
+    t.entries[0x11] = entry("bgezal", DISASM_RS_BRANCH);
+    return t;
+}
+
+/**
+ * @brief Builds the table of the coprocessor instructions, indexed by rs (bits 21-25).
+ * 
+ * The mnemonics get the coprocessor number appended. Commands (rs >= 0b10000) are looked up in the COP0 and GTE tables.
+ * 
+ * @return DisasmTable Table indexed by rs
+ */
+static constexpr DisasmTable make_cop_table()
+{
+    DisasmTable t{};
+    t.entries[0x00] = entry("mfc", DISASM_RT_COP);
+    t.entries[0x02] = entry("cfc", DISASM_RT_COP);
+    t.entries[0x04] = entry("mtc", DISASM_RT_COP);
+    t.entries[0x06] = entry("ctc", DISASM_RT_COP);
+    t.entries[0x08] = entry("bc", DISASM_BRANCH);
+    for(int i = 0x10; i < 0x20; i++)
+        t.entries[i] = entry("cop", DISASM_COP_COMMAND);
+    return t;
+}
+
+/**
+ * @brief Builds the table of the COP0 commands, indexed by function (bits 0-5).
+ * 
+ * @return DisasmTable Table indexed by function
+ */
+static constexpr DisasmTable make_cop0_table()
+{
+    DisasmTable t{};
+    t.entries[0x01] = entry("tlbr", DISASM_NONE);
+    t.entries[0x02] = entry("tlbwi", DISASM_NONE);
+    t.entries[0x06] = entry("tlbwr", DISASM_NONE);
+    t.entries[0x08] = entry("tlbp", DISASM_NONE);
+    t.entries[0x10] = entry("rfe", DISASM_NONE);
+    return t;
+}
+
+/**
+ * @brief Builds the table of the GTE commands, indexed by function (bits 0-5).
+ * 
+ * @return DisasmTable Table indexed by function
+ */
+static constexpr DisasmTable make_gte_table()
+{
+    DisasmTable t{};
+    t.entries[0x01] = entry("rtps", DISASM_GTE);
+    t.entries[0x06] = entry("nclip", DISASM_GTE);
+    t.entries[0x0c] = entry("op", DISASM_GTE);
+    t.entries[0x10] = entry("dpcs", DISASM_GTE);
+    t.entries[0x11] = entry("intpl", DISASM_GTE);
+    t.entries[0x12] = entry("mvmva", DISASM_GTE_MVMVA);
+    t.entries[0x13] = entry("ncds", DISASM_GTE);
+    t.entries[0x14] = entry("cdp", DISASM_GTE);
+    t.entries[0x16] = entry("ncdt", DISASM_GTE);
+    t.entries[0x1b] = entry("nccs", DISASM_GTE);
+    t.entries[0x1c] = entry("cc", DISASM_GTE);
+    t.entries[0x1e] = entry("ncs", DISASM_GTE);
+    t.entries[0x20] = entry("nct", DISASM_GTE);
+    t.entries[0x28] = entry("sqr", DISASM_GTE);
+    t.entries[0x29] = entry("dcpl", DISASM_GTE);
+    t.entries[0x2a] = entry("dpct", DISASM_GTE);
+    t.entries[0x2d] = entry("avsz3", DISASM_GTE);
+    t.entries[0x2e] = entry("avsz4", DISASM_GTE);
+    t.entries[0x30] = entry("rtpt", DISASM_GTE);
+    t.entries[0x3d] = entry("gpf", DISASM_GTE);
+    t.entries[0x3e] = entry("gpl", DISASM_GTE);
+    t.entries[0x3f] = entry("ncct", DISASM_GTE);
+    return t;
+}
+
+static constexpr DisasmTable primary_table = make_primary_table();
+static constexpr DisasmTable special_table = make_special_table();
+static constexpr DisasmTable regimm_table = make_regimm_table();
+static constexpr DisasmTable cop_table = make_cop_table();
+static constexpr DisasmTable cop0_table = make_cop0_table();
+static constexpr DisasmTable gte_table = make_gte_table();
+
+static constexpr const char* reg_names[32] = {
+    "zero", "at", "v0", "v1", "a0", "a1", "a2", "a3",
+    "t0", "t1", "t2", "t3", "t4", "t5", "t6", "t7",
+    "s0", "s1", "s2", "s3", "s4", "s5", "s6", "s7",
+    "t8", "t9", "k0", "k1", "gp", "sp", "fp", "ra"
+};
+
+static constexpr const char* cop0_names[16] = {
+    nullptr, nullptr, nullptr, "bpc", nullptr, "bda", "jumpdest", "dcic",
+    "badvaddr", "bdam", nullptr, "bpcm", "sr", "cause", "epc", "prid"
+};
+
+static constexpr const char* mvmva_names[12] = {
+    "rt", "ll", "lc", "bad",
+    "v0", "v1", "v2", "ir",
+    "tr", "bk", "fc", "none"
+};
+
+static constexpr DisasmTable reg_table = make_name_table(reg_names, 32);
+static constexpr DisasmTable cop0_reg_table = make_name_table(cop0_names, 16);
+static constexpr DisasmTable mvmva_table = make_name_table(mvmva_names, 12);
+
+static const char hex_digits[] = "0123456789abcdef";
+
+/**
+ * @brief Pairs of hexadecimal digits of every byte value.
+ * 
+ */
+static const char hex_pairs[] =
+    "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"
+    "202122232425262728292a2b2c2d2e2f303132333435363738393a3b3c3d3e3f"
+    "404142434445464748494a4b4c4d4e4f505152535455565758595a5b5c5d5e5f"
+    "606162636465666768696a6b6c6d6e6f707172737475767778797a7b7c7d7e7f"
+    "808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f"
+    "a0a1a2a3a4a5a6a7a8a9aaabacadaeafb0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+    "c0c1c2c3c4c5c6c7c8c9cacbcccdcecfd0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+    "e0e1e2e3e4e5e6e7e8e9eaebecedeeeff0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+
+/**
+ * @brief Pairs of decimal digits from 00 to 99.
+ * 
+ */
+static const char dec_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/**
+ * @brief Copies a name from a table entry.
+ * 
+ * All 8 characters are copied and the pointer is advanced by the length, the output must have room for them.
+ * 
+ * @param p Output
+ * @param name Entry of the name
+ * @return char* End of the name
+ */
+static inline char* put_name(char* p, const DisasmEntry& name)
+{
+    memcpy(p, name.mnemonic, 8);
+    return p + name.length;
+}
+
+static inline char* put_str(char* p, const char* s)
+{
+    while(*s) *p++ = *s++;
+    return p;
+}
+
+static inline char* put_sep(char* p)
+{
+    memcpy(p, ", ", 2);
+    return p + 2;
+}
+
+static inline char* put_reg(char* p, uint32_t reg)
+{
+    return put_name(p, reg_table.entries[reg]);
+}
+
+/**
+ * @brief Writes a number in hexadecimal with a 0x prefix and no leading zeros.
+ * 
+ * @param p Output
+ * @param value Number to write
+ * @return char* End of the number
+ */
+static inline char* put_hex(char* p, uint32_t value)
+{
+    int digits = 1;
+    while(digits < 8 && (value >> (digits * 4))) digits++;
+    *p++ = '0';
+    *p++ = 'x';
+    for(int i = digits - 1; i >= 0; i--)
+        *p++ = hex_digits[(value >> (i * 4)) & 0xf];
+    return p;
+}
+
+/**
+ * @brief Writes a number in hexadecimal with a 0x prefix and all 8 digits.
+ * 
+ * @param p Output
+ * @param value Number to write
+ * @return char* End of the number
+ */
+static inline char* put_hex8(char* p, uint32_t value)
+{
+    memcpy(p, "0x", 2);
+    memcpy(p + 2, &hex_pairs[(value >> 24) * 2], 2);
+    memcpy(p + 4, &hex_pairs[((value >> 16) & 0xff) * 2], 2);
+    memcpy(p + 6, &hex_pairs[((value >> 8) & 0xff) * 2], 2);
+    memcpy(p + 8, &hex_pairs[(value & 0xff) * 2], 2);
+    return p + 10;
+}
+
+/**
+ * @brief Writes a signed number in decimal.
+ * 
+ * Digits are produced in pairs, most operands (offsets, shift amounts, register numbers) take a single step.
+ * 
+ * @param p Output
+ * @param value Number to write
+ * @return char* End of the number
+ */
+static inline char* put_dec(char* p, int32_t value)
+{
+    uint32_t magnitude = value < 0 ? 0u - uint32_t(value) : uint32_t(value);
+    if(value < 0) *p++ = '-';
+    if(magnitude < 10)
+    {
+        *p++ = '0' + magnitude;
+        return p;
+    }
+    if(magnitude < 100)
+    {
+        memcpy(p, &dec_pairs[magnitude * 2], 2);
+        return p + 2;
+    }
+
+    char digits[10];
+    int n = 10;
+    while(magnitude >= 100)
+    {
+        n -= 2;
+        memcpy(&digits[n], &dec_pairs[(magnitude % 100) * 2], 2);
+        magnitude /= 100;
+    }
+    if(magnitude < 10)
+        digits[--n] = '0' + magnitude;
+    else
+    {
+        n -= 2;
+        memcpy(&digits[n], &dec_pairs[magnitude * 2], 2);
+    }
+    memcpy(p, &digits[n], 10 - n);
+    return p + 10 - n;
+}
+
+static inline char* put_cop_reg(char* p, uint32_t reg)
+{
+    *p++ = '$';
+    return put_dec(p, reg);
+}
+
+/**
+ * @brief Writes the text of an instruction.
+ * 
+ * @param ins Instruction word
+ * @param addr Address of the instruction, for branch and jump targets
+ * @param out Buffer of at least DISASM_BUFFER_SIZE characters
+ * @return size_t Length of the text, without the terminating NUL
+ */
+static size_t format(uint32_t ins, uint32_t addr, char* out)
+{
+    char* p = out;
+    uint32_t op = ins >> 26;
+    uint32_t rs = (ins >> 21) & 0x1f;
+    uint32_t rt = (ins >> 16) & 0x1f;
+    uint32_t rd = (ins >> 11) & 0x1f;
+    uint32_t funct = ins & 0x3f;
+    int32_t imm = int16_t(ins & 0xffff);
+    uint32_t target = addr + 4 + (uint32_t(imm) << 2);
+
+    if(ins == 0)
+    {
+        p = put_str(p, "nop");
+        *p = 0;
+        return p - out;
+    }
+
+    DisasmEntry entry = primary_table.entries[op];
+    char cop = 0;
+    switch(entry.format)
+    {
+        case DISASM_SPECIAL:
+            entry = special_table.entries[funct];
+            break;
+        case DISASM_REGIMM:
+            entry = regimm_table.entries[rt];
+            break;
+        case DISASM_COP:
+            cop = '0' + (op & 3);
+            entry = cop_table.entries[rs];
+            if(entry.format == DISASM_COP_COMMAND)
+            {
+                const DisasmEntry* command = nullptr;
+                if(op == 0x10) command = &cop0_table.entries[funct];
+                else if(op == 0x12) command = &gte_table.entries[funct];
+                if(command && command->length)
+                {
+                    entry = *command;
+                    cop = 0;
+                }
+            }
+            else if(entry.format == DISASM_BRANCH && rt > 1)
+                entry = DisasmEntry{};
+            else if(op == 0x10 && (rs == 0 || rs == 4))
+                entry.format = DISASM_RT_COP0;
+            break;
+        default:
+            break;
+    }
+
+    if(!entry.length)
+    {
+        p = put_str(p, ".word ");
+        p = put_hex8(p, ins);
+        *p = 0;
+        return p - out;
+    }
+
+    p = put_name(p, entry);
+    if(cop)
+    {
+        *p++ = cop;
+        if(entry.format == DISASM_BRANCH) *p++ = rt ? 't' : 'f';
+    }
+    if(entry.format != DISASM_NONE) *p++ = ' ';
+
+    switch(entry.format)
+    {
+        case DISASM_RD_RS_RT:
+            p = put_reg(p, rd);
+            p = put_sep(p);
+            p = put_reg(p, rs);
+            p = put_sep(p);
+            p = put_reg(p, rt);
+            break;
+        case DISASM_RD_RT_SA:
+            p = put_reg(p, rd);
+            p = put_sep(p);
+            p = put_reg(p, rt);
+            p = put_sep(p);
+            p = put_dec(p, (ins >> 6) & 0x1f);
+            break;
+        case DISASM_RD_RT_RS:
+            p = put_reg(p, rd);
+            p = put_sep(p);
+            p = put_reg(p, rt);
+            p = put_sep(p);
+            p = put_reg(p, rs);
+            break;
+        case DISASM_RS:
+            p = put_reg(p, rs);
+            break;
+        case DISASM_RD:
+            p = put_reg(p, rd);
+            break;
+        case DISASM_RD_RS:
+            //jalr links to ra unless told otherwise
+            if(rd != 31)
+            {
+                p = put_reg(p, rd);
+                p = put_sep(p);
+            }
+            p = put_reg(p, rs);
+            break;
+        case DISASM_RS_RT:
+            p = put_reg(p, rs);
+            p = put_sep(p);
+            p = put_reg(p, rt);
+            break;
+        case DISASM_RT_RS_IMM:
+            p = put_reg(p, rt);
+            p = put_sep(p);
+            p = put_reg(p, rs);
+            p = put_sep(p);
+            p = put_dec(p, imm);
+            break;
+        case DISASM_RT_RS_UIMM:
+            p = put_reg(p, rt);
+            p = put_sep(p);
+            p = put_reg(p, rs);
+            p = put_sep(p);
+            p = put_hex(p, ins & 0xffff);
+            break;
+        case DISASM_RT_UIMM:
+            p = put_reg(p, rt);
+            p = put_sep(p);
+            p = put_hex(p, ins & 0xffff);
+            break;
+        case DISASM_RS_RT_BRANCH:
+            p = put_reg(p, rs);
+            p = put_sep(p);
+            p = put_reg(p, rt);
+            p = put_sep(p);
+            p = put_hex8(p, target);
+            break;
+        case DISASM_RS_BRANCH:
+            p = put_reg(p, rs);
+            p = put_sep(p);
+            p = put_hex8(p, target);
+            break;
+        case DISASM_BRANCH:
+            p = put_hex8(p, target);
+            break;
+        case DISASM_JUMP:
+            p = put_hex8(p, ((addr + 4) & 0xf0000000) | ((ins & 0x3ffffff) << 2));
+            break;
+        case DISASM_RT_MEM:
+            p = put_reg(p, rt);
+            p = put_sep(p);
+            p = put_dec(p, imm);
+            *p++ = '(';
+            p = put_reg(p, rs);
+            *p++ = ')';
+            break;
+        case DISASM_COP_MEM:
+            p = put_cop_reg(p, rt);
+            p = put_sep(p);
+            p = put_dec(p, imm);
+            *p++ = '(';
+            p = put_reg(p, rs);
+            *p++ = ')';
+            break;
+        case DISASM_CODE:
+            //the code field is only printed when set
+            p = (ins >> 6) & 0xfffff ? put_hex(p, (ins >> 6) & 0xfffff) : p - 1;
+            break;
+        case DISASM_RT_COP0:
+            p = put_reg(p, rt);
+            p = put_sep(p);
+            p = cop0_reg_table.entries[rd].length ? put_name(p, cop0_reg_table.entries[rd]) : put_cop_reg(p, rd);
+            break;
+        case DISASM_RT_COP:
+            p = put_reg(p, rt);
+            p = put_sep(p);
+            p = put_cop_reg(p, rd);
+            break;
+        case DISASM_COP_COMMAND:
+            p = put_hex(p, ins & 0x1ffffff);
+            break;
+        case DISASM_GTE_MVMVA:
+            p = put_name(p, mvmva_table.entries[(ins >> 17) & 3]);
+            p = put_sep(p);
+            p = put_name(p, mvmva_table.entries[4 + ((ins >> 15) & 3)]);
+            p = put_sep(p);
+            p = put_name(p, mvmva_table.entries[8 + ((ins >> 13) & 3)]);
+            p = put_sep(p);
+            [[fallthrough]];
+        case DISASM_GTE:
+            //shift and saturation flags, the command name alone when both are clear
+            if(ins & (1 << 19))
+                p = put_str(p, "sf");
+            if((ins & (1 << 19)) && (ins & (1 << 10)))
+                p = put_sep(p);
+            if(ins & (1 << 10))
+                p = put_str(p, "lm");
+            if(!(ins & ((1 << 19) | (1 << 10))))
+                p -= entry.format == DISASM_GTE ? 1 : 2;
+            break;
+        default:
+            break;
+    }
+
+    *p = 0;
+    return p - out;
+}
+
+/**
+ * @brief Disassembles an instruction into a caller-provided buffer.
+ * 
+ * The instruction is looked up in constant format tables and its operands are formatted without allocating, so that whole traces can be disassembled quickly. Text that does not fit is truncated, the buffer is always NUL-terminated.
+ * 
+ * @param ins Instruction word
+ * @param addr Address of the instruction, for branch and jump targets
+ * @param buffer Output buffer, DISASM_BUFFER_SIZE characters always hold a whole instruction
+ * @param size Size of the buffer
+ * @return size_t Length of the text written, without the terminating NUL
+ */
+size_t disassemble(uint32_t ins, uint32_t addr, char* buffer, size_t size)
+{
+    if(size >= DISASM_BUFFER_SIZE)
+        return format(ins, addr, buffer);
+    if(size == 0)
+        return 0;
+
+    char text[DISASM_BUFFER_SIZE];
+    size_t length = format(ins, addr, text);
+    if(length >= size) length = size - 1;
+    memcpy(buffer, text, length);
+    buffer[length] = 0;
+    return length;
+}
@@ -1,6 +1,5 @@
 #include <iostream>
 
-#include <core/cpu/cpu.hpp>
 #include <cpu_test.hpp>
 
 /**
@@ -10,7 +9,7 @@
  * @return true 
  * @return false 
  */
-void test_cpu_add(CPU& cpu)
+void test_cpu_add(TestCPU& cpu)
 {
     // Test unsigned addition
     std::cout << "ADD (SPECIAL 100000) Addition: ";
@@ -27,7 +26,9 @@ void test_cpu_add(CPU& cpu)
 
 int main()
 {
-    CPU test_cpu;
+    MockBus bus;
+    TestCPU test_cpu;
+    test_cpu.connectBus(&bus);
 
     test_cpu_add(test_cpu);
 
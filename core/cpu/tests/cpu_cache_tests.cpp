@@ -0,0 +1,69 @@
+#include <iostream>
+#include <vector>
+
+#include <core/interconnect/bus.hpp>
+#include <test_bios.hpp>
+
+#define TEST_BIOS_PATH "cpu_cache_test_bios.bin"
+
+/**
+ * @brief Creates a BIOS that enables the instruction cache, does an isolated store to 0x200 and jumps to 0x80001000
+ * 
+ */
+void create_test_bios()
+{
+    std::vector<uint32_t> program = {
+        0x3c08fffe, //lui t0, 0xfffe
+        0x34090800, //ori t1, zero, 0x800
+        0xad090130, //sw t1, 0x130(t0)
+        0x3c0b0001, //lui t3, 0x0001
+        0x408b6000, //mtc0 t3, $12
+        0xac000200, //sw zero, 0x200(zero)
+        0x40806000, //mtc0 zero, $12
+        0x3c0a8000, //lui t2, 0x8000
+        0x354a1000, //ori t2, t2, 0x1000
+        0x01400008, //jr t2
+        0x00000000  //nop
+    };
+    write_test_bios(TEST_BIOS_PATH, program);
+}
+
+/**
+ * @brief Tests that an isolated store does not reach RAM and that cached code keeps running after RAM is overwritten
+ * 
+ * The loop at 0x80001000 increments v0 and stores it to 0x100. Once it has been cached, its increment is patched in RAM, which must not be seen until the line is invalidated.
+ * 
+ * @param bus 
+ */
+void test_cpu_icache(Bus& bus)
+{
+    std::cout << "CPU Instruction Cache: ";
+    bus.write32_cpu(0x200, 0x12345678);
+    bus.write32_cpu(0x1000, 0x24420001); //addiu v0, v0, 1
+    bus.write32_cpu(0x1004, 0xac020100); //sw v0, 0x100(zero)
+    bus.write32_cpu(0x1008, 0x08000400); //j 0x80001000
+    bus.write32_cpu(0x100c, 0x00000000); //nop
+
+    for(int i = 0; i < 100; i++)
+        bus.clock();
+    bool isolated = bus.read32_cpu(0x200) == 0x12345678;
+    bool enabled = bus.read32_cpu(0xfffe0130) == 0x800;
+
+    bus.write32_cpu(0x1000, 0x24420100); //addiu v0, v0, 0x100
+    uint32_t before = bus.read32_cpu(0x100);
+    for(int i = 0; i < 400; i++)
+        bus.clock();
+    uint32_t delta = bus.read32_cpu(0x100) - before;
+
+    if(isolated && enabled && delta > 0 && delta < 0x100) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+int main()
+{
+    create_test_bios();
+    Bus bus(TEST_BIOS_PATH);
+
+    test_cpu_icache(bus);
+    return 0;
+}
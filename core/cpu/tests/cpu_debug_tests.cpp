@@ -0,0 +1,103 @@
+#include <iostream>
+#include <vector>
+
+#include <core/interconnect/bus.hpp>
+#include <test_bios.hpp>
+
+#define TEST_BIOS_PATH "cpu_debug_test_bios.bin"
+
+/**
+ * @brief Creates a BIOS from a program at the reset vector and a debug handler that saves EPC and DCIC to k0 and k1
+ * 
+ * @param program Instructions at 0xbfc00000
+ */
+void create_test_bios(const std::vector<uint32_t>& program)
+{
+    std::vector<uint32_t> handler = {
+        0x401a7000, //mfc0 k0, epc
+        0x401b3800, //mfc0 k1, dcic
+        0x00000000, //nop
+        0x0bf00053, //j 0xbfc0014c
+        0x00000000  //nop
+    };
+    std::vector<uint32_t> image = program;
+    image.resize(0x140 / 4, 0x00000000);
+    image.insert(image.end(), handler.begin(), handler.end());
+    write_test_bios(TEST_BIOS_PATH, image);
+}
+
+/**
+ * @brief Tests that an execution breakpoint stops before the instruction at BPC
+ * 
+ */
+void test_cpu_code_breakpoint()
+{
+    std::cout << "CPU Execution Breakpoint: ";
+    create_test_bios({
+        0x3c080040, //lui t0, 0x0040 (BEV)
+        0x40886000, //mtc0 t0, status
+        0x3c08bfc0, //lui t0, 0xbfc0
+        0x35080030, //ori t0, t0, 0x30
+        0x40881800, //mtc0 t0, bpc
+        0x2409ffff, //addiu t1, zero, -1
+        0x40895800, //mtc0 t1, bpcm
+        0x3c0ac180, //lui t2, 0xc180 (master and execution enables)
+        0x408a3800, //mtc0 t2, dcic
+        0x00000000, //nop
+        0x34100001, //ori s0, zero, 1
+        0x34110002, //ori s1, zero, 2
+        0x34120003, //ori s2, zero, 3 (breakpoint)
+        0x0bf0000d, //j 0xbfc00034
+        0x00000000  //nop
+    });
+    Bus bus(TEST_BIOS_PATH);
+    for(int i = 0; i < 200; i++)
+        bus.clock();
+
+    CPUState state;
+    bus.get_cpu_state(&state);
+    bool success = state.reg_gen[26] == 0xbfc00030 && state.reg_gen[27] == 0xc1800003;
+    success = success && state.reg_gen[17] == 2 && state.reg_gen[18] != 3;
+    std::cout << (success ? "Success" : "Failure") << std::endl;
+}
+
+/**
+ * @brief Tests that a data breakpoint on writes lets the store complete and breaks before the next instruction, and ignores reads
+ * 
+ */
+void test_cpu_data_breakpoint()
+{
+    std::cout << "CPU Data Breakpoint: ";
+    create_test_bios({
+        0x3c080040, //lui t0, 0x0040 (BEV)
+        0x40886000, //mtc0 t0, status
+        0x34080100, //ori t0, zero, 0x100
+        0x40882800, //mtc0 t0, bda
+        0x2409fffc, //addiu t1, zero, -4
+        0x40894800, //mtc0 t1, bdam
+        0x3c0aca80, //lui t2, 0xca80 (master, data and write enables)
+        0x408a3800, //mtc0 t2, dcic
+        0x340b0055, //ori t3, zero, 0x55
+        0x8c0c0100, //lw t4, 0x100(zero)
+        0xa00b0102, //sb t3, 0x102(zero) (breakpoint)
+        0x34100007, //ori s0, zero, 7
+        0x0bf0000c, //j 0xbfc00030
+        0x00000000  //nop
+    });
+    Bus bus(TEST_BIOS_PATH);
+    for(int i = 0; i < 200; i++)
+        bus.clock();
+
+    CPUState state;
+    bus.get_cpu_state(&state);
+    bool success = state.reg_gen[26] == 0xbfc0002c && (state.reg_gen[27] & 0x1f) == 0x15;
+    success = success && bus.read8_cpu(0x102) == 0x55 && state.reg_gen[16] != 7;
+    std::cout << (success ? "Success" : "Failure") << std::endl;
+}
+
+int main()
+{
+    test_cpu_code_breakpoint();
+    test_cpu_data_breakpoint();
+    return 0;
+}
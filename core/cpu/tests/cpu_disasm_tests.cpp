@@ -0,0 +1,98 @@
+#include <cstring>
+#include <iostream>
+
+#include <core/cpu/disassembler.hpp>
+
+/**
+ * @brief Instruction with its expected text.
+ * 
+ */
+struct DisasmCase
+{
+    uint32_t ins;
+    uint32_t addr;
+    const char* text;
+};
+
+static const DisasmCase cases[] = {
+    {0x00000000, 0, "nop"},
+    {0x27bdffe8, 0, "addiu sp, sp, -24"},
+    {0x3c088000, 0, "lui t0, 0x8000"},
+    {0x35080f00, 0, "ori t0, t0, 0xf00"},
+    {0x8fbf0014, 0, "lw ra, 20(sp)"},
+    {0xa104fffc, 0, "sb a0, -4(t0)"},
+    {0x00084080, 0, "sll t0, t0, 2"},
+    {0x01095021, 0, "addu t2, t0, t1"},
+    {0x0109001a, 0, "div t0, t1"},
+    {0x00004012, 0, "mflo t0"},
+    {0x03e00008, 0, "jr ra"},
+    {0x0100f809, 0, "jalr t0"},
+    {0x01001009, 0, "jalr v0, t0"},
+    {0x0bf00001, 0xbfc00000, "j 0xbfc00004"},
+    {0x0c004000, 0x80010000, "jal 0x80010000"},
+    {0x1620fffd, 0xbfc0003c, "bne s1, zero, 0xbfc00034"},
+    {0x04110002, 0x80001000, "bgezal zero, 0x8000100c"},
+    {0x0000000c, 0, "syscall"},
+    {0x0001000d, 0, "break 0x400"},
+    {0x40886000, 0, "mtc0 t0, sr"},
+    {0x40026800, 0, "mfc0 v0, cause"},
+    {0x42000010, 0, "rfe"},
+    {0x48880800, 0, "mtc2 t0, $1"},
+    {0x48c2f800, 0, "ctc2 v0, $31"},
+    {0xc8410000, 0, "lwc2 $1, 0(v0)"},
+    {0xe8a7fff8, 0, "swc2 $7, -8(a1)"},
+    {0x4a180001, 0, "rtps sf"},
+    {0x4a000006, 0, "nclip"},
+    {0x4a480412, 0, "mvmva rt, v0, tr, sf, lm"},
+    {0x4a02c012, 0, "mvmva ll, v1, fc"},
+    {0x4a100428, 0, "sqr lm"},
+    {0x45000003, 0x100, "bc1f 0x00000110"},
+    {0x44020800, 0, "mfc1 v0, $1"},
+    {0x4e123456, 0, "cop3 0x123456"},
+    {0xffffffff, 0, ".word 0xffffffff"},
+    {0x0000003f, 0, ".word 0x0000003f"},
+};
+
+/**
+ * @brief Tests the text of instructions of every format
+ * 
+ */
+void test_disasm_format()
+{
+    std::cout << "CPU Disassembler Format: ";
+    char buffer[DISASM_BUFFER_SIZE];
+    for(const DisasmCase& c : cases)
+    {
+        size_t length = disassemble(c.ins, c.addr, buffer, sizeof(buffer));
+        if(strcmp(buffer, c.text) != 0 || length != strlen(c.text))
+        {
+            std::cout << "Failure (0x" << std::hex << c.ins << ": \"" << buffer << "\")" << std::endl;
+            return;
+        }
+    }
+    std::cout << "Success" << std::endl;
+}
+
+/**
+ * @brief Tests that text which does not fit in a small buffer is truncated and terminated
+ * 
+ */
+void test_disasm_truncate()
+{
+    std::cout << "CPU Disassembler Truncation: ";
+    char buffer[8];
+    memset(buffer, 'x', sizeof(buffer));
+    size_t length = disassemble(0x27bdffe8, 0, buffer, sizeof(buffer));
+    bool fits = length == 7 && strcmp(buffer, "addiu s") == 0;
+    bool empty = disassemble(0x27bdffe8, 0, buffer, 0) == 0;
+
+    if(fits && empty) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+int main()
+{
+    test_disasm_format();
+    test_disasm_truncate();
+    return 0;
+}
@@ -0,0 +1,60 @@
+#include <iostream>
+#include <vector>
+
+#include <core/interconnect/bus.hpp>
+#include <test_bios.hpp>
+
+#define TEST_BIOS_PATH "cpu_fetch_test_bios.bin"
+
+/**
+ * @brief Creates a BIOS that jumps to 0x00000ff8 with the instruction cache disabled
+ * 
+ */
+void create_test_bios()
+{
+    std::vector<uint32_t> program = {
+        0x340a0ff8, //ori t2, zero, 0xff8
+        0x01400008, //jr t2
+        0x00000000  //nop
+    };
+    write_test_bios(TEST_BIOS_PATH, program);
+}
+
+/**
+ * @brief Tests uncached fetches from RAM across a page boundary, and that code modified in RAM is seen at once
+ * 
+ * The loop at 0xff8 crosses into the next page: it increments v0 and stores it to 0x100. Its increment is then patched in RAM.
+ * 
+ * @param bus 
+ */
+void test_cpu_fetch(Bus& bus)
+{
+    std::cout << "CPU Code Page Fetch: ";
+    bus.write32_cpu(0x0ff8, 0x24420001); //addiu v0, v0, 1
+    bus.write32_cpu(0x0ffc, 0x00000000); //nop
+    bus.write32_cpu(0x1000, 0xac020100); //sw v0, 0x100(zero)
+    bus.write32_cpu(0x1004, 0x080003fe); //j 0x00000ff8
+    bus.write32_cpu(0x1008, 0x00000000); //nop
+    bus.write32_cpu(0x0100, 0x00000000);
+
+    for(int i = 0; i < 100; i++)
+        bus.clock();
+    uint32_t before = bus.read32_cpu(0x100);
+
+    bus.write32_cpu(0x0ff8, 0x24420100); //addiu v0, v0, 0x100
+    for(int i = 0; i < 100; i++)
+        bus.clock();
+    uint32_t delta = bus.read32_cpu(0x100) - before;
+
+    if(before != 0 && delta >= 0x100) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+int main()
+{
+    create_test_bios();
+    Bus bus(TEST_BIOS_PATH);
+
+    test_cpu_fetch(bus);
+    return 0;
+}
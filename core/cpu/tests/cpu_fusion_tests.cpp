@@ -0,0 +1,94 @@
+#include <iostream>
+#include <vector>
+
+#include <core/interconnect/bus.hpp>
+#include <test_bios.hpp>
+
+#define TEST_BIOS_PATH "cpu_fusion_test_bios.bin"
+
+/**
+ * @brief Creates a BIOS made of the fused idioms, with a load delay and a branch delay slot to check, that stores its results to RAM
+ * 
+ */
+void create_test_bios()
+{
+    std::vector<uint32_t> program = {
+        0x3c081234, //lui t0, 0x1234
+        0x35085678, //ori t0, t0, 0x5678
+        0x3c098000, //lui t1, 0x8000
+        0x25290100, //addiu t1, t1, 0x100
+        0x3c0a0000, //lui t2, 0x0000
+        0xad480010, //sw t0, 0x10(t2)
+        0xad490014, //sw t1, 0x14(t2)
+        0x3c0b0000, //lui t3, 0x0000
+        0x8d6c0010, //lw t4, 0x10(t3)
+        0x01806825, //or t5, t4, zero (load delay slot)
+        0x01807025, //or t6, t4, zero
+        0x34100005, //ori s0, zero, 5
+        0x34120000, //ori s2, zero, 0
+        0x2610ffff, //loop: addiu s0, s0, -1
+        0x0010882a, //slt s1, zero, s0
+        0x1620fffd, //bne s1, zero, loop
+        0x26520001, //addiu s2, s2, 1 (branch delay slot)
+        0xac0d0018, //sw t5, 0x18(zero)
+        0xac0e001c, //sw t6, 0x1c(zero)
+        0xac120020, //sw s2, 0x20(zero)
+        0x340f0001, //ori t7, zero, 1
+        0xac0f0024, //sw t7, 0x24(zero)
+        0x0bf00016, //j 0xbfc00058
+        0x00000000  //nop
+    };
+    write_test_bios(TEST_BIOS_PATH, program);
+}
+
+/**
+ * @brief Runs the test BIOS until it has stored its results
+ * 
+ * @param bus 
+ * @param results Words stored to 0x10-0x20
+ * @return uint64_t Cycle count when the results were complete
+ */
+uint64_t run_test_bios(Bus& bus, std::vector<uint32_t>& results)
+{
+    for(int i = 0; i < 1000 && bus.read32_cpu(0x24) != 1; i++)
+        bus.clock();
+    for(uint32_t addr = 0x10; addr <= 0x20; addr += 4)
+        results.push_back(bus.read32_cpu(addr));
+    return bus.get_cycles();
+}
+
+/**
+ * @brief Tests that fused idioms give the same results and timing as separate instructions
+ * 
+ */
+void test_cpu_fusion()
+{
+    std::cout << "CPU Instruction Fusion: ";
+    create_test_bios();
+
+    Bus fused(TEST_BIOS_PATH);
+    std::vector<uint32_t> fused_results;
+    uint64_t fused_cycles = run_test_bios(fused, fused_results);
+
+    Bus separate(TEST_BIOS_PATH);
+    separate.set_fusion(false);
+    std::vector<uint32_t> separate_results;
+    uint64_t separate_cycles = run_test_bios(separate, separate_results);
+
+    std::vector<uint32_t> expected = {0x12345678, 0x80000100, 0xdeadbeef, 0x12345678, 5};
+    bool results = fused_results == expected && separate_results == expected && fused_cycles == separate_cycles;
+    bool counts = fused.get_fusion_count(FUSION_LUI_ORI) == 1 && fused.get_fusion_count(FUSION_LUI_ADDIU) == 1 &&
+        fused.get_fusion_count(FUSION_LUI_STORE) == 1 && fused.get_fusion_count(FUSION_LUI_LOAD) == 1 &&
+        fused.get_fusion_count(FUSION_COMPARE_BRANCH) == 5;
+    for(int idiom = 0; idiom < FUSION_COUNT; idiom++)
+        counts &= separate.get_fusion_count(FusedIdiom(idiom)) == 0;
+
+    if(results && counts) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+int main()
+{
+    test_cpu_fusion();
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <core/interconnect/bus.hpp>
+#include <core/timer/timer.hpp>
+#include <test_bios.hpp>
+
+#define TEST_BIOS_PATH "cpu_idle_test_bios.bin"
+
+/**
+ * @brief Creates a BIOS that polls a register until bit 0 is set, then stores 1 to 0x0 and spins
+ * 
+ * @param poll Instruction loading the polled register into t1 (base t0 = 0x1f800000)
+ * @param filler Instruction in the load delay slot
+ */
+void create_test_bios(uint32_t poll, uint32_t filler)
+{
+    std::vector<uint32_t> program = {
+        0x3c081f80, //lui t0, 0x1f80
+        poll,       //loop: poll t1
+        filler,
+        0x31290001, //andi t1, t1, 1
+        0x1120fffc, //beq t1, zero, loop
+        0x00000000, //nop
+        0x340a0001, //ori t2, zero, 1
+        0xac0a0000, //sw t2, 0(zero)
+        0x0bf00008, //j 0xbfc00020
+        0x00000000  //nop
+    };
+    write_test_bios(TEST_BIOS_PATH, program);
+}
+
+/**
+ * @brief Tests that a loop polling I_STAT for vblank is skipped up to the interrupt
+ * 
+ */
+void test_cpu_idle_loop()
+{
+    std::cout << "CPU Idle Loop: ";
+    create_test_bios(0x8d091070, 0x00000000); //lw t1, 0x1070(t0); nop
+    Bus bus(TEST_BIOS_PATH);
+
+    for(int i = 0; i < 1000 && bus.read32_cpu(0x0) != 1; i++)
+        bus.clock();
+
+    if(bus.read32_cpu(0x0) == 1 && bus.get_cycles() >= VBLANK_START && bus.get_idle_cycles() > 0) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+/**
+ * @brief Tests that loops carrying state between iterations or reading from a FIFO are not skipped
+ * 
+ */
+void test_cpu_busy_loop()
+{
+    std::cout << "CPU Busy Loop: ";
+    bool busy = true;
+    std::vector<uint32_t> polls = {
+        0x8d091070, //lw t1, 0x1070(t0)
+        0x91091801  //lbu t1, 0x1801(t0)
+    };
+    std::vector<uint32_t> fillers = {
+        0x256b0001, //addiu t3, t3, 1
+        0x00000000  //nop
+    };
+    for(size_t i = 0; i < polls.size(); i++)
+    {
+        create_test_bios(polls[i], fillers[i]);
+        Bus bus(TEST_BIOS_PATH);
+        for(int j = 0; j < 1000; j++)
+            bus.clock();
+        busy &= bus.get_cycles() < VBLANK_START && bus.get_idle_cycles() == 0;
+    }
+
+    if(busy) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+/**
+ * @brief Tests that a busy loop in RAM is analysed again once its code is overwritten
+ * 
+ * The BIOS jumps to a loop at 0x1000 that counts iterations in t3 while polling I_STAT. Replacing the counter with a nop makes it idle.
+ */
+void test_cpu_patched_loop()
+{
+    std::cout << "CPU Patched Loop: ";
+    std::vector<uint32_t> program = {
+        0x3c081f80, //lui t0, 0x1f80
+        0x340a1000, //ori t2, zero, 0x1000
+        0x01400008, //jr t2
+        0x00000000  //nop
+    };
+    write_test_bios(TEST_BIOS_PATH, program);
+
+    Bus bus(TEST_BIOS_PATH);
+    bus.write32_cpu(0x1000, 0x8d091070); //loop: lw t1, 0x1070(t0)
+    bus.write32_cpu(0x1004, 0x256b0001); //addiu t3, t3, 1
+    bus.write32_cpu(0x1008, 0x31290001); //andi t1, t1, 1
+    bus.write32_cpu(0x100c, 0x1120fffc); //beq t1, zero, loop
+    bus.write32_cpu(0x1010, 0x00000000); //nop
+    bus.write32_cpu(0x1014, 0x08000405); //j 0x1014
+    bus.write32_cpu(0x1018, 0x00000000); //nop
+
+    for(int i = 0; i < 1000; i++)
+        bus.clock();
+    bool busy = bus.get_idle_cycles() == 0;
+
+    bus.write32_cpu(0x80001004, 0x00000000); //nop
+    for(int i = 0; i < 1000 && bus.get_idle_cycles() == 0; i++)
+        bus.clock();
+
+    if(busy && bus.get_idle_cycles() > 0) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+int main()
+{
+    test_cpu_idle_loop();
+    test_cpu_busy_loop();
+    test_cpu_patched_loop();
+    return 0;
+}
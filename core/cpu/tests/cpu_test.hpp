@@ -4,6 +4,8 @@
 #include <cstdint>
 #include <vector>
 
+#include <core/cpu/cpu.hpp>
+
 /**
  * @brief Struct to hold a read or write log entry for testing
  * 
@@ -23,35 +25,33 @@ struct RWLogEntry
 };
 
 /**
- * @brief Class to hold the read/write log for testing
+ * @brief Bus policy for testing, records every access of the CPU connected to it
+ * 
+ * Reads return 0xdeadc0de, 0xc0de and 0xde. Every instance has its own log, so several CPUs can be tested in one process.
  * 
  */
-class RWLog
+class MockBus
 {
 public:
-    static RWLog* get_instance();
+    MockBus();
 
-    uint32_t get_read_count();;
+    uint32_t read32_cpu(uint32_t addr);
+    void write32_cpu(uint32_t addr, uint32_t data);
+    uint16_t read16_cpu(uint32_t addr);
+    void write16_cpu(uint32_t addr, uint16_t data);
+    uint8_t read8_cpu(uint32_t addr);
+    void write8_cpu(uint32_t addr, uint8_t data);
+    bool side_effect_free(uint32_t addr);
+    const uint8_t* code_page(uint32_t addr);
+    void mark_code(uint32_t addr, uint32_t size);
+
+    uint32_t get_read_count();
     uint32_t get_write_count();
 
-    void log_read32(uint32_t addr);
-    void log_write32(uint32_t addr, uint32_t data);
-    void log_read16(uint32_t addr);
-    void log_write16(uint32_t addr, uint16_t data);
-    void log_read8(uint32_t addr);
-    void log_write8(uint32_t addr, uint8_t data);
-    
     void clear();
     RWLogEntry get_entry(int index);
     int size();
 
-private:
-    RWLog()
-    {
-        readCount = 0;
-        writeCount = 0;
-    }
-
 private:
     /**
      * @brief Vector to hold the log entries
@@ -70,12 +70,12 @@ private:
      * 
      */
     uint32_t writeCount;
-
-    /**
-     * @brief Singleton instance
-     * 
-     */
-    inline static RWLog* instance;
 };
 
-#endif
\ No newline at end of file
+/**
+ * @brief CPU connected to a mock bus
+ * 
+ */
+using TestCPU = CPUCore<MockBus>;
+
+#endif
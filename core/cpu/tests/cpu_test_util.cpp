@@ -1,122 +1,150 @@
+#include <core/cpu/cpu_impl.hpp>
 #include <cpu_test.hpp>
 
+template class CPUCore<MockBus>;
+
 /**
- * @brief Get the singleton instance
+ * @brief Construct a new MockBus object with an empty log
  * 
- * @return RWLog* 
  */
-RWLog* RWLog::get_instance()
+MockBus::MockBus()
 {
-    if(instance == nullptr)
-    {
-        instance = new RWLog();
-    }
-    return instance;
+    readCount = 0;
+    writeCount = 0;
 }
 
 /**
- * @brief Get the number of reads
+ * @brief Log a read32
  * 
- * @return uint32_t 
+ * @param addr
+ * @return uint32_t
  */
-uint32_t RWLog::get_read_count()
+uint32_t MockBus::read32_cpu(uint32_t addr)
 {
-    return readCount;
+    log.push_back(RWLogEntry(true, addr, 0));
+    readCount++;
+    return 0xdeadc0de;
 }
 
 /**
- * @brief Get the number of writes
+ * @brief Log a write32
  * 
- * @return uint32_t 
+ * @param addr
+ * @param data
  */
-uint32_t RWLog::get_write_count()
+void MockBus::write32_cpu(uint32_t addr, uint32_t data)
 {
-    return writeCount;
+    log.push_back(RWLogEntry(false, addr, data));
+    writeCount++;
 }
 
 /**
- * @brief Log a read32
+ * @brief Log a read16
  * 
- * @param addr 
- * @param data 
+ * @param addr
+ * @return uint16_t
  */
-void RWLog::log_read32(uint32_t addr)
+uint16_t MockBus::read16_cpu(uint32_t addr)
 {
-    RWLogEntry entry(true, addr, 0);
-    log.push_back(entry);
+    log.push_back(RWLogEntry(true, addr, 0));
     readCount++;
+    return 0xc0de;
 }
 
 /**
- * @brief Log a write32
+ * @brief Log a write16
  * 
- * @param addr 
- * @param data 
+ * @param addr
+ * @param data
  */
-void RWLog::log_write32(uint32_t addr, uint32_t data)
+void MockBus::write16_cpu(uint32_t addr, uint16_t data)
 {
-    RWLogEntry entry(false, addr, data);
-    log.push_back(entry);
+    log.push_back(RWLogEntry(false, addr, data));
     writeCount++;
 }
 
 /**
- * @brief Log a read16
+ * @brief Log a read8
  * 
- * @param addr 
- * @param data 
+ * @param addr
+ * @return uint8_t
  */
-void RWLog::log_read16(uint32_t addr)
+uint8_t MockBus::read8_cpu(uint32_t addr)
 {
-    RWLogEntry entry(true, addr, 0);
-    log.push_back(entry);
+    log.push_back(RWLogEntry(true, addr, 0));
     readCount++;
+    return 0xde;
 }
 
 /**
- * @brief Log a write16
+ * @brief Log a write8
  * 
- * @param addr 
- * @param data 
+ * @param addr
+ * @param data
  */
-void RWLog::log_write16(uint32_t addr, uint16_t data)
+void MockBus::write8_cpu(uint32_t addr, uint8_t data)
 {
-    RWLogEntry entry(false, addr, data);
-    log.push_back(entry);
+    log.push_back(RWLogEntry(false, addr, data));
     writeCount++;
 }
 
 /**
- * @brief Log a read8
+ * @brief No address of the mock bus is known to be free of side effects
  * 
- * @param addr 
- * @param data 
+ * @param addr
+ * @return false
  */
-void RWLog::log_read8(uint32_t addr)
+bool MockBus::side_effect_free(uint32_t addr)
 {
-    RWLogEntry entry(true, addr, 0);
-    log.push_back(entry);
-    readCount++;
+    return false;
 }
 
 /**
- * @brief Log a write8
+ * @brief The mock bus has no host pages, all fetches go through read32_cpu
  * 
- * @param addr 
- * @param data 
+ * @param addr
+ * @return const uint8_t*
  */
-void RWLog::log_write8(uint32_t addr, uint8_t data)
+const uint8_t* MockBus::code_page(uint32_t addr)
 {
-    RWLogEntry entry(false, addr, data);
-    log.push_back(entry);
-    writeCount++;
+    return nullptr;
+}
+
+/**
+ * @brief The mock bus does not track writes to code
+ * 
+ * @param addr
+ * @param size
+ */
+void MockBus::mark_code(uint32_t addr, uint32_t size)
+{
+}
+
+/**
+ * @brief Get the number of reads
+ * 
+ * @return uint32_t
+ */
+uint32_t MockBus::get_read_count()
+{
+    return readCount;
+}
+
+/**
+ * @brief Get the number of writes
+ * 
+ * @return uint32_t
+ */
+uint32_t MockBus::get_write_count()
+{
+    return writeCount;
 }
 
 /**
  * @brief Clear the log
  * 
  */
-void RWLog::clear()
+void MockBus::clear()
 {
     log.clear();
 }
@@ -124,10 +152,10 @@ void RWLog::clear()
 /**
  * @brief Get the entry at the given index
  * 
- * @param index 
- * @return RWLogEntry 
+ * @param index
+ * @return RWLogEntry
  */
-RWLogEntry RWLog::get_entry(int index)
+RWLogEntry MockBus::get_entry(int index)
 {
     return log[index];
 }
@@ -135,9 +163,9 @@ RWLogEntry RWLog::get_entry(int index)
 /**
  * @brief Get the size of the log
  * 
- * @return int 
+ * @return int
  */
-int RWLog::size()
+int MockBus::size()
 {
     return log.size();
-}
\ No newline at end of file
+}
@@ -0,0 +1,485 @@
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+
+#include <core/debug/gdb_stub.hpp>
+
+/**
+ * @brief Formats a 32-bit value as the hex of its bytes in target (little endian) order.
+ * 
+ * @param value Value to format
+ * @return std::string 8 hex digits
+ */
+static std::string hex32(uint32_t value)
+{
+    char text[9];
+    snprintf(text, sizeof(text), "%02x%02x%02x%02x", value & 0xff, (value >> 8) & 0xff, (value >> 16) & 0xff, value >> 24);
+    return text;
+}
+
+/**
+ * @brief Parses the hex of the bytes of a 32-bit value in target (little endian) order.
+ * 
+ * @param text At least 8 hex digits
+ * @return uint32_t Value
+ */
+static uint32_t parse_hex32(const std::string& text)
+{
+    uint32_t value = 0;
+    for(int i = 0; i < 4; i++)
+        value |= uint32_t(strtoul(text.substr(i * 2, 2).c_str(), nullptr, 16)) << (i * 8);
+    return value;
+}
+
+/**
+ * @brief Parses an "addr,length" argument.
+ * 
+ * @param args Argument text
+ * @param addr Output address
+ * @param length Output length
+ * @return true The argument was valid
+ * @return false The argument was malformed
+ */
+static bool parse_range(const std::string& args, uint32_t& addr, uint32_t& length)
+{
+    size_t comma = args.find(',');
+    if(comma == std::string::npos)
+        return false;
+    addr = strtoul(args.substr(0, comma).c_str(), nullptr, 16);
+    length = strtoul(args.substr(comma + 1).c_str(), nullptr, 16);
+    return true;
+}
+
+/**
+ * @brief Construct a new GDBStub object
+ * 
+ * The machine stays stopped until the debugger resumes it.
+ * 
+ * @param bus Machine to debug
+ */
+GDBStub::GDBStub(Bus* bus)
+{
+    this->bus = bus;
+    breakpoint_pages.assign(PAGE_COUNT, 0);
+    last_signal = GDB_SIGTRAP;
+    killed = false;
+}
+
+/**
+ * @brief Frames a payload into a packet, with its checksum.
+ * 
+ * @param payload Payload of the packet
+ * @return std::string Packet ready to send
+ */
+std::string GDBStub::frame(const std::string& payload)
+{
+    uint8_t checksum = 0;
+    for(char c : payload)
+        checksum += uint8_t(c);
+    char sum[3];
+    snprintf(sum, sizeof(sum), "%02x", checksum);
+    return "$" + payload + "#" + sum;
+}
+
+/**
+ * @brief Handles the payload of a packet from the debugger.
+ * 
+ * Continue and step packets run the machine and return once it stops.
+ * 
+ * @param packet Payload of the packet
+ * @return std::string Payload of the reply, empty for unsupported packets
+ * 
+ * \b References:
+ * @ref resume
+ * @ref read_registers
+ * @ref write_registers
+ * @ref read_memory
+ * @ref write_memory
+ * @ref breakpoint
+ * @ref query
+ */
+std::string GDBStub::handle_packet(const std::string& packet)
+{
+    if(packet.empty())
+        return "";
+    std::string args = packet.substr(1);
+
+    switch(packet[0])
+    {
+        case '?':
+            return stop_reply(last_signal);
+        case 'c':
+        case 's':
+            if(!args.empty())
+                bus->set_cpu_pc(strtoul(args.c_str(), nullptr, 16));
+            return resume(packet[0] == 's');
+        case 'g':
+            return read_registers();
+        case 'G':
+            return write_registers(args);
+        case 'p':
+            return read_register(args);
+        case 'P':
+            return write_register(args);
+        case 'm':
+            return read_memory(args);
+        case 'M':
+            return write_memory(args);
+        case 'Z':
+        case 'z':
+            return breakpoint(packet[0] == 'Z', args);
+        case 'H':
+        case 'T':
+            return "OK";
+        case 'D':
+            return "OK";
+        case 'k':
+            killed = true;
+            return "";
+        case 'q':
+            return query(packet);
+        default:
+            return "";
+    }
+}
+
+/**
+ * @brief Handles an interrupt request (Ctrl-C) received while the machine is stopped.
+ * 
+ * @return std::string Stop reply
+ */
+std::string GDBStub::interrupt()
+{
+    return stop_reply(GDB_SIGINT);
+}
+
+/**
+ * @brief Builds a stop reply and remembers its signal.
+ * 
+ * @param signal Signal reported to the debugger
+ * @return std::string Stop reply
+ */
+std::string GDBStub::stop_reply(int signal)
+{
+    last_signal = signal;
+    char reply[4];
+    snprintf(reply, sizeof(reply), "S%02x", signal);
+    return reply;
+}
+
+/**
+ * @brief Builds the stop reply for a watchpoint hit.
+ * 
+ * @param hit Access that hit the watchpoint
+ * @return std::string Stop reply with the watched address
+ */
+std::string GDBStub::watch_reply(const WatchHit& hit)
+{
+    last_signal = GDB_SIGTRAP;
+    char reply[32];
+    snprintf(reply, sizeof(reply), "T%02x%s:%08x;", GDB_SIGTRAP, hit.write ? "watch" : "rwatch", hit.addr);
+    return reply;
+}
+
+/**
+ * @brief Runs the machine until a breakpoint, an interrupt request or an error.
+ * 
+ * The first instruction always runs, so that continuing from a breakpoint does not stop on it again. Fusion is enabled again when the machine stops.
+ * 
+ * @param step Whether to stop after one instruction
+ * @return std::string Stop reply
+ * 
+ * \b References:
+ * @ref Bus::clock
+ * @ref Bus::get_cpu_pc
+ * @ref Bus::set_fusion
+ * @ref Bus::take_watch_hit
+ */
+std::string GDBStub::resume(bool step)
+{
+    error.clear();
+    WatchHit hit;
+    try
+    {
+        bus->set_fusion(false);
+        bus->clock();
+        if(bus->take_watch_hit(&hit))
+            return watch_reply(hit);
+        if(step)
+            return stop_reply(GDB_SIGTRAP);
+
+        bool fusion = false;
+        for(uint64_t clocks = 1; ; clocks++)
+        {
+            uint32_t pc = bus->get_cpu_pc();
+            bool trap = breakpoint_pages[page_index(pc)] || breakpoint_pages[page_index(pc + 4)];
+            if(trap && breakpoints.count(pc))
+                break;
+            if(fusion == trap)
+            {
+                fusion = !trap;
+                bus->set_fusion(fusion);
+            }
+            if(clocks % GDB_POLL_INTERVAL == 0 && interrupt_check && interrupt_check())
+            {
+                bus->set_fusion(true);
+                return stop_reply(GDB_SIGINT);
+            }
+            bus->clock();
+            if(bus->take_watch_hit(&hit))
+            {
+                bus->set_fusion(true);
+                return watch_reply(hit);
+            }
+        }
+    }
+    catch(const std::exception& e)
+    {
+        error = e.what();
+        bus->set_fusion(true);
+        return stop_reply(GDB_SIGSEGV);
+    }
+    bus->set_fusion(true);
+    return stop_reply(GDB_SIGTRAP);
+}
+
+/**
+ * @brief Returns the value of a register in GDB numbering.
+ * 
+ * @param index Number of the register
+ * @param state State of the CPU
+ * @return uint32_t Value, 0 for the registers the CPU does not have
+ */
+uint32_t GDBStub::get_register(uint32_t index, CPUState& state)
+{
+    if(index < 32)
+        return state.reg_gen[index];
+    switch(index)
+    {
+        case GDB_REG_STATUS: return state.reg_cop0_status;
+        case GDB_REG_LO: return state.reg_lo;
+        case GDB_REG_HI: return state.reg_hi;
+        case GDB_REG_CAUSE: return state.reg_cop0_cause;
+        case GDB_REG_PC: return bus->get_cpu_pc();
+        default: return 0;
+    }
+}
+
+/**
+ * @brief Sets a register in GDB numbering. The pc is set separately by the callers.
+ * 
+ * @param index Number of the register
+ * @param value Value to set
+ * @param state State of the CPU to modify
+ */
+void GDBStub::set_register(uint32_t index, uint32_t value, CPUState& state)
+{
+    if(index > 0 && index < 32)
+        state.reg_gen[index] = value;
+    switch(index)
+    {
+        case GDB_REG_STATUS: state.reg_cop0_status = value; break;
+        case GDB_REG_LO: state.reg_lo = value; break;
+        case GDB_REG_HI: state.reg_hi = value; break;
+        case GDB_REG_CAUSE: state.reg_cop0_cause = value; break;
+        default: break;
+    }
+}
+
+/**
+ * @brief Handles the g packet.
+ * 
+ * @return std::string All the registers
+ */
+std::string GDBStub::read_registers()
+{
+    CPUState state;
+    bus->get_cpu_state(&state);
+    std::string reply;
+    for(uint32_t i = 0; i < GDB_REGISTER_COUNT; i++)
+        reply += hex32(get_register(i, state));
+    return reply;
+}
+
+/**
+ * @brief Handles the G packet.
+ * 
+ * @param args Values of the registers, from r0 on
+ * @return std::string OK
+ */
+std::string GDBStub::write_registers(const std::string& args)
+{
+    CPUState state;
+    bus->get_cpu_state(&state);
+    uint32_t count = args.size() / 8;
+    for(uint32_t i = 0; i < count && i < GDB_REGISTER_COUNT; i++)
+        set_register(i, parse_hex32(args.substr(i * 8, 8)), state);
+    bus->set_cpu_state(&state);
+    if(count > GDB_REG_PC)
+    {
+        uint32_t pc = parse_hex32(args.substr(GDB_REG_PC * 8, 8));
+        if(pc != bus->get_cpu_pc())
+            bus->set_cpu_pc(pc);
+    }
+    return "OK";
+}
+
+/**
+ * @brief Handles the p packet.
+ * 
+ * @param args Number of the register
+ * @return std::string Value of the register
+ */
+std::string GDBStub::read_register(const std::string& args)
+{
+    CPUState state;
+    bus->get_cpu_state(&state);
+    return hex32(get_register(strtoul(args.c_str(), nullptr, 16), state));
+}
+
+/**
+ * @brief Handles the P packet.
+ * 
+ * @param args "n=value"
+ * @return std::string OK, or E01 if malformed
+ */
+std::string GDBStub::write_register(const std::string& args)
+{
+    size_t equal = args.find('=');
+    if(equal == std::string::npos || args.size() < equal + 9)
+        return "E01";
+    uint32_t index = strtoul(args.substr(0, equal).c_str(), nullptr, 16);
+    uint32_t value = parse_hex32(args.substr(equal + 1, 8));
+    if(index == GDB_REG_PC)
+    {
+        bus->set_cpu_pc(value);
+        return "OK";
+    }
+    CPUState state;
+    bus->get_cpu_state(&state);
+    set_register(index, value, state);
+    bus->set_cpu_state(&state);
+    return "OK";
+}
+
+/**
+ * @brief Handles the m packet.
+ * 
+ * @param args "addr,length"
+ * @return std::string Hex of the bytes, or E01 if any of them is not memory
+ * 
+ * \b References:
+ * @ref Bus::read8_debug
+ */
+std::string GDBStub::read_memory(const std::string& args)
+{
+    uint32_t addr, length;
+    if(!parse_range(args, addr, length) || length > GDB_PACKET_SIZE / 2)
+        return "E01";
+    std::string reply;
+    for(uint32_t i = 0; i < length; i++)
+    {
+        uint8_t data;
+        if(!bus->read8_debug(addr + i, &data))
+            return "E01";
+        char byte[3];
+        snprintf(byte, sizeof(byte), "%02x", data);
+        reply += byte;
+    }
+    return reply;
+}
+
+/**
+ * @brief Handles the M packet.
+ * 
+ * @param args "addr,length:bytes"
+ * @return std::string OK, or E01 if malformed or any byte is not writable memory
+ * 
+ * \b References:
+ * @ref Bus::write8_debug
+ */
+std::string GDBStub::write_memory(const std::string& args)
+{
+    uint32_t addr, length;
+    size_t colon = args.find(':');
+    if(colon == std::string::npos || !parse_range(args.substr(0, colon), addr, length) || args.size() < colon + 1 + length * 2)
+        return "E01";
+    for(uint32_t i = 0; i < length; i++)
+    {
+        uint8_t data = strtoul(args.substr(colon + 1 + i * 2, 2).c_str(), nullptr, 16);
+        if(!bus->write8_debug(addr + i, data))
+            return "E01";
+    }
+    return "OK";
+}
+
+/**
+ * @brief Handles the Z and z packets for breakpoints (0 and 1) and watchpoints (2 write, 3 read, 4 access).
+ * 
+ * Both kinds of breakpoints are kept by the stub, so the code is never patched. Watchpoints are set on the Bus, and only cover RAM.
+ * 
+ * @param insert Whether to insert or remove the breakpoint
+ * @param args "type,addr,kind"
+ * @return std::string OK, E01 if the watchpoint is outside RAM, empty for unsupported types
+ * 
+ * \b References:
+ * @ref Bus::add_watchpoint
+ * @ref Bus::remove_watchpoint
+ */
+std::string GDBStub::breakpoint(bool insert, const std::string& args)
+{
+    if(args.size() < 2 || args[0] < '0' || args[0] > '4' || args[1] != ',')
+        return "";
+    uint32_t addr, kind;
+    if(!parse_range(args.substr(2), addr, kind))
+        return "E01";
+
+    if(args[0] >= '2')
+    {
+        WatchType type = args[0] == '2' ? WATCH_WRITE : args[0] == '3' ? WATCH_READ : WATCH_ACCESS;
+        try
+        {
+            if(insert) bus->add_watchpoint(addr, kind, type, WATCH_STOP);
+            else bus->remove_watchpoint(addr, kind, type);
+        }
+        catch(const std::runtime_error&)
+        {
+            return "E01";
+        }
+        return "OK";
+    }
+
+    if(insert && breakpoints.insert(addr).second)
+        breakpoint_pages[page_index(addr)]++;
+    else if(!insert && breakpoints.erase(addr))
+        breakpoint_pages[page_index(addr)]--;
+    return "OK";
+}
+
+/**
+ * @brief Handles the general query packets.
+ * 
+ * There is a single thread, and the stub always attaches to an existing machine.
+ * 
+ * @param packet Query packet
+ * @return std::string Reply, empty for unsupported queries
+ */
+std::string GDBStub::query(const std::string& packet)
+{
+    if(packet.rfind("qSupported", 0) == 0)
+    {
+        std::stringstream ss;
+        ss << "PacketSize=" << std::hex << GDB_PACKET_SIZE;
+        return ss.str();
+    }
+    if(packet == "qAttached")
+        return "1";
+    if(packet == "qC")
+        return "QC1";
+    if(packet == "qfThreadInfo")
+        return "m1";
+    if(packet == "qsThreadInfo")
+        return "l";
+    return "";
+}
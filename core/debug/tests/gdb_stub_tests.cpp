@@ -0,0 +1,121 @@
+#include <iostream>
+#include <vector>
+
+#include <core/debug/gdb_stub.hpp>
+#include <test_bios.hpp>
+
+#define TEST_BIOS_PATH "gdb_stub_test_bios.bin"
+
+/**
+ * @brief Creates a BIOS that counts the iterations of a loop in t0
+ * 
+ */
+void create_test_bios()
+{
+    std::vector<uint32_t> program = {
+        0x34080000, //ori t0, zero, 0
+        0x25080001, //loop: addiu t0, t0, 1
+        0x0bf00001, //j loop
+        0x00000000  //nop
+    };
+    write_test_bios(TEST_BIOS_PATH, program);
+}
+
+/**
+ * @brief Tests the framing of the packets
+ * 
+ */
+void test_gdb_frame()
+{
+    std::cout << "GDB Packet Framing: ";
+    bool success = GDBStub::frame("OK") == "$OK#9a" && GDBStub::frame("") == "$#00";
+    std::cout << (success ? "Success" : "Failure") << std::endl;
+}
+
+/**
+ * @brief Tests breakpoints, continue and single-step
+ * 
+ * @param stub 
+ */
+void test_gdb_execution(GDBStub& stub)
+{
+    std::cout << "GDB Breakpoints and Stepping: ";
+    bool success = stub.handle_packet("?") == "S05";
+    success = success && stub.handle_packet("Z0,bfc00004,4") == "OK";
+    success = success && stub.handle_packet("c") == "S05" && stub.handle_packet("p25") == "0400c0bf";
+    success = success && stub.handle_packet("c") == "S05" && stub.handle_packet("p25") == "0400c0bf";
+    success = success && stub.handle_packet("p8") == "01000000";
+    success = success && stub.handle_packet("s") == "S05" && stub.handle_packet("p25") == "0800c0bf";
+    success = success && stub.handle_packet("p8") == "02000000";
+    success = success && stub.handle_packet("z0,bfc00004,4") == "OK";
+
+    int polls = 0;
+    stub.set_interrupt_check([&polls]() { return ++polls == 2; });
+    success = success && stub.handle_packet("c") == "S02" && stub.handle_packet("?") == "S02";
+    stub.set_interrupt_check(nullptr);
+    std::cout << (success ? "Success" : "Failure") << std::endl;
+}
+
+/**
+ * @brief Tests register and memory reads and writes
+ * 
+ * @param stub 
+ * @param bus 
+ */
+void test_gdb_access(GDBStub& stub, Bus& bus)
+{
+    std::cout << "GDB Register and Memory Access: ";
+    bool success = stub.handle_packet("g").size() == GDB_REGISTER_COUNT * 8;
+    success = success && stub.handle_packet("P8=78563412") == "OK" && stub.handle_packet("g").substr(8 * 8, 8) == "78563412";
+    success = success && stub.handle_packet("P25=0000c0bf") == "OK" && stub.handle_packet("s") == "S05";
+    success = success && stub.handle_packet("p25") == "0400c0bf" && stub.handle_packet("p8") == "00000000";
+
+    success = success && stub.handle_packet("mbfc00000,4") == "00000834";
+    success = success && stub.handle_packet("M80000100,4:efbeadde") == "OK" && bus.read32_cpu(0x80000100) == 0xdeadbeef;
+    success = success && stub.handle_packet("m00000100,2") == "efbe";
+    //device registers and the BIOS are out of reach
+    success = success && stub.handle_packet("m1f801070,4") == "E01" && stub.handle_packet("Mbfc00000,1:00") == "E01";
+    success = success && stub.handle_packet("Z2,80000100,4") == "OK" && stub.handle_packet("z2,80000100,4") == "OK";
+    success = success && stub.handle_packet("Z4,1f801070,4") == "E01";
+    std::cout << (success ? "Success" : "Failure") << std::endl;
+}
+
+/**
+ * @brief Tests that code patched through memory writes runs, even when it was prefetched and is in the instruction cache
+ * 
+ * @param stub 
+ * @param bus 
+ */
+void test_gdb_patch_code(GDBStub& stub, Bus& bus)
+{
+    std::cout << "GDB Code Patch: ";
+    bus.write32_cpu(0x80000200, 0x34090001); //ori t1, zero, 1
+    bus.write32_cpu(0x80000204, 0x34090002); //ori t1, zero, 2
+    bus.write32_cpu(0x80000208, 0x340a0001); //ori t2, zero, 1
+    bus.write32_cpu(0x8000020c, 0x08000083); //j 0x8000020c
+    bus.write32_cpu(0x80000210, 0x00000000); //nop
+    bus.write32_cpu(0xfffe0130, CACHE_CTRL_ICACHE_ENABLE);
+
+    //the first step caches the line and prefetches 0x80000204
+    bool success = stub.handle_packet("P25=00020080") == "OK" && stub.handle_packet("s") == "S05";
+    success = success && stub.handle_packet("p25") == "04020080";
+    success = success && stub.handle_packet("M80000204,4:03000934") == "OK";
+    success = success && stub.handle_packet("M80000208,4:04000a34") == "OK";
+    success = success && stub.handle_packet("s") == "S05" && stub.handle_packet("p9") == "03000000";
+    success = success && stub.handle_packet("s") == "S05" && stub.handle_packet("pa") == "04000000";
+    bus.write32_cpu(0xfffe0130, 0);
+    std::cout << (success ? "Success" : "Failure") << std::endl;
+}
+
+int main()
+{
+    create_test_bios();
+    Bus bus(TEST_BIOS_PATH);
+    GDBStub stub(&bus);
+
+    test_gdb_frame();
+    test_gdb_execution(stub);
+    test_gdb_access(stub, bus);
+    test_gdb_patch_code(stub, bus);
+    return 0;
+}
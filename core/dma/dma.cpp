@@ -0,0 +1,333 @@
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "core/dma/dma.hpp"
+#include "core/interconnect/bus.hpp"
+
+/**
+ * @brief Construct a new DMA:: DMA object
+ * 
+ * All channels are idle and disabled on reset.
+ */
+DMA::DMA()
+{
+    bus = nullptr;
+    for(DMAChannelState& channel : channels)
+    {
+        channel.madr = 0;
+        channel.bcr = 0;
+        channel.chcr = 0;
+    }
+    channels[DMA_OTC].chcr = DMA_CHCR_BACKWARD;
+    dpcr = DMA_DPCR_RESET;
+    dicr = 0;
+    irq_flag = false;
+}
+
+/**
+ * @brief Reads one of the DMA registers.
+ * 
+ * @param offset Offset from the start of the DMA range
+ * @return uint32_t Value of the register
+ * 
+ * @throw std::runtime_error If the offset does not map to a register
+ */
+uint32_t DMA::read32_cpu(uint32_t offset)
+{
+    if(offset < DMA_REG_DPCR)
+    {
+        DMAChannelState& channel = channels[offset >> 4];
+        switch(offset & 0xf)
+        {
+            case DMA_REG_MADR:
+                return channel.madr;
+            case DMA_REG_BCR:
+                return channel.bcr;
+            case DMA_REG_CHCR:
+                return channel.chcr;
+        }
+    }
+    else if(offset == DMA_REG_DPCR)
+    {
+        return dpcr;
+    }
+    else if(offset == DMA_REG_DICR)
+    {
+        return dicr | (irq_flag ? DMA_DICR_MASTER_FLAG : 0);
+    }
+
+    std::stringstream ss;
+    ss << "Unhandled read from DMA register: 0x" << std::hex << offset;
+    throw std::runtime_error(ss.str());
+}
+
+/**
+ * @brief Writes one of the DMA registers.
+ * 
+ * A channel whose transfer becomes active runs immediately.
+ * 
+ * @param offset Offset from the start of the DMA range
+ * @param data Data to write
+ * 
+ * @throw std::runtime_error If the offset does not map to a register
+ * 
+ * \b References:
+ * @ref active
+ * @ref run
+ * @ref update_irq
+ */
+void DMA::write32_cpu(uint32_t offset, uint32_t data)
+{
+    if(offset < DMA_REG_DPCR)
+    {
+        DMAChannel index = DMAChannel(offset >> 4);
+        DMAChannelState& channel = channels[index];
+        switch(offset & 0xf)
+        {
+            case DMA_REG_MADR:
+                channel.madr = data & 0xffffff;
+                return;
+            case DMA_REG_BCR:
+                channel.bcr = data;
+                return;
+            case DMA_REG_CHCR:
+                //the ordering table clear channel only has the start and trigger bits and always goes backward
+                if(index == DMA_OTC)
+                    channel.chcr = (data & (DMA_CHCR_START | DMA_CHCR_TRIGGER | 0x40000000)) | DMA_CHCR_BACKWARD;
+                else
+                    channel.chcr = data;
+                if(active(index)) run(index);
+                return;
+        }
+    }
+    else if(offset == DMA_REG_DPCR)
+    {
+        dpcr = data;
+        return;
+    }
+    else if(offset == DMA_REG_DICR)
+    {
+        //flags are acknowledged by writing 1 to them
+        uint32_t flags = dicr & 0x7f000000 & ~(data & 0x7f000000);
+        dicr = flags | (data & 0x00ff803f);
+        update_irq();
+        return;
+    }
+
+    std::stringstream ss;
+    ss << "Unhandled write to DMA register: 0x" << std::hex << offset;
+    throw std::runtime_error(ss.str());
+}
+
+/**
+ * @brief Called by a device when it can take or provide data for its channel.
+ * 
+ * Runs the transfer if the channel is waiting for the device.
+ * 
+ * @param channel Channel of the device
+ * 
+ * \b References:
+ * @ref active
+ * @ref run
+ */
+void DMA::request(DMAChannel channel)
+{
+    if(active(channel)) run(channel);
+}
+
+/**
+ * @brief Returns whether a channel is enabled and started.
+ * 
+ * @param channel Channel to check
+ * @return true The channel has a transfer to run
+ * @return false The channel is idle
+ */
+bool DMA::active(DMAChannel channel)
+{
+    uint32_t chcr = channels[channel].chcr;
+    bool enabled = (dpcr >> (channel * 4 + 3)) & 1;
+    bool triggered = ((chcr & DMA_CHCR_SYNC_MASK) >> DMA_CHCR_SYNC_SHIFT) != DMA_SYNC_MANUAL || (chcr & DMA_CHCR_TRIGGER);
+    return enabled && (chcr & DMA_CHCR_START) && triggered;
+}
+
+/**
+ * @brief Runs the transfer of a channel.
+ * 
+ * @param channel Channel to run
+ * 
+ * @throw std::runtime_error If the channel uses linked list mode (GPU command lists)
+ * 
+ * \b References:
+ * @ref clear_ordering_table
+ * @ref transfer_to_device
+ * @ref transfer_from_device
+ * @ref finish
+ */
+void DMA::run(DMAChannel channel)
+{
+    DMAChannelState& state = channels[channel];
+    state.chcr &= ~DMA_CHCR_TRIGGER;
+
+    DMASync sync = DMASync((state.chcr & DMA_CHCR_SYNC_MASK) >> DMA_CHCR_SYNC_SHIFT);
+    uint32_t words;
+    switch(sync)
+    {
+        case DMA_SYNC_MANUAL:
+            words = state.bcr & 0xffff;
+            if(words == 0) words = 0x10000;
+            break;
+        case DMA_SYNC_BLOCK:
+            words = (state.bcr & 0xffff) * (state.bcr >> 16);
+            break;
+        default:
+            std::stringstream ss;
+            ss << "Unhandled DMA sync mode " << sync << " on channel " << channel;
+            throw std::runtime_error(ss.str());
+    }
+
+    if(channel == DMA_OTC)
+    {
+        clear_ordering_table(words);
+    }
+    else if(state.chcr & DMA_CHCR_FROM_RAM)
+    {
+        transfer_to_device(channel, words);
+    }
+    else if(!transfer_from_device(channel, words))
+    {
+        //the device does not have the data yet, wait for its request
+        return;
+    }
+
+    finish(channel);
+}
+
+/**
+ * @brief Copies words from RAM to a device in one block.
+ * 
+ * @param channel Channel of the device
+ * @param words Number of words to transfer
+ * 
+ * \b References:
+ * @ref Bus::read32_dma
+ * @ref Bus::dma_device_write
+ */
+void DMA::transfer_to_device(DMAChannel channel, uint32_t words)
+{
+    DMAChannelState& state = channels[channel];
+    int32_t step = (state.chcr & DMA_CHCR_BACKWARD) ? -4 : 4;
+
+    std::vector<uint32_t> buffer(words);
+    uint32_t addr = state.madr;
+    for(uint32_t i = 0; i < words; i++)
+    {
+        buffer[i] = bus->read32_dma(addr);
+        addr = (addr + step) & 0xffffff;
+    }
+    bus->dma_device_write(channel, buffer.data(), words);
+
+    if(((state.chcr & DMA_CHCR_SYNC_MASK) >> DMA_CHCR_SYNC_SHIFT) == DMA_SYNC_BLOCK)
+    {
+        state.madr = addr;
+        state.bcr &= 0xffff;
+    }
+}
+
+/**
+ * @brief Copies words from a device to RAM.
+ * 
+ * In block mode only the blocks the device can already provide are transferred, and the channel keeps its remaining blocks until the device requests it again.
+ * 
+ * @param channel Channel of the device
+ * @param words Number of words to transfer
+ * @return true The transfer is complete
+ * @return false Blocks are left to transfer
+ * 
+ * \b References:
+ * @ref Bus::dma_device_ready
+ * @ref Bus::dma_device_read
+ * @ref Bus::write32_dma
+ */
+bool DMA::transfer_from_device(DMAChannel channel, uint32_t words)
+{
+    DMAChannelState& state = channels[channel];
+    int32_t step = (state.chcr & DMA_CHCR_BACKWARD) ? -4 : 4;
+    bool block = ((state.chcr & DMA_CHCR_SYNC_MASK) >> DMA_CHCR_SYNC_SHIFT) == DMA_SYNC_BLOCK;
+
+    uint32_t block_size = state.bcr & 0xffff;
+    uint32_t blocks = state.bcr >> 16;
+    if(block)
+    {
+        uint32_t ready = block_size ? bus->dma_device_ready(channel) / block_size : 0;
+        if(ready < blocks) blocks = ready;
+        words = blocks * block_size;
+    }
+
+    std::vector<uint32_t> buffer(words);
+    bus->dma_device_read(channel, buffer.data(), words);
+    uint32_t addr = state.madr;
+    for(uint32_t i = 0; i < words; i++)
+    {
+        bus->write32_dma(addr, buffer[i]);
+        addr = (addr + step) & 0xffffff;
+    }
+
+    if(!block) return true;
+
+    state.madr = addr;
+    state.bcr -= blocks << 16;
+    return (state.bcr >> 16) == 0;
+}
+
+/**
+ * @brief Fills the ordering table used by the GPU with an empty linked list.
+ * 
+ * Every entry points to the previous word, the last one holds the end marker.
+ * 
+ * @param words Number of entries
+ * 
+ * \b References:
+ * @ref Bus::write32_dma
+ */
+void DMA::clear_ordering_table(uint32_t words)
+{
+    uint32_t addr = channels[DMA_OTC].madr;
+    for(uint32_t i = 0; i < words; i++)
+    {
+        uint32_t next = (i == words - 1) ? 0xffffff : ((addr - 4) & 0x1fffff);
+        bus->write32_dma(addr, next);
+        addr = (addr - 4) & 0xffffff;
+    }
+}
+
+/**
+ * @brief Ends the transfer of a channel and sets its interrupt flag.
+ * 
+ * @param channel Channel that finished
+ * 
+ * \b References:
+ * @ref update_irq
+ */
+void DMA::finish(DMAChannel channel)
+{
+    channels[channel].chcr &= ~(DMA_CHCR_START | DMA_CHCR_TRIGGER);
+    if(dicr & (1 << (DMA_DICR_ENABLE_SHIFT + channel)))
+        dicr |= 1 << (DMA_DICR_FLAG_SHIFT + channel);
+    update_irq();
+}
+
+/**
+ * @brief Recomputes the master interrupt flag and raises the DMA interrupt on its rising edge.
+ * 
+ * \b References:
+ * @ref Bus::raise_irq
+ */
+void DMA::update_irq()
+{
+    uint32_t flags = (dicr >> DMA_DICR_FLAG_SHIFT) & (dicr >> DMA_DICR_ENABLE_SHIFT) & 0x7f;
+    bool flag = (dicr & DMA_DICR_FORCE) || ((dicr & DMA_DICR_MASTER_ENABLE) && flags);
+    if(flag && !irq_flag)
+        bus->raise_irq(IRQ_DMA);
+    irq_flag = flag;
+}
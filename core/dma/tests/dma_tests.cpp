@@ -0,0 +1,63 @@
+#include <iostream>
+
+#include <core/interconnect/bus.hpp>
+#include <core/dma/dma.hpp>
+#include <test_bios.hpp>
+
+#define TEST_BIOS_PATH "dma_test_bios.bin"
+#define DMA_BASE 0x1f801080
+#define I_STAT_ADDR 0x1f801070
+
+/**
+ * @brief Tests that channel 6 builds an empty ordering table backwards from MADR
+ * 
+ * @param bus 
+ */
+void test_dma_otc(Bus& bus)
+{
+    std::cout << "DMA Ordering Table Clear: ";
+    bus.write32_cpu(DMA_BASE + DMA_REG_DPCR, DMA_DPCR_RESET | (8 << (DMA_OTC * 4)));
+    bus.write32_cpu(DMA_BASE + DMA_OTC * 0x10 + DMA_REG_MADR, 0x1000);
+    bus.write32_cpu(DMA_BASE + DMA_OTC * 0x10 + DMA_REG_BCR, 4);
+    bus.write32_cpu(DMA_BASE + DMA_OTC * 0x10 + DMA_REG_CHCR, DMA_CHCR_START | DMA_CHCR_TRIGGER);
+
+    bool table = bus.read32_cpu(0x1000) == 0xffc && bus.read32_cpu(0xffc) == 0xff8 && bus.read32_cpu(0xff8) == 0xff4 && bus.read32_cpu(0xff4) == 0xffffff;
+    bool done = (bus.read32_cpu(DMA_BASE + DMA_OTC * 0x10 + DMA_REG_CHCR) & DMA_CHCR_START) == 0;
+    if(table && done) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+/**
+ * @brief Tests that a finished transfer sets its DICR flag and raises the DMA interrupt until acknowledged
+ * 
+ * @param bus 
+ */
+void test_dma_irq(Bus& bus)
+{
+    std::cout << "DMA Interrupt: ";
+    bus.write32_cpu(I_STAT_ADDR, 0);
+    bus.write32_cpu(DMA_BASE + DMA_REG_DICR, DMA_DICR_MASTER_ENABLE | (1 << (DMA_DICR_ENABLE_SHIFT + DMA_OTC)));
+    bus.write32_cpu(DMA_BASE + DMA_OTC * 0x10 + DMA_REG_MADR, 0x2000);
+    bus.write32_cpu(DMA_BASE + DMA_OTC * 0x10 + DMA_REG_BCR, 16);
+    bus.write32_cpu(DMA_BASE + DMA_OTC * 0x10 + DMA_REG_CHCR, DMA_CHCR_START | DMA_CHCR_TRIGGER);
+
+    uint32_t dicr = bus.read32_cpu(DMA_BASE + DMA_REG_DICR);
+    bool flagged = (dicr & DMA_DICR_MASTER_FLAG) && (dicr & (1 << (DMA_DICR_FLAG_SHIFT + DMA_OTC)));
+    bool raised = bus.read32_cpu(I_STAT_ADDR) & (1 << IRQ_DMA);
+
+    //acknowledge the channel flag
+    bus.write32_cpu(DMA_BASE + DMA_REG_DICR, dicr);
+    bool cleared = (bus.read32_cpu(DMA_BASE + DMA_REG_DICR) & (DMA_DICR_MASTER_FLAG | (1 << (DMA_DICR_FLAG_SHIFT + DMA_OTC)))) == 0;
+    if(flagged && raised && cleared) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+int main()
+{
+    write_test_bios(TEST_BIOS_PATH, {0x0bf00000, 0x00000000}); //j 0xbfc00000
+    Bus bus(TEST_BIOS_PATH);
+
+    test_dma_otc(bus);
+    test_dma_irq(bus);
+    return 0;
+}
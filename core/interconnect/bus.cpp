@@ -1,33 +1,181 @@
+#include <cstring>
 #include <iostream>
 #include <sstream>
 
 #include "core/interconnect/bus.hpp"
+#include "core/logging/logging.hpp"
 #include "core/bios/bios.hpp"
 #include "core/cpu/cpu.hpp"
 #include "core/memory/ram.hpp"
+#include "core/interrupt/interrupt.hpp"
+#include "core/timer/timer.hpp"
+#include "core/spu/spu.hpp"
+#include "core/cdrom/cdrom.hpp"
+#include "core/dma/dma.hpp"
+#include "core/mdec/mdec.hpp"
+#include "core/sio/sio.hpp"
+
+/**
+ * @brief Returns the size of the arena of a machine.
+ * 
+ * @return size_t Size in bytes
+ */
+static size_t machine_arena_size()
+{
+    return arena_size<CPU>() + 2 * arena_size<uint8_t*>(PAGE_COUNT) +
+        arena_size<RAM>() + RAM::arena_size(RAM_SIZE) + arena_size<BIOS>() + BIOS::arena_size() +
+        arena_size<InterruptController>() + arena_size<Timers>() + arena_size<SPU>() + SPU::arena_size() + arena_size<CDROM>() +
+        arena_size<DMA>() + arena_size<MDEC>() + arena_size<SIO0>() + arena_size<Scheduler>();
+}
 
 /**
  * @brief Construct a new Bus:: Bus object
  * 
+ * The components are created in the arena in order of how hot they are: the CPU, with its registers and dispatch state, is followed by the page tables every load and store goes through, then the RAM and the BIOS.
+ * 
  * @param bios_path Path to the BIOS file
  * 
  * \b References:
  * @ref CPU::CPU
  * @ref BIOS::BIOS
  * @ref RAM::RAM
- * @ref CPU::connectBus
+ * @ref InterruptController::InterruptController
+ * @ref Timers::Timers
+ * @ref SPU::SPU
+ * @ref CDROM::CDROM
+ * @ref DMA::DMA
+ * @ref MDEC::MDEC
+ * @ref SIO0::SIO0
+ * @ref Scheduler::Scheduler
+ * @ref Arena::create
+ * @ref connect_components
  */
-Bus::Bus(std::string bios_path)
+Bus::Bus(std::string bios_path) : arena(machine_arena_size())
 {
-    cpu = new CPU();
-    bios = new BIOS(bios_path);
-    ram = new RAM(2 * 1024 * 1024);
+    cpu = arena.create<CPU>();
+    read_pages = arena.create_array<uint8_t*>(PAGE_COUNT);
+    write_pages = arena.create_array<uint8_t*>(PAGE_COUNT);
+    ram = arena.create<RAM>(arena, RAM_SIZE);
+    bios = arena.create<BIOS>(arena, bios_path);
+    interrupt = arena.create<InterruptController>();
+    timers = arena.create<Timers>();
+    spu = arena.create<SPU>(arena);
+    cdrom = arena.create<CDROM>();
+    dma = arena.create<DMA>();
+    mdec = arena.create<MDEC>();
+    sio0 = arena.create<SIO0>();
+    scheduler = arena.create<Scheduler>();
+
+    cycle_model = false;
+    deterministic = false;
+    frames = 0;
+    idle_cycles = 0;
+    fusion = true;
+    monitor = nullptr;
+    watch_stopped = false;
+    cpu->set_idle_skip(true);
+    memset(scratchpad, 0, sizeof(scratchpad));
+    connect_components();
+
+    scheduler->schedule(EVENT_VBLANK, VBLANK_START);
+    scheduler->schedule(EVENT_SPU, SPU_CYCLES_PER_BLOCK);
+}
 
+/**
+ * @brief Construct a new Bus:: Bus object forked from another Bus
+ * 
+ * Copies the state of every component of the parent. The RAM, the BIOS and the sound RAM are shared copy-on-write, so they cost nothing to copy. The parent pays once for the pages it wrote since it was last forked. The child has no monitor and no coverage map, no pad poll callback, and reads the disc of the parent through its own reader.
+ * 
+ * @param parent Bus to fork
+ * 
+ * \b References:
+ * @ref RAM::RAM
+ * @ref BIOS::BIOS
+ * @ref SPU::SPU
+ * @ref connect_components
+ * @ref map_pages
+ */
+Bus::Bus(Bus* parent) : arena(machine_arena_size())
+{
+    cpu = arena.create<CPU>(*parent->cpu);
+    read_pages = arena.create_array<uint8_t*>(PAGE_COUNT);
+    write_pages = arena.create_array<uint8_t*>(PAGE_COUNT);
+    ram = arena.create<RAM>(arena, *parent->ram);
+    bios = arena.create<BIOS>(arena, *parent->bios);
+    //the pages of the parent moved to shared memory
+    parent->map_pages();
+    interrupt = arena.create<InterruptController>(*parent->interrupt);
+    timers = arena.create<Timers>(*parent->timers);
+    spu = arena.create<SPU>(arena, *parent->spu);
+    cdrom = arena.create<CDROM>(*parent->cdrom);
+    dma = arena.create<DMA>(*parent->dma);
+    mdec = arena.create<MDEC>(*parent->mdec);
+    sio0 = arena.create<SIO0>(*parent->sio0);
+    scheduler = arena.create<Scheduler>(*parent->scheduler);
+
+    cycle_model = parent->cycle_model;
+    deterministic = parent->deterministic;
+    frames = parent->frames;
+    idle_cycles = parent->idle_cycles;
+    fusion = parent->fusion;
+    monitor = nullptr;
+    watchpoints = parent->watchpoints;
+    watch_stopped = false;
+    cpu->set_coverage(nullptr);
+    sio0->set_poll_callback(nullptr);
+    memcpy(scratchpad, parent->scratchpad, sizeof(scratchpad));
+    connect_components();
+}
+
+/**
+ * @brief Forks the machine.
+ * 
+ * The child runs on from the current state of this machine, independently of it. Either may be destroyed first.
+ * 
+ * @return std::unique_ptr<Bus> New machine
+ */
+std::unique_ptr<Bus> Bus::fork()
+{
+    return std::unique_ptr<Bus>(new Bus(this));
+}
+
+/**
+ * @brief Connects the components to the Bus and fills the page tables.
+ * 
+ * \b References:
+ * @ref CPU::connectBus
+ * @ref Timers::connectBus
+ * @ref SPU::connectBus
+ * @ref CDROM::connectBus
+ * @ref DMA::connectBus
+ * @ref MDEC::connectBus
+ * @ref SIO0::connectBus
+ * @ref RAM::set_code_write_callback
+ * @ref RAM::set_unshare_callback
+ * @ref map_pages
+ */
+void Bus::connect_components()
+{
     cpu->connectBus(this);
+    timers->connectBus(this);
+    spu->connectBus(this);
+    cdrom->connectBus(this);
+    dma->connectBus(this);
+    mdec->connectBus(this);
+    sio0->connectBus(this);
+
+    ram->set_code_write_callback([this](uint32_t offset, uint32_t size) {
+        cpu->invalidate_code(ram_range.start + offset, size);
+    });
+    ram->set_unshare_callback([this](uint32_t page) {
+        map_ram_page(page);
+        cpu->flush_code_page();
+    });
+    map_pages();
 }
 
 /**
- * @brief Reads a 32-bit word from the given address
+ * @brief Reads a 32-bit word from an address outside the scratchpad and the page table
  * 
  * TODO: Map all addresses.
  * 
@@ -40,11 +188,19 @@ Bus::Bus(std::string bios_path)
  * \b References:
  * @ref BIOS::read32_cpu
  * @ref RAM::read32_cpu
+ * @ref CPU::get_cache_control
+ * @ref InterruptController::read32_cpu
+ * @ref Timers::read32_cpu
+ * @ref SPU::read16_cpu
+ * @ref DMA::read32_cpu
+ * @ref MDEC::read32_cpu
+ * @ref SIO0::read32_cpu
+ * @ref watch_access
  * @ref Range::contains
  * @ref Range::offset
  * @ref region_mask
  */
-uint32_t Bus::read32_cpu(uint32_t addr)
+uint32_t Bus::read32_io(uint32_t addr)
 {
     //catch unaligned accesses
     if (addr % 4 != 0)
@@ -64,13 +220,37 @@ uint32_t Bus::read32_cpu(uint32_t addr)
     }
     else if(ram_range.contains(addr))
     {
+        watch_access(addr_og, ram_range.offset(addr), 4, false, 0);
         return ram->read32_cpu(ram_range.offset(addr));
     }
+    else if(cache_ctrl_range.contains(addr))
+    {
+        return cpu->get_cache_control();
+    }
     else if(interrupt_range.contains(addr))
     {
-        std::cout << "Unhandled Interrupt Control Read: Just returning 0" << std::endl;
-        // TODO: Implement interrupts
-        return 0;
+        return interrupt->read32_cpu(interrupt_range.offset(addr));
+    }
+    else if(timer_range.contains(addr))
+    {
+        return timers->read32_cpu(timer_range.offset(addr));
+    }
+    else if(spu_range.contains(addr))
+    {
+        uint32_t offset = spu_range.offset(addr);
+        return spu->read16_cpu(offset) | (uint32_t(spu->read16_cpu(offset + 2)) << 16);
+    }
+    else if(dma_range.contains(addr))
+    {
+        return dma->read32_cpu(dma_range.offset(addr));
+    }
+    else if(mdec_range.contains(addr))
+    {
+        return mdec->read32_cpu(mdec_range.offset(addr));
+    }
+    else if(sio0_range.contains(addr))
+    {
+        return sio0->read32_cpu(sio0_range.offset(addr));
     }
 
     //throw a runtime error with the unmapped address converted to hex
@@ -80,7 +260,7 @@ uint32_t Bus::read32_cpu(uint32_t addr)
 }
 
 /**
- * @brief Writes a 32-bit word to the given address
+ * @brief Writes a 32-bit word to an address outside the scratchpad and the page table
  * 
  * TODO: Map all addresses.
  * 
@@ -93,11 +273,20 @@ uint32_t Bus::read32_cpu(uint32_t addr)
  * 
  * \b References:
  * @ref RAM::write32_cpu
+ * @ref CPU::set_cache_control
+ * @ref InterruptController::write32_cpu
+ * @ref Timers::write32_cpu
+ * @ref SPU::write16_cpu
+ * @ref DMA::write32_cpu
+ * @ref MDEC::write32_cpu
+ * @ref SIO0::write32_cpu
+ * @ref update_irq
+ * @ref watch_access
  * @ref Range::contains
  * @ref Range::offset
  * @ref region_mask
  */
-void Bus::write32_cpu(uint32_t addr, uint32_t data)
+void Bus::write32_io(uint32_t addr, uint32_t data)
 {
     //catch unaligned accesses
     if (addr % 4 != 0)
@@ -132,9 +321,7 @@ void Bus::write32_cpu(uint32_t addr, uint32_t data)
                 }
                 break;
             default:
-                std::stringstream ss;
-                ss << "Unhandled write to MEM_CTRL register: " << addr;
-                // throw std::runtime_error(ss.str());
+                LOG_LIMIT(16, LOG_LEVEL_WARN, LOG_BUS, "Unhandled write to MEM_CTRL register 0x{:x}: 0x{:x}", addr, data);
                 break;
         }
         return;
@@ -146,18 +333,46 @@ void Bus::write32_cpu(uint32_t addr, uint32_t data)
     }
     else if(cache_ctrl_range.contains(addr))
     {
-        //TODO: implement cache control register
+        cpu->set_cache_control(data);
         return;
     }
     else if(ram_range.contains(addr))
     {
+        watch_access(addr_og, ram_range.offset(addr), 4, true, data);
         ram->write32_cpu(ram_range.offset(addr), data);
         return;
     }
     else if(interrupt_range.contains(addr))
     {
-        //Implement peripherals and interrupts
-        std::cout << "Ignoring write32 to Interrupt Register" << std::endl;
+        interrupt->write32_cpu(interrupt_range.offset(addr), data);
+        update_irq();
+        return;
+    }
+    else if(timer_range.contains(addr))
+    {
+        timers->write32_cpu(timer_range.offset(addr), data);
+        return;
+    }
+    else if(spu_range.contains(addr))
+    {
+        uint32_t offset = spu_range.offset(addr);
+        spu->write16_cpu(offset, data & 0xffff);
+        spu->write16_cpu(offset + 2, data >> 16);
+        return;
+    }
+    else if(dma_range.contains(addr))
+    {
+        dma->write32_cpu(dma_range.offset(addr), data);
+        return;
+    }
+    else if(mdec_range.contains(addr))
+    {
+        mdec->write32_cpu(mdec_range.offset(addr), data);
+        return;
+    }
+    else if(sio0_range.contains(addr))
+    {
+        sio0->write32_cpu(sio0_range.offset(addr), data);
         return;
     }
 
@@ -168,7 +383,7 @@ void Bus::write32_cpu(uint32_t addr, uint32_t data)
 }
 
 /**
- * @brief Reads a 16-bit word from the given address
+ * @brief Reads a 16-bit word from an address outside the scratchpad and the page table
  * 
  * TODO: Map all addresses.
  * 
@@ -179,11 +394,16 @@ void Bus::write32_cpu(uint32_t addr, uint32_t data)
  * @throw std::runtime_error If the address is unmapped
  * 
  * \b References:
+ * @ref InterruptController::read32_cpu
+ * @ref Timers::read32_cpu
+ * @ref SPU::read16_cpu
+ * @ref SIO0::read32_cpu
+ * @ref watch_access
  * @ref Range::contains
  * @ref Range::offset
  * @ref region_mask
  */
-uint16_t Bus::read16_cpu(uint32_t addr)
+uint16_t Bus::read16_io(uint32_t addr)
 {
     //catch unaligned accesses
     if (addr % 2 != 0)
@@ -197,6 +417,28 @@ uint16_t Bus::read16_cpu(uint32_t addr)
     uint32_t addr_og = addr;
     addr &= region_mask(addr);
 
+    if(ram_range.contains(addr))
+    {
+        watch_access(addr_og, ram_range.offset(addr), 2, false, 0);
+        return ram->read16_cpu(ram_range.offset(addr));
+    }
+    else if(interrupt_range.contains(addr))
+    {
+        return interrupt->read32_cpu(interrupt_range.offset(addr));
+    }
+    else if(timer_range.contains(addr))
+    {
+        return timers->read32_cpu(timer_range.offset(addr));
+    }
+    else if(spu_range.contains(addr))
+    {
+        return spu->read16_cpu(spu_range.offset(addr));
+    }
+    else if(sio0_range.contains(addr))
+    {
+        return sio0->read32_cpu(sio0_range.offset(addr));
+    }
+
     //throw a runtime error with the unmapped address converted to hex
     std::stringstream ss;
     ss << "Unmapped address for read16_cpu: 0x" << std::hex << addr_og;
@@ -204,7 +446,7 @@ uint16_t Bus::read16_cpu(uint32_t addr)
 }
 
 /**
- * @brief Writes a 16-bit word to the given address
+ * @brief Writes a 16-bit word to an address outside the scratchpad and the page table
  * 
  * TODO: Map all addresses.
  * 
@@ -215,11 +457,17 @@ uint16_t Bus::read16_cpu(uint32_t addr)
  * @throw std::runtime_error If the address is unmapped
  * 
  * \b References:
+ * @ref SPU::write16_cpu
+ * @ref InterruptController::write32_cpu
+ * @ref Timers::write32_cpu
+ * @ref SIO0::write32_cpu
+ * @ref update_irq
+ * @ref watch_access
  * @ref Range::contains
  * @ref Range::offset
  * @ref region_mask
  */
-void Bus::write16_cpu(uint32_t addr, uint16_t data)
+void Bus::write16_io(uint32_t addr, uint16_t data)
 {
     //catch unaligned accesses
     if (addr % 2 != 0)
@@ -233,35 +481,42 @@ void Bus::write16_cpu(uint32_t addr, uint16_t data)
     uint32_t addr_og = addr;
     addr &= region_mask(addr);
 
-    if(spu_range.contains(addr))
+    if(ram_range.contains(addr))
     {
-        //TODO: Implement SPU
-        switch(spu_range.offset(addr))
-        {
-            default:
-                std::stringstream ss;
-                ss << "Unhandled write16 (" << data << ") to SPU register: " << addr_og;
-                // throw std::runtime_error(ss.str());
-                break;
-        }
-
+        watch_access(addr_og, ram_range.offset(addr), 2, true, data);
+        ram->write16_cpu(ram_range.offset(addr), data);
+        return;
+    }
+    else if(spu_range.contains(addr))
+    {
+        spu->write16_cpu(spu_range.offset(addr), data);
         return;
     }
     else if(timer_range.contains(addr))
     {
-        //TODO implement timer
-        std::cout << "Ignoring write16 to Timer Register" << std::endl;
+        timers->write32_cpu(timer_range.offset(addr), data);
+        return;
+    }
+    else if(interrupt_range.contains(addr))
+    {
+        interrupt->write32_cpu(interrupt_range.offset(addr), data);
+        update_irq();
+        return;
+    }
+    else if(sio0_range.contains(addr))
+    {
+        sio0->write32_cpu(sio0_range.offset(addr), data);
         return;
     }
 
     //throw a runtime error with the unmapped address converted to hex
     std::stringstream ss;
-    ss << "Unmapped address for write16_cpu: 0x" << std::hex << addr;
+    ss << "Unmapped address for write16_cpu: 0x" << std::hex << addr_og;
     throw std::runtime_error(ss.str());
 }
 
 /**
- * @brief Reads a 8-bit word from the given address
+ * @brief Reads a 8-bit word from an address outside the scratchpad and the page table
  * 
  * TODO: Implement Expansion Region 1.
  * TODO: Map all addresses.
@@ -274,11 +529,14 @@ void Bus::write16_cpu(uint32_t addr, uint16_t data)
  * \b References:
  * @ref BIOS::read32_cpu
  * @ref RAM::read8_cpu
+ * @ref CDROM::read8_cpu
+ * @ref SIO0::read32_cpu
+ * @ref watch_access
  * @ref Range::contains
  * @ref Range::offset
  * @ref region_mask
  */
-uint8_t Bus::read8_cpu(uint32_t addr)
+uint8_t Bus::read8_io(uint32_t addr)
 {
     uint32_t addr_og = addr;
     addr &= region_mask(addr);
@@ -294,8 +552,17 @@ uint8_t Bus::read8_cpu(uint32_t addr)
     }
     else if(ram_range.contains(addr))
     {
+        watch_access(addr_og, ram_range.offset(addr), 1, false, 0);
         return ram->read8_cpu(ram_range.offset(addr));
     }
+    else if(cdrom_range.contains(addr))
+    {
+        return cdrom->read8_cpu(cdrom_range.offset(addr));
+    }
+    else if(sio0_range.contains(addr))
+    {
+        return sio0->read32_cpu(sio0_range.offset(addr));
+    }
 
     //throw a runtime error with the unmapped address converted to hex
     std::stringstream ss;
@@ -304,8 +571,8 @@ uint8_t Bus::read8_cpu(uint32_t addr)
 }
 
 /**
- * @brief Writes a 8-bit word to the given address
- *
+ * @brief Writes a 8-bit word to an address outside the scratchpad and the page table
+ * 
  * TODO: Implement Expansion Region 2.
  * TODO: Map all addresses.
  * 
@@ -316,24 +583,38 @@ uint8_t Bus::read8_cpu(uint32_t addr)
  * 
  * \b References:
  * @ref RAM::write8_cpu
+ * @ref CDROM::write8_cpu
+ * @ref SIO0::write32_cpu
+ * @ref watch_access
  * @ref Range::contains
  * @ref Range::offset
  * @ref region_mask
  */
-void Bus::write8_cpu(uint32_t addr, uint8_t data)
+void Bus::write8_io(uint32_t addr, uint8_t data)
 {
     uint32_t addr_og = addr;
     addr &= region_mask(addr);
 
     if(expansion2_range.contains(addr))
     {
-        std::cout << "Ignoring write8 to Expansion 2" << std::endl;
+        LOG_LIMIT(16, LOG_LEVEL_DEBUG, LOG_BUS, "Ignoring write8 to Expansion 2 0x{:x}: 0x{:x}", addr, data);
         return;
     }
     else if(ram_range.contains(addr))
     {
+        watch_access(addr_og, ram_range.offset(addr), 1, true, data);
         return ram->write8_cpu(ram_range.offset(addr), data);
     }
+    else if(cdrom_range.contains(addr))
+    {
+        cdrom->write8_cpu(cdrom_range.offset(addr), data);
+        return;
+    }
+    else if(sio0_range.contains(addr))
+    {
+        sio0->write32_cpu(sio0_range.offset(addr), data);
+        return;
+    }
 
     //throw a runtime error with the unmapped address converted to hex
     std::stringstream ss;
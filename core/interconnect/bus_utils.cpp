@@ -1,5 +1,19 @@
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
 #include <core/interconnect/bus.hpp>
 #include <core/cpu/cpu.hpp>
+#include <core/interrupt/interrupt.hpp>
+#include <core/timer/timer.hpp>
+#include <core/spu/spu.hpp>
+#include <core/cdrom/cdrom.hpp>
+#include <core/dma/dma.hpp>
+#include <core/mdec/mdec.hpp>
+#include <core/sio/sio.hpp>
+#include <core/logging/logging.hpp>
+#include <core/memory/ram.hpp>
+#include <core/bios/bios.hpp>
 
 /**
  * @brief Returns the region mask for a given address
@@ -41,10 +55,951 @@ uint32_t Bus::region_mask(uint32_t addr)
  * @brief Clocks the PSX
  * 
  * Clocks all the components of the PSX and serves as a synchronization point between the components.
+ * Advances the global cycle count and handles the events that have become due. Every instruction takes CYCLES_PER_INSTRUCTION cycles, or the cost of its fetch when the cycle model is enabled.
+ * The CPU may execute a fused pair of instructions in one clock when the next event is far enough away that it could not have become due between them.
+ * If the instruction closed an iteration of an idle loop, the cycle count jumps straight to the next event.
  * 
+ * @ref CPU::set_fusion_window
  * @ref CPU::clock
+ * @ref CPU::get_fetch_cycles
+ * @ref CPU::get_executed
+ * @ref CPU::in_idle_loop
+ * @ref Scheduler::advance
+ * @ref Scheduler::next_event
+ * @ref Scheduler::event_due
+ * @ref Scheduler::pop_event
+ * @ref handle_event
  */
 void Bus::clock()
 {
+    //a fused pair must not run past an event that becomes due after its first instruction
+    uint64_t first_cycles = cycle_model ? CYCLES_MAX_FETCH : CYCLES_PER_INSTRUCTION;
+    cpu->set_fusion_window(fusion && scheduler->next_event() - scheduler->now() > first_cycles);
     cpu->clock();
-}
\ No newline at end of file
+
+    scheduler->advance(cycle_model ? cpu->get_fetch_cycles() : CYCLES_PER_INSTRUCTION * cpu->get_executed());
+    if(cpu->in_idle_loop() && scheduler->next_event() != EVENT_NEVER && !scheduler->event_due())
+    {
+        uint64_t skipped = scheduler->next_event() - scheduler->now();
+        scheduler->advance(skipped);
+        idle_cycles += skipped;
+    }
+    while(scheduler->event_due())
+        handle_event(scheduler->pop_event());
+}
+
+/**
+ * @brief Dispatches a due event to the component that scheduled it.
+ * 
+ * TODO: Move the vblank interrupt to the GPU once it is implemented.
+ * 
+ * @param event Event that is due
+ * 
+ * \b References:
+ * @ref Timers::handle_event
+ * @ref SPU::handle_event
+ * @ref CDROM::handle_command_event
+ * @ref CDROM::handle_drive_event
+ * @ref SIO0::handle_event
+ * @ref raise_irq
+ */
+void Bus::handle_event(Event event)
+{
+    switch(event)
+    {
+        case EVENT_VBLANK:
+            frames++;
+            raise_irq(IRQ_VBLANK);
+            publish_state();
+            scheduler->schedule(EVENT_VBLANK, scheduler->now() + CYCLES_PER_FRAME);
+            break;
+        case EVENT_TIMER0:
+        case EVENT_TIMER1:
+        case EVENT_TIMER2:
+            timers->handle_event(event - EVENT_TIMER0);
+            break;
+        case EVENT_SPU:
+            spu->handle_event();
+            break;
+        case EVENT_CDROM_COMMAND:
+            cdrom->handle_command_event();
+            break;
+        case EVENT_CDROM_DRIVE:
+            cdrom->handle_drive_event();
+            break;
+        case EVENT_SIO0:
+            sio0->handle_event();
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Returns the global cycle count.
+ * 
+ * @return uint64_t Number of CPU cycles since reset
+ * 
+ * \b References:
+ * @ref Scheduler::now
+ */
+uint64_t Bus::get_cycles()
+{
+    return scheduler->now();
+}
+
+/**
+ * @brief Schedules an event on the global timeline.
+ * 
+ * @param event Event to schedule
+ * @param time Cycle count at which the event is due
+ * 
+ * \b References:
+ * @ref Scheduler::schedule
+ */
+void Bus::schedule_event(Event event, uint64_t time)
+{
+    scheduler->schedule(event, time);
+}
+
+/**
+ * @brief Removes an event from the global timeline.
+ * 
+ * @param event Event to cancel
+ * 
+ * \b References:
+ * @ref Scheduler::cancel
+ */
+void Bus::cancel_event(Event event)
+{
+    scheduler->cancel(event);
+}
+
+/**
+ * @brief Raises an interrupt line of the interrupt controller.
+ * 
+ * Used by the devices connected to the Bus to request an interrupt.
+ * 
+ * @param irq Interrupt line to raise
+ * 
+ * \b References:
+ * @ref InterruptController::raise
+ * @ref update_irq
+ */
+void Bus::raise_irq(IRQ irq)
+{
+    interrupt->raise(irq);
+    update_irq();
+}
+
+/**
+ * @brief Forwards the output of the interrupt controller to the CPU.
+ * 
+ * Called only when the state of the interrupt controller changes.
+ * 
+ * \b References:
+ * @ref InterruptController::pending
+ * @ref CPU::set_irq
+ */
+void Bus::update_irq()
+{
+    cpu->set_irq(interrupt->pending());
+}
+
+/**
+ * @brief Sets the consumer of the audio produced by the SPU.
+ * 
+ * The sink is not owned by the Bus and must outlive it.
+ * 
+ * @param sink Pointer to the audio sink
+ * 
+ * \b References:
+ * @ref SPU::connectSink
+ */
+void Bus::set_audio_sink(AudioSink* sink)
+{
+    spu->connectSink(sink);
+}
+
+/**
+ * @brief Inserts a disc image into the CD-ROM drive.
+ * 
+ * @param path Path to the CUE sheet, ISO file or compressed image
+ * @param read_ahead Number of sectors read ahead of the drive head by the reader thread
+ * 
+ * @throw std::runtime_error If the disc image cannot be opened
+ * 
+ * \b References:
+ * @ref open_disc
+ * @ref CDROM::insert_disc
+ */
+void Bus::load_disc(std::string path, uint32_t read_ahead)
+{
+    cdrom->insert_disc(open_disc(path), read_ahead);
+}
+
+/**
+ * @brief Reads a word from RAM for a DMA transfer.
+ * 
+ * @param addr Address in RAM (wraps around the 2MB)
+ * @return uint32_t Data read from RAM
+ * 
+ * \b References:
+ * @ref RAM::read32_cpu
+ */
+uint32_t Bus::read32_dma(uint32_t addr)
+{
+    return ram->read32_cpu(addr & 0x1ffffc);
+}
+
+/**
+ * @brief Writes a word to RAM for a DMA transfer.
+ * 
+ * @param addr Address in RAM (wraps around the 2MB)
+ * @param data Data to write to RAM
+ * 
+ * \b References:
+ * @ref RAM::write32_cpu
+ */
+void Bus::write32_dma(uint32_t addr, uint32_t data)
+{
+    ram->write32_cpu(addr & 0x1ffffc, data);
+}
+
+/**
+ * @brief Returns the number of words a device can provide to its DMA channel.
+ * 
+ * Devices without an output FIFO of their own report that the whole transfer is ready.
+ * 
+ * @param channel Channel of the device
+ * @return uint32_t Number of words ready
+ * 
+ * \b References:
+ * @ref MDEC::output_words
+ */
+uint32_t Bus::dma_device_ready(DMAChannel channel)
+{
+    if(channel == DMA_MDEC_OUT)
+        return mdec->output_words();
+    return 0xffffffff;
+}
+
+/**
+ * @brief Reads a block of words from the device of a DMA channel.
+ * 
+ * @param channel Channel of the device
+ * @param data Buffer for the words
+ * @param count Number of words
+ * 
+ * @throw std::runtime_error If the channel has no device that can be read
+ * 
+ * \b References:
+ * @ref MDEC::read_data
+ * @ref CDROM::read_data32
+ */
+void Bus::dma_device_read(DMAChannel channel, uint32_t* data, uint32_t count)
+{
+    switch(channel)
+    {
+        case DMA_MDEC_OUT:
+            mdec->read_data(data, count);
+            return;
+        case DMA_CDROM:
+            for(uint32_t i = 0; i < count; i++)
+                data[i] = cdrom->read_data32();
+            return;
+        default:
+            std::stringstream ss;
+            ss << "Unhandled DMA read from channel " << channel;
+            throw std::runtime_error(ss.str());
+    }
+}
+
+/**
+ * @brief Writes a block of words to the device of a DMA channel.
+ * 
+ * @param channel Channel of the device
+ * @param data Words to write
+ * @param count Number of words
+ * 
+ * @throw std::runtime_error If the channel has no device that can be written
+ * 
+ * \b References:
+ * @ref MDEC::write_data
+ * @ref SPU::write16_cpu
+ */
+void Bus::dma_device_write(DMAChannel channel, const uint32_t* data, uint32_t count)
+{
+    switch(channel)
+    {
+        case DMA_MDEC_IN:
+            mdec->write_data(data, count);
+            return;
+        case DMA_SPU:
+            for(uint32_t i = 0; i < count; i++)
+            {
+                spu->write16_cpu(SPU_REG_TRANSFER_FIFO, data[i] & 0xffff);
+                spu->write16_cpu(SPU_REG_TRANSFER_FIFO, data[i] >> 16);
+            }
+            return;
+        default:
+            std::stringstream ss;
+            ss << "Unhandled DMA write to channel " << channel;
+            throw std::runtime_error(ss.str());
+    }
+}
+
+/**
+ * @brief Signals the DMA controller that a device is ready for its channel.
+ * 
+ * @param channel Channel of the device
+ * 
+ * \b References:
+ * @ref DMA::request
+ */
+void Bus::dma_request(DMAChannel channel)
+{
+    dma->request(channel);
+}
+
+/**
+ * @brief Fills the page tables with the host memory of the RAM and the BIOS.
+ * 
+ * Pages left empty (I/O, expansion regions, unmapped memory) are handled by the range checks of the accessors. So are the pages covered by a watchpoint, for the kind of access it watches.
+ * 
+ * Only the entries of the RAM and the BIOS are ever written, and all of them are written again here. The other entries stay zero from the arena and are never touched, so most of the tables never take host memory.
+ * 
+ * \b References:
+ * @ref map_ram_page
+ * @ref BIOS::get_host
+ * @ref CPU::flush_code_page
+ */
+void Bus::map_pages()
+{
+    cpu->flush_code_page();
+
+    for(uint32_t page = 0; page <= (ram_range.end - ram_range.start) >> PAGE_SHIFT; page++)
+        map_ram_page(page);
+    //the read table is never written through
+    for(uint32_t offset = 0; offset <= bios_range.end - bios_range.start; offset += PAGE_SIZE)
+        read_pages[(bios_range.start + offset) >> PAGE_SHIFT] = const_cast<uint8_t*>(bios->get_host(offset));
+}
+
+/**
+ * @brief Maps a page of RAM into the page tables.
+ * 
+ * Pages shared with other machines are only mapped for reading, so that writes reach the RAM, which copies them. Pages under a watchpoint are not mapped for the accesses it watches.
+ * 
+ * @param page Index of the 4KB page in the RAM
+ * 
+ * \b References:
+ * @ref RAM::get_host
+ * @ref RAM::is_shared
+ * @ref RAM::get_data
+ */
+void Bus::map_ram_page(uint32_t page)
+{
+    uint32_t offset = page << PAGE_SHIFT;
+    uint8_t* read = const_cast<uint8_t*>(ram->get_host(offset));
+    uint8_t* write = ram->is_shared(offset) ? nullptr : ram->get_data() + offset;
+    for(const Watchpoint& watch : watchpoints)
+    {
+        if(watch.start >= offset + PAGE_SIZE || watch.end <= offset)
+            continue;
+        if(watch.type & WATCH_READ) read = nullptr;
+        if(watch.type & WATCH_WRITE) write = nullptr;
+    }
+    read_pages[(ram_range.start >> PAGE_SHIFT) + page] = read;
+    write_pages[(ram_range.start >> PAGE_SHIFT) + page] = write;
+}
+
+/**
+ * @brief Adds a watchpoint on a range of RAM.
+ * 
+ * @param addr Start of the range, in any segment
+ * @param size Size of the range in bytes
+ * @param type Accesses to watch
+ * @param action Whether to log the hits or to stop (see take_watch_hit)
+ * 
+ * @throw std::runtime_error If the range is not in RAM
+ * 
+ * \b References:
+ * @ref map_pages
+ */
+void Bus::add_watchpoint(uint32_t addr, uint32_t size, WatchType type, WatchAction action)
+{
+    uint32_t phys = addr & region_mask(addr);
+    if(size == 0 || !ram_range.contains(phys) || !ram_range.contains(phys + size - 1))
+    {
+        std::stringstream ss;
+        ss << "Watchpoint outside RAM: 0x" << std::hex << addr << " (0x" << size << " bytes)";
+        throw std::runtime_error(ss.str());
+    }
+    uint32_t start = ram_range.offset(phys);
+    watchpoints.push_back({start, start + size, type, action});
+    map_pages();
+}
+
+/**
+ * @brief Removes a watchpoint added with the same range and type.
+ * 
+ * @param addr Start of the range, in any segment
+ * @param size Size of the range in bytes
+ * @param type Accesses watched
+ * 
+ * \b References:
+ * @ref map_pages
+ */
+void Bus::remove_watchpoint(uint32_t addr, uint32_t size, WatchType type)
+{
+    uint32_t phys = addr & region_mask(addr);
+    if(!ram_range.contains(phys))
+        return;
+    uint32_t start = ram_range.offset(phys);
+    for(size_t i = 0; i < watchpoints.size(); i++)
+    {
+        if(watchpoints[i].start == start && watchpoints[i].end == start + size && watchpoints[i].type == type)
+        {
+            watchpoints.erase(watchpoints.begin() + i);
+            map_pages();
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Checks a CPU access to a watched page of RAM against the watchpoints.
+ * 
+ * Called by the I/O path, which only sees RAM accesses to the pages removed from the page table by watchpoints. A hit is logged with the address of the instruction and the old and new values, or recorded for take_watch_hit.
+ * 
+ * @param addr Address accessed by the CPU
+ * @param offset Offset of the access in RAM
+ * @param size Size of the access in bytes
+ * @param write Whether the access is a write
+ * @param data Data written
+ * 
+ * \b References:
+ * @ref CPU::get_ins_addr
+ */
+void Bus::watch_access(uint32_t addr, uint32_t offset, uint32_t size, bool write, uint32_t data)
+{
+    for(const Watchpoint& watch : watchpoints)
+    {
+        if(!(watch.type & (write ? WATCH_WRITE : WATCH_READ)) || offset + size <= watch.start || offset >= watch.end)
+            continue;
+
+        WatchHit hit;
+        hit.pc = cpu->get_ins_addr();
+        hit.addr = addr;
+        hit.size = size;
+        hit.write = write;
+        hit.old_value = 0;
+        memcpy(&hit.old_value, ram->get_host(offset), size);
+        hit.new_value = write ? data : hit.old_value;
+
+        if(watch.action == WATCH_LOG)
+        {
+            if(write)
+                LOG_INFO(LOG_BUS, "Watchpoint: write to 0x{:x} at pc 0x{:x}: 0x{:x} -> 0x{:x}", addr, hit.pc, hit.old_value, hit.new_value);
+            else
+                LOG_INFO(LOG_BUS, "Watchpoint: read from 0x{:x} at pc 0x{:x}: 0x{:x}", addr, hit.pc, hit.old_value);
+        }
+        else
+        {
+            watch_hit = hit;
+            watch_stopped = true;
+        }
+        return;
+    }
+}
+
+/**
+ * @brief Enables or disables the cycle model.
+ * 
+ * With the cycle model, instructions fetched from the instruction cache take fewer cycles than uncached ones instead of the fixed CYCLES_PER_INSTRUCTION.
+ * 
+ * @param enabled Whether to use the cycle model
+ */
+void Bus::set_cycle_model(bool enabled)
+{
+    cycle_model = enabled;
+}
+
+/**
+ * @brief Returns whether the cycle model is enabled.
+ * 
+ * @return true Instructions are timed by the cost of their fetch
+ * @return false Every instruction takes CYCLES_PER_INSTRUCTION cycles
+ */
+bool Bus::get_cycle_model()
+{
+    return cycle_model;
+}
+
+/**
+ * @brief Enables or disables the deterministic mode.
+ * 
+ * The only input from the host the emulation reacts to is then the controller state. The CDROM waits for the disc image rather than retrying a sector the reader thread has not read yet, which made the emulated timing depend on the host. Events were already ordered by the scheduler alone.
+ * 
+ * @param enabled Whether to run deterministically
+ * 
+ * \b References:
+ * @ref CDROM::set_deterministic
+ */
+void Bus::set_deterministic(bool enabled)
+{
+    deterministic = enabled;
+    cdrom->set_deterministic(enabled);
+}
+
+/**
+ * @brief Returns the number of frames (vblanks) since reset.
+ * 
+ * @return uint64_t Number of frames
+ */
+uint64_t Bus::get_frame_count()
+{
+    return frames;
+}
+
+/**
+ * @brief Runs the machine up to and including the next vblank.
+ * 
+ * Unthrottled: the machine runs as fast as the host allows.
+ * 
+ * \b References:
+ * @ref clock
+ */
+void Bus::run_frame()
+{
+    uint64_t frame = frames;
+    while(frames == frame)
+        clock();
+}
+
+/**
+ * @brief Returns the input of the controller of a port.
+ * 
+ * Hosts driving many machines keep the reference and write the buttons and sticks to it directly, which costs a few stores per frame. The pad reads it whenever the game polls it.
+ * 
+ * @param port Controller port (0 or 1)
+ * @return PadState& Input of the controller
+ * 
+ * @throw std::runtime_error If the port does not exist
+ * 
+ * \b References:
+ * @ref SIO0::get_pad
+ */
+PadState& Bus::get_pad(uint32_t port)
+{
+    return sio0->get_pad(port);
+}
+
+/**
+ * @brief Sets the buttons held on a controller.
+ * 
+ * @param port Controller port (0 or 1)
+ * @param buttons Pressed buttons (PAD_BUTTON_*)
+ * 
+ * @throw std::runtime_error If the port does not exist
+ * 
+ * \b References:
+ * @ref SIO0::get_pad
+ */
+void Bus::set_pad_buttons(uint32_t port, uint16_t buttons)
+{
+    sio0->get_pad(port).buttons = buttons;
+}
+
+/**
+ * @brief Returns the buttons held on a controller.
+ * 
+ * @param port Controller port (0 or 1)
+ * @return uint16_t Pressed buttons (PAD_BUTTON_*)
+ * 
+ * @throw std::runtime_error If the port does not exist
+ * 
+ * \b References:
+ * @ref SIO0::get_pad
+ */
+uint16_t Bus::get_pad_buttons(uint32_t port)
+{
+    return sio0->get_pad(port).buttons;
+}
+
+/**
+ * @brief Plugs a controller into a port.
+ * 
+ * A digital pad is plugged into each port at power-on.
+ * 
+ * @param port Controller port (0 or 1)
+ * @param type Controller, PAD_NONE to unplug it
+ * 
+ * @throw std::runtime_error If the port does not exist
+ * 
+ * \b References:
+ * @ref SIO0::set_pad_type
+ */
+void Bus::set_pad_type(uint32_t port, PadType type)
+{
+    sio0->set_pad_type(port, type);
+}
+
+/**
+ * @brief Returns the controller plugged into a port.
+ * 
+ * @param port Controller port (0 or 1)
+ * @return PadType Controller
+ * 
+ * @throw std::runtime_error If the port does not exist
+ * 
+ * \b References:
+ * @ref SIO0::get_pad_type
+ */
+PadType Bus::get_pad_type(uint32_t port)
+{
+    return sio0->get_pad_type(port);
+}
+
+/**
+ * @brief Sets the function called when a game starts polling a controller.
+ * 
+ * For hosts that compute the input at every poll rather than every frame. The function receives the port and the input of the controller, which it updates before the pad sends it.
+ * 
+ * @param callback Function to call, nullptr to remove it
+ * 
+ * \b References:
+ * @ref SIO0::set_poll_callback
+ */
+void Bus::set_pad_poll_callback(std::function<void(uint32_t, PadState&)> callback)
+{
+    sio0->set_poll_callback(callback);
+}
+
+/**
+ * @brief Enables or disables idle loop skipping.
+ * 
+ * Enabled by default. Skipping changes how many instructions run between two events, but not what the emulated software observes, since an idle loop only polls state that changes on events.
+ * 
+ * @param enabled Whether to skip idle loops
+ * 
+ * \b References:
+ * @ref CPU::set_idle_skip
+ */
+void Bus::set_idle_skip(bool enabled)
+{
+    cpu->set_idle_skip(enabled);
+}
+
+/**
+ * @brief Returns the number of cycles skipped in idle loops since reset.
+ * 
+ * @return uint64_t Number of cycles
+ */
+uint64_t Bus::get_idle_cycles()
+{
+    return idle_cycles;
+}
+
+/**
+ * @brief Checks whether a CPU read from the given address has no side effect.
+ * 
+ * Used by the idle loop detection of the CPU. Memory, the interrupt and DMA registers and the CD-ROM and SIO0 status registers can be polled freely. Everything else is treated as a device that may change state when it is read (FIFOs) or that changes with time between events (timer counters).
+ * 
+ * @param addr Address to check
+ * @return true Reading the address only returns data
+ * @return false Reading the address may change the state of a device
+ * 
+ * \b References:
+ * @ref in_scratchpad
+ * @ref page_lookup
+ * @ref region_mask
+ */
+bool Bus::side_effect_free(uint32_t addr)
+{
+    if(in_scratchpad(addr) || page_lookup(read_pages, addr))
+        return true;
+
+    uint32_t phys = addr & region_mask(addr);
+    return interrupt_range.contains(phys) || dma_range.contains(phys) || phys == cdrom_range.start ||
+        phys == sio0_range.start + SIO_REG_STAT;
+}
+
+/**
+ * @brief Enables or disables instruction fusion in the CPU.
+ * 
+ * Enabled by default. Fusion never changes the results or the timing of the emulation, only the number of dispatches.
+ * 
+ * @param enabled Whether the CPU may execute fused pairs
+ */
+void Bus::set_fusion(bool enabled)
+{
+    fusion = enabled;
+}
+
+/**
+ * @brief Returns how many times the CPU has fused an idiom since reset.
+ * 
+ * @param idiom Idiom to query
+ * @return uint64_t Number of fused pairs
+ * 
+ * \b References:
+ * @ref CPU::get_fusion_count
+ */
+uint64_t Bus::get_fusion_count(FusedIdiom idiom)
+{
+    return cpu->get_fusion_count(idiom);
+}
+
+/**
+ * @brief Returns the host memory backing a page the CPU executes from.
+ * 
+ * Used by the CPU to fetch instructions without going through the Bus. Only pages of RAM and BIOS qualify. The page table is not used, so that fetches from pages under a read watchpoint are not reported as reads.
+ * 
+ * @param addr Address in the page
+ * @return const uint8_t* Host pointer to the start of the page, nullptr if the page is not backed by host memory
+ */
+const uint8_t* Bus::code_page(uint32_t addr)
+{
+    static_assert(CODE_PAGE_SIZE == PAGE_SIZE, "The CPU caches whole pages of the page table");
+    if(addr >= KSEG2_START)
+        return nullptr;
+    uint32_t phys = addr & 0x1fffffff & ~PAGE_MASK;
+    if(ram_range.contains(phys))
+        return ram->get_host(ram_range.offset(phys));
+    if(bios_range.contains(phys))
+        return bios->get_host(bios_range.offset(phys));
+    return nullptr;
+}
+
+/**
+ * @brief Marks a range the CPU caches code from, so that writes to it are reported back.
+ * 
+ * Ranges outside RAM are ignored, nothing else the CPU executes from is writable.
+ * 
+ * @param addr Start of the range, in any segment
+ * @param size Size of the range in bytes
+ * 
+ * \b References:
+ * @ref RAM::mark_code
+ * @ref CPU::invalidate_code
+ */
+void Bus::mark_code(uint32_t addr, uint32_t size)
+{
+    uint32_t phys = addr & region_mask(addr);
+    if(ram_range.contains(phys))
+        ram->mark_code(ram_range.offset(phys), size);
+}
+
+/**
+ * @brief Copies the state of the CPU.
+ * 
+ * Used by debugging tools, for example to compare two machines in lockstep.
+ * 
+ * @param state Structure to fill
+ * @return CPUState* The filled structure
+ * 
+ * \b References:
+ * @ref CPU::get_state
+ */
+CPUState* Bus::get_cpu_state(CPUState* state)
+{
+    return cpu->get_state(state);
+}
+
+/**
+ * @brief Overwrites the state of the CPU.
+ * 
+ * Used by debuggers to change registers.
+ * 
+ * @param state State to set
+ * 
+ * \b References:
+ * @ref CPU::set_state
+ */
+void Bus::set_cpu_state(CPUState* state)
+{
+    cpu->set_state(state);
+}
+
+/**
+ * @brief Returns the address of the next instruction the CPU executes.
+ * 
+ * @return uint32_t Address of the instruction
+ * 
+ * \b References:
+ * @ref CPU::get_next_ins_addr
+ */
+uint32_t Bus::get_cpu_pc()
+{
+    return cpu->get_next_ins_addr();
+}
+
+/**
+ * @brief Makes the CPU continue at the given address.
+ * 
+ * @param addr Address of the next instruction to execute
+ * 
+ * \b References:
+ * @ref CPU::jump_to
+ */
+void Bus::set_cpu_pc(uint32_t addr)
+{
+    cpu->jump_to(addr);
+}
+
+/**
+ * @brief Reads a byte of memory for a debugger.
+ * 
+ * Only the scratchpad, the RAM and the BIOS can be read, so that a debugger never triggers the side effects of a device register.
+ * 
+ * @param addr Address to read
+ * @param data Output byte
+ * @return true The byte was read
+ * @return false The address is not memory
+ * 
+ * \b References:
+ * @ref in_scratchpad
+ * @ref region_mask
+ */
+bool Bus::read8_debug(uint32_t addr, uint8_t* data)
+{
+    if(in_scratchpad(addr))
+    {
+        *data = scratchpad[addr & (SCRATCHPAD_SIZE - 1)];
+        return true;
+    }
+    uint32_t phys = addr & region_mask(addr);
+    if(ram_range.contains(phys))
+    {
+        *data = *ram->get_host(ram_range.offset(phys));
+        return true;
+    }
+    if(bios_range.contains(phys))
+    {
+        *data = *bios->get_host(bios_range.offset(phys));
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Writes a byte of memory for a debugger.
+ * 
+ * Only the scratchpad and the RAM can be written. RAM is written through RAM::write8_cpu, which drops the idle loops of the patched code. The CPU also drops the word from its instruction cache and fetches it again if it is the next instruction, so patching the instruction at the stop address takes effect.
+ * 
+ * @param addr Address to write
+ * @param data Byte to write
+ * @return true The byte was written
+ * @return false The address is not writable memory
+ * 
+ * \b References:
+ * @ref in_scratchpad
+ * @ref region_mask
+ * @ref RAM::write8_cpu
+ * @ref CPU::invalidate_fetched
+ */
+bool Bus::write8_debug(uint32_t addr, uint8_t data)
+{
+    if(in_scratchpad(addr))
+    {
+        scratchpad[addr & (SCRATCHPAD_SIZE - 1)] = data;
+        return true;
+    }
+    uint32_t phys = addr & region_mask(addr);
+    if(ram_range.contains(phys))
+    {
+        ram->write8_cpu(ram_range.offset(phys), data);
+        cpu->invalidate_fetched(phys);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Sets the monitor the state is published to.
+ * 
+ * The state is published at the start of every vertical blank. The monitor must outlive the Bus, or be unset first.
+ * 
+ * @param monitor Monitor to publish to, nullptr to stop publishing
+ */
+void Bus::set_monitor(StateMonitor* monitor)
+{
+    this->monitor = monitor;
+}
+
+/**
+ * @brief Sets the coverage map the executed instructions are marked in.
+ * 
+ * Every instruction executed from RAM or BIOS is marked. The map must outlive the Bus, or be unset first.
+ * 
+ * @param coverage Map to mark, nullptr to stop marking
+ * 
+ * @throw std::runtime_error If the emulator was built without WOLPSX_COVERAGE
+ * 
+ * \b References:
+ * @ref CPU::set_coverage
+ */
+void Bus::set_coverage(CodeCoverage* coverage)
+{
+#ifndef WOLPSX_COVERAGE
+    if(coverage)
+        throw std::runtime_error("Coverage is not compiled in (WOLPSX_COVERAGE)");
+#endif
+    cpu->set_coverage(coverage);
+}
+
+/**
+ * @brief Publishes the CPU registers, the cycle count and the watched RAM regions to the monitor.
+ * 
+ * Called at every frame, and by the host for other boundaries. Only the emulation thread may call it.
+ * 
+ * \b References:
+ * @ref StateMonitor::begin_publish
+ * @ref CPU::publish_state
+ * @ref StateMonitor::publish_ram
+ * @ref StateMonitor::end_publish
+ */
+void Bus::publish_state()
+{
+    if(!monitor)
+        return;
+    uint64_t cycles = scheduler->now();
+    monitor->begin_publish();
+    cpu->publish_state(monitor);
+    monitor->publish_word(MONITOR_CYCLES_LOW, uint32_t(cycles));
+    monitor->publish_word(MONITOR_CYCLES_HIGH, uint32_t(cycles >> 32));
+    monitor->publish_ram(*ram);
+    monitor->end_publish();
+}
+
+/**
+ * @brief Returns the host memory of the RAM.
+ * 
+ * The pages shared with other machines are copied into the private storage of the RAM first, so the memory is one block. This copies the whole RAM once the machine was forked, so it is only meant for the tools that need all of it at once (hashing it for lockstep runs and movies).
+ * 
+ * @return const uint8_t* Pointer to the first byte, valid until the next write to the RAM
+ */
+const uint8_t* Bus::get_ram_data()
+{
+    return ram->get_contents();
+}
+/**
+ * @brief Returns the size of the RAM.
+ * 
+ * @return uint32_t Size of the RAM in bytes
+ */
+uint32_t Bus::get_ram_size()
+{
+    return ram_range.end - ram_range.start + 1;
+}
+
+/**
+ * @brief Returns the number of pages of RAM shared with forked machines.
+ * 
+ * @return uint32_t Number of 4KB pages
+ */
+uint32_t Bus::get_shared_ram_pages()
+{
+    return ram->count_shared_pages();
+}
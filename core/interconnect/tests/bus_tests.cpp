@@ -0,0 +1,200 @@
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <core/interconnect/bus.hpp>
+#include <test_bios.hpp>
+
+#define TEST_BIOS_PATH "bus_test_bios.bin"
+
+/**
+ * @brief Tests accesses of every width to the scratchpad through KUSEG and KSEG0, and that KSEG1 does not reach it
+ * 
+ * @param bus 
+ */
+void test_bus_scratchpad(Bus& bus)
+{
+    std::cout << "Bus Scratchpad: ";
+    bus.write32_cpu(0x1f800000, 0x12345678);
+    bus.write16_cpu(0x1f800004, 0xbeef);
+    bus.write8_cpu(0x9f8003ff, 0x5a);
+
+    bool ok = bus.read32_cpu(0x9f800000) == 0x12345678;
+    ok &= bus.read16_cpu(0x1f800002) == 0x1234;
+    ok &= bus.read8_cpu(0x1f800005) == 0xbe;
+    ok &= bus.read8_cpu(0x1f8003ff) == 0x5a;
+
+    bool kseg1 = false;
+    try
+    {
+        bus.read32_cpu(0xbf800000);
+    }
+    catch(const std::runtime_error&)
+    {
+        kseg1 = true;
+    }
+    if(ok && kseg1) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+/**
+ * @brief Tests that RAM and BIOS accesses through the page table see the same memory in every segment
+ * 
+ * @param bus 
+ */
+void test_bus_pages(Bus& bus)
+{
+    std::cout << "Bus Page Table: ";
+    bus.write32_cpu(0x80001ffc, 0xcafef00d);
+    bus.write8_cpu(0xa0002000, 0x77);
+
+    bool ok = bus.read32_cpu(0x00001ffc) == 0xcafef00d;
+    ok &= bus.read16_cpu(0xa0001ffe) == 0xcafe;
+    ok &= bus.read8_cpu(0x80002000) == 0x77;
+    ok &= bus.read32_cpu(0xbfc00000) == 0x0bf00000;
+    ok &= bus.read8_cpu(0x9fc00003) == 0x0b;
+
+    //the BIOS is read-only
+    bool rom = false;
+    try
+    {
+        bus.write32_cpu(0xbfc00000, 0);
+    }
+    catch(const std::runtime_error&)
+    {
+        rom = bus.read32_cpu(0xbfc00000) == 0x0bf00000;
+    }
+    if(ok && rom) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+/**
+ * @brief Tests that watchpoints catch the accesses they watch, at every width, and nothing else
+ * 
+ * @param bus 
+ */
+void test_bus_watchpoints(Bus& bus)
+{
+    std::cout << "Bus Watchpoints: ";
+    bus.write32_cpu(0x3000, 0x11111111);
+    bus.add_watchpoint(0x80003000, 4, WATCH_WRITE, WATCH_STOP);
+    bus.add_watchpoint(0x3100, 2, WATCH_READ, WATCH_STOP);
+
+    WatchHit hit;
+    bus.write16_cpu(0xa0003002, 0x2222);
+    bool ok = bus.take_watch_hit(&hit) && hit.write && hit.addr == 0xa0003002 && hit.size == 2;
+    ok &= hit.old_value == 0x1111 && hit.new_value == 0x2222;
+    ok &= !bus.take_watch_hit(&hit);
+
+    //outside the range, but on the same page, or not watched for this kind of access
+    bus.write32_cpu(0x3004, 5);
+    bus.write8_cpu(0x3103, 7);
+    ok &= bus.read32_cpu(0x3000) == 0x22221111 && !bus.take_watch_hit(&hit);
+
+    bus.read8_cpu(0x80003101);
+    ok &= bus.take_watch_hit(&hit) && !hit.write && hit.size == 1 && hit.addr == 0x80003101;
+
+    //instruction fetches are not reads
+    ok &= bus.code_page(0x3100) != nullptr;
+
+    bus.remove_watchpoint(0x80003000, 4, WATCH_WRITE);
+    bus.remove_watchpoint(0x3100, 2, WATCH_READ);
+    bus.write32_cpu(0x3000, 3);
+    bus.read8_cpu(0x3101);
+    ok &= bus.read32_cpu(0x3000) == 3 && !bus.take_watch_hit(&hit);
+
+    bool outside = false;
+    try
+    {
+        bus.add_watchpoint(0x1f801070, 4, WATCH_ACCESS, WATCH_LOG);
+    }
+    catch(const std::runtime_error&)
+    {
+        outside = true;
+    }
+    if(ok && outside) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+/**
+ * @brief Tests that writes to RAM pages marked as holding code are reported once, until the page is marked again
+ * 
+ */
+void test_ram_code_writes()
+{
+    std::cout << "RAM Code Writes: ";
+    Arena arena(RAM::arena_size(RAM_SIZE));
+    RAM ram(arena, RAM_SIZE);
+    std::vector<std::pair<uint32_t, uint32_t>> writes;
+    ram.set_code_write_callback([&](uint32_t offset, uint32_t size) { writes.push_back({offset, size}); });
+
+    ram.write32_cpu(0x5000, 1);
+    ram.mark_code(0x5ff8, 0x10); //spans two pages
+    bool ok = !ram.is_code(0x4fff) && ram.is_code(0x5000) && ram.is_code(0x6fff) && !ram.is_code(0x7000);
+
+    ram.write16_cpu(0x5002, 2);
+    ram.write32_cpu(0x5004, 3); //page no longer marked
+    ram.write8_cpu(0x6001, 4);
+    ok &= writes.size() == 2 && writes[0] == std::make_pair(0x5002u, 2u) && writes[1] == std::make_pair(0x6001u, 1u);
+    ok &= !ram.is_code(0x5000) && !ram.is_code(0x6000);
+
+    ram.mark_code(0x5000, 4);
+    ram.write32_cpu(0x5ffc, 5);
+    ok &= writes.size() == 3 && writes[2] == std::make_pair(0x5ffcu, 4u);
+
+    if(ok) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+/**
+ * @brief Tests that a forked machine runs on from the state of its parent and shares its RAM until either writes
+ * 
+ */
+void test_bus_fork()
+{
+    std::cout << "Bus Fork: ";
+    std::unique_ptr<Bus> parent(new Bus(TEST_BIOS_PATH));
+    parent->write32_cpu(0x1000, 0x11111111);
+    parent->write32_cpu(0x2000, 0x22222222);
+    parent->write8_cpu(0x1f800000, 0x33);
+    for(int i = 0; i < 100; i++)
+        parent->clock();
+
+    std::unique_ptr<Bus> child = parent->fork();
+    bool ok = child->get_cycles() == parent->get_cycles() && child->get_cpu_pc() == parent->get_cpu_pc();
+    ok &= child->read32_cpu(0x1000) == 0x11111111 && child->read8_cpu(0x1f800000) == 0x33;
+    ok &= parent->get_shared_ram_pages() == RAM_SIZE / PAGE_SIZE && child->get_shared_ram_pages() == RAM_SIZE / PAGE_SIZE;
+
+    child->write32_cpu(0x80001000, 0x44444444);
+    parent->write16_cpu(0x2002, 0x5555);
+    ok &= parent->read32_cpu(0x1000) == 0x11111111 && child->read32_cpu(0x1000) == 0x44444444;
+    ok &= parent->read32_cpu(0x2000) == 0x55552222 && child->read32_cpu(0x2000) == 0x22222222;
+    ok &= child->get_shared_ram_pages() == RAM_SIZE / PAGE_SIZE - 1;
+
+    std::unique_ptr<Bus> grandchild = child->fork();
+    parent.reset();
+    child.reset();
+    for(int i = 0; i < 100; i++)
+        grandchild->clock();
+    ok &= grandchild->read32_cpu(0x1000) == 0x44444444 && grandchild->read32_cpu(0x2000) == 0x22222222;
+    ok &= grandchild->read32_cpu(0xbfc00000) == 0x0bf00000 && grandchild->get_cpu_pc() >= 0xbfc00000;
+    grandchild.reset();
+
+    if(ok) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+int main()
+{
+    write_test_bios(TEST_BIOS_PATH, {0x0bf00000, 0x00000000}); //j 0xbfc00000
+    Bus bus(TEST_BIOS_PATH);
+
+    test_bus_scratchpad(bus);
+    test_bus_pages(bus);
+    test_bus_watchpoints(bus);
+    test_ram_code_writes();
+    test_bus_fork();
+    return 0;
+}
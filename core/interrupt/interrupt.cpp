@@ -0,0 +1,95 @@
+#include <sstream>
+#include <stdexcept>
+
+#include "core/interrupt/interrupt.hpp"
+
+/**
+ * @brief Construct a new InterruptController:: InterruptController object
+ * 
+ * All interrupts are acknowledged and masked on reset.
+ */
+InterruptController::InterruptController()
+{
+    i_stat = 0;
+    i_mask = 0;
+    is_pending = false;
+}
+
+/**
+ * @brief Reads one of the interrupt registers.
+ * 
+ * @param offset Offset from the start of the interrupt range
+ * @return uint32_t Value of the register
+ * 
+ * @throw std::runtime_error If the offset does not map to a register
+ */
+uint32_t InterruptController::read32_cpu(uint32_t offset)
+{
+    switch(offset)
+    {
+        case I_STAT_OFFSET:
+            return i_stat;
+        case I_MASK_OFFSET:
+            return i_mask;
+        default:
+            std::stringstream ss;
+            ss << "Unhandled read from Interrupt register: 0x" << std::hex << offset;
+            throw std::runtime_error(ss.str());
+    }
+}
+
+/**
+ * @brief Writes one of the interrupt registers.
+ * 
+ * Writing I_STAT acknowledges every interrupt whose bit is written as 0. Writing I_MASK replaces the mask.
+ * 
+ * @param offset Offset from the start of the interrupt range
+ * @param data Data to write
+ * 
+ * @throw std::runtime_error If the offset does not map to a register
+ * 
+ * \b References:
+ * @ref update
+ */
+void InterruptController::write32_cpu(uint32_t offset, uint32_t data)
+{
+    switch(offset)
+    {
+        case I_STAT_OFFSET:
+            i_stat &= data & 0x7ff;
+            break;
+        case I_MASK_OFFSET:
+            i_mask = data & 0x7ff;
+            break;
+        default:
+            std::stringstream ss;
+            ss << "Unhandled write to Interrupt register: 0x" << std::hex << offset;
+            throw std::runtime_error(ss.str());
+    }
+    update();
+}
+
+/**
+ * @brief Raises an interrupt line.
+ * 
+ * Sets the corresponding bit in I_STAT. The bit stays set until it is acknowledged by software.
+ * 
+ * @param irq Interrupt line to raise
+ * 
+ * \b References:
+ * @ref update
+ */
+void InterruptController::raise(IRQ irq)
+{
+    i_stat |= 1 << irq;
+    update();
+}
+
+/**
+ * @brief Recomputes the cached interrupt output.
+ * 
+ */
+void InterruptController::update()
+{
+    is_pending = (i_stat & i_mask) != 0;
+}
@@ -0,0 +1,197 @@
+#include <iostream>
+#include <vector>
+
+#include <core/interconnect/bus.hpp>
+#include <core/interrupt/interrupt.hpp>
+#include <test_bios.hpp>
+
+#define TEST_BIOS_PATH "interrupt_test_bios.bin"
+
+/**
+ * @brief Interrupt handler used by the CPU tests
+ * 
+ * Saves EPC, Cause and Status to k0, k1 and s2 and counts its entries in s1. It only acknowledges I_STAT (through t1 = 0x1f800000) from its second entry, so the interrupt must stay pending and enter it again right after the first RFE.
+ */
+static const std::vector<uint32_t> test_handler = {
+    0x401a7000, //mfc0 k0, epc
+    0x401b6800, //mfc0 k1, cause
+    0x40126000, //mfc0 s2, status
+    0x26310001, //addiu s1, s1, 1
+    0x2a2b0002, //slti t3, s1, 2
+    0x15600002, //bnez t3, +2
+    0x00000000, //nop
+    0xad201070, //sw zero, 0x1070(t1) (I_STAT)
+    0x03400008, //jr k0
+    0x42000010  //rfe
+};
+
+/**
+ * @brief Creates a BIOS from a program at the reset vector and the test handler at the BEV=1 vector (0xbfc00180)
+ * 
+ * @param program Instructions at 0xbfc00000
+ */
+void create_test_bios(const std::vector<uint32_t>& program)
+{
+    std::vector<uint32_t> image = program;
+    image.resize(0x180 / 4, 0x00000000);
+    image.insert(image.end(), test_handler.begin(), test_handler.end());
+    write_test_bios(TEST_BIOS_PATH, image);
+}
+
+/**
+ * @brief Clocks the Bus until the CPU is about to execute the instruction at the given address
+ * 
+ * @param bus 
+ * @param addr Address of the instruction
+ * @return true The address was reached
+ * @return false The address was not reached in 1000 clocks
+ */
+bool run_until(Bus& bus, uint32_t addr)
+{
+    for(int i = 0; i < 1000; i++)
+    {
+        if(bus.get_cpu_pc() == addr)
+            return true;
+        bus.clock();
+    }
+    return false;
+}
+
+/**
+ * @brief Tests that a raised interrupt is only pending while it is unmasked
+ * 
+ * @param intc 
+ */
+void test_interrupt_mask(InterruptController& intc)
+{
+    std::cout << "Interrupt Mask: ";
+    intc.write32_cpu(I_STAT_OFFSET, 0);
+    intc.write32_cpu(I_MASK_OFFSET, 0);
+    intc.raise(IRQ_VBLANK);
+    bool masked = !intc.pending() && intc.read32_cpu(I_STAT_OFFSET) == 0x1;
+    intc.write32_cpu(I_MASK_OFFSET, 1 << IRQ_VBLANK);
+    bool unmasked = intc.pending();
+    if(masked && unmasked) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+/**
+ * @brief Tests that writing 0 to an I_STAT bit acknowledges only that interrupt
+ * 
+ * @param intc 
+ */
+void test_interrupt_ack(InterruptController& intc)
+{
+    std::cout << "Interrupt Acknowledge: ";
+    intc.write32_cpu(I_STAT_OFFSET, 0);
+    intc.write32_cpu(I_MASK_OFFSET, (1 << IRQ_CDROM) | (1 << IRQ_TIMER0));
+    intc.raise(IRQ_CDROM);
+    intc.raise(IRQ_TIMER0);
+    intc.write32_cpu(I_STAT_OFFSET, ~(1u << IRQ_CDROM));
+    bool timer_left = intc.pending() && intc.read32_cpu(I_STAT_OFFSET) == (1 << IRQ_TIMER0);
+    intc.write32_cpu(I_STAT_OFFSET, ~(1u << IRQ_TIMER0));
+    bool none_left = !intc.pending() && intc.read32_cpu(I_STAT_OFFSET) == 0;
+    if(timer_left && none_left) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+/**
+ * @brief Tests that the CPU takes an interrupt pending in I_STAT and I_MASK once IEc and IM2 are set, with BEV set
+ * 
+ * Checks Cause bit 10 following I_STAT & I_MASK, EPC, the KU/IE stack push and the BIOS vector, then the interrupt staying pending until it is acknowledged and RFE restoring the stack.
+ */
+void test_interrupt_cpu()
+{
+    std::cout << "Interrupt CPU Exception: ";
+    create_test_bios({
+        0x34100000, //ori s0, zero, 0
+        0x34110000, //ori s1, zero, 0
+        0x3c091f80, //lui t1, 0x1f80
+        0x340a0001, //ori t2, zero, 1
+        0xad2a1074, //sw t2, 0x1074(t1) (I_MASK = vblank)
+        0x3c080040, //lui t0, 0x0040 (BEV)
+        0x35080401, //ori t0, t0, 0x0401 (IM2, IEc)
+        0x40886000, //mtc0 t0, status
+        0x34100001, //ori s0, zero, 1 (interrupted)
+        0x0bf00009, //j 0xbfc00024
+        0x00000000  //nop
+    });
+    Bus bus(TEST_BIOS_PATH);
+    CPUState state;
+
+    //masked: the interrupt is flagged in I_STAT but not in Cause
+    bus.raise_irq(IRQ_VBLANK);
+    bus.get_cpu_state(&state);
+    bool success = (state.reg_cop0_cause & 0x400) == 0;
+
+    success = success && run_until(bus, 0xbfc00180);
+    bus.get_cpu_state(&state);
+    success = success && state.reg_cop0_epc == 0xbfc00020 && state.reg_cop0_cause == 0x400;
+    success = success && state.reg_cop0_status == 0x00400404 && state.reg_gen[16] == 0;
+
+    //the first entry returns without acknowledging, so the ori is only reached after the second
+    success = success && run_until(bus, 0xbfc00024);
+    bus.get_cpu_state(&state);
+    success = success && state.reg_gen[17] == 2 && state.reg_gen[16] == 1;
+    success = success && state.reg_gen[26] == 0xbfc00020 && state.reg_gen[27] == 0x400 && state.reg_gen[18] == 0x00400404;
+    success = success && state.reg_cop0_status == 0x00400401 && (state.reg_cop0_cause & 0x400) == 0;
+    success = success && bus.read32_cpu(0x1f801070) == 0;
+    std::cout << (success ? "Success" : "Failure") << std::endl;
+}
+
+/**
+ * @brief Tests an interrupt taken in the delay slot of a jump, with BEV cleared
+ * 
+ * EPC points to the jump and BD is set, so that the handler returns to the jump and its delay slot runs again.
+ */
+void test_interrupt_delay_slot()
+{
+    std::cout << "Interrupt CPU Delay Slot: ";
+    create_test_bios({
+        0x34100000, //ori s0, zero, 0
+        0x34110000, //ori s1, zero, 0
+        0x34130000, //ori s3, zero, 0
+        0x34140000, //ori s4, zero, 0
+        0x3c091f80, //lui t1, 0x1f80
+        0x340a0001, //ori t2, zero, 1
+        0xad2a1074, //sw t2, 0x1074(t1) (I_MASK = vblank)
+        0x34080401, //ori t0, zero, 0x0401 (IM2, IEc)
+        0x40886000, //mtc0 t0, status
+        0x00000000, //nop
+        0x0bf0000d, //j 0xbfc00034
+        0x26730001, //addiu s3, s3, 1 (delay slot, interrupted)
+        0x34140001, //ori s4, zero, 1 (skipped)
+        0x34100001, //ori s0, zero, 1
+        0x0bf0000e, //j 0xbfc00038
+        0x00000000  //nop
+    });
+    Bus bus(TEST_BIOS_PATH);
+    for(uint32_t i = 0; i < test_handler.size(); i++)
+        bus.write32_cpu(0x80000080 + i * 4, test_handler[i]);
+    CPUState state;
+
+    bool success = run_until(bus, 0xbfc0002c);
+    bus.raise_irq(IRQ_VBLANK);
+    success = success && run_until(bus, 0x80000080);
+    bus.get_cpu_state(&state);
+    success = success && state.reg_cop0_epc == 0xbfc00028 && state.reg_cop0_cause == 0x80000400;
+    success = success && state.reg_cop0_status == 0x00000404 && state.reg_gen[19] == 0;
+
+    success = success && run_until(bus, 0xbfc00038);
+    bus.get_cpu_state(&state);
+    success = success && state.reg_gen[17] == 2 && state.reg_gen[19] == 1 && state.reg_gen[20] == 0 && state.reg_gen[16] == 1;
+    success = success && state.reg_cop0_status == 0x00000401 && bus.read32_cpu(0x1f801070) == 0;
+    std::cout << (success ? "Success" : "Failure") << std::endl;
+}
+
+int main()
+{
+    InterruptController test_intc;
+
+    test_interrupt_mask(test_intc);
+    test_interrupt_ack(test_intc);
+    test_interrupt_cpu();
+    test_interrupt_delay_slot();
+
+    return 0;
+}
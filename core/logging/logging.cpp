@@ -0,0 +1,267 @@
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+#include "core/logging/logging.hpp"
+
+/**
+ * @brief Names of the categories, indexed by LogCategory.
+ * 
+ */
+static const char* category_names[LOG_CATEGORY_COUNT] = {
+    "CPU", "BUS", "DMA", "MDEC", "CDROM", "SPU", "TIMER", "INTERRUPT"
+};
+
+/**
+ * @brief Names of the levels, indexed by LogLevel.
+ * 
+ */
+static const char* level_names[LOG_LEVEL_NONE] = {
+    "TRACE", "DEBUG", "INFO", "WARN", "ERROR"
+};
+
+/**
+ * @brief Returns the logger, starting it on first use.
+ * 
+ * @return Logger& The logger
+ */
+Logger& Logger::get()
+{
+    static Logger logger;
+    return logger;
+}
+
+/**
+ * @brief Construct a new Logger:: Logger object
+ * 
+ * Every category logs messages of level INFO and above to std::cerr.
+ * 
+ * \b References:
+ * @ref run
+ */
+Logger::Logger()
+{
+    ring = std::unique_ptr<LogEntry[]>(new LogEntry[LOG_RING_SIZE]);
+    for(uint64_t i = 0; i < LOG_RING_SIZE; i++)
+        ring[i].sequence.store(i, std::memory_order_relaxed);
+    head.store(0, std::memory_order_relaxed);
+    tail = 0;
+    dropped.store(0, std::memory_order_relaxed);
+    for(std::atomic<int>& level : levels)
+        level.store(LOG_LEVEL_INFO, std::memory_order_relaxed);
+    output = &std::cerr;
+    stop = false;
+    thread = std::thread(&Logger::run, this);
+}
+
+/**
+ * @brief Destroy the Logger:: Logger object
+ * 
+ * Stops the background thread and writes the messages left in the ring.
+ * 
+ * \b References:
+ * @ref drain
+ */
+Logger::~Logger()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    cv.notify_one();
+    thread.join();
+    drain();
+}
+
+/**
+ * @brief Sets the runtime level of a category.
+ * 
+ * @param category Category to change
+ * @param level Minimum level of the messages logged
+ */
+void Logger::set_level(LogCategory category, LogLevel level)
+{
+    levels[category].store(level, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Sets the runtime level of every category.
+ * 
+ * @param level Minimum level of the messages logged
+ */
+void Logger::set_level(LogLevel level)
+{
+    for(std::atomic<int>& category_level : levels)
+        category_level.store(level, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Sets the stream the messages are written to.
+ * 
+ * The messages already in the ring are written to the previous stream first.
+ * 
+ * @param output Stream to write to, not owned by the logger
+ * 
+ * \b References:
+ * @ref drain
+ */
+void Logger::set_output(std::ostream* output)
+{
+    drain();
+    std::lock_guard<std::mutex> lock(drain_mutex);
+    this->output = output;
+}
+
+/**
+ * @brief Writes every message pushed so far.
+ * 
+ * Blocks the caller until the ring is drained. Messages are otherwise written by the background thread.
+ * 
+ * \b References:
+ * @ref drain
+ */
+void Logger::flush()
+{
+    drain();
+}
+
+/**
+ * @brief Pushes a message to the ring, or counts it as dropped if the ring is full.
+ * 
+ * Lock-free and safe to call from several threads: each producer claims a slot by advancing head and publishes it through the sequence number of the slot.
+ * 
+ * @param level Level of the message
+ * @param category Category of the message
+ * @param format Format string (string literal)
+ * @param args Arguments
+ * @param count Number of arguments
+ */
+void Logger::push(LogLevel level, LogCategory category, const char* format, const LogArg* args, uint32_t count)
+{
+    uint64_t pos = head.load(std::memory_order_relaxed);
+    LogEntry* entry;
+    while(true)
+    {
+        entry = &ring[pos % LOG_RING_SIZE];
+        int64_t diff = int64_t(entry->sequence.load(std::memory_order_acquire)) - int64_t(pos);
+        if(diff == 0)
+        {
+            if(head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if(diff < 0)
+        {
+            //the slot has not been drained yet, the ring is full
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        else
+        {
+            pos = head.load(std::memory_order_relaxed);
+        }
+    }
+
+    entry->level = level;
+    entry->category = category;
+    entry->format = format;
+    entry->arg_count = count;
+    for(uint32_t i = 0; i < count; i++)
+        entry->args[i] = args[i];
+    entry->sequence.store(pos + 1, std::memory_order_release);
+}
+
+/**
+ * @brief Formats and writes the messages in the ring.
+ * 
+ * \b References:
+ * @ref format
+ */
+void Logger::drain()
+{
+    std::lock_guard<std::mutex> lock(drain_mutex);
+    bool written = false;
+    while(true)
+    {
+        LogEntry& entry = ring[tail % LOG_RING_SIZE];
+        if(entry.sequence.load(std::memory_order_acquire) != tail + 1)
+            break;
+
+        *output << "[" << category_names[entry.category] << "] " << level_names[entry.level] << ": " << format(entry.format, entry.args, entry.arg_count) << "\n";
+        entry.sequence.store(tail + LOG_RING_SIZE, std::memory_order_release);
+        tail++;
+        written = true;
+    }
+
+    uint64_t lost = dropped.exchange(0, std::memory_order_relaxed);
+    if(lost)
+    {
+        *output << "[LOG] WARN: " << lost << " messages dropped\n";
+        written = true;
+    }
+    if(written)
+        output->flush();
+}
+
+/**
+ * @brief Main loop of the background thread.
+ * 
+ * Drains the ring every LOG_DRAIN_INTERVAL_MS milliseconds. Producers never wake the thread, so logging costs no system call on the emulation thread.
+ * 
+ * \b References:
+ * @ref drain
+ */
+void Logger::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while(!stop)
+    {
+        lock.unlock();
+        drain();
+        lock.lock();
+        cv.wait_for(lock, std::chrono::milliseconds(LOG_DRAIN_INTERVAL_MS), [this] { return stop; });
+    }
+}
+
+/**
+ * @brief Formats a message.
+ * 
+ * "{}" is replaced by the next argument in decimal (or the string), "{:x}" by the next argument in hexadecimal. Placeholders without an argument are kept as they are.
+ * 
+ * @param format Format string
+ * @param args Arguments
+ * @param count Number of arguments
+ * @return std::string Formatted message
+ */
+std::string Logger::format(const char* format, const LogArg* args, uint32_t count)
+{
+    std::stringstream ss;
+    uint32_t next = 0;
+    for(const char* c = format; *c; c++)
+    {
+        bool hex = c[0] == '{' && c[1] == ':' && c[2] == 'x' && c[3] == '}';
+        bool dec = c[0] == '{' && c[1] == '}';
+        if((!hex && !dec) || next >= count)
+        {
+            ss << *c;
+            continue;
+        }
+
+        const LogArg& arg = args[next++];
+        if(hex) ss << std::hex;
+        switch(arg.type)
+        {
+            case LOG_ARG_UNSIGNED:
+                ss << arg.u;
+                break;
+            case LOG_ARG_SIGNED:
+                ss << arg.i;
+                break;
+            case LOG_ARG_STRING:
+                ss << arg.s;
+                break;
+        }
+        ss << std::dec;
+        c += hex ? 3 : 1;
+    }
+    return ss.str();
+}
@@ -0,0 +1,134 @@
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <core/logging/logging.hpp>
+
+/**
+ * @brief Counts the occurrences of a string
+ * 
+ * @param text Text to search
+ * @param pattern String to count
+ * @return int Number of occurrences
+ */
+int count_occurrences(const std::string& text, const std::string& pattern)
+{
+    int count = 0;
+    for(size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1))
+        count++;
+    return count;
+}
+
+/**
+ * @brief Returns the argument and counts the calls
+ * 
+ * @param calls Call counter
+ * @return int 
+ */
+int side_effect(int& calls)
+{
+    calls++;
+    return calls;
+}
+
+/**
+ * @brief Tests the formatting of the arguments
+ * 
+ */
+void test_logging_format()
+{
+    std::cout << "Logging Format: ";
+    std::stringstream out;
+    Logger::get().set_output(&out);
+    LOG_WARN(LOG_BUS, "Write to 0x{:x}: {} ({}) {}", 0x1f801000u, -5, "bytes", 7);
+    Logger::get().flush();
+    if(out.str() == "[BUS] WARN: Write to 0x1f801000: -5 (bytes) 7\n") std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+/**
+ * @brief Tests that disabled levels do not evaluate their arguments, at compile time and at runtime
+ * 
+ */
+void test_logging_levels()
+{
+    std::cout << "Logging Levels: ";
+    std::stringstream out;
+    Logger::get().set_output(&out);
+    int calls = 0;
+    //TRACE is below the default WOLPSX_LOG_MIN_LEVEL and compiled out
+    LOG_TRACE(LOG_CPU, "{}", side_effect(calls));
+    //DEBUG is compiled in but below the runtime level of the category
+    LOG_DEBUG(LOG_CPU, "{}", side_effect(calls));
+    Logger::get().set_level(LOG_CPU, LOG_LEVEL_DEBUG);
+    LOG_DEBUG(LOG_CPU, "{}", side_effect(calls));
+    Logger::get().set_level(LOG_CPU, LOG_LEVEL_INFO);
+    Logger::get().flush();
+    if(calls == 1 && out.str() == "[CPU] DEBUG: 1\n") std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+/**
+ * @brief Tests that LOG_ONCE and LOG_LIMIT stop logging a call site
+ * 
+ */
+void test_logging_limit()
+{
+    std::cout << "Logging Limit: ";
+    std::stringstream out;
+    Logger::get().set_output(&out);
+    for(int i = 0; i < 100; i++)
+    {
+        LOG_ONCE(LOG_LEVEL_WARN, LOG_SPU, "once {}", i);
+        LOG_LIMIT(3, LOG_LEVEL_WARN, LOG_DMA, "limited {}", i);
+    }
+    Logger::get().flush();
+    std::string text = out.str();
+    bool once = count_occurrences(text, "once") == 1;
+    bool limited = count_occurrences(text, "[DMA] WARN: limited") == 3 && count_occurrences(text, "Suppressing further messages: limited {}") == 1;
+    if(once && limited) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+/**
+ * @brief Tests that messages from several threads are all written, or counted as dropped when the ring is full
+ * 
+ */
+void test_logging_threads()
+{
+    std::cout << "Logging Threads: ";
+    std::stringstream out;
+    Logger::get().set_output(&out);
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; t++)
+        threads.emplace_back([t] {
+            for(int i = 0; i < 1000; i++)
+                LOG_INFO(LOG_CDROM, "thread {} message {}", t, i);
+        });
+    for(std::thread& thread : threads)
+        thread.join();
+    Logger::get().flush();
+
+    std::string text = out.str();
+    int written = count_occurrences(text, "[CDROM] INFO: thread");
+    int dropped = 0;
+    size_t pos = text.find("[LOG] WARN: ");
+    while(pos != std::string::npos)
+    {
+        dropped += std::stoi(text.substr(pos + 12));
+        pos = text.find("[LOG] WARN: ", pos + 1);
+    }
+    if(written + dropped == 4000 && written >= LOG_RING_SIZE / 2) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+int main()
+{
+    test_logging_format();
+    test_logging_levels();
+    test_logging_limit();
+    test_logging_threads();
+    Logger::get().set_output(&std::cerr);
+    return 0;
+}
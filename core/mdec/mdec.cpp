@@ -0,0 +1,340 @@
+#include <cstring>
+
+#include "core/mdec/mdec.hpp"
+#include "core/interconnect/bus.hpp"
+
+/**
+ * @brief Position in the block of the n-th coefficient of the zigzag scan.
+ * 
+ */
+static const uint8_t zagzig[64] = {
+     0,  1,  8, 16,  9,  2,  3, 10,
+    17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34,
+    27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36,
+    29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46,
+    53, 60, 61, 54, 47, 55, 62, 63
+};
+
+/**
+ * @brief Sign extends the 10-bit coefficient of a run length code.
+ * 
+ * @param code Run length code
+ * @return int32_t Coefficient
+ */
+static inline int32_t coefficient(uint16_t code)
+{
+    return int32_t(uint32_t(code) << 22) >> 22;
+}
+
+/**
+ * @brief Construct a new MDEC:: MDEC object
+ * 
+ * The quantization and scale tables are cleared, software uploads them before decoding.
+ */
+MDEC::MDEC()
+{
+    bus = nullptr;
+    memset(quant_y, 0, sizeof(quant_y));
+    memset(quant_uv, 0, sizeof(quant_uv));
+    int16_t zero[64] = {0};
+    set_scale_table(zero);
+    control = 0;
+    reset();
+}
+
+/**
+ * @brief Aborts the current command and clears the FIFOs.
+ * 
+ */
+void MDEC::reset()
+{
+    command = 0;
+    remaining = 0;
+    params.clear();
+    output.clear();
+    output_index = 0;
+}
+
+/**
+ * @brief Reads one of the MDEC registers.
+ * 
+ * @param offset Offset from the start of the MDEC range
+ * @return uint32_t Output word for the data register, status for the control register
+ * 
+ * \b References:
+ * @ref read_data
+ */
+uint32_t MDEC::read32_cpu(uint32_t offset)
+{
+    if(offset == MDEC_REG_DATA)
+    {
+        uint32_t word = 0;
+        if(output_words()) read_data(&word, 1);
+        return word;
+    }
+
+    bool empty = output_words() == 0;
+    uint32_t status = (remaining - 1) & 0xffff;
+    //depth, signed and bit 15 of the current command
+    status |= ((command >> 25) & 0xf) << 23;
+    if(empty) status |= MDEC_STATUS_OUT_EMPTY;
+    if(remaining || !empty) status |= MDEC_STATUS_BUSY;
+    if(control & MDEC_CONTROL_DATA_IN_REQUEST) status |= MDEC_STATUS_DATA_IN_REQUEST;
+    if((control & MDEC_CONTROL_DATA_OUT_REQUEST) && !empty) status |= MDEC_STATUS_DATA_OUT_REQUEST;
+    return status;
+}
+
+/**
+ * @brief Writes one of the MDEC registers.
+ * 
+ * @param offset Offset from the start of the MDEC range
+ * @param data Command or parameter word for the data register, control word for the control register
+ * 
+ * \b References:
+ * @ref write_word
+ * @ref reset
+ * @ref Bus::dma_request
+ */
+void MDEC::write32_cpu(uint32_t offset, uint32_t data)
+{
+    if(offset == MDEC_REG_DATA)
+    {
+        write_word(data);
+        return;
+    }
+
+    if(data & MDEC_CONTROL_RESET) reset();
+    control = data & (MDEC_CONTROL_DATA_IN_REQUEST | MDEC_CONTROL_DATA_OUT_REQUEST);
+    if(control & MDEC_CONTROL_DATA_OUT_REQUEST && output_words())
+        bus->dma_request(DMA_MDEC_OUT);
+}
+
+/**
+ * @brief Receives a block of command and parameter words from DMA channel 0.
+ * 
+ * @param data Words to write
+ * @param count Number of words
+ * 
+ * \b References:
+ * @ref write_word
+ */
+void MDEC::write_data(const uint32_t* data, uint32_t count)
+{
+    for(uint32_t i = 0; i < count; i++)
+        write_word(data[i]);
+}
+
+/**
+ * @brief Copies words out of the output FIFO for DMA channel 1.
+ * 
+ * @param data Buffer for the words
+ * @param count Number of words, at most output_words()
+ */
+void MDEC::read_data(uint32_t* data, uint32_t count)
+{
+    memcpy(data, output.data() + output_index, count * 4);
+    output_index += count * 4;
+    if(output_index == output.size())
+    {
+        output.clear();
+        output_index = 0;
+    }
+}
+
+/**
+ * @brief Handles a word written to the data register.
+ * 
+ * @param data Command, or parameter of the current command
+ * 
+ * \b References:
+ * @ref start_command
+ * @ref execute_command
+ */
+void MDEC::write_word(uint32_t data)
+{
+    if(remaining == 0)
+    {
+        start_command(data);
+        return;
+    }
+
+    params.push_back(data);
+    if(--remaining == 0) execute_command();
+}
+
+/**
+ * @brief Starts a command and sets the number of parameter words it takes.
+ * 
+ * Unknown commands take no parameters and are ignored.
+ * 
+ * @param command Command word
+ * 
+ * \b References:
+ * @ref execute_command
+ */
+void MDEC::start_command(uint32_t command)
+{
+    this->command = command;
+    params.clear();
+
+    switch(command >> 29)
+    {
+        case MDEC_CMD_DECODE:
+            remaining = command & 0xffff;
+            break;
+        case MDEC_CMD_SET_QUANT:
+            remaining = (command & 1) ? 32 : 16;
+            break;
+        case MDEC_CMD_SET_SCALE:
+            remaining = 32;
+            break;
+        default:
+            remaining = 0;
+            break;
+    }
+
+    if(remaining == 0) execute_command();
+}
+
+/**
+ * @brief Executes the current command once all its parameters have been received.
+ * 
+ * \b References:
+ * @ref decode_macroblocks
+ * @ref set_scale_table
+ * @ref Bus::dma_request
+ */
+void MDEC::execute_command()
+{
+    switch(command >> 29)
+    {
+        case MDEC_CMD_DECODE:
+            decode_macroblocks();
+            if(control & MDEC_CONTROL_DATA_OUT_REQUEST && output_words())
+                bus->dma_request(DMA_MDEC_OUT);
+            break;
+        case MDEC_CMD_SET_QUANT:
+        {
+            const uint8_t* bytes = (const uint8_t*)params.data();
+            memcpy(quant_y, bytes, 64);
+            if(command & 1) memcpy(quant_uv, bytes + 64, 64);
+            break;
+        }
+        case MDEC_CMD_SET_SCALE:
+            set_scale_table((const int16_t*)params.data());
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Sets the scale table and derives the tables used by the IDCT.
+ * 
+ * @param table 64 signed entries
+ */
+void MDEC::set_scale_table(const int16_t* table)
+{
+    memcpy(scale, table, sizeof(scale));
+    for(int i = 0; i < 64; i++)
+        idct_table[i] = scale[i] / 8;
+
+    for(int p = 0; p < 4; p++)
+    {
+        for(int x = 0; x < 8; x++)
+        {
+            idct_pairs[p][x * 2] = idct_table[(2 * p) * 8 + x];
+            idct_pairs[p][x * 2 + 1] = idct_table[(2 * p + 1) * 8 + x];
+        }
+    }
+}
+
+/**
+ * @brief Decodes all the macroblocks in the parameters of the decode command.
+ * 
+ * Colour macroblocks are made of the Cr, Cb and four Y blocks, monochrome ones of a single Y block. A macroblock cut short by the end of the data is dropped.
+ * 
+ * \b References:
+ * @ref decode_block
+ * @ref output_color
+ * @ref output_mono
+ */
+void MDEC::decode_macroblocks()
+{
+    MDECDepth depth = MDECDepth((command >> 27) & 3);
+    bool color = depth == MDEC_DEPTH_24BIT || depth == MDEC_DEPTH_15BIT;
+    alignas(16) int16_t blocks[6][64];
+    uint32_t index = 0;
+
+    while(true)
+    {
+        if(color)
+        {
+            bool complete = decode_block(blocks[0], quant_uv, index) && decode_block(blocks[1], quant_uv, index);
+            for(int i = 2; i < 6 && complete; i++)
+                complete = decode_block(blocks[i], quant_y, index);
+            if(!complete) break;
+            output_color(&blocks[0][0]);
+        }
+        else
+        {
+            if(!decode_block(blocks[0], quant_y, index)) break;
+            output_mono(blocks[0]);
+        }
+    }
+}
+
+/**
+ * @brief Run length decodes, dequantizes and transforms one 8x8 block.
+ * 
+ * The first code holds the quantization scale and the DC coefficient, each following one the number of zero coefficients to skip and the next coefficient. A scale of 0 disables the zigzag reordering and the quantization table.
+ * 
+ * @param block Output block
+ * @param quant Quantization table (zigzag order)
+ * @param index Position in the parameters (halfwords), advanced past the block
+ * @return true The block was decoded
+ * @return false The parameters ended before the block
+ * 
+ * \b References:
+ * @ref idct
+ */
+bool MDEC::decode_block(int16_t* block, const uint8_t* quant, uint32_t& index)
+{
+    const uint16_t* codes = (const uint16_t*)params.data();
+    uint32_t total = params.size() * 2;
+
+    //skip padding
+    uint16_t code;
+    do
+    {
+        if(index >= total) return false;
+        code = codes[index++];
+    } while(code == 0xfe00);
+
+    memset(block, 0, 64 * sizeof(int16_t));
+    uint32_t k = 0;
+    int32_t q_scale = (code >> 10) & 0x3f;
+    int32_t value = coefficient(code) * quant[0];
+
+    while(true)
+    {
+        if(q_scale == 0) value = coefficient(code) * 2;
+        if(value < -0x400) value = -0x400;
+        if(value > 0x3ff) value = 0x3ff;
+
+        if(q_scale > 0) block[zagzig[k]] = value;
+        else block[k] = value;
+
+        if(index >= total) break;
+        code = codes[index++];
+        k += ((code >> 10) & 0x3f) + 1;
+        if(k > 63) break;
+        value = (coefficient(code) * quant[k] * q_scale + 4) / 8;
+    }
+
+    idct(block);
+    return true;
+}
@@ -0,0 +1,287 @@
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MDEC_SSE2
+#endif
+
+#include "core/mdec/mdec.hpp"
+
+/**
+ * @brief YUV to RGB coefficients in 8.8 fixed point.
+ * 
+ * R = 1.402 Cr, G = -0.3437 Cb - 0.7143 Cr, B = 1.772 Cb
+ */
+#define MDEC_CR_TO_R 359
+#define MDEC_CB_TO_G -88
+#define MDEC_CR_TO_G -183
+#define MDEC_CB_TO_B 454
+
+#ifdef MDEC_SSE2
+/**
+ * @brief Transposes an 8x8 matrix of 16-bit values held in eight registers.
+ * 
+ * @param r Rows of the matrix, replaced by its columns
+ */
+static inline void transpose8x8(__m128i* r)
+{
+    __m128i a0 = _mm_unpacklo_epi16(r[0], r[1]);
+    __m128i a1 = _mm_unpackhi_epi16(r[0], r[1]);
+    __m128i a2 = _mm_unpacklo_epi16(r[2], r[3]);
+    __m128i a3 = _mm_unpackhi_epi16(r[2], r[3]);
+    __m128i a4 = _mm_unpacklo_epi16(r[4], r[5]);
+    __m128i a5 = _mm_unpackhi_epi16(r[4], r[5]);
+    __m128i a6 = _mm_unpacklo_epi16(r[6], r[7]);
+    __m128i a7 = _mm_unpackhi_epi16(r[6], r[7]);
+
+    __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+    __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+    __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+    __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+    __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+    __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+    __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+    __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+
+    r[0] = _mm_unpacklo_epi64(b0, b4);
+    r[1] = _mm_unpackhi_epi64(b0, b4);
+    r[2] = _mm_unpacklo_epi64(b1, b5);
+    r[3] = _mm_unpackhi_epi64(b1, b5);
+    r[4] = _mm_unpacklo_epi64(b2, b6);
+    r[5] = _mm_unpackhi_epi64(b2, b6);
+    r[6] = _mm_unpacklo_epi64(b3, b7);
+    r[7] = _mm_unpackhi_epi64(b3, b7);
+}
+#endif
+
+/**
+ * @brief Applies the inverse DCT to a block in place.
+ * 
+ * Two passes of dst[y][x] = (sum(src[z][y] * scale[z][x] / 8) + 0xfff) >> 13, each of which also transposes the block. With SSE2 the block is transposed first so that every output row is a sum of four multiply-adds of a broadcast pair of coefficients with a pair of interleaved rows of the scale table.
+ * 
+ * @param block Dequantized coefficients, replaced by the samples
+ */
+void MDEC::idct(int16_t* block)
+{
+#ifdef MDEC_SSE2
+    __m128i rows[8];
+    for(int i = 0; i < 8; i++)
+        rows[i] = _mm_loadu_si128((const __m128i*)(block + i * 8));
+
+    const __m128i round = _mm_set1_epi32(0xfff);
+    __m128i pairs_lo[4], pairs_hi[4];
+    for(int p = 0; p < 4; p++)
+    {
+        pairs_lo[p] = _mm_load_si128((const __m128i*)idct_pairs[p]);
+        pairs_hi[p] = _mm_load_si128((const __m128i*)(idct_pairs[p] + 8));
+    }
+
+    for(int pass = 0; pass < 2; pass++)
+    {
+        transpose8x8(rows);
+        for(int y = 0; y < 8; y++)
+        {
+            __m128i z01 = _mm_shuffle_epi32(rows[y], 0x00);
+            __m128i z23 = _mm_shuffle_epi32(rows[y], 0x55);
+            __m128i z45 = _mm_shuffle_epi32(rows[y], 0xaa);
+            __m128i z67 = _mm_shuffle_epi32(rows[y], 0xff);
+
+            __m128i lo = _mm_add_epi32(
+                _mm_add_epi32(_mm_madd_epi16(z01, pairs_lo[0]), _mm_madd_epi16(z23, pairs_lo[1])),
+                _mm_add_epi32(_mm_madd_epi16(z45, pairs_lo[2]), _mm_madd_epi16(z67, pairs_lo[3])));
+            __m128i hi = _mm_add_epi32(
+                _mm_add_epi32(_mm_madd_epi16(z01, pairs_hi[0]), _mm_madd_epi16(z23, pairs_hi[1])),
+                _mm_add_epi32(_mm_madd_epi16(z45, pairs_hi[2]), _mm_madd_epi16(z67, pairs_hi[3])));
+
+            lo = _mm_srai_epi32(_mm_add_epi32(lo, round), 13);
+            hi = _mm_srai_epi32(_mm_add_epi32(hi, round), 13);
+            rows[y] = _mm_packs_epi32(lo, hi);
+        }
+    }
+
+    for(int i = 0; i < 8; i++)
+        _mm_storeu_si128((__m128i*)(block + i * 8), rows[i]);
+#else
+    int16_t temp[64];
+    int16_t* src = block;
+    int16_t* dst = temp;
+    for(int pass = 0; pass < 2; pass++)
+    {
+        for(int x = 0; x < 8; x++)
+        {
+            for(int y = 0; y < 8; y++)
+            {
+                int32_t sum = 0;
+                for(int z = 0; z < 8; z++)
+                    sum += src[y + z * 8] * idct_table[x + z * 8];
+                sum = (sum + 0xfff) >> 13;
+                if(sum < -0x8000) sum = -0x8000;
+                if(sum > 0x7fff) sum = 0x7fff;
+                dst[x + y * 8] = sum;
+            }
+        }
+        int16_t* swap = src;
+        src = dst;
+        dst = swap;
+    }
+#endif
+}
+
+/**
+ * @brief Converts eight pixels of a row from YUV to clamped RGB.
+ * 
+ * @param y Eight luminance samples
+ * @param cr Four Cr samples, each covering two pixels
+ * @param cb Four Cb samples, each covering two pixels
+ * @param is_signed Whether the output is signed (-128 - 127) instead of unsigned (0 - 255)
+ * @param r Eight red values
+ * @param g Eight green values
+ * @param b Eight blue values
+ */
+static void convert_row(const int16_t* y, const int16_t* cr, const int16_t* cb, bool is_signed, uint8_t* r, uint8_t* g, uint8_t* b)
+{
+#ifdef MDEC_SSE2
+    __m128i vcr = _mm_loadl_epi64((const __m128i*)cr);
+    __m128i vcb = _mm_loadl_epi64((const __m128i*)cb);
+    vcr = _mm_unpacklo_epi16(vcr, vcr);
+    vcb = _mm_unpacklo_epi16(vcb, vcb);
+
+    //(Cb, Cr) pairs multiplied with (Cb, Cr) coefficient pairs
+    __m128i lo = _mm_unpacklo_epi16(vcb, vcr);
+    __m128i hi = _mm_unpackhi_epi16(vcb, vcr);
+    const __m128i to_r = _mm_set1_epi32(int32_t(uint32_t(MDEC_CR_TO_R) << 16));
+    const __m128i to_g = _mm_set1_epi32(int32_t((uint32_t(uint16_t(MDEC_CR_TO_G)) << 16) | uint16_t(MDEC_CB_TO_G)));
+    const __m128i to_b = _mm_set1_epi32(MDEC_CB_TO_B);
+
+    __m128i vr = _mm_packs_epi32(_mm_srai_epi32(_mm_madd_epi16(lo, to_r), 8), _mm_srai_epi32(_mm_madd_epi16(hi, to_r), 8));
+    __m128i vg = _mm_packs_epi32(_mm_srai_epi32(_mm_madd_epi16(lo, to_g), 8), _mm_srai_epi32(_mm_madd_epi16(hi, to_g), 8));
+    __m128i vb = _mm_packs_epi32(_mm_srai_epi32(_mm_madd_epi16(lo, to_b), 8), _mm_srai_epi32(_mm_madd_epi16(hi, to_b), 8));
+
+    __m128i vy = _mm_loadu_si128((const __m128i*)y);
+    //the saturating pack clamps to -128 - 127
+    vr = _mm_packs_epi16(_mm_adds_epi16(vy, vr), vy);
+    vg = _mm_packs_epi16(_mm_adds_epi16(vy, vg), vy);
+    vb = _mm_packs_epi16(_mm_adds_epi16(vy, vb), vy);
+
+    if(!is_signed)
+    {
+        const __m128i bias = _mm_set1_epi8(char(0x80));
+        vr = _mm_xor_si128(vr, bias);
+        vg = _mm_xor_si128(vg, bias);
+        vb = _mm_xor_si128(vb, bias);
+    }
+
+    _mm_storel_epi64((__m128i*)r, vr);
+    _mm_storel_epi64((__m128i*)g, vg);
+    _mm_storel_epi64((__m128i*)b, vb);
+#else
+    for(int x = 0; x < 8; x++)
+    {
+        int32_t vcr = cr[x / 2];
+        int32_t vcb = cb[x / 2];
+        int32_t values[3] = {
+            y[x] + ((MDEC_CR_TO_R * vcr) >> 8),
+            y[x] + ((MDEC_CB_TO_G * vcb + MDEC_CR_TO_G * vcr) >> 8),
+            y[x] + ((MDEC_CB_TO_B * vcb) >> 8)
+        };
+        uint8_t* out[3] = {r, g, b};
+        for(int c = 0; c < 3; c++)
+        {
+            int32_t v = values[c];
+            if(v < -128) v = -128;
+            if(v > 127) v = 127;
+            out[c][x] = uint8_t(v) ^ (is_signed ? 0 : 0x80);
+        }
+    }
+#endif
+}
+
+/**
+ * @brief Converts a decoded colour macroblock to RGB and appends it to the output FIFO.
+ * 
+ * The 16x16 pixels are output row by row, as 24-bit RGB (3 bytes per pixel) or 15-bit RGB with the bit 15 of the command.
+ * 
+ * @param blocks Cr, Cb, Y1 (top left), Y2 (top right), Y3 (bottom left) and Y4 (bottom right) blocks, 64 samples each
+ */
+void MDEC::output_color(const int16_t* blocks)
+{
+    MDECDepth depth = MDECDepth((command >> 27) & 3);
+    bool is_signed = command & (1 << 26);
+    uint16_t bit15 = (command & (1 << 25)) ? 0x8000 : 0;
+
+    size_t base = output.size();
+    output.resize(base + (depth == MDEC_DEPTH_24BIT ? 16 * 16 * 3 : 16 * 16 * 2));
+    uint8_t* out = output.data() + base;
+
+    const int16_t* cr = blocks;
+    const int16_t* cb = blocks + 64;
+    alignas(16) uint8_t r[8], g[8], b[8];
+
+    for(int y = 0; y < 16; y++)
+    {
+        for(int xx = 0; xx < 16; xx += 8)
+        {
+            const int16_t* luma = blocks + (2 + (y >= 8) * 2 + (xx >= 8)) * 64 + (y & 7) * 8;
+            int chroma = (y / 2) * 8 + xx / 2;
+            convert_row(luma, cr + chroma, cb + chroma, is_signed, r, g, b);
+
+            if(depth == MDEC_DEPTH_24BIT)
+            {
+                for(int x = 0; x < 8; x++)
+                {
+                    *out++ = r[x];
+                    *out++ = g[x];
+                    *out++ = b[x];
+                }
+                continue;
+            }
+
+#ifdef MDEC_SSE2
+            const __m128i zero = _mm_setzero_si128();
+            __m128i vr = _mm_srli_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)r), zero), 3);
+            __m128i vg = _mm_srli_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)g), zero), 3);
+            __m128i vb = _mm_srli_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)b), zero), 3);
+            __m128i pixels = _mm_or_si128(_mm_or_si128(vr, _mm_slli_epi16(vg, 5)), _mm_or_si128(_mm_slli_epi16(vb, 10), _mm_set1_epi16(bit15)));
+            _mm_storeu_si128((__m128i*)out, pixels);
+#else
+            for(int x = 0; x < 8; x++)
+            {
+                uint16_t pixel = (r[x] >> 3) | ((g[x] >> 3) << 5) | ((b[x] >> 3) << 10) | bit15;
+                memcpy(out + x * 2, &pixel, 2);
+            }
+#endif
+            out += 16;
+        }
+    }
+}
+
+/**
+ * @brief Appends a decoded monochrome block to the output FIFO.
+ * 
+ * The 8x8 pixels are output as 8-bit values, or packed two per byte (low nibble first) for 4-bit output.
+ * 
+ * @param block Y block
+ */
+void MDEC::output_mono(const int16_t* block)
+{
+    MDECDepth depth = MDECDepth((command >> 27) & 3);
+    bool is_signed = command & (1 << 26);
+
+    uint8_t pixels[64];
+    for(int i = 0; i < 64; i++)
+    {
+        int32_t v = block[i];
+        if(v < -128) v = -128;
+        if(v > 127) v = 127;
+        pixels[i] = uint8_t(v) ^ (is_signed ? 0 : 0x80);
+    }
+
+    if(depth == MDEC_DEPTH_8BIT)
+    {
+        output.insert(output.end(), pixels, pixels + 64);
+        return;
+    }
+
+    for(int i = 0; i < 64; i += 2)
+        output.push_back((pixels[i] >> 4) | (pixels[i + 1] & 0xf0));
+}
@@ -0,0 +1,231 @@
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <core/interconnect/bus.hpp>
+#include <core/dma/dma.hpp>
+#include <core/mdec/mdec.hpp>
+#include <test_bios.hpp>
+
+#define TEST_BIOS_PATH "mdec_test_bios.bin"
+#define DMA_BASE 0x1f801080
+#define MDEC_BASE 0x1f801820
+#define INPUT_ADDR 0x10000
+#define OUTPUT_ADDR 0x40000
+#define MACROBLOCKS 4
+
+static const uint8_t zagzig[64] = {
+     0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63
+};
+
+/**
+ * @brief Builds the standard IDCT scale table used by the BIOS
+ * 
+ * @param scale 64 entries
+ */
+void build_scale_table(int16_t* scale)
+{
+    for(int u = 0; u < 8; u++)
+    {
+        double c = u == 0 ? std::sqrt(0.5) : 1.0;
+        for(int x = 0; x < 8; x++)
+            scale[u * 8 + x] = int16_t(std::lround(32768.0 * 0.5 * c * std::cos((2 * x + 1) * u * M_PI / 16)));
+    }
+}
+
+/**
+ * @brief Reference decoder of one block, written after the documented hardware algorithm
+ * 
+ * @param codes Run length codes
+ * @param index Position in the codes, advanced past the block
+ * @param quant Quantization table
+ * @param scale Scale table
+ * @param out Decoded block
+ */
+void reference_block(const std::vector<uint16_t>& codes, size_t& index, const uint8_t* quant, const int16_t* scale, int16_t* out)
+{
+    int32_t coeffs[64] = {0};
+    uint16_t n = codes[index++];
+    while(n == 0xfe00) n = codes[index++];
+    int32_t q = n >> 10;
+    uint32_t k = 0;
+    int32_t val = (int32_t(n << 22) >> 22) * quant[0];
+    while(true)
+    {
+        if(q == 0) val = (int32_t(n << 22) >> 22) * 2;
+        val = std::min(std::max(val, -0x400), 0x3ff);
+        coeffs[q > 0 ? zagzig[k] : k] = val;
+        n = codes[index++];
+        k += (n >> 10) + 1;
+        if(k > 63) break;
+        val = ((int32_t(n << 22) >> 22) * quant[k] * q + 4) / 8;
+    }
+
+    int32_t temp[64];
+    int32_t* src = coeffs;
+    int32_t* dst = temp;
+    for(int pass = 0; pass < 2; pass++)
+    {
+        for(int x = 0; x < 8; x++)
+        {
+            for(int y = 0; y < 8; y++)
+            {
+                int32_t sum = 0;
+                for(int z = 0; z < 8; z++)
+                    sum += src[y + z * 8] * (scale[x + z * 8] / 8);
+                dst[x + y * 8] = std::min(std::max((sum + 0xfff) >> 13, -0x8000), 0x7fff);
+            }
+        }
+        std::swap(src, dst);
+    }
+    for(int i = 0; i < 64; i++)
+        out[i] = src[i];
+}
+
+/**
+ * @brief Reference colour conversion of a decoded macroblock to 24-bit or 15-bit pixels
+ * 
+ * @param blocks Cr, Cb, Y1 - Y4
+ * @param depth Output depth
+ * @param out Output bytes
+ */
+void reference_color(int16_t blocks[6][64], MDECDepth depth, std::vector<uint8_t>& out)
+{
+    for(int y = 0; y < 16; y++)
+    {
+        for(int x = 0; x < 16; x++)
+        {
+            int32_t cr = blocks[0][(y / 2) * 8 + x / 2];
+            int32_t cb = blocks[1][(y / 2) * 8 + x / 2];
+            int32_t luma = blocks[2 + (y / 8) * 2 + x / 8][(y % 8) * 8 + x % 8];
+            int32_t rgb[3] = {luma + ((359 * cr) >> 8), luma + ((-88 * cb - 183 * cr) >> 8), luma + ((454 * cb) >> 8)};
+            uint8_t c[3];
+            for(int i = 0; i < 3; i++)
+                c[i] = uint8_t(std::min(std::max(rgb[i], -128), 127)) ^ 0x80;
+            if(depth == MDEC_DEPTH_24BIT)
+            {
+                out.insert(out.end(), c, c + 3);
+            }
+            else
+            {
+                uint16_t pixel = (c[0] >> 3) | ((c[1] >> 3) << 5) | ((c[2] >> 3) << 10);
+                out.push_back(pixel & 0xff);
+                out.push_back(pixel >> 8);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Generates run length codes for a random block
+ * 
+ * @param rng 
+ * @param codes Codes to append to
+ */
+void random_block(std::mt19937& rng, std::vector<uint16_t>& codes)
+{
+    std::uniform_int_distribution<int> value(-512, 511);
+    std::uniform_int_distribution<int> run(0, 6);
+    std::uniform_int_distribution<int> q_scale(1, 63);
+    codes.push_back((q_scale(rng) << 10) | (value(rng) & 0x3ff));
+    int k = 0;
+    while(true)
+    {
+        int skip = run(rng);
+        if(k + skip + 1 > 63) break;
+        k += skip + 1;
+        codes.push_back((skip << 10) | (value(rng) & 0x3ff));
+    }
+    codes.push_back(0xfe00);
+}
+
+/**
+ * @brief Decodes random macroblocks through DMA channels 0 and 1 and compares the output with the reference decoder
+ * 
+ * @param bus 
+ * @param depth Output depth (24-bit or 15-bit)
+ * @param seed Seed of the random data
+ */
+void test_mdec_decode(Bus& bus, MDECDepth depth, uint32_t seed)
+{
+    std::cout << "MDEC Decode " << (depth == MDEC_DEPTH_24BIT ? "24-bit" : "15-bit") << ": ";
+    std::mt19937 rng(seed);
+
+    uint8_t quant[128];
+    for(int i = 0; i < 128; i++)
+        quant[i] = 1 + rng() % 32;
+    int16_t scale[64];
+    build_scale_table(scale);
+
+    //upload the tables through the data register
+    uint32_t words[32];
+    bus.write32_cpu(MDEC_BASE + MDEC_REG_CONTROL, MDEC_CONTROL_RESET);
+    bus.write32_cpu(MDEC_BASE + MDEC_REG_DATA, (MDEC_CMD_SET_QUANT << 29) | 1);
+    memcpy(words, quant, 128);
+    for(int i = 0; i < 32; i++)
+        bus.write32_cpu(MDEC_BASE + MDEC_REG_DATA, words[i]);
+    bus.write32_cpu(MDEC_BASE + MDEC_REG_DATA, MDEC_CMD_SET_SCALE << 29);
+    memcpy(words, scale, 128);
+    for(int i = 0; i < 32; i++)
+        bus.write32_cpu(MDEC_BASE + MDEC_REG_DATA, words[i]);
+
+    std::vector<uint16_t> codes;
+    for(int i = 0; i < MACROBLOCKS * 6; i++)
+        random_block(rng, codes);
+    //pad to a whole number of 32 word blocks
+    while(codes.size() % 64) codes.push_back(0xfe00);
+    uint32_t input_words = codes.size() / 2;
+    for(uint32_t i = 0; i < input_words; i++)
+        bus.write32_cpu(INPUT_ADDR + i * 4, codes[i * 2] | (uint32_t(codes[i * 2 + 1]) << 16));
+
+    std::vector<uint8_t> expected;
+    size_t index = 0;
+    for(int mb = 0; mb < MACROBLOCKS; mb++)
+    {
+        int16_t blocks[6][64];
+        for(int b = 0; b < 6; b++)
+            reference_block(codes, index, b < 2 ? quant + 64 : quant, scale, blocks[b]);
+        reference_color(blocks, depth, expected);
+    }
+    uint32_t output_words = expected.size() / 4;
+
+    bus.write32_cpu(DMA_BASE + DMA_REG_DPCR, DMA_DPCR_RESET | (8 << (DMA_MDEC_IN * 4)) | (8 << (DMA_MDEC_OUT * 4)));
+    bus.write32_cpu(MDEC_BASE + MDEC_REG_CONTROL, MDEC_CONTROL_DATA_IN_REQUEST | MDEC_CONTROL_DATA_OUT_REQUEST);
+
+    //the output channel waits for the decoded data
+    bus.write32_cpu(DMA_BASE + DMA_MDEC_OUT * 0x10 + DMA_REG_MADR, OUTPUT_ADDR);
+    bus.write32_cpu(DMA_BASE + DMA_MDEC_OUT * 0x10 + DMA_REG_BCR, ((output_words / 32) << 16) | 32);
+    bus.write32_cpu(DMA_BASE + DMA_MDEC_OUT * 0x10 + DMA_REG_CHCR, DMA_CHCR_START | (DMA_SYNC_BLOCK << DMA_CHCR_SYNC_SHIFT));
+
+    bus.write32_cpu(MDEC_BASE + MDEC_REG_DATA, (MDEC_CMD_DECODE << 29) | (depth << 27) | input_words);
+    bus.write32_cpu(DMA_BASE + DMA_MDEC_IN * 0x10 + DMA_REG_MADR, INPUT_ADDR);
+    bus.write32_cpu(DMA_BASE + DMA_MDEC_IN * 0x10 + DMA_REG_BCR, ((input_words / 32) << 16) | 32);
+    bus.write32_cpu(DMA_BASE + DMA_MDEC_IN * 0x10 + DMA_REG_CHCR, DMA_CHCR_START | DMA_CHCR_FROM_RAM | (DMA_SYNC_BLOCK << DMA_CHCR_SYNC_SHIFT));
+
+    bool match = true;
+    for(uint32_t i = 0; i < output_words; i++)
+    {
+        uint32_t word;
+        memcpy(&word, expected.data() + i * 4, 4);
+        match &= bus.read32_cpu(OUTPUT_ADDR + i * 4) == word;
+    }
+    bool done = (bus.read32_cpu(DMA_BASE + DMA_MDEC_OUT * 0x10 + DMA_REG_CHCR) & DMA_CHCR_START) == 0;
+    bool empty = bus.read32_cpu(MDEC_BASE + MDEC_REG_CONTROL) & MDEC_STATUS_OUT_EMPTY;
+    if(match && done && empty) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+int main()
+{
+    write_test_bios(TEST_BIOS_PATH, {0x0bf00000, 0x00000000}); //j 0xbfc00000
+    Bus bus(TEST_BIOS_PATH);
+
+    test_mdec_decode(bus, MDEC_DEPTH_24BIT, 1);
+    test_mdec_decode(bus, MDEC_DEPTH_15BIT, 2);
+    return 0;
+}
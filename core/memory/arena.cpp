@@ -0,0 +1,93 @@
+#include <sstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include "core/memory/arena.hpp"
+
+/**
+ * @brief Construct a new Arena:: Arena object
+ * 
+ * The block is mapped directly from the OS, page-aligned and zeroed. Pages are only backed by memory once they are written, so the parts of the machine that are never touched (most of the page tables, the private storage of shared memory) cost nothing, and creating and destroying a machine does not go through the heap.
+ * 
+ * @param capacity Size of the arena in bytes
+ * 
+ * @throw std::bad_alloc If the block could not be mapped
+ */
+Arena::Arena(size_t capacity) : capacity(capacity), used(0)
+{
+#ifdef _WIN32
+    block = (uint8_t*)VirtualAlloc(nullptr, capacity, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if(!block)
+        throw std::bad_alloc();
+#else
+    void* mapping = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(mapping == MAP_FAILED)
+        throw std::bad_alloc();
+    block = (uint8_t*)mapping;
+#endif
+}
+
+/**
+ * @brief Destroy the Arena:: Arena object
+ * 
+ * Destroys the objects in reverse order of construction, so objects may use the ones created before them, then unmaps the block.
+ */
+Arena::~Arena()
+{
+    for(auto it = destructors.rbegin(); it != destructors.rend(); it++)
+        it->destroy(it->object);
+#ifdef _WIN32
+    VirtualFree(block, 0, MEM_RELEASE);
+#else
+    munmap(block, capacity);
+#endif
+}
+
+/**
+ * @brief Allocates zeroed memory starting on a cache line.
+ * 
+ * @param size Size in bytes
+ * @return void* Allocated memory
+ * 
+ * @throw std::runtime_error If the arena is too small
+ */
+void* Arena::allocate(size_t size)
+{
+    size_t rounded = (size + ARENA_ALIGNMENT - 1) & ~size_t(ARENA_ALIGNMENT - 1);
+    if(rounded > capacity - used)
+    {
+        std::stringstream ss;
+        ss << "Arena exhausted: " << size << " bytes requested, " << capacity - used << " left";
+        throw std::runtime_error(ss.str());
+    }
+    void* memory = block + used;
+    used += rounded;
+    return memory;
+}
+
+/**
+ * @brief Returns the number of bytes handed out.
+ * 
+ * @return size_t Used size
+ */
+size_t Arena::get_used()
+{
+    return used;
+}
+
+/**
+ * @brief Returns the size of the arena.
+ * 
+ * @return size_t Capacity in bytes
+ */
+size_t Arena::get_capacity()
+{
+    return capacity;
+}
@@ -0,0 +1,150 @@
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include "core/memory/cow_memory.hpp"
+
+/**
+ * @brief Construct a new CowMemory:: CowMemory object
+ * 
+ * Every page starts private and zeroed.
+ * 
+ * @param arena Arena of the machine, which must have arena_size(size) bytes left
+ * @param size Size of the memory in bytes
+ * 
+ * @throw std::runtime_error If the size is not a multiple of the page size
+ */
+CowMemory::CowMemory(Arena& arena, uint32_t size) : size(size)
+{
+    if(size == 0 || (size & COW_PAGE_MASK))
+    {
+        std::stringstream ss;
+        ss << "Invalid copy-on-write memory size: 0x" << std::hex << size;
+        throw std::runtime_error(ss.str());
+    }
+    data = arena.create_array<uint8_t>(size);
+    pages = arena.create_array<uint8_t*>(size >> COW_PAGE_SHIFT);
+    shared = arena.create_array<CowPage*>(size >> COW_PAGE_SHIFT);
+    for(uint32_t page = 0; page < size >> COW_PAGE_SHIFT; page++)
+        pages[page] = data + (page << COW_PAGE_SHIFT);
+}
+
+/**
+ * @brief Destroy the CowMemory:: CowMemory object
+ * 
+ * Releases the shared pages.
+ */
+CowMemory::~CowMemory()
+{
+    for(uint32_t page = 0; page < size >> COW_PAGE_SHIFT; page++)
+        if(shared[page])
+            release(shared[page]);
+}
+
+/**
+ * @brief Returns the space a memory takes in an arena.
+ * 
+ * The CowMemory object itself is not included.
+ * 
+ * @param size Size of the memory in bytes
+ * @return size_t Size in bytes
+ */
+size_t CowMemory::arena_size(uint32_t size)
+{
+    return ::arena_size<uint8_t>(size) + ::arena_size<uint8_t*>(size >> COW_PAGE_SHIFT) +
+        ::arena_size<CowPage*>(size >> COW_PAGE_SHIFT);
+}
+
+/**
+ * @brief Returns the whole memory as one block.
+ * 
+ * The shared pages are copied into their slots of the private storage, which are otherwise unused, and stay shared.
+ * 
+ * @return const uint8_t* Private storage, valid until the next write
+ */
+const uint8_t* CowMemory::flatten()
+{
+    for(uint32_t page = 0; page < size >> COW_PAGE_SHIFT; page++)
+        if(shared[page])
+            memcpy(data + (page << COW_PAGE_SHIFT), shared[page]->data, COW_PAGE_SIZE);
+    return data;
+}
+
+/**
+ * @brief Shares every page of another memory of the same size.
+ * 
+ * The private pages of the parent are moved to new shared pages first. The parent and this memory both change their host addresses, without calling the unshare callback, so their owners must reload all of them.
+ * 
+ * @param parent Memory to share the pages of
+ * 
+ * @throw std::runtime_error If the sizes differ
+ */
+void CowMemory::fork_from(CowMemory& parent)
+{
+    if(parent.size != size)
+        throw std::runtime_error("Forking a copy-on-write memory of a different size");
+
+    for(uint32_t page = 0; page < size >> COW_PAGE_SHIFT; page++)
+    {
+        CowPage* frozen = parent.shared[page];
+        if(!frozen)
+        {
+            frozen = new CowPage;
+            frozen->refs.store(1, std::memory_order_relaxed);
+            memcpy(frozen->data, parent.data + (page << COW_PAGE_SHIFT), COW_PAGE_SIZE);
+            parent.shared[page] = frozen;
+            parent.pages[page] = frozen->data;
+        }
+        frozen->refs.fetch_add(1, std::memory_order_relaxed);
+        if(shared[page])
+            release(shared[page]);
+        shared[page] = frozen;
+        pages[page] = frozen->data;
+    }
+}
+
+/**
+ * @brief Returns the number of shared pages.
+ * 
+ * @return uint32_t Number of pages
+ */
+uint32_t CowMemory::count_shared()
+{
+    uint32_t count = 0;
+    for(uint32_t page = 0; page < size >> COW_PAGE_SHIFT; page++)
+        if(shared[page])
+            count++;
+    return count;
+}
+
+/**
+ * @brief Copies a shared page into the private storage and releases it.
+ * 
+ * @param page Index of the page
+ * 
+ * \b References:
+ * @ref unshare_callback
+ */
+void CowMemory::unshare(uint32_t page)
+{
+    uint8_t* slot = data + (page << COW_PAGE_SHIFT);
+    memcpy(slot, shared[page]->data, COW_PAGE_SIZE);
+    release(shared[page]);
+    shared[page] = nullptr;
+    pages[page] = slot;
+    if(unshare_callback)
+        unshare_callback(page);
+}
+
+/**
+ * @brief Drops a reference to a shared page, freeing it with the last one.
+ * 
+ * Machines sharing a page may run on different threads, so the count is atomic.
+ * 
+ * @param page Shared page
+ */
+void CowMemory::release(CowPage* page)
+{
+    if(page->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        delete page;
+}
@@ -1,3 +1,4 @@
+#include <cstring>
 #include <iostream>
 #include <sstream>
 
@@ -6,13 +7,87 @@
 /**
  * @brief Construct a new RAM:: RAM object
  * 
- * Initializes the RAM with 0xca.
+ * Allocates the memory and the code marks from the arena and initializes the RAM with 0xca.
  * 
+ * @param arena Arena of the machine, which must have arena_size(size) bytes left
  * @param size Size of the RAM in bytes
  */
-RAM::RAM(uint32_t size)
+RAM::RAM(Arena& arena, uint32_t size) : memory(arena, size), size(size)
 {
-    data = std::vector<uint8_t>(size, 0xca);
+    code_pages = arena.create_array<uint8_t>(code_page_count(size));
+    memset(memory.get_data(), 0xca, size);
+}
+
+/**
+ * @brief Construct a new RAM:: RAM object forked from another RAM
+ * 
+ * Shares every page of the parent copy-on-write and copies its code marks. The code write and unshare callbacks are not copied.
+ * 
+ * @param arena Arena of the new machine, which must have arena_size(parent size) bytes left
+ * @param parent RAM to fork
+ * 
+ * \b References:
+ * @ref CowMemory::fork_from
+ */
+RAM::RAM(Arena& arena, RAM& parent) : memory(arena, parent.size), size(parent.size)
+{
+    code_pages = arena.create_array<uint8_t>(code_page_count(size));
+    memcpy(code_pages, parent.code_pages, code_page_count(size));
+    memory.fork_from(parent.memory);
+}
+
+/**
+ * @brief Returns the space the memory of a RAM takes in an arena.
+ * 
+ * The RAM object itself is not included.
+ * 
+ * @param size Size of the RAM in bytes
+ * @return size_t Size in bytes
+ */
+size_t RAM::arena_size(uint32_t size)
+{
+    return CowMemory::arena_size(size) + ::arena_size<uint8_t>(code_page_count(size));
+}
+
+/**
+ * @brief Returns the number of 4KB pages of a RAM.
+ * 
+ * @param size Size of the RAM in bytes
+ * @return uint32_t Number of pages
+ */
+uint32_t RAM::code_page_count(uint32_t size)
+{
+    return (size + (1 << RAM_CODE_PAGE_SHIFT) - 1) >> RAM_CODE_PAGE_SHIFT;
+}
+
+/**
+ * @brief Marks the pages of a range as holding cached code.
+ * 
+ * @param offset Offset of the range in the RAM
+ * @param size Size of the range in bytes
+ */
+void RAM::mark_code(uint32_t offset, uint32_t size)
+{
+    if(size == 0 || offset >= this->size)
+        return;
+    uint32_t last = (offset + size - 1) >> RAM_CODE_PAGE_SHIFT;
+    for(uint32_t page = offset >> RAM_CODE_PAGE_SHIFT; page <= last && page < code_page_count(this->size); page++)
+        code_pages[page] = 1;
+}
+
+/**
+ * @brief Reports a write to a page holding cached code.
+ * 
+ * The mark of the page is cleared before the callback runs, so the callback marks it again only if code it still caches is left in the page.
+ * 
+ * @param offset Offset of the write in the RAM
+ * @param size Size of the write in bytes
+ */
+void RAM::code_written(uint32_t offset, uint32_t size)
+{
+    code_pages[offset >> RAM_CODE_PAGE_SHIFT] = 0;
+    if(code_write_callback)
+        code_write_callback(offset, size);
 }
 
 /**
@@ -26,7 +101,7 @@ RAM::RAM(uint32_t size)
  */
 uint32_t RAM::read32_cpu(uint32_t offset)
 {
-    if(offset >= data.size())
+    if(offset >= size)
     {
         std::stringstream ss;
         ss << "Size exceeded for read32_cpu (RAM): 0x" << std::hex << offset;
@@ -38,7 +113,7 @@ uint32_t RAM::read32_cpu(uint32_t offset)
         ss << "Unaligned read32_cpu (RAM): 0x" << std::hex << offset;
         throw std::runtime_error(ss.str());
     }
-    return *(uint32_t*)&data[offset];
+    return *(const uint32_t*)memory.read_ptr(offset);
 }
 
 /**
@@ -52,7 +127,7 @@ uint32_t RAM::read32_cpu(uint32_t offset)
  */
 void RAM::write32_cpu(uint32_t offset, uint32_t data)
 {
-    if(offset >= this->data.size())
+    if(offset >= size)
     {
         std::stringstream ss;
         ss << "Size exceeded for write32_cpu (RAM): 0x" << std::hex << offset;
@@ -64,7 +139,9 @@ void RAM::write32_cpu(uint32_t offset, uint32_t data)
         ss << "Unaligned write32_cpu (RAM): 0x" << std::hex << offset;
         throw std::runtime_error(ss.str());
     }
-    *(uint32_t*)&this->data[offset] = data;
+    *(uint32_t*)memory.write_ptr(offset) = data;
+    if(is_code(offset))
+        code_written(offset, 4);
 }
 
 /**
@@ -77,13 +154,13 @@ void RAM::write32_cpu(uint32_t offset, uint32_t data)
  */
 uint8_t RAM::read8_cpu(uint32_t offset)
 {
-    if(offset >= data.size())
+    if(offset >= size)
     {
         std::stringstream ss;
         ss << "Size exceeded for read8_cpu (RAM): 0x" << std::hex << offset;
         throw std::runtime_error(ss.str());
     }
-    return data[offset];
+    return *memory.read_ptr(offset);
 }
 
 /**
@@ -96,13 +173,15 @@ uint8_t RAM::read8_cpu(uint32_t offset)
  */
 void RAM::write8_cpu(uint32_t offset, uint8_t data)
 {
-    if(offset >= this->data.size())
+    if(offset >= size)
     {
         std::stringstream ss;
         ss << "Size exceeded for write8_cpu (RAM): 0x" << std::hex << offset;
         throw std::runtime_error(ss.str());
     }
-    this->data[offset] = data;
+    *memory.write_ptr(offset) = data;
+    if(is_code(offset))
+        code_written(offset, 1);
 }
 
 /**
@@ -116,7 +195,7 @@ void RAM::write8_cpu(uint32_t offset, uint8_t data)
  */
 uint16_t RAM::read16_cpu(uint32_t offset)
 {
-    if(offset >= data.size())
+    if(offset >= size)
     {
         std::stringstream ss;
         ss << "Size exceeded for read16_cpu (RAM): 0x" << std::hex << offset;
@@ -128,7 +207,7 @@ uint16_t RAM::read16_cpu(uint32_t offset)
         ss << "Unaligned read16_cpu (RAM): 0x" << std::hex << offset;
         throw std::runtime_error(ss.str());
     }
-    return *(uint16_t*)&data[offset];
+    return *(const uint16_t*)memory.read_ptr(offset);
 }
 
 /**
@@ -142,7 +221,7 @@ uint16_t RAM::read16_cpu(uint32_t offset)
  */
 void RAM::write16_cpu(uint32_t offset, uint16_t data)
 {
-    if(offset >= this->data.size())
+    if(offset >= size)
     {
         std::stringstream ss;
         ss << "Size exceeded for write16_cpu (RAM): 0x" << std::hex << offset;
@@ -154,5 +233,7 @@ void RAM::write16_cpu(uint32_t offset, uint16_t data)
         ss << "Unaligned write16_cpu (RAM): 0x" << std::hex << offset;
         throw std::runtime_error(ss.str());
     }
-    *(uint16_t*)&this->data[offset] = data;
+    *(uint16_t*)memory.write_ptr(offset) = data;
+    if(is_code(offset))
+        code_written(offset, 2);
 }
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include <core/memory/arena.hpp>
+#include <core/memory/cow_memory.hpp>
+#include <core/interconnect/bus.hpp>
+#include <test_bios.hpp>
+
+#define TEST_BIOS_PATH "memory_test_bios.bin"
+
+/**
+ * @brief Object recording the order in which it is destroyed
+ * 
+ */
+struct Tracked
+{
+    Tracked(std::vector<int>& log, int id) : log(log), id(id) {}
+    ~Tracked() { log.push_back(id); }
+    std::vector<int>& log;
+    int id;
+};
+
+/**
+ * @brief Tests that arena allocations are aligned, adjacent and zeroed, that objects are destroyed in reverse order and that an exhausted arena throws
+ * 
+ */
+void test_arena()
+{
+    std::cout << "Arena: ";
+    std::vector<int> log;
+    bool ok = true;
+    {
+        Arena arena(4 * ARENA_ALIGNMENT);
+        Tracked* a = arena.create<Tracked>(log, 1);
+        uint32_t* words = arena.create_array<uint32_t>(20);
+        Tracked* b = arena.create<Tracked>(log, 2);
+
+        ok &= (uintptr_t)a % ARENA_ALIGNMENT == 0 && (uint8_t*)words == (uint8_t*)a + ARENA_ALIGNMENT;
+        ok &= (uint8_t*)b == (uint8_t*)words + 2 * ARENA_ALIGNMENT && arena.get_used() == 4 * ARENA_ALIGNMENT;
+        for(int i = 0; i < 20; i++)
+            ok &= words[i] == 0;
+
+        bool exhausted = false;
+        try
+        {
+            arena.create_array<uint8_t>(1);
+        }
+        catch(const std::runtime_error&)
+        {
+            exhausted = true;
+        }
+        ok &= exhausted && a->id == 1 && b->id == 2 && log.empty();
+    }
+    ok &= log == std::vector<int>({2, 1});
+
+    if(ok) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+/**
+ * @brief Tests that forked memories share pages until one of them writes, and keep them when the other is destroyed
+ * 
+ */
+void test_cow_memory()
+{
+    std::cout << "Copy-on-write Memory: ";
+    Arena arena(3 * CowMemory::arena_size(4 * COW_PAGE_SIZE));
+    CowMemory* parent = new CowMemory(arena, 4 * COW_PAGE_SIZE);
+    CowMemory child(arena, 4 * COW_PAGE_SIZE);
+    CowMemory grandchild(arena, 4 * COW_PAGE_SIZE);
+    std::vector<uint32_t> unshared;
+    child.set_unshare_callback([&](uint32_t page) { unshared.push_back(page); });
+
+    *parent->write_ptr(0x10) = 1;
+    *parent->write_ptr(COW_PAGE_SIZE + 0x10) = 2;
+    child.fork_from(*parent);
+    bool ok = parent->count_shared() == 4 && child.count_shared() == 4 && *child.read_ptr(0x10) == 1;
+    ok &= child.read_ptr(0x10) == parent->read_ptr(0x10);
+
+    //each side copies the page it writes, the other keeps the old contents
+    *child.write_ptr(0x10) = 3;
+    *parent->write_ptr(COW_PAGE_SIZE + 0x10) = 4;
+    ok &= *child.read_ptr(0x10) == 3 && *parent->read_ptr(0x10) == 1;
+    ok &= *child.read_ptr(COW_PAGE_SIZE + 0x10) == 2 && *parent->read_ptr(COW_PAGE_SIZE + 0x10) == 4;
+    ok &= unshared == std::vector<uint32_t>({0}) && child.count_shared() == 3 && parent->count_shared() == 3;
+
+    grandchild.fork_from(child);
+    delete parent;
+    ok &= *grandchild.read_ptr(0x10) == 3 && *grandchild.read_ptr(COW_PAGE_SIZE + 0x10) == 2;
+    ok &= child.flatten()[COW_PAGE_SIZE + 0x10] == 2 && child.count_shared() == 4;
+
+    if(ok) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+/**
+ * @brief Tests that machines can be created, run and destroyed repeatedly, each with its own memory
+ * 
+ */
+void test_machine_churn()
+{
+    std::cout << "Machine Churn: ";
+    bool ok = true;
+    for(int i = 0; i < 50; i++)
+    {
+        Bus first(TEST_BIOS_PATH);
+        Bus second(TEST_BIOS_PATH);
+        first.write32_cpu(0x1000, i);
+        for(int j = 0; j < 100; j++)
+        {
+            first.clock();
+            second.clock();
+        }
+        ok &= first.read32_cpu(0x1000) == uint32_t(i) && second.read32_cpu(0x1000) == 0xcacacaca;
+        ok &= second.read32_cpu(0xbfc00000) == 0x0bf00000;
+    }
+
+    bool bad_bios = false;
+    try
+    {
+        Bus bus("memory_test_missing_bios.bin");
+    }
+    catch(const std::runtime_error&)
+    {
+        bad_bios = true;
+    }
+
+    if(ok && bad_bios) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+int main()
+{
+    write_test_bios(TEST_BIOS_PATH, {0x0bf00000, 0x00000000}); //j 0xbfc00000
+    test_arena();
+    test_cow_memory();
+    test_machine_churn();
+    std::remove(TEST_BIOS_PATH);
+    return 0;
+}
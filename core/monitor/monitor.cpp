@@ -0,0 +1,133 @@
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include <core/monitor/monitor.hpp>
+#include <core/memory/ram.hpp>
+
+/**
+ * @brief Construct a new StateMonitor object
+ * 
+ * Nothing is watched or published yet.
+ */
+StateMonitor::StateMonitor()
+{
+    sequence.store(0, std::memory_order_relaxed);
+    for(uint32_t i = 0; i < MONITOR_WORD_COUNT; i++)
+        words[i].store(0, std::memory_order_relaxed);
+    for(uint32_t i = 0; i < MONITOR_RAM_WORDS; i++)
+        ram_words[i].store(0, std::memory_order_relaxed);
+    region_count = 0;
+    watched_words = 0;
+}
+
+/**
+ * @brief Adds a region of RAM to the published state.
+ * 
+ * Must be called before the emulation thread starts publishing.
+ * 
+ * @param addr Offset of the region in RAM, word aligned
+ * @param size Size of the region in bytes, a multiple of 4
+ * @return uint32_t Offset of the region in MonitorSnapshot::ram
+ * 
+ * @throw std::runtime_error If the region is unaligned
+ * @throw std::runtime_error If there are too many regions or words watched
+ */
+uint32_t StateMonitor::watch(uint32_t addr, uint32_t size)
+{
+    if(addr % 4 != 0 || size % 4 != 0)
+    {
+        std::stringstream ss;
+        ss << "Unaligned monitor region: 0x" << std::hex << addr << " (0x" << size << " bytes)";
+        throw std::runtime_error(ss.str());
+    }
+    if(region_count == MONITOR_MAX_REGIONS || watched_words + size / 4 > MONITOR_RAM_WORDS)
+    {
+        std::stringstream ss;
+        ss << "Monitor region does not fit: 0x" << std::hex << addr << " (0x" << size << " bytes)";
+        throw std::runtime_error(ss.str());
+    }
+
+    uint32_t offset = watched_words * 4;
+    region_start[region_count] = addr / 4;
+    region_size[region_count] = size / 4;
+    region_count++;
+    watched_words += size / 4;
+    return offset;
+}
+
+/**
+ * @brief Stores the watched RAM regions during a publication.
+ * 
+ * The regions are read a page at a time through the host address of the page, so that the pages shared with forked machines are read in place and never copied.
+ * 
+ * @param ram RAM of the machine
+ * 
+ * \b References:
+ * @ref RAM::get_host
+ */
+void StateMonitor::publish_ram(RAM& ram)
+{
+    uint32_t index = 0;
+    for(uint32_t region = 0; region < region_count; region++)
+    {
+        uint32_t offset = region_start[region] * 4;
+        uint32_t end = offset + region_size[region] * 4;
+        while(offset < end)
+        {
+            uint32_t page_end = (offset | COW_PAGE_MASK) + 1;
+            uint32_t chunk_end = page_end < end ? page_end : end;
+            const uint8_t* src = ram.get_host(offset);
+            for(; offset < chunk_end; offset += 4, src += 4)
+            {
+                uint32_t word;
+                memcpy(&word, src, 4);
+                ram_words[index++].store(word, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Copies the last publication.
+ * 
+ * Can be called from any thread and never blocks the emulation thread. If a publication is in progress or completes during the copy, the copy is retried, up to MONITOR_READ_ATTEMPTS times.
+ * 
+ * @param snapshot Structure to fill
+ * @return true The snapshot is consistent
+ * @return false The emulation thread kept publishing during every attempt, the snapshot must not be used
+ */
+bool StateMonitor::read(MonitorSnapshot* snapshot)
+{
+    uint32_t copy[MONITOR_WORD_COUNT];
+    for(int attempt = 0; attempt < MONITOR_READ_ATTEMPTS; attempt++)
+    {
+        uint32_t start = sequence.load(std::memory_order_acquire);
+        if(start & 1)
+            continue;
+
+        for(uint32_t i = 0; i < MONITOR_WORD_COUNT; i++)
+            copy[i] = words[i].load(std::memory_order_relaxed);
+        for(uint32_t i = 0; i < watched_words; i++)
+        {
+            uint32_t word = ram_words[i].load(std::memory_order_relaxed);
+            memcpy(snapshot->ram + i * 4, &word, 4);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(sequence.load(std::memory_order_relaxed) != start)
+            continue;
+
+        memcpy(snapshot->reg_gen, copy + MONITOR_REG_GEN, sizeof(snapshot->reg_gen));
+        snapshot->reg_hi = copy[MONITOR_REG_HI];
+        snapshot->reg_lo = copy[MONITOR_REG_LO];
+        snapshot->program_counter = copy[MONITOR_PC];
+        snapshot->reg_cop0_status = copy[MONITOR_COP0_STATUS];
+        snapshot->reg_cop0_cause = copy[MONITOR_COP0_CAUSE];
+        snapshot->reg_cop0_epc = copy[MONITOR_COP0_EPC];
+        snapshot->cycles = copy[MONITOR_CYCLES_LOW] | uint64_t(copy[MONITOR_CYCLES_HIGH]) << 32;
+        snapshot->publication = start / 2;
+        return true;
+    }
+    return false;
+}
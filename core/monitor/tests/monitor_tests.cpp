@@ -0,0 +1,177 @@
+#include <atomic>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+#include <core/monitor/monitor.hpp>
+#include <core/memory/ram.hpp>
+
+#define CONCURRENT_PUBLICATIONS 200000
+#define TEST_RAM_SIZE 0x4000
+
+/**
+ * @brief Publishes the same value in every register and watched word
+ * 
+ * @param monitor Monitor to publish to
+ * @param ram RAM to fill and publish
+ * @param words Number of words of the RAM to fill
+ * @param value Value to publish
+ */
+void publish_value(StateMonitor& monitor, RAM& ram, uint32_t words, uint32_t value)
+{
+    for(uint32_t i = 0; i < words; i++)
+        ram.write32_cpu(i * 4, value);
+    monitor.begin_publish();
+    for(uint32_t i = 0; i < MONITOR_WORD_COUNT; i++)
+        monitor.publish_word(i, value);
+    monitor.publish_ram(ram);
+    monitor.end_publish();
+}
+
+/**
+ * @brief Checks that every register and watched word of a snapshot has the same value
+ * 
+ * @param snapshot Snapshot to check
+ * @param ram_bytes Number of watched bytes
+ * @return true The snapshot comes from a single publication
+ * @return false The snapshot mixes publications
+ */
+bool consistent(const MonitorSnapshot& snapshot, uint32_t ram_bytes)
+{
+    uint32_t value = snapshot.reg_gen[0];
+    for(int i = 0; i < 32; i++)
+        if(snapshot.reg_gen[i] != value) return false;
+    if(snapshot.reg_hi != value || snapshot.reg_lo != value || snapshot.program_counter != value) return false;
+    if(snapshot.reg_cop0_status != value || snapshot.reg_cop0_cause != value || snapshot.reg_cop0_epc != value) return false;
+    if(snapshot.cycles != (value | uint64_t(value) << 32)) return false;
+    for(uint32_t i = 0; i < ram_bytes; i += 4)
+        if(*(const uint32_t*)(snapshot.ram + i) != value) return false;
+    return true;
+}
+
+/**
+ * @brief Tests a publication read back on the same thread
+ * 
+ */
+void test_monitor_publish()
+{
+    std::cout << "Monitor publish and read: ";
+    StateMonitor monitor;
+    Arena arena(RAM::arena_size(TEST_RAM_SIZE));
+    RAM ram(arena, TEST_RAM_SIZE);
+    ram.write32_cpu(0x100, 0x11111111);
+    ram.write32_cpu(0x104, 0x22222222);
+    ram.write32_cpu(0x200, 0x33333333);
+    uint32_t first = monitor.watch(0x100, 8);
+    uint32_t second = monitor.watch(0x200, 4);
+
+    MonitorSnapshot snapshot;
+    bool empty = monitor.read(&snapshot) && snapshot.publication == 0;
+
+    monitor.begin_publish();
+    for(int i = 0; i < 32; i++)
+        monitor.publish_word(MONITOR_REG_GEN + i, i * 3);
+    monitor.publish_word(MONITOR_PC, 0xbfc00180);
+    monitor.publish_word(MONITOR_CYCLES_LOW, 0x89abcdef);
+    monitor.publish_word(MONITOR_CYCLES_HIGH, 0x1);
+    monitor.publish_ram(ram);
+    monitor.end_publish();
+
+    bool success = empty && monitor.read(&snapshot);
+    success = success && snapshot.publication == 1 && snapshot.reg_gen[31] == 93 && snapshot.program_counter == 0xbfc00180;
+    success = success && snapshot.cycles == 0x189abcdefULL && first == 0 && second == 8;
+    success = success && *(uint32_t*)(snapshot.ram + first) == 0x11111111 && *(uint32_t*)(snapshot.ram + first + 4) == 0x22222222;
+    success = success && *(uint32_t*)(snapshot.ram + second) == 0x33333333;
+    std::cout << (success ? "Success" : "Failure") << std::endl;
+}
+
+/**
+ * @brief Tests that the regions that cannot be watched are rejected
+ * 
+ */
+void test_monitor_watch_limits()
+{
+    std::cout << "Monitor watch limits: ";
+    StateMonitor monitor;
+    int rejected = 0;
+    try { monitor.watch(0x102, 4); } catch(const std::runtime_error&) { rejected++; }
+    try { monitor.watch(0x100, 6); } catch(const std::runtime_error&) { rejected++; }
+    try { monitor.watch(0, MONITOR_RAM_WORDS * 4 + 4); } catch(const std::runtime_error&) { rejected++; }
+    bool success = rejected == 3 && monitor.watch(0, MONITOR_RAM_WORDS * 4) == 0;
+    std::cout << (success ? "Success" : "Failure") << std::endl;
+}
+
+/**
+ * @brief Tests that a reader on another thread only ever sees complete publications
+ * 
+ */
+void test_monitor_concurrent()
+{
+    std::cout << "Monitor concurrent reads: ";
+    StateMonitor monitor;
+    Arena arena(RAM::arena_size(TEST_RAM_SIZE));
+    RAM ram(arena, TEST_RAM_SIZE);
+    uint32_t words = 0x40;
+    monitor.watch(0, words * 4);
+
+    std::atomic<bool> done(false);
+    uint32_t reads = 0;
+    uint32_t torn = 0;
+    std::thread reader([&]() {
+        MonitorSnapshot snapshot;
+        while(!done.load(std::memory_order_acquire))
+        {
+            if(!monitor.read(&snapshot)) continue;
+            reads++;
+            if(!consistent(snapshot, words * 4)) torn++;
+        }
+    });
+
+    for(uint32_t value = 1; value <= CONCURRENT_PUBLICATIONS; value++)
+        publish_value(monitor, ram, words, value);
+    done.store(true, std::memory_order_release);
+    reader.join();
+
+    MonitorSnapshot last;
+    bool success = torn == 0 && monitor.read(&last) && last.reg_gen[0] == CONCURRENT_PUBLICATIONS && last.publication == CONCURRENT_PUBLICATIONS;
+    std::cout << (success ? "Success" : "Failure") << " (" << reads << " reads)" << std::endl;
+}
+
+/**
+ * @brief Tests publishing regions of a forked RAM, one of them across a page boundary
+ * 
+ * The shared pages are read in place: the private storage of the forked RAM is left untouched.
+ */
+void test_monitor_shared_ram()
+{
+    std::cout << "Monitor shared RAM: ";
+    StateMonitor monitor;
+    Arena arena(2 * RAM::arena_size(TEST_RAM_SIZE));
+    RAM parent(arena, TEST_RAM_SIZE);
+    for(uint32_t offset = 0xff0; offset < 0x1010; offset += 4)
+        parent.write32_cpu(offset, offset * 3);
+    RAM child(arena, parent);
+    child.write32_cpu(0x2000, 0x44444444);
+    uint32_t across = monitor.watch(0xff0, 0x20);
+    uint32_t written = monitor.watch(0x2000, 4);
+
+    monitor.begin_publish();
+    monitor.publish_ram(child);
+    monitor.end_publish();
+
+    MonitorSnapshot snapshot;
+    bool success = monitor.read(&snapshot) && *(uint32_t*)(snapshot.ram + written) == 0x44444444;
+    for(uint32_t i = 0; i < 0x20; i += 4)
+        success = success && *(uint32_t*)(snapshot.ram + across + i) == (0xff0 + i) * 3;
+    success = success && child.count_shared_pages() == TEST_RAM_SIZE / COW_PAGE_SIZE - 1 && child.get_data()[0xff0] == 0;
+    std::cout << (success ? "Success" : "Failure") << std::endl;
+}
+
+int main()
+{
+    test_monitor_publish();
+    test_monitor_watch_limits();
+    test_monitor_concurrent();
+    test_monitor_shared_ram();
+    return 0;
+}
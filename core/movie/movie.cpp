@@ -0,0 +1,346 @@
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "core/movie/movie.hpp"
+#include "core/bios/bios.hpp"
+
+#define HASH_OFFSET 0xcbf29ce484222325ULL
+#define HASH_PRIME 0x100000001b3ULL
+
+/**
+ * @brief Spreads every bit of a word over the whole word.
+ * 
+ * @param word Word to mix
+ * @return uint64_t Mixed word
+ */
+static inline uint64_t mix(uint64_t word)
+{
+    word = (word ^ (word >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    word = (word ^ (word >> 27)) * 0x94d049bb133111ebULL;
+    return word ^ (word >> 31);
+}
+
+/**
+ * @brief Writes a little-endian value to a stream.
+ * 
+ * @param file Stream
+ * @param value Value to write
+ * @param size Size of the value in bytes
+ */
+static void write_value(std::ofstream& file, uint64_t value, int size)
+{
+    char bytes[8];
+    for(int i = 0; i < size; i++)
+        bytes[i] = char(value >> (i * 8));
+    file.write(bytes, size);
+}
+
+/**
+ * @brief Reads a little-endian value from a stream.
+ * 
+ * @param file Stream
+ * @param size Size of the value in bytes
+ * @return uint64_t Value read, 0 if the stream ended
+ */
+static uint64_t read_value(std::ifstream& file, int size)
+{
+    unsigned char bytes[8] = {0};
+    file.read((char*)bytes, size);
+    uint64_t value = 0;
+    for(int i = 0; i < size; i++)
+        value |= uint64_t(bytes[i]) << (i * 8);
+    return value;
+}
+
+/**
+ * @brief Construct a new Movie:: Movie object
+ * 
+ * The movie is empty until it is started or loaded.
+ */
+Movie::Movie()
+{
+    flags = 0;
+    for(uint32_t port = 0; port < PAD_PORT_COUNT; port++)
+        pad_types[port] = PAD_DIGITAL;
+    bios_hash = 0;
+    start_hash = 0;
+}
+
+/**
+ * @brief Starts recording a movie on a machine that was just powered on.
+ * 
+ * Switches the machine to deterministic mode and records its starting state.
+ * 
+ * @param bus Machine to record, with its disc already loaded
+ * @param disc_path Path of the disc image, empty if there is none
+ * 
+ * @throw std::runtime_error If the machine has already run
+ * 
+ * \b References:
+ * @ref Bus::set_deterministic
+ */
+void Movie::start(Bus& bus, const std::string& disc_path)
+{
+    if(bus.get_cycles() != 0)
+        throw std::runtime_error("Movies start from power-on");
+
+    bus.set_deterministic(true);
+    flags = bus.get_cycle_model() ? MOVIE_FLAG_CYCLE_MODEL : 0;
+    for(uint32_t port = 0; port < PAD_PORT_COUNT; port++)
+        pad_types[port] = bus.get_pad_type(port);
+    bios_hash = hash_bios(bus);
+    start_hash = hash_ram(bus);
+    this->disc_path = disc_path;
+    frames.clear();
+}
+
+/**
+ * @brief Runs one frame with the given controller input and records it.
+ * 
+ * @param bus Machine being recorded
+ * @param pads Input of each controller port
+ * 
+ * \b References:
+ * @ref Bus::get_pad
+ * @ref Bus::run_frame
+ */
+void Movie::record_frame(Bus& bus, const PadState* pads)
+{
+    MovieFrame frame;
+    for(uint32_t port = 0; port < PAD_PORT_COUNT; port++)
+    {
+        frame.pads[port] = pads[port];
+        bus.get_pad(port) = pads[port];
+    }
+    bus.run_frame();
+    frame.ram_hash = hash_ram(bus);
+    frames.push_back(frame);
+}
+
+/**
+ * @brief Prepares a machine that was just powered on to replay the movie.
+ * 
+ * Switches the machine to deterministic mode with the settings the movie was recorded with, and checks that it starts from the same state.
+ * 
+ * @param bus Machine to replay on, with the disc of the movie already loaded
+ * 
+ * @throw std::runtime_error If the machine has already run
+ * @throw std::runtime_error If the BIOS or the starting RAM differ from the recording
+ * 
+ * \b References:
+ * @ref Bus::set_deterministic
+ * @ref Bus::set_cycle_model
+ * @ref Bus::set_pad_type
+ */
+void Movie::start_replay(Bus& bus)
+{
+    if(bus.get_cycles() != 0)
+        throw std::runtime_error("Movies start from power-on");
+    if(hash_bios(bus) != bios_hash)
+        throw std::runtime_error("The movie was recorded with a different BIOS");
+    if(hash_ram(bus) != start_hash)
+        throw std::runtime_error("The movie was recorded from a different starting state");
+
+    bus.set_deterministic(true);
+    bus.set_cycle_model(flags & MOVIE_FLAG_CYCLE_MODEL);
+    for(uint32_t port = 0; port < PAD_PORT_COUNT; port++)
+        bus.set_pad_type(port, pad_types[port]);
+}
+
+/**
+ * @brief Replays one frame and checks its result.
+ * 
+ * @param bus Machine replaying the movie
+ * @param frame Index of the frame, frames must be replayed in order
+ * @return true The RAM matches the recording at the end of the frame
+ * @return false The replay diverged
+ * 
+ * @throw std::runtime_error If the frame is not in the movie
+ */
+bool Movie::replay_frame(Bus& bus, uint64_t frame)
+{
+    const MovieFrame& recorded = get_frame(frame);
+    for(uint32_t port = 0; port < PAD_PORT_COUNT; port++)
+        bus.get_pad(port) = recorded.pads[port];
+    bus.run_frame();
+    return hash_ram(bus) == recorded.ram_hash;
+}
+
+/**
+ * @brief Returns the number of frames recorded.
+ * 
+ * @return uint64_t Number of frames
+ */
+uint64_t Movie::get_frame_count()
+{
+    return frames.size();
+}
+
+/**
+ * @brief Returns a recorded frame.
+ * 
+ * @param frame Index of the frame
+ * @return const MovieFrame& Input and result of the frame
+ * 
+ * @throw std::runtime_error If the frame is not in the movie
+ */
+const MovieFrame& Movie::get_frame(uint64_t frame)
+{
+    if(frame >= frames.size())
+    {
+        std::stringstream ss;
+        ss << "Frame " << frame << " is past the end of the movie (" << frames.size() << " frames)";
+        throw std::runtime_error(ss.str());
+    }
+    return frames[frame];
+}
+
+/**
+ * @brief Returns the path of the disc the movie was recorded with.
+ * 
+ * @return const std::string& Path, empty if there was no disc
+ */
+const std::string& Movie::get_disc_path()
+{
+    return disc_path;
+}
+
+/**
+ * @brief Saves the movie to a file.
+ * 
+ * @param path Path of the file
+ * 
+ * @throw std::runtime_error If the file could not be written
+ */
+void Movie::save(const std::string& path)
+{
+    std::ofstream file(path, std::ios::binary);
+    file.write(MOVIE_MAGIC, MOVIE_MAGIC_SIZE);
+    write_value(file, MOVIE_VERSION, 4);
+    write_value(file, flags, 4);
+    for(uint32_t port = 0; port < PAD_PORT_COUNT; port++)
+        write_value(file, pad_types[port], 1);
+    write_value(file, bios_hash, 8);
+    write_value(file, start_hash, 8);
+    write_value(file, disc_path.size(), 4);
+    file.write(disc_path.data(), disc_path.size());
+    write_value(file, frames.size(), 8);
+    for(const MovieFrame& frame : frames)
+    {
+        for(uint32_t port = 0; port < PAD_PORT_COUNT; port++)
+        {
+            write_value(file, frame.pads[port].buttons, 2);
+            for(int axis = 0; axis < PAD_AXIS_COUNT; axis++)
+                write_value(file, frame.pads[port].axes[axis], 1);
+        }
+        write_value(file, frame.ram_hash, 8);
+    }
+    if(!file)
+    {
+        std::stringstream ss;
+        ss << "Could not write movie: " << path;
+        throw std::runtime_error(ss.str());
+    }
+}
+
+/**
+ * @brief Replaces the movie with one saved to a file.
+ * 
+ * @param path Path of the file
+ * 
+ * @throw std::runtime_error If the file could not be read, is not a movie or is truncated
+ */
+void Movie::load(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    char magic[MOVIE_MAGIC_SIZE];
+    file.read(magic, MOVIE_MAGIC_SIZE);
+    if(!file || memcmp(magic, MOVIE_MAGIC, MOVIE_MAGIC_SIZE) != 0 || read_value(file, 4) != MOVIE_VERSION)
+    {
+        std::stringstream ss;
+        ss << "Not a movie: " << path;
+        throw std::runtime_error(ss.str());
+    }
+    flags = read_value(file, 4);
+    for(uint32_t port = 0; port < PAD_PORT_COUNT; port++)
+    {
+        uint64_t type = read_value(file, 1);
+        pad_types[port] = type <= PAD_ANALOG ? PadType(type) : PAD_NONE;
+    }
+    bios_hash = read_value(file, 8);
+    start_hash = read_value(file, 8);
+    disc_path.assign(read_value(file, 4), '\0');
+    file.read(&disc_path[0], disc_path.size());
+    uint64_t count = read_value(file, 8);
+    frames.clear();
+    for(uint64_t i = 0; i < count && file; i++)
+    {
+        MovieFrame frame;
+        for(uint32_t port = 0; port < PAD_PORT_COUNT; port++)
+        {
+            frame.pads[port].buttons = read_value(file, 2);
+            for(int axis = 0; axis < PAD_AXIS_COUNT; axis++)
+                frame.pads[port].axes[axis] = read_value(file, 1);
+        }
+        frame.ram_hash = read_value(file, 8);
+        frames.push_back(frame);
+    }
+    if(!file)
+    {
+        frames.clear();
+        std::stringstream ss;
+        ss << "Truncated movie: " << path;
+        throw std::runtime_error(ss.str());
+    }
+}
+
+/**
+ * @brief Hashes a block of memory.
+ * 
+ * FNV-1a over 64-bit words, which hashes the 2MB of RAM in a fraction of a millisecond. Each word is mixed (splitmix64 finalizer) before it is combined: the multiplication of FNV only carries bits upward, so without it a flip of the top bit of a word would only flip the top bit of the hash, and two such flips would cancel. Only meant to detect divergence, not tampering.
+ * 
+ * @param data Block to hash
+ * @param size Size of the block in bytes
+ * @return uint64_t Hash
+ */
+uint64_t Movie::hash(const uint8_t* data, size_t size)
+{
+    uint64_t hash = HASH_OFFSET;
+    size_t i = 0;
+    for(; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        hash = (hash ^ mix(word)) * HASH_PRIME;
+    }
+    for(; i < size; i++)
+        hash = (hash ^ data[i]) * HASH_PRIME;
+    return hash;
+}
+
+/**
+ * @brief Hashes the RAM of a machine.
+ * 
+ * @param bus Machine
+ * @return uint64_t Hash
+ */
+uint64_t Movie::hash_ram(Bus& bus)
+{
+    return hash(bus.get_ram_data(), bus.get_ram_size());
+}
+
+/**
+ * @brief Hashes the BIOS of a machine.
+ * 
+ * @param bus Machine
+ * @return uint64_t Hash
+ */
+uint64_t Movie::hash_bios(Bus& bus)
+{
+    std::vector<uint8_t> image(BIOS_SIZE);
+    for(uint32_t offset = 0; offset < BIOS_SIZE; offset++)
+        bus.read8_debug(0xbfc00000 + offset, &image[offset]);
+    return hash(image.data(), image.size());
+}
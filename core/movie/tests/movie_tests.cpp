@@ -0,0 +1,148 @@
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include <core/movie/movie.hpp>
+#include <core/interconnect/bus.hpp>
+#include <test_bios.hpp>
+
+#define TEST_BIOS_PATH "movie_test_bios.bin"
+#define OTHER_BIOS_PATH "movie_other_bios.bin"
+#define TEST_MOVIE_PATH "movie_test_movie.bin"
+#define TEST_FRAMES 4
+
+/**
+ * @brief Creates a BIOS that counts up a word of RAM forever
+ * 
+ * @param path Path of the BIOS
+ * @param step Amount added to the counter every iteration
+ */
+void create_test_bios(const char* path, uint16_t step)
+{
+    std::vector<uint32_t> program = {
+        0x3c088000,        //lui t0, 0x8000
+        0x8d092000,        //lw t1, 0x2000(t0)
+        0x00000000,        //nop
+        0x25290000u | step, //addiu t1, t1, step
+        0xad092000,        //sw t1, 0x2000(t0)
+        0x1000fffb,        //b 0xbfc00004
+        0x00000000         //nop
+    };
+    write_test_bios(path, program);
+}
+
+/**
+ * @brief Tests recording a movie, saving it and replaying it on a new machine
+ * 
+ */
+void test_movie_replay()
+{
+    std::cout << "Movie Replay: ";
+    Bus* bus = new Bus(TEST_BIOS_PATH);
+    bus->set_pad_type(0, PAD_ANALOG);
+    Movie* recorded = new Movie();
+    recorded->start(*bus, "");
+    for(uint16_t frame = 0; frame < TEST_FRAMES; frame++)
+    {
+        PadState pads[PAD_PORT_COUNT] = {{frame, {0x80, 0x80, uint8_t(frame), 0x80}}, {uint16_t(frame << 4), {0x80, 0x80, 0x80, 0x80}}};
+        recorded->record_frame(*bus, pads);
+    }
+    bool recording = bus->get_frame_count() == TEST_FRAMES && recorded->get_frame_count() == TEST_FRAMES &&
+        bus->get_pad_buttons(1) == (TEST_FRAMES - 1) << 4 &&
+        recorded->get_frame(0).ram_hash != recorded->get_frame(1).ram_hash;
+    recorded->save(TEST_MOVIE_PATH);
+    delete recorded;
+    delete bus;
+
+    bus = new Bus(TEST_BIOS_PATH);
+    Movie* replayed = new Movie();
+    replayed->load(TEST_MOVIE_PATH);
+    replayed->start_replay(*bus);
+    bool replay = replayed->get_frame_count() == TEST_FRAMES && replayed->get_frame(2).pads[0].buttons == 2 &&
+        replayed->get_frame(2).pads[0].axes[PAD_AXIS_LEFT_X] == 2;
+    for(uint64_t frame = 0; frame < replayed->get_frame_count(); frame++)
+        replay = replayed->replay_frame(*bus, frame) && replay;
+    replay = replay && bus->get_pad_buttons(0) == TEST_FRAMES - 1 && bus->get_pad_type(0) == PAD_ANALOG &&
+        bus->get_pad(0).axes[PAD_AXIS_LEFT_X] == TEST_FRAMES - 1;
+    delete replayed;
+    delete bus;
+
+    if(recording && replay) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+/**
+ * @brief Tests that a replay detects a diverging frame and a different BIOS
+ * 
+ * The RAM hash of the last frame is corrupted in the saved movie.
+ */
+void test_movie_divergence()
+{
+    std::cout << "Movie Divergence: ";
+    {
+        std::fstream file(TEST_MOVIE_PATH, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(-1, std::ios::end);
+        file.put('\x5a');
+    }
+
+    Bus* bus = new Bus(TEST_BIOS_PATH);
+    Movie* movie = new Movie();
+    movie->load(TEST_MOVIE_PATH);
+    movie->start_replay(*bus);
+    bool diverged = true;
+    for(uint64_t frame = 0; frame < TEST_FRAMES - 1; frame++)
+        diverged = movie->replay_frame(*bus, frame) && diverged;
+    diverged = !movie->replay_frame(*bus, TEST_FRAMES - 1) && diverged;
+    delete bus;
+
+    bool other_bios = false;
+    bus = new Bus(OTHER_BIOS_PATH);
+    try
+    {
+        movie->start_replay(*bus);
+    }
+    catch(const std::runtime_error& e)
+    {
+        other_bios = true;
+    }
+    delete bus;
+    delete movie;
+
+    if(diverged && other_bios) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+/**
+ * @brief Tests that the hash sees words differing in the same high bit
+ * 
+ * With plain FNV-1a over words, flipping bit 63 of two words leaves the hash unchanged.
+ */
+void test_movie_hash()
+{
+    std::cout << "Movie Hash: ";
+    std::vector<uint8_t> a(4096, 0x11);
+    std::vector<uint8_t> b = a;
+    b[7] ^= 0x80;
+    b[2047] ^= 0x80;
+    std::vector<uint8_t> c = a;
+    c[1] ^= 0x01;
+    uint64_t hash_a = Movie::hash(a.data(), a.size());
+    bool differ = hash_a != Movie::hash(b.data(), b.size()) && hash_a != Movie::hash(c.data(), c.size());
+    bool stable = hash_a == Movie::hash(a.data(), a.size());
+    if(differ && stable) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+int main()
+{
+    create_test_bios(TEST_BIOS_PATH, 1);
+    create_test_bios(OTHER_BIOS_PATH, 2);
+
+    test_movie_hash();
+    test_movie_replay();
+    test_movie_divergence();
+    std::remove(TEST_MOVIE_PATH);
+    return 0;
+}
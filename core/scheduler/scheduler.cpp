@@ -0,0 +1,82 @@
+#include "core/scheduler/scheduler.hpp"
+
+/**
+ * @brief Construct a new Scheduler:: Scheduler object
+ * 
+ * Starts at cycle 0 with no events scheduled.
+ */
+Scheduler::Scheduler()
+{
+    cycles = 0;
+    for(int i = 0; i < EVENT_COUNT; i++)
+        event_time[i] = EVENT_NEVER;
+    next_event_time = EVENT_NEVER;
+}
+
+/**
+ * @brief Schedules an event.
+ * 
+ * If the event is already scheduled, it is moved to the new time.
+ * 
+ * @param event Event to schedule
+ * @param time Cycle count at which the event is due
+ * 
+ * \b References:
+ * @ref update_next_event
+ */
+void Scheduler::schedule(Event event, uint64_t time)
+{
+    event_time[event] = time;
+    update_next_event();
+}
+
+/**
+ * @brief Removes an event from the schedule.
+ * 
+ * @param event Event to cancel
+ * 
+ * \b References:
+ * @ref update_next_event
+ */
+void Scheduler::cancel(Event event)
+{
+    event_time[event] = EVENT_NEVER;
+    update_next_event();
+}
+
+/**
+ * @brief Removes and returns the earliest due event.
+ * 
+ * Should only be called when event_due returns true.
+ * 
+ * @return Event The earliest scheduled event
+ * 
+ * \b References:
+ * @ref update_next_event
+ */
+Event Scheduler::pop_event()
+{
+    int earliest = 0;
+    for(int i = 1; i < EVENT_COUNT; i++)
+    {
+        if(event_time[i] < event_time[earliest])
+            earliest = i;
+    }
+    event_time[earliest] = EVENT_NEVER;
+    update_next_event();
+    return Event(earliest);
+}
+
+/**
+ * @brief Recomputes the time of the earliest scheduled event.
+ * 
+ */
+void Scheduler::update_next_event()
+{
+    next_event_time = EVENT_NEVER;
+    for(int i = 0; i < EVENT_COUNT; i++)
+    {
+        if(event_time[i] < next_event_time)
+            next_event_time = event_time[i];
+    }
+}
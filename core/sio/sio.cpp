@@ -0,0 +1,403 @@
+#include <sstream>
+#include <stdexcept>
+
+#include "core/sio/sio.hpp"
+#include "core/interconnect/bus.hpp"
+#include "core/interrupt/interrupt.hpp"
+
+/**
+ * @brief Throws if a controller port does not exist.
+ * 
+ * @param port Controller port
+ * 
+ * @throw std::runtime_error If the port is not 0 or 1
+ */
+static void check_port(uint32_t port)
+{
+    if(port >= PAD_PORT_COUNT)
+    {
+        std::stringstream ss;
+        ss << "Invalid controller port: " << port;
+        throw std::runtime_error(ss.str());
+    }
+}
+
+/**
+ * @brief Construct a new SIO0:: SIO0 object
+ * 
+ * A digital pad is plugged into each port, with no button pressed and the sticks centred.
+ */
+SIO0::SIO0()
+{
+    bus = nullptr;
+    for(uint32_t port = 0; port < PAD_PORT_COUNT; port++)
+    {
+        pads[port].buttons = 0;
+        for(int axis = 0; axis < PAD_AXIS_COUNT; axis++)
+            pads[port].axes[axis] = PAD_AXIS_CENTER;
+        set_pad_type(port, PAD_DIGITAL);
+    }
+    baud = SIO_DEFAULT_BAUD;
+    transferring = false;
+    reset();
+}
+
+/**
+ * @brief Resets the registers and ends the transfers in progress.
+ * 
+ * The baud rate is kept.
+ */
+void SIO0::reset()
+{
+    stat = 0;
+    mode = 0;
+    ctrl = 0;
+    rx_data = 0xff;
+    rx_full = false;
+    reply = 0xff;
+    reply_ack = false;
+    address = 0;
+    step = 0;
+    if(transferring)
+        bus->cancel_event(EVENT_SIO0);
+    transferring = false;
+}
+
+/**
+ * @brief Reads a SIO0 register.
+ * 
+ * Reading the data register pops the byte received. A 32-bit read of the mode register also returns the control register in the upper half.
+ * 
+ * @param offset Offset from the start of the SIO0 range
+ * @return uint32_t Value of the register
+ * 
+ * @throw std::runtime_error If the offset does not map to a register
+ */
+uint32_t SIO0::read32_cpu(uint32_t offset)
+{
+    switch(offset)
+    {
+        case SIO_REG_DATA:
+            rx_full = false;
+            return rx_data;
+        case SIO_REG_STAT:
+            return stat | SIO_STAT_TX_READY | (rx_full ? SIO_STAT_RX_NOT_EMPTY : 0) | (transferring ? 0 : SIO_STAT_TX_FINISHED);
+        case SIO_REG_STAT + 2:
+            return 0;
+        case SIO_REG_MODE:
+            return mode | (uint32_t(ctrl) << 16);
+        case SIO_REG_CTRL:
+            return ctrl;
+        case SIO_REG_BAUD:
+            return baud;
+    }
+
+    std::stringstream ss;
+    ss << "Unhandled read from SIO0 register: 0x" << std::hex << offset;
+    throw std::runtime_error(ss.str());
+}
+
+/**
+ * @brief Writes a SIO0 register.
+ * 
+ * Writing the data register starts a transfer. The status register is read-only.
+ * 
+ * @param offset Offset from the start of the SIO0 range
+ * @param data Data to write
+ * 
+ * @throw std::runtime_error If the offset does not map to a register
+ * 
+ * \b References:
+ * @ref start_transfer
+ * @ref write_ctrl
+ */
+void SIO0::write32_cpu(uint32_t offset, uint32_t data)
+{
+    switch(offset)
+    {
+        case SIO_REG_DATA:
+            start_transfer(data & 0xff);
+            return;
+        case SIO_REG_STAT:
+        case SIO_REG_STAT + 2:
+            return;
+        case SIO_REG_MODE:
+            mode = data;
+            return;
+        case SIO_REG_CTRL:
+            write_ctrl(data);
+            return;
+        case SIO_REG_BAUD:
+            baud = data;
+            return;
+    }
+
+    std::stringstream ss;
+    ss << "Unhandled write to SIO0 register: 0x" << std::hex << offset;
+    throw std::runtime_error(ss.str());
+}
+
+/**
+ * @brief Writes the control register.
+ * 
+ * The acknowledge bit clears the interrupt flag and the reset bit resets the port. Deselecting the port or switching to the other port ends the transfer with the device.
+ * 
+ * @param data Value written
+ * 
+ * \b References:
+ * @ref reset
+ */
+void SIO0::write_ctrl(uint16_t data)
+{
+    if(data & SIO_CTRL_RESET)
+    {
+        reset();
+        return;
+    }
+    if(data & SIO_CTRL_ACKNOWLEDGE)
+        stat &= ~SIO_STAT_IRQ;
+
+    uint16_t old = ctrl;
+    ctrl = data & ~(SIO_CTRL_ACKNOWLEDGE | SIO_CTRL_RESET);
+    if(!(ctrl & SIO_CTRL_SELECT) || ((old ^ ctrl) & SIO_CTRL_PORT))
+    {
+        address = 0;
+        step = 0;
+    }
+}
+
+/**
+ * @brief Sends a byte to the device of the selected port.
+ * 
+ * The answer of the device is computed at once and delivered when the transfer completes. The first byte addresses a device: a pad answers SIO_ADDRESS_PAD, and nothing answers the memory card address. A port that is not selected answers nothing.
+ * 
+ * @param data Byte to send
+ * 
+ * \b References:
+ * @ref pad_transfer
+ * @ref Bus::schedule_event
+ */
+void SIO0::start_transfer(uint8_t data)
+{
+    if(!(ctrl & SIO_CTRL_TX_ENABLE))
+        return;
+
+    uint32_t port = (ctrl & SIO_CTRL_PORT) ? 1 : 0;
+    reply = 0xff;
+    reply_ack = false;
+    if(ctrl & SIO_CTRL_SELECT)
+    {
+        if(step == 0)
+        {
+            if(data == SIO_ADDRESS_PAD && devices[port].type != PAD_NONE)
+            {
+                address = SIO_ADDRESS_PAD;
+                reply_ack = true;
+                if(poll_callback)
+                    poll_callback(port, pads[port]);
+            }
+        }
+        else if(address == SIO_ADDRESS_PAD)
+            reply = pad_transfer(port, data, reply_ack);
+
+        //a byte that is not acknowledged ends the transfer
+        if(!reply_ack)
+            address = 0;
+        step++;
+    }
+
+    stat &= ~SIO_STAT_ACK_LEVEL;
+    transferring = true;
+    bus->schedule_event(EVENT_SIO0, bus->get_cycles() + uint64_t(baud ? baud : 1) * 8);
+}
+
+/**
+ * @brief Exchanges a byte with a pad, after its address byte.
+ * 
+ * The pad answers the command byte with its ID, then 0x5a, then the data of the command: the buttons (and the sticks in analog mode) for the read command 0x42, and fixed tables for the configuration commands of analog pads. The first byte after 0x5a is the parameter of the command. The pad acknowledges every byte but the last.
+ * 
+ * @param port Port of the pad
+ * @param data Byte sent by the CPU
+ * @param ack Set to whether the pad acknowledges the byte
+ * @return uint8_t Byte sent by the pad
+ * 
+ * \b References:
+ * @ref pad_config_reply
+ */
+uint8_t SIO0::pad_transfer(uint32_t port, uint8_t data, bool& ack)
+{
+    PadDevice& pad = devices[port];
+    if(step == 1)
+    {
+        pad.command = data;
+        pad.param = 0;
+        if(pad.config)
+            pad.id = PAD_ID_CONFIG;
+        else if(data == 0x42 || (data == 0x43 && pad.type == PAD_ANALOG))
+            pad.id = pad.analog ? PAD_ID_ANALOG : PAD_ID_DIGITAL;
+        else
+        {
+            ack = false;
+            return 0xff;
+        }
+        ack = true;
+        return pad.id;
+    }
+    if(step == 2)
+    {
+        ack = true;
+        return 0x5a;
+    }
+
+    uint32_t index = step - 3;
+    uint32_t count = (pad.id & 0xf) * 2;
+    if(index >= count)
+    {
+        ack = false;
+        return 0xff;
+    }
+    if(index == 0)
+        pad.param = data;
+
+    uint8_t answer;
+    if(pad.id != PAD_ID_CONFIG)
+    {
+        const PadState& state = pads[port];
+        if(index < 2)
+            answer = ~(state.buttons >> (index * 8));
+        else
+            answer = state.axes[index - 2];
+    }
+    else
+        answer = pad_config_reply(pad, index);
+
+    ack = index < count - 1;
+    if(!ack)
+    {
+        if(pad.command == 0x43)
+            pad.config = pad.param == 1;
+        else if(pad.command == 0x44 && pad.config)
+            pad.analog = pad.param == 1;
+    }
+    return answer;
+}
+
+/**
+ * @brief Returns a data byte of a command of an analog pad in configuration mode.
+ * 
+ * 0x44 sets the analog mode, 0x45 returns the status, 0x46, 0x47 and 0x4c return fixed tables of the DualShock and 0x4d maps the (unemulated) motors.
+ * 
+ * @param pad Pad
+ * @param index Index of the byte after 0x5a
+ * @return uint8_t Byte sent by the pad
+ */
+uint8_t SIO0::pad_config_reply(PadDevice& pad, uint32_t index)
+{
+    static const uint8_t status[6] = {0x01, 0x02, 0x00, 0x02, 0x01, 0x00};
+    static const uint8_t actuator[2][6] = {{0x00, 0x00, 0x01, 0x02, 0x00, 0x0a}, {0x00, 0x00, 0x01, 0x01, 0x01, 0x14}};
+    static const uint8_t combination[6] = {0x00, 0x00, 0x02, 0x00, 0x01, 0x00};
+    static const uint8_t mode[2][6] = {{0x00, 0x00, 0x00, 0x04, 0x00, 0x00}, {0x00, 0x00, 0x00, 0x07, 0x00, 0x00}};
+
+    switch(pad.command)
+    {
+        case 0x45:
+            return index == 2 ? (pad.analog ? 0x01 : 0x00) : status[index];
+        case 0x46:
+            return pad.param < 2 ? actuator[pad.param][index] : 0x00;
+        case 0x47:
+            return combination[index];
+        case 0x4c:
+            return pad.param < 2 ? mode[pad.param][index] : 0x00;
+        case 0x4d:
+            return 0xff;
+        default:
+            return 0x00;
+    }
+}
+
+/**
+ * @brief Completes the transfer in progress.
+ * 
+ * The byte of the device is received. If the device acknowledged the byte, the /ACK input goes low and the interrupt is raised when enabled.
+ * 
+ * \b References:
+ * @ref Bus::raise_irq
+ */
+void SIO0::handle_event()
+{
+    transferring = false;
+    rx_data = reply;
+    rx_full = true;
+    if(reply_ack)
+    {
+        stat |= SIO_STAT_ACK_LEVEL;
+        if(ctrl & SIO_CTRL_ACK_IRQ_ENABLE)
+        {
+            stat |= SIO_STAT_IRQ;
+            bus->raise_irq(IRQ_SIO0);
+        }
+    }
+}
+
+/**
+ * @brief Returns the input of the pad of a port.
+ * 
+ * The host writes it directly, the pad reads it when the game polls it. The reference stays valid for the life of the machine.
+ * 
+ * @param port Controller port (0 or 1)
+ * @return PadState& Input of the pad
+ * 
+ * @throw std::runtime_error If the port does not exist
+ */
+PadState& SIO0::get_pad(uint32_t port)
+{
+    check_port(port);
+    return pads[port];
+}
+
+/**
+ * @brief Plugs a controller into a port.
+ * 
+ * An analog pad is plugged in with its analog mode on. Games can switch it to digital mode.
+ * 
+ * @param port Controller port (0 or 1)
+ * @param type Controller, PAD_NONE to unplug it
+ * 
+ * @throw std::runtime_error If the port does not exist
+ */
+void SIO0::set_pad_type(uint32_t port, PadType type)
+{
+    check_port(port);
+    devices[port].type = type;
+    devices[port].analog = type == PAD_ANALOG;
+    devices[port].config = false;
+    devices[port].id = PAD_ID_DIGITAL;
+    devices[port].command = 0;
+    devices[port].param = 0;
+}
+
+/**
+ * @brief Returns the controller plugged into a port.
+ * 
+ * @param port Controller port (0 or 1)
+ * @return PadType Controller
+ * 
+ * @throw std::runtime_error If the port does not exist
+ */
+PadType SIO0::get_pad_type(uint32_t port)
+{
+    check_port(port);
+    return devices[port].type;
+}
+
+/**
+ * @brief Sets the function called when a game starts polling a pad.
+ * 
+ * Called with the port and the input of the pad, which it can update before the pad sends it.
+ * 
+ * @param callback Function to call, nullptr to remove it
+ */
+void SIO0::set_poll_callback(std::function<void(uint32_t, PadState&)> callback)
+{
+    poll_callback = callback;
+}
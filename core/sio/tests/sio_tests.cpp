@@ -0,0 +1,170 @@
+#include <iostream>
+#include <vector>
+
+#include <core/interconnect/bus.hpp>
+#include <core/sio/sio.hpp>
+#include <test_bios.hpp>
+
+#define TEST_BIOS_PATH "sio_test_bios.bin"
+
+#define JOY_DATA 0x1f801040
+#define JOY_STAT 0x1f801044
+#define JOY_CTRL 0x1f80104a
+#define JOY_BAUD 0x1f80104e
+
+/**
+ * @brief Selects a port with transfers and the acknowledge interrupt enabled
+ * 
+ * Deselects the port first, which ends the previous transfer with the device.
+ * 
+ * @param bus 
+ * @param port 
+ */
+void select_port(Bus& bus, uint32_t port)
+{
+    bus.write16_cpu(JOY_CTRL, 0);
+    bus.write16_cpu(JOY_BAUD, SIO_DEFAULT_BAUD);
+    bus.write16_cpu(JOY_CTRL, SIO_CTRL_TX_ENABLE | SIO_CTRL_SELECT | SIO_CTRL_ACK_IRQ_ENABLE | (port ? SIO_CTRL_PORT : 0));
+}
+
+/**
+ * @brief Exchanges a byte with the device of the selected port
+ * 
+ * Runs the machine until the transfer completes and acknowledges the interrupt.
+ * 
+ * @param bus 
+ * @param data Byte to send
+ * @param ack Set to whether the device acknowledged the byte (and raised IRQ7)
+ * @return uint8_t Byte received
+ */
+uint8_t exchange(Bus& bus, uint8_t data, bool& ack)
+{
+    bus.write32_cpu(0x1f801070, 0);
+    bus.write8_cpu(JOY_DATA, data);
+    for(int i = 0; i < 10000 && !(bus.read32_cpu(JOY_STAT) & SIO_STAT_TX_FINISHED); i++)
+        bus.clock();
+    uint32_t stat = bus.read32_cpu(JOY_STAT);
+    bool irq = (bus.read32_cpu(0x1f801070) >> IRQ_SIO0) & 1;
+    ack = (stat & SIO_STAT_ACK_LEVEL) && (stat & SIO_STAT_IRQ) && irq;
+    bus.write16_cpu(JOY_CTRL, bus.read16_cpu(JOY_CTRL) | SIO_CTRL_ACKNOWLEDGE);
+    return bus.read8_cpu(JOY_DATA);
+}
+
+/**
+ * @brief Sends a command to the device of a port and checks its answer
+ * 
+ * @param bus 
+ * @param port 
+ * @param sent Bytes to send
+ * @param expected Bytes expected back, all acknowledged but the last
+ * @return true The device answered as expected
+ * @return false The device answered something else
+ */
+bool transfer(Bus& bus, uint32_t port, const std::vector<uint8_t>& sent, const std::vector<uint8_t>& expected)
+{
+    select_port(bus, port);
+    bool match = true;
+    for(size_t i = 0; i < sent.size(); i++)
+    {
+        bool ack;
+        uint8_t received = exchange(bus, sent[i], ack);
+        match = match && received == expected[i] && ack == (i + 1 < sent.size());
+    }
+    return match;
+}
+
+/**
+ * @brief Tests reading the buttons of a digital pad
+ * 
+ * @param bus 
+ */
+void test_sio_digital_pad(Bus& bus)
+{
+    std::cout << "SIO0 Digital Pad: ";
+    bus.get_pad(0).buttons = PAD_BUTTON_CROSS | PAD_BUTTON_START;
+    bool read = transfer(bus, 0, {0x01, 0x42, 0x00, 0x00, 0x00}, {0xff, PAD_ID_DIGITAL, 0x5a, 0xf7, 0xbf});
+    bus.set_pad_buttons(0, 0);
+    bool released = transfer(bus, 0, {0x01, 0x42, 0x00, 0x00, 0x00}, {0xff, PAD_ID_DIGITAL, 0x5a, 0xff, 0xff});
+    if(read && released) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+/**
+ * @brief Tests reading the sticks of an analog pad and switching it to digital mode
+ * 
+ * @param bus 
+ */
+void test_sio_analog_pad(Bus& bus)
+{
+    std::cout << "SIO0 Analog Pad: ";
+    bus.set_pad_type(1, PAD_ANALOG);
+    PadState& pad = bus.get_pad(1);
+    pad.buttons = PAD_BUTTON_L1;
+    pad.axes[PAD_AXIS_RIGHT_X] = 0x10;
+    pad.axes[PAD_AXIS_LEFT_Y] = 0xf0;
+    bool analog = transfer(bus, 1, {0x01, 0x42, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+        {0xff, PAD_ID_ANALOG, 0x5a, 0xff, 0xfb, 0x10, 0x80, 0x80, 0xf0});
+
+    //enter configuration mode, switch to digital mode and read the status, then leave
+    bool config = transfer(bus, 1, {0x01, 0x43, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00},
+        {0xff, PAD_ID_ANALOG, 0x5a, 0xff, 0xfb, 0x10, 0x80, 0x80, 0xf0}) &&
+        transfer(bus, 1, {0x01, 0x44, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00},
+        {0xff, PAD_ID_CONFIG, 0x5a, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}) &&
+        transfer(bus, 1, {0x01, 0x45, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+        {0xff, PAD_ID_CONFIG, 0x5a, 0x01, 0x02, 0x00, 0x02, 0x01, 0x00}) &&
+        transfer(bus, 1, {0x01, 0x43, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+        {0xff, PAD_ID_CONFIG, 0x5a, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00});
+    bool digital = transfer(bus, 1, {0x01, 0x42, 0x00, 0x00, 0x00}, {0xff, PAD_ID_DIGITAL, 0x5a, 0xff, 0xfb});
+
+    if(analog && config && digital) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+/**
+ * @brief Tests that empty memory card slots, unplugged pads and unknown commands are not acknowledged
+ * 
+ * @param bus 
+ */
+void test_sio_no_device(Bus& bus)
+{
+    std::cout << "SIO0 No Device: ";
+    bool memcard = transfer(bus, 0, {0x81}, {0xff});
+    bool command = transfer(bus, 0, {0x01, 0x45}, {0xff, 0xff});
+    bus.set_pad_type(0, PAD_NONE);
+    bool unplugged = transfer(bus, 0, {0x01}, {0xff});
+    bus.set_pad_type(0, PAD_DIGITAL);
+    if(memcard && command && unplugged) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+/**
+ * @brief Tests that the poll callback sets the input of a pad when it is polled
+ * 
+ * @param bus 
+ */
+void test_sio_poll_callback(Bus& bus)
+{
+    std::cout << "SIO0 Poll Callback: ";
+    int polls = 0;
+    bus.set_pad_poll_callback([&polls](uint32_t port, PadState& pad) {
+        polls++;
+        pad.buttons = port == 0 ? PAD_BUTTON_SQUARE : 0;
+    });
+    bool polled = transfer(bus, 0, {0x01, 0x42, 0x00, 0x00, 0x00}, {0xff, PAD_ID_DIGITAL, 0x5a, 0xff, 0x7f});
+    bus.set_pad_poll_callback(nullptr);
+    bus.set_pad_buttons(0, 0);
+    if(polled && polls == 1) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+int main()
+{
+    write_test_bios(TEST_BIOS_PATH, {});
+    Bus bus(TEST_BIOS_PATH);
+
+    test_sio_digital_pad(bus);
+    test_sio_analog_pad(bus);
+    test_sio_no_device(bus);
+    test_sio_poll_callback(bus);
+    return 0;
+}
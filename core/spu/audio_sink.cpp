@@ -0,0 +1,90 @@
+#include <stdexcept>
+
+#include "core/spu/audio_sink.hpp"
+
+/**
+ * @brief Discards a block of audio.
+ * 
+ * @param samples Interleaved stereo samples
+ * @param frames Number of stereo frames in the block
+ */
+void NullAudioSink::write(const int16_t* samples, uint32_t frames)
+{
+    (void)samples;
+    (void)frames;
+}
+
+/**
+ * @brief Construct a new WavAudioSink:: WavAudioSink object
+ * 
+ * Creates the file and writes a header that is completed when the sink is destroyed.
+ * 
+ * @param path Path of the WAV file to create
+ * 
+ * @throw std::runtime_error If the file cannot be created
+ */
+WavAudioSink::WavAudioSink(std::string path)
+{
+    file.open(path, std::ios::binary);
+    if(!file)
+    {
+        throw std::runtime_error("Unable to create WAV file: " + path);
+    }
+    frames_written = 0;
+    write_header();
+}
+
+/**
+ * @brief Destroy the WavAudioSink:: WavAudioSink object
+ * 
+ * Rewrites the header with the final size of the data.
+ */
+WavAudioSink::~WavAudioSink()
+{
+    file.seekp(0, std::ios::beg);
+    write_header();
+    file.close();
+}
+
+/**
+ * @brief Appends a block of audio to the WAV file.
+ * 
+ * @param samples Interleaved stereo samples
+ * @param frames Number of stereo frames in the block
+ */
+void WavAudioSink::write(const int16_t* samples, uint32_t frames)
+{
+    //since the system is little endian, we can do this
+    file.write((const char*)samples, frames * 4);
+    frames_written += frames;
+}
+
+/**
+ * @brief Writes the RIFF/WAVE header for the frames written so far.
+ * 
+ */
+void WavAudioSink::write_header()
+{
+    uint32_t data_size = frames_written * 4;
+    uint32_t riff_size = 36 + data_size;
+    uint32_t fmt_size = 16;
+    uint16_t format = 1; //PCM
+    uint16_t channels = 2;
+    uint32_t sample_rate = AUDIO_SAMPLE_RATE;
+    uint32_t byte_rate = AUDIO_SAMPLE_RATE * 4;
+    uint16_t block_align = 4;
+    uint16_t bits_per_sample = 16;
+
+    file.write("RIFF", 4);
+    file.write((const char*)&riff_size, 4);
+    file.write("WAVEfmt ", 8);
+    file.write((const char*)&fmt_size, 4);
+    file.write((const char*)&format, 2);
+    file.write((const char*)&channels, 2);
+    file.write((const char*)&sample_rate, 4);
+    file.write((const char*)&byte_rate, 4);
+    file.write((const char*)&block_align, 2);
+    file.write((const char*)&bits_per_sample, 2);
+    file.write("data", 4);
+    file.write((const char*)&data_size, 4);
+}
@@ -0,0 +1,371 @@
+#include <cstring>
+
+#include "core/spu/spu.hpp"
+#include "core/interconnect/bus.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SPU_SSE2
+#endif
+
+/**
+ * @brief Construct a new SPU:: SPU object
+ * 
+ * Takes the sound RAM, cleared, from the arena, clears the registers and silences all voices.
+ * 
+ * @param arena Arena of the machine, which must have arena_size() bytes left
+ */
+SPU::SPU(Arena& arena) : sound_ram(arena, SOUND_RAM_SIZE)
+{
+    bus = nullptr;
+    sink = &null_sink;
+    memset(regs, 0, sizeof(regs));
+    memset(voices, 0, sizeof(voices));
+    memset(volume_left, 0, sizeof(volume_left));
+    memset(volume_right, 0, sizeof(volume_right));
+    memset(voice_output, 0, sizeof(voice_output));
+    for(int i = 0; i < SPU_VOICE_COUNT; i++)
+        voices[i].phase = ADSR_OFF;
+    endx = 0;
+    transfer_address = 0;
+    irq_flag = false;
+}
+
+/**
+ * @brief Construct a new SPU:: SPU object forked from another SPU
+ * 
+ * Copies the registers and voices and shares the sound RAM copy-on-write. The new SPU has no Bus and renders to its own null sink.
+ * 
+ * @param arena Arena of the new machine, which must have arena_size() bytes left
+ * @param parent SPU to fork
+ * 
+ * \b References:
+ * @ref CowMemory::fork_from
+ */
+SPU::SPU(Arena& arena, SPU& parent) : sound_ram(arena, SOUND_RAM_SIZE)
+{
+    bus = nullptr;
+    sink = &null_sink;
+    sound_ram.fork_from(parent.sound_ram);
+    memcpy(regs, parent.regs, sizeof(regs));
+    memcpy(voices, parent.voices, sizeof(voices));
+    memcpy(volume_left, parent.volume_left, sizeof(volume_left));
+    memcpy(volume_right, parent.volume_right, sizeof(volume_right));
+    memcpy(voice_output, parent.voice_output, sizeof(voice_output));
+    endx = parent.endx;
+    transfer_address = parent.transfer_address;
+    irq_flag = parent.irq_flag;
+}
+
+/**
+ * @brief Returns the space the sound RAM takes in an arena.
+ * 
+ * The SPU object itself is not included.
+ * 
+ * @return size_t Size in bytes
+ */
+size_t SPU::arena_size()
+{
+    return CowMemory::arena_size(SOUND_RAM_SIZE);
+}
+
+/**
+ * @brief Reads a 16-bit SPU register.
+ * 
+ * @param offset Offset from the start of the SPU range
+ * @return uint16_t Value of the register
+ */
+uint16_t SPU::read16_cpu(uint32_t offset)
+{
+    if(offset < 0x180)
+    {
+        //current envelope level of a voice
+        if((offset & 0xf) == 0xc)
+            return voices[offset >> 4].level;
+        return regs[offset >> 1];
+    }
+
+    switch(offset)
+    {
+        case SPU_REG_ENDX_LO:
+            return endx & 0xffff;
+        case SPU_REG_ENDX_HI:
+            return endx >> 16;
+        case SPU_REG_SPUSTAT:
+        {
+            //manual transfers complete immediately, so the busy flag is never set
+            uint16_t spucnt = regs[SPU_REG_SPUCNT >> 1];
+            uint16_t stat = spucnt & 0x3f;
+            if(irq_flag)
+                stat |= SPUSTAT_IRQ;
+            if(spucnt & 0x20)
+                stat |= 0x80;
+            return stat;
+        }
+        default:
+            return regs[(offset >> 1) & 0x1ff];
+    }
+}
+
+/**
+ * @brief Writes a 16-bit SPU register.
+ * 
+ * @param offset Offset from the start of the SPU range
+ * @param data Data to write
+ * 
+ * \b References:
+ * @ref write_voice
+ * @ref key_on
+ * @ref key_off
+ * @ref check_irq
+ */
+void SPU::write16_cpu(uint32_t offset, uint16_t data)
+{
+    regs[(offset >> 1) & 0x1ff] = data;
+
+    if(offset < 0x180)
+    {
+        write_voice(offset >> 4, offset & 0xf, data);
+        return;
+    }
+
+    switch(offset)
+    {
+        case SPU_REG_KON_LO:
+            key_on(data);
+            break;
+        case SPU_REG_KON_HI:
+            key_on(uint32_t(data) << 16);
+            break;
+        case SPU_REG_KOFF_LO:
+            key_off(data);
+            break;
+        case SPU_REG_KOFF_HI:
+            key_off(uint32_t(data) << 16);
+            break;
+        case SPU_REG_TRANSFER_ADDRESS:
+            transfer_address = uint32_t(data) * 8;
+            break;
+        case SPU_REG_TRANSFER_FIFO:
+            check_irq(transfer_address, 2);
+            //since the system is little endian, we can do this
+            *(uint16_t*)sound_ram.write_ptr(transfer_address) = data;
+            transfer_address = (transfer_address + 2) & (SOUND_RAM_SIZE - 1);
+            break;
+        case SPU_REG_SPUCNT:
+            //disabling the interrupt acknowledges it
+            if(!(data & SPUCNT_IRQ_ENABLE))
+                irq_flag = false;
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Handles the scheduled block event.
+ * 
+ * Renders the next block of audio, hands it to the audio sink and schedules the next block.
+ * 
+ * \b References:
+ * @ref render_block
+ * @ref Bus::schedule_event
+ */
+void SPU::handle_event()
+{
+    int16_t block[SPU_BLOCK_SIZE * 2];
+    render_block(block);
+    sink->write(block, SPU_BLOCK_SIZE);
+    bus->schedule_event(EVENT_SPU, bus->get_cycles() + SPU_CYCLES_PER_BLOCK);
+}
+
+/**
+ * @brief Renders the next SPU_BLOCK_SIZE stereo samples.
+ * 
+ * Every voice renders its whole block before the voices are mixed, which keeps the per-voice state in registers and lets the mixer work on all voices of a sample at once.
+ * 
+ * @param out Buffer for SPU_BLOCK_SIZE interleaved stereo samples
+ * 
+ * \b References:
+ * @ref render_voice
+ * @ref mix
+ */
+void SPU::render_block(int16_t* out)
+{
+    if(!(regs[SPU_REG_SPUCNT >> 1] & SPUCNT_ENABLE))
+    {
+        memset(out, 0, SPU_BLOCK_SIZE * 2 * sizeof(int16_t));
+        return;
+    }
+
+    for(uint32_t i = 0; i < SPU_VOICE_COUNT; i++)
+        render_voice(i);
+
+    mix(out);
+}
+
+/**
+ * @brief Writes a voice register.
+ * 
+ * Volumes in sweep mode are not implemented and keep their last fixed value.
+ * 
+ * @param index Index of the voice
+ * @param reg Offset of the register in the voice
+ * @param data Data to write
+ */
+void SPU::write_voice(uint32_t index, uint32_t reg, uint16_t data)
+{
+    Voice& voice = voices[index];
+    switch(reg)
+    {
+        case 0x0:
+            if(!(data & 0x8000))
+                volume_left[index] = int16_t(data << 1);
+            break;
+        case 0x2:
+            if(!(data & 0x8000))
+                volume_right[index] = int16_t(data << 1);
+            break;
+        case 0x4:
+            voice.pitch = data;
+            break;
+        case 0x6:
+            voice.start_address = uint32_t(data) * 8;
+            break;
+        case 0x8:
+            voice.adsr = (voice.adsr & 0xffff0000) | data;
+            break;
+        case 0xa:
+            voice.adsr = (voice.adsr & 0x0000ffff) | (uint32_t(data) << 16);
+            break;
+        case 0xc:
+            voice.level = int16_t(data);
+            break;
+        case 0xe:
+            voice.repeat_address = uint32_t(data) * 8;
+            break;
+    }
+}
+
+/**
+ * @brief Starts the voices in the given mask.
+ * 
+ * @param mask Bit mask of the voices to start
+ * 
+ * \b References:
+ * @ref decode_block
+ */
+void SPU::key_on(uint32_t mask)
+{
+    for(uint32_t i = 0; i < SPU_VOICE_COUNT; i++)
+    {
+        if(!(mask & (1 << i)))
+            continue;
+        Voice& voice = voices[i];
+        voice.current_address = voice.start_address;
+        voice.pitch_counter = 0;
+        voice.adpcm_history[0] = 0;
+        voice.adpcm_history[1] = 0;
+        memset(voice.decoded, 0, sizeof(voice.decoded));
+        voice.phase = ADSR_ATTACK;
+        voice.level = 0;
+        voice.adsr_counter = 0;
+        endx &= ~(1 << i);
+        decode_block(i);
+    }
+}
+
+/**
+ * @brief Releases the voices in the given mask.
+ * 
+ * @param mask Bit mask of the voices to release
+ */
+void SPU::key_off(uint32_t mask)
+{
+    for(uint32_t i = 0; i < SPU_VOICE_COUNT; i++)
+    {
+        if((mask & (1 << i)) && voices[i].phase != ADSR_OFF)
+        {
+            voices[i].phase = ADSR_RELEASE;
+            voices[i].adsr_counter = 0;
+        }
+    }
+}
+
+/**
+ * @brief Raises the SPU interrupt if the IRQ address is accessed.
+ * 
+ * @param address Start of the accessed area of sound RAM (bytes)
+ * @param size Size of the accessed area (bytes)
+ * 
+ * \b References:
+ * @ref Bus::raise_irq
+ */
+void SPU::check_irq(uint32_t address, uint32_t size)
+{
+    if(!(regs[SPU_REG_SPUCNT >> 1] & SPUCNT_IRQ_ENABLE) || irq_flag)
+        return;
+    uint32_t irq_address = uint32_t(regs[SPU_REG_IRQ_ADDRESS >> 1]) * 8;
+    if(irq_address >= address && irq_address < address + size)
+    {
+        irq_flag = true;
+        bus->raise_irq(IRQ_SPU);
+    }
+}
+
+/**
+ * @brief Mixes the output of all voices of the current block.
+ * 
+ * Each voice sample is scaled by the voice volume, summed over all voices and clamped, then scaled by the main volume. The voices of one sample are adjacent in voice_output, so eight voices are scaled and summed per SIMD operation.
+ * 
+ * @param out Buffer for SPU_BLOCK_SIZE interleaved stereo samples
+ */
+void SPU::mix(int16_t* out)
+{
+    bool unmuted = regs[SPU_REG_SPUCNT >> 1] & SPUCNT_UNMUTE;
+    int32_t main_left = int16_t(regs[SPU_REG_MAIN_VOL_L >> 1] << 1);
+    int32_t main_right = int16_t(regs[SPU_REG_MAIN_VOL_R >> 1] << 1);
+
+    for(uint32_t n = 0; n < SPU_BLOCK_SIZE; n++)
+    {
+        int32_t left = 0;
+        int32_t right = 0;
+#ifdef SPU_SSE2
+        __m128i acc_left = _mm_setzero_si128();
+        __m128i acc_right = _mm_setzero_si128();
+        for(uint32_t i = 0; i < SPU_VOICE_COUNT; i += 8)
+        {
+            __m128i samples = _mm_load_si128((const __m128i*)&voice_output[n][i]);
+            __m128i vol_l = _mm_load_si128((const __m128i*)&volume_left[i]);
+            __m128i vol_r = _mm_load_si128((const __m128i*)&volume_right[i]);
+
+            //full 32-bit products, shifted per voice like the hardware does
+            __m128i lo = _mm_mullo_epi16(samples, vol_l);
+            __m128i hi = _mm_mulhi_epi16(samples, vol_l);
+            acc_left = _mm_add_epi32(acc_left, _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 15));
+            acc_left = _mm_add_epi32(acc_left, _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 15));
+
+            lo = _mm_mullo_epi16(samples, vol_r);
+            hi = _mm_mulhi_epi16(samples, vol_r);
+            acc_right = _mm_add_epi32(acc_right, _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 15));
+            acc_right = _mm_add_epi32(acc_right, _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 15));
+        }
+        alignas(16) int32_t sums[8];
+        _mm_store_si128((__m128i*)&sums[0], acc_left);
+        _mm_store_si128((__m128i*)&sums[4], acc_right);
+        left = sums[0] + sums[1] + sums[2] + sums[3];
+        right = sums[4] + sums[5] + sums[6] + sums[7];
+#else
+        for(uint32_t i = 0; i < SPU_VOICE_COUNT; i++)
+        {
+            left += (voice_output[n][i] * volume_left[i]) >> 15;
+            right += (voice_output[n][i] * volume_right[i]) >> 15;
+        }
+#endif
+        left = left < -0x8000 ? -0x8000 : (left > 0x7fff ? 0x7fff : left);
+        right = right < -0x8000 ? -0x8000 : (right > 0x7fff ? 0x7fff : right);
+
+        out[n * 2] = unmuted ? int16_t((left * main_left) >> 15) : 0;
+        out[n * 2 + 1] = unmuted ? int16_t((right * main_right) >> 15) : 0;
+    }
+}
@@ -0,0 +1,350 @@
+#include <cmath>
+#include <cstring>
+
+#include "core/spu/spu.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SPU_SSE2
+#endif
+
+/**
+ * @brief Returns the 512-entry table of the 4-tap gaussian interpolation.
+ * 
+ * The table is generated from a gaussian kernel whose width and scale approximate the hardware table: the four weights used for a sample sum up to about 0x7f80 and the nearest sample gets about 70% of the weight.
+ * 
+ * @return const int16_t* Interpolation table
+ */
+static const int16_t* gauss_table()
+{
+    struct GaussTable
+    {
+        int16_t values[512];
+
+        GaussTable()
+        {
+            double raw[512];
+            for(int i = 0; i < 512; i++)
+            {
+                //distance (in samples) between the tap and the interpolated position
+                double distance = (0x200 - i) / 256.0;
+                raw[i] = std::exp(-1.546 * distance * distance);
+            }
+            double scale = 0x7f80 / (raw[0x0ff] + raw[0x1ff] + raw[0x100] + raw[0x000]);
+            for(int i = 0; i < 512; i++)
+                values[i] = int16_t(std::lround(raw[i] * scale));
+        }
+    };
+    static const GaussTable table;
+    return table.values;
+}
+
+/**
+ * @brief Decodes the ADPCM block at the current address of a voice.
+ * 
+ * A block is 16 bytes: a header byte (shift in bits [3:0], filter in bits [6:4]), a flag byte and 28 4-bit samples. The samples are expanded and shifted eight at a time with SIMD instructions; only the prediction filter, which depends on the previous output, runs sample by sample.
+ * The last three samples of the previous block are kept in front of the new samples for the interpolation.
+ * 
+ * @param index Index of the voice
+ * 
+ * \b References:
+ * @ref check_irq
+ */
+void SPU::decode_block(uint32_t index)
+{
+    static const int32_t filter_pos[5] = {0, 60, 115, 98, 122};
+    static const int32_t filter_neg[5] = {0, 0, -52, -55, -60};
+
+    Voice& voice = voices[index];
+    uint32_t address = voice.current_address & (SOUND_RAM_SIZE - 16);
+    check_irq(address, 16);
+
+    const uint8_t* block = sound_ram.read_ptr(address);
+    uint32_t shift = block[0] & 0xf;
+    if(shift > 12)
+        shift = 9;
+    uint32_t filter = (block[0] >> 4) & 0x7;
+    if(filter > 4)
+        filter = 4;
+    voice.block_flags = block[1];
+    if(voice.block_flags & ADPCM_FLAG_LOOP_START)
+        voice.repeat_address = address;
+
+    voice.decoded[0] = voice.decoded[28];
+    voice.decoded[1] = voice.decoded[29];
+    voice.decoded[2] = voice.decoded[30];
+
+    alignas(16) int16_t raw[32];
+#ifdef SPU_SSE2
+    __m128i bytes = _mm_srli_si128(_mm_loadu_si128((const __m128i*)block), 2);
+    __m128i zero = _mm_setzero_si128();
+    __m128i high_mask = _mm_set1_epi16(0x00f0);
+    __m128i shift_count = _mm_cvtsi32_si128(int(shift));
+    for(int half = 0; half < 2; half++)
+    {
+        __m128i words = half ? _mm_unpackhi_epi8(bytes, zero) : _mm_unpacklo_epi8(bytes, zero);
+        //move each nibble to the top of a 16-bit lane, low nibble first
+        __m128i low = _mm_slli_epi16(words, 12);
+        __m128i high = _mm_slli_epi16(_mm_and_si128(words, high_mask), 8);
+        __m128i first = _mm_sra_epi16(_mm_unpacklo_epi16(low, high), shift_count);
+        __m128i second = _mm_sra_epi16(_mm_unpackhi_epi16(low, high), shift_count);
+        _mm_store_si128((__m128i*)&raw[half * 16], first);
+        _mm_store_si128((__m128i*)&raw[half * 16 + 8], second);
+    }
+#else
+    for(int i = 0; i < 28; i++)
+    {
+        uint8_t nibble = (block[2 + i / 2] >> ((i & 1) * 4)) & 0xf;
+        raw[i] = int16_t(uint16_t(nibble) << 12) >> shift;
+    }
+#endif
+
+    int32_t old = voice.adpcm_history[0];
+    int32_t older = voice.adpcm_history[1];
+    if(filter == 0)
+    {
+        memcpy(&voice.decoded[3], raw, 28 * sizeof(int16_t));
+        old = raw[27];
+        older = raw[26];
+    }
+    else
+    {
+        int32_t pos = filter_pos[filter];
+        int32_t neg = filter_neg[filter];
+        for(int i = 0; i < 28; i++)
+        {
+            int32_t sample = raw[i] + ((old * pos + older * neg + 32) >> 6);
+            sample = sample < -0x8000 ? -0x8000 : (sample > 0x7fff ? 0x7fff : sample);
+            voice.decoded[3 + i] = int16_t(sample);
+            older = old;
+            old = sample;
+        }
+    }
+    voice.adpcm_history[0] = int16_t(old);
+    voice.adpcm_history[1] = int16_t(older);
+}
+
+/**
+ * @brief Moves a voice to its next ADPCM block.
+ * 
+ * Handles the flags of the block that has just finished: at a loop end the voice jumps to the repeat address and sets its ENDX bit. Without the loop repeat flag the voice is also silenced.
+ * 
+ * @param index Index of the voice
+ * 
+ * \b References:
+ * @ref decode_block
+ */
+void SPU::next_block(uint32_t index)
+{
+    Voice& voice = voices[index];
+    if(voice.block_flags & ADPCM_FLAG_LOOP_END)
+    {
+        endx |= 1 << index;
+        voice.current_address = voice.repeat_address;
+        if(!(voice.block_flags & ADPCM_FLAG_LOOP_REPEAT))
+        {
+            voice.phase = ADSR_OFF;
+            voice.level = 0;
+        }
+    }
+    else
+    {
+        voice.current_address = (voice.current_address + 16) & (SOUND_RAM_SIZE - 1);
+    }
+    decode_block(index);
+}
+
+/**
+ * @brief Steps the ADSR envelope of a voice by one sample.
+ * 
+ * Every phase is described by a shift, a step, a direction and a mode (linear or exponential): \n
+ * - The level changes by step << (11 - shift) every 1 << (shift - 11) samples (negative shifts are 0) \n
+ * - Exponential increases are 4 times slower above level 0x6000 \n
+ * - Exponential decreases are scaled by the current level \n
+ * 
+ * @param index Index of the voice
+ */
+void SPU::step_envelope(uint32_t index)
+{
+    Voice& voice = voices[index];
+    if(voice.phase == ADSR_OFF)
+        return;
+    if(voice.adsr_counter > 0)
+    {
+        voice.adsr_counter--;
+        return;
+    }
+
+    uint32_t adsr = voice.adsr;
+    bool exponential;
+    bool decreasing;
+    int32_t shift;
+    int32_t step;
+    switch(voice.phase)
+    {
+        case ADSR_ATTACK:
+            exponential = adsr & 0x8000;
+            decreasing = false;
+            shift = (adsr >> 10) & 0x1f;
+            step = 7 - int32_t((adsr >> 8) & 0x3);
+            break;
+        case ADSR_DECAY:
+            exponential = true;
+            decreasing = true;
+            shift = (adsr >> 4) & 0xf;
+            step = -8;
+            break;
+        case ADSR_SUSTAIN:
+            exponential = adsr & 0x80000000;
+            decreasing = adsr & 0x40000000;
+            shift = (adsr >> 24) & 0x1f;
+            step = decreasing ? -8 + int32_t((adsr >> 22) & 0x3) : 7 - int32_t((adsr >> 22) & 0x3);
+            break;
+        default:
+            exponential = adsr & 0x00200000;
+            decreasing = true;
+            shift = (adsr >> 16) & 0x1f;
+            step = -8;
+            break;
+    }
+
+    int32_t cycles = 1 << (shift > 11 ? shift - 11 : 0);
+    int32_t adsr_step = step * (1 << (shift < 11 ? 11 - shift : 0));
+    if(exponential && !decreasing && voice.level > 0x6000)
+        cycles *= 4;
+    if(exponential && decreasing)
+        adsr_step = (adsr_step * voice.level) >> 15;
+
+    int32_t level = voice.level + adsr_step;
+    level = level < 0 ? 0 : (level > 0x7fff ? 0x7fff : level);
+    voice.level = int16_t(level);
+    voice.adsr_counter = cycles - 1;
+
+    switch(voice.phase)
+    {
+        case ADSR_ATTACK:
+            if(level >= 0x7fff)
+            {
+                voice.phase = ADSR_DECAY;
+                voice.adsr_counter = 0;
+            }
+            break;
+        case ADSR_DECAY:
+            if(level <= int32_t(((adsr & 0xf) + 1) * 0x800))
+            {
+                voice.phase = ADSR_SUSTAIN;
+                voice.adsr_counter = 0;
+            }
+            break;
+        case ADSR_RELEASE:
+            if(level == 0)
+                voice.phase = ADSR_OFF;
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Renders one block of a voice into voice_output.
+ * 
+ * The sample positions, interpolation weights and envelope levels of the whole block are gathered first. The gaussian interpolation and the envelope are then applied to eight samples at a time with SIMD instructions.
+ * With pitch modulation the step is scaled by the output of the previous voice, which has already been rendered for this block.
+ * 
+ * @param index Index of the voice
+ * 
+ * \b References:
+ * @ref step_envelope
+ * @ref next_block
+ */
+void SPU::render_voice(uint32_t index)
+{
+    Voice& voice = voices[index];
+    if(voice.phase == ADSR_OFF)
+    {
+        for(uint32_t n = 0; n < SPU_BLOCK_SIZE; n++)
+            voice_output[n][index] = 0;
+        return;
+    }
+
+    const int16_t* gauss = gauss_table();
+    uint32_t pmon = regs[SPU_REG_PMON_LO >> 1] | (uint32_t(regs[SPU_REG_PMON_HI >> 1]) << 16);
+    bool modulated = index > 0 && (pmon & (1 << index));
+
+    alignas(16) int16_t taps[4][SPU_BLOCK_SIZE];
+    alignas(16) int16_t weights[4][SPU_BLOCK_SIZE];
+    alignas(16) int16_t envelope[SPU_BLOCK_SIZE];
+    alignas(16) int16_t output[SPU_BLOCK_SIZE];
+
+    for(uint32_t n = 0; n < SPU_BLOCK_SIZE; n++)
+    {
+        uint32_t position = voice.pitch_counter >> 12;
+        uint32_t weight = (voice.pitch_counter >> 4) & 0xff;
+        taps[0][n] = voice.decoded[position];
+        taps[1][n] = voice.decoded[position + 1];
+        taps[2][n] = voice.decoded[position + 2];
+        taps[3][n] = voice.decoded[position + 3];
+        weights[0][n] = gauss[0x0ff - weight];
+        weights[1][n] = gauss[0x1ff - weight];
+        weights[2][n] = gauss[0x100 + weight];
+        weights[3][n] = gauss[weight];
+        envelope[n] = voice.level;
+
+        step_envelope(index);
+
+        uint32_t step = voice.pitch;
+        if(modulated)
+        {
+            int32_t factor = voice_output[n][index - 1] + 0x8000;
+            step = uint32_t((int32_t(int16_t(step)) * factor) >> 15) & 0xffff;
+        }
+        if(step > 0x4000)
+            step = 0x4000;
+
+        voice.pitch_counter += step;
+        if((voice.pitch_counter >> 12) >= 28)
+        {
+            voice.pitch_counter -= 28 << 12;
+            next_block(index);
+        }
+    }
+
+#ifdef SPU_SSE2
+    for(uint32_t n = 0; n < SPU_BLOCK_SIZE; n += 8)
+    {
+        __m128i t0 = _mm_load_si128((const __m128i*)&taps[0][n]);
+        __m128i t1 = _mm_load_si128((const __m128i*)&taps[1][n]);
+        __m128i t2 = _mm_load_si128((const __m128i*)&taps[2][n]);
+        __m128i t3 = _mm_load_si128((const __m128i*)&taps[3][n]);
+        __m128i w0 = _mm_load_si128((const __m128i*)&weights[0][n]);
+        __m128i w1 = _mm_load_si128((const __m128i*)&weights[1][n]);
+        __m128i w2 = _mm_load_si128((const __m128i*)&weights[2][n]);
+        __m128i w3 = _mm_load_si128((const __m128i*)&weights[3][n]);
+
+        //pair the taps so that one multiply-add covers two taps of four samples
+        __m128i sum_lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(t0, t1), _mm_unpacklo_epi16(w0, w1)),
+                                       _mm_madd_epi16(_mm_unpacklo_epi16(t2, t3), _mm_unpacklo_epi16(w2, w3)));
+        __m128i sum_hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(t0, t1), _mm_unpackhi_epi16(w0, w1)),
+                                       _mm_madd_epi16(_mm_unpackhi_epi16(t2, t3), _mm_unpackhi_epi16(w2, w3)));
+        __m128i interpolated = _mm_packs_epi32(_mm_srai_epi32(sum_lo, 15), _mm_srai_epi32(sum_hi, 15));
+
+        __m128i env = _mm_load_si128((const __m128i*)&envelope[n]);
+        __m128i lo = _mm_mullo_epi16(interpolated, env);
+        __m128i hi = _mm_mulhi_epi16(interpolated, env);
+        __m128i result = _mm_packs_epi32(_mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 15),
+                                         _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 15));
+        _mm_store_si128((__m128i*)&output[n], result);
+    }
+#else
+    for(uint32_t n = 0; n < SPU_BLOCK_SIZE; n++)
+    {
+        int32_t sum = taps[0][n] * weights[0][n] + taps[1][n] * weights[1][n] + taps[2][n] * weights[2][n] + taps[3][n] * weights[3][n];
+        int32_t interpolated = sum >> 15;
+        interpolated = interpolated < -0x8000 ? -0x8000 : (interpolated > 0x7fff ? 0x7fff : interpolated);
+        output[n] = int16_t((interpolated * envelope[n]) >> 15);
+    }
+#endif
+
+    for(uint32_t n = 0; n < SPU_BLOCK_SIZE; n++)
+        voice_output[n][index] = output[n];
+}
@@ -0,0 +1,88 @@
+#include <iostream>
+
+#include <core/spu/spu.hpp>
+
+/**
+ * @brief Writes an ADPCM block with a constant sample value to sound RAM
+ * 
+ * @param spu 
+ * @param address Address in sound RAM (multiple of 8)
+ * @param flags Loop flags of the block
+ */
+void write_constant_block(SPU& spu, uint32_t address, uint8_t flags)
+{
+    spu.write16_cpu(SPU_REG_TRANSFER_ADDRESS, address / 8);
+    spu.write16_cpu(SPU_REG_TRANSFER_FIFO, uint16_t(flags) << 8); //shift 0, filter 0
+    for(int i = 0; i < 7; i++)
+        spu.write16_cpu(SPU_REG_TRANSFER_FIFO, 0x7777);
+}
+
+/**
+ * @brief Configures voice 0 to play the block at the given address with a fast attack
+ * 
+ * @param spu 
+ * @param address Address in sound RAM (multiple of 8)
+ */
+void setup_voice(SPU& spu, uint32_t address)
+{
+    spu.write16_cpu(SPU_REG_SPUCNT, SPUCNT_ENABLE | SPUCNT_UNMUTE);
+    spu.write16_cpu(SPU_REG_MAIN_VOL_L, 0x3fff);
+    spu.write16_cpu(SPU_REG_MAIN_VOL_R, 0x3fff);
+    spu.write16_cpu(0x0, 0x3fff);
+    spu.write16_cpu(0x2, 0x3fff);
+    spu.write16_cpu(0x4, 0x1000);
+    spu.write16_cpu(0x6, address / 8);
+    spu.write16_cpu(0x8, 0x000f);
+    spu.write16_cpu(0xa, 0x0000);
+    spu.write16_cpu(SPU_REG_KON_LO, 0x0001);
+}
+
+/**
+ * @brief Tests that a looping voice reaches full volume on both channels
+ * 
+ * @param spu 
+ */
+void test_spu_looping_voice(SPU& spu)
+{
+    std::cout << "SPU Looping Voice: ";
+    write_constant_block(spu, 0x1000, ADPCM_FLAG_LOOP_START | ADPCM_FLAG_LOOP_END | ADPCM_FLAG_LOOP_REPEAT);
+    setup_voice(spu, 0x1000);
+    int16_t block[SPU_BLOCK_SIZE * 2];
+    spu.render_block(block);
+    spu.render_block(block);
+    int16_t left = block[SPU_BLOCK_SIZE * 2 - 2];
+    int16_t right = block[SPU_BLOCK_SIZE * 2 - 1];
+    bool looping = spu.read16_cpu(0xc) == 0x7fff;
+    if(left == right && left > 0x6f00 && looping) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+/**
+ * @brief Tests that a voice stops and sets ENDX at a loop end without repeat
+ * 
+ * @param spu 
+ */
+void test_spu_endx(SPU& spu)
+{
+    std::cout << "SPU ENDX: ";
+    write_constant_block(spu, 0x2000, ADPCM_FLAG_LOOP_END);
+    setup_voice(spu, 0x2000);
+    bool cleared = (spu.read16_cpu(SPU_REG_ENDX_LO) & 1) == 0;
+    int16_t block[SPU_BLOCK_SIZE * 2];
+    spu.render_block(block);
+    bool ended = (spu.read16_cpu(SPU_REG_ENDX_LO) & 1) && spu.read16_cpu(0xc) == 0;
+    bool silent = block[SPU_BLOCK_SIZE * 2 - 2] == 0;
+    if(cleared && ended && silent) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+int main()
+{
+    Arena arena(SPU::arena_size());
+    SPU test_spu(arena);
+
+    test_spu_looping_voice(test_spu);
+    test_spu_endx(test_spu);
+
+    return 0;
+}
@@ -0,0 +1,29 @@
+#ifndef TEST_BIOS_HPP
+#define TEST_BIOS_HPP
+
+#include <stdint.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <core/bios/bios.hpp>
+
+/**
+ * @brief Writes a BIOS image running the given program, for testing
+ * 
+ * The program is placed at the reset vector (0xbfc00000) and the rest of the image is filled with NOPs.
+ * 
+ * @param path Path of the image
+ * @param program Instruction words
+ */
+inline void write_test_bios(const std::string& path, const std::vector<uint32_t>& program)
+{
+    std::vector<char> data(BIOS_SIZE, 0);
+    for(size_t i = 0; i < program.size(); i++)
+        for(int b = 0; b < 4; b++)
+            data[i * 4 + b] = char(program[i] >> (b * 8));
+    std::ofstream file(path, std::ios::binary);
+    file.write(data.data(), data.size());
+}
+
+#endif
@@ -0,0 +1,111 @@
+#include <iostream>
+
+#include <core/interconnect/bus.hpp>
+#include <core/timer/timer.hpp>
+#include <test_bios.hpp>
+
+#define TEST_BIOS_PATH "timer_test_bios.bin"
+
+/**
+ * @brief Clocks the bus the given number of times
+ * 
+ * @param bus 
+ * @param count 
+ */
+void run(Bus& bus, int count)
+{
+    for(int i = 0; i < count; i++)
+        bus.clock();
+}
+
+/**
+ * @brief Tests that a free running system clock counter follows the cycle count
+ * 
+ * @param bus 
+ */
+void test_timer_sysclk(Bus& bus)
+{
+    std::cout << "Timer 2 System Clock: ";
+    bus.write16_cpu(0x1f801124, 0x0000);
+    run(bus, 100);
+    uint16_t value = bus.read16_cpu(0x1f801120);
+    if(value == 100 * CYCLES_PER_INSTRUCTION) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+/**
+ * @brief Tests the target interrupt of a counter clocked by system clock / 8
+ * 
+ * @param bus 
+ */
+void test_timer_target_irq(Bus& bus)
+{
+    std::cout << "Timer 2 Target IRQ: ";
+    bus.write32_cpu(0x1f801070, 0);
+    bus.write32_cpu(0x1f801074, 1 << IRQ_TIMER2);
+    bus.write16_cpu(0x1f801128, 10);
+    bus.write16_cpu(0x1f801124, 0x0200 | TIMER_MODE_RESET_AT_TARGET | TIMER_MODE_IRQ_AT_TARGET | TIMER_MODE_IRQ_REPEAT);
+    bool early = bus.read32_cpu(0x1f801070) == 0;
+    run(bus, 8 * 11 / CYCLES_PER_INSTRUCTION + 8);
+    bool raised = bus.read32_cpu(0x1f801070) == (1 << IRQ_TIMER2);
+    bool reached = bus.read16_cpu(0x1f801124) & TIMER_MODE_REACHED_TARGET;
+    bool wrapped = bus.read16_cpu(0x1f801120) <= 10;
+    if(early && raised && reached && wrapped) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+/**
+ * @brief Tests counter 1 clocked by hblank
+ * 
+ * @param bus 
+ */
+void test_timer_hblank(Bus& bus)
+{
+    std::cout << "Timer 1 Hblank Clock: ";
+    bus.write16_cpu(0x1f801114, 0x0100);
+    run(bus, 3 * CYCLES_PER_SCANLINE / CYCLES_PER_INSTRUCTION);
+    uint16_t value = bus.read16_cpu(0x1f801110);
+    if(value == 3) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+/**
+ * @brief Tests the interrupt flag of a counter in toggle mode when several periods pass between synchronizations
+ * 
+ * With the cycle model an instruction fetched from the BIOS takes more cycles than a period of a counter reset at target 1, so whole periods are collapsed. The flag must flip once per period.
+ * 
+ * @param bus 
+ */
+void test_timer_toggle_periods(Bus& bus)
+{
+    std::cout << "Timer 2 Toggle Periods: ";
+    bool toggled = true;
+    bus.set_cycle_model(true);
+    bus.write16_cpu(0x1f801128, 1);
+    for(int count = 1; count <= 8; count++)
+    {
+        uint64_t start = bus.get_cycles();
+        bus.write16_cpu(0x1f801124, TIMER_MODE_RESET_AT_TARGET | TIMER_MODE_IRQ_AT_TARGET | TIMER_MODE_IRQ_REPEAT | TIMER_MODE_IRQ_TOGGLE);
+        run(bus, count);
+        uint64_t hits = (bus.get_cycles() - start + 1) / 2;
+        bool flag = bus.read16_cpu(0x1f801124) & TIMER_MODE_IRQ_FLAG;
+        toggled = toggled && flag == !(hits & 1);
+    }
+    bus.write16_cpu(0x1f801124, 0);
+    bus.set_cycle_model(false);
+    if(toggled) std::cout << "Success" << std::endl;
+    else std::cout << "Failure" << std::endl;
+}
+
+int main()
+{
+    write_test_bios(TEST_BIOS_PATH, {});
+    Bus bus(TEST_BIOS_PATH);
+
+    test_timer_sysclk(bus);
+    test_timer_target_irq(bus);
+    test_timer_hblank(bus);
+    test_timer_toggle_periods(bus);
+
+    return 0;
+}
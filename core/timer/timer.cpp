@@ -0,0 +1,475 @@
+#include <sstream>
+#include <stdexcept>
+
+#include "core/timer/timer.hpp"
+#include "core/interconnect/bus.hpp"
+
+/**
+ * @brief Construct a new Timers:: Timers object
+ * 
+ * All counters start at 0 in free-running system clock mode with interrupts disabled.
+ */
+Timers::Timers()
+{
+    bus = nullptr;
+    for(int i = 0; i < 3; i++)
+    {
+        counters[i].value = 0;
+        counters[i].mode = TIMER_MODE_IRQ_FLAG;
+        counters[i].target = 0;
+        counters[i].last_sync = 0;
+        counters[i].irq_fired = false;
+        counters[i].waiting_for_blank = false;
+    }
+}
+
+/**
+ * @brief Reads a root counter register.
+ * 
+ * Reading the mode register clears the reached target and reached 0xffff flags.
+ * 
+ * @param offset Offset from the start of the timer range
+ * @return uint32_t Value of the register
+ * 
+ * @throw std::runtime_error If the offset does not map to a register
+ * 
+ * \b References:
+ * @ref sync
+ */
+uint32_t Timers::read32_cpu(uint32_t offset)
+{
+    int index = offset >> 4;
+    if(index < 3)
+    {
+        RootCounter& counter = counters[index];
+        switch(offset & 0xf)
+        {
+            case TIMER_REG_VALUE:
+                sync(index);
+                return counter.value;
+            case TIMER_REG_MODE:
+            {
+                sync(index);
+                uint16_t mode = counter.mode;
+                counter.mode &= ~(TIMER_MODE_REACHED_TARGET | TIMER_MODE_REACHED_MAX);
+                return mode;
+            }
+            case TIMER_REG_TARGET:
+                return counter.target;
+        }
+    }
+
+    std::stringstream ss;
+    ss << "Unhandled read from Timer register: 0x" << std::hex << offset;
+    throw std::runtime_error(ss.str());
+}
+
+/**
+ * @brief Writes a root counter register.
+ * 
+ * Writing the mode register resets the counter value to 0 and re-arms the interrupt.
+ * 
+ * @param offset Offset from the start of the timer range
+ * @param data Data to write
+ * 
+ * @throw std::runtime_error If the offset does not map to a register
+ * 
+ * \b References:
+ * @ref sync
+ * @ref schedule_irq
+ */
+void Timers::write32_cpu(uint32_t offset, uint32_t data)
+{
+    int index = offset >> 4;
+    if(index < 3)
+    {
+        RootCounter& counter = counters[index];
+        switch(offset & 0xf)
+        {
+            case TIMER_REG_VALUE:
+                sync(index);
+                counter.value = data & 0xffff;
+                schedule_irq(index);
+                return;
+            case TIMER_REG_MODE:
+                sync(index);
+                counter.mode = (data & 0x3ff) | TIMER_MODE_IRQ_FLAG;
+                counter.value = 0;
+                counter.irq_fired = false;
+                counter.waiting_for_blank = index < 2 && (data & TIMER_MODE_SYNC_ENABLE) && ((data >> 1) & 3) == 3;
+                schedule_irq(index);
+                return;
+            case TIMER_REG_TARGET:
+                sync(index);
+                counter.target = data & 0xffff;
+                schedule_irq(index);
+                return;
+        }
+    }
+
+    std::stringstream ss;
+    ss << "Unhandled write to Timer register: 0x" << std::hex << offset;
+    throw std::runtime_error(ss.str());
+}
+
+/**
+ * @brief Handles the scheduled interrupt event of a counter.
+ * 
+ * The event is scheduled no later than the counter can reach its target (or 0xffff), so bringing the counter up to date raises the interrupt if it is due. Otherwise the event is simply scheduled again.
+ * 
+ * @param index Index of the counter
+ * 
+ * \b References:
+ * @ref sync
+ * @ref schedule_irq
+ */
+void Timers::handle_event(int index)
+{
+    sync(index);
+    schedule_irq(index);
+}
+
+/**
+ * @brief Brings the value of a counter up to the current cycle count.
+ * 
+ * Splits the elapsed time at the hblank/vblank boundaries when a sync mode is active and counts the ticks of the clock source in each part.
+ * 
+ * Sync modes of counters 0 (hblank) and 1 (vblank): \n
+ * - \b 0: Pause the counter during the blank \n
+ * - \b 1: Reset the counter to 0 at the start of the blank \n
+ * - \b 2: Reset the counter to 0 at the start of the blank and pause outside of the blank \n
+ * - \b 3: Pause until the first blank, then free run \n
+ * 
+ * Sync modes of counter 2: \n
+ * - \b 0, \b 3: Stop the counter \n
+ * - \b 1, \b 2: Free run \n
+ * 
+ * @param index Index of the counter
+ * 
+ * \b References:
+ * @ref count
+ * @ref source_ticks
+ * @ref Bus::get_cycles
+ */
+void Timers::sync(int index)
+{
+    RootCounter& counter = counters[index];
+    uint64_t now = bus->get_cycles();
+    uint64_t from = counter.last_sync;
+    counter.last_sync = now;
+    if(from >= now)
+        return;
+
+    uint32_t sync_mode = (counter.mode >> 1) & 3;
+    if(!(counter.mode & TIMER_MODE_SYNC_ENABLE))
+    {
+        count(index, source_ticks(index, from, now));
+        return;
+    }
+    if(index == 2)
+    {
+        if(sync_mode == 1 || sync_mode == 2)
+            count(index, source_ticks(index, from, now));
+        return;
+    }
+
+    uint64_t period = index == 0 ? CYCLES_PER_SCANLINE : CYCLES_PER_FRAME;
+    uint64_t blank = index == 0 ? HBLANK_START : VBLANK_START;
+    uint64_t start = from;
+    while(start < now)
+    {
+        uint64_t phase = start % period;
+        bool in_blank = phase >= blank;
+        uint64_t boundary = start - phase + (in_blank ? period : blank);
+        uint64_t end = boundary < now ? boundary : now;
+        bool blank_starts = !in_blank && end == boundary;
+
+        switch(sync_mode)
+        {
+            case 0:
+                if(!in_blank)
+                    count(index, source_ticks(index, start, end));
+                break;
+            case 1:
+                count(index, source_ticks(index, start, end));
+                if(blank_starts)
+                    counter.value = 0;
+                break;
+            case 2:
+                if(in_blank)
+                    count(index, source_ticks(index, start, end));
+                if(blank_starts)
+                    counter.value = 0;
+                break;
+            case 3:
+                if(!counter.waiting_for_blank)
+                {
+                    count(index, source_ticks(index, start, now));
+                    return;
+                }
+                if(blank_starts)
+                    counter.waiting_for_blank = false;
+                break;
+        }
+        start = end;
+    }
+}
+
+/**
+ * @brief Advances the value of a counter by the given number of ticks.
+ * 
+ * Sets the reached target and reached 0xffff flags (and raises the interrupts) for every point passed on the way.
+ * 
+ * @param index Index of the counter
+ * @param ticks Number of ticks of the clock source
+ * 
+ * \b References:
+ * @ref reached_target
+ * @ref reached_max
+ */
+void Timers::count(int index, uint64_t ticks)
+{
+    RootCounter& counter = counters[index];
+    bool reset = counter.mode & TIMER_MODE_RESET_AT_TARGET;
+    while(ticks > 0)
+    {
+        uint64_t wrap = (reset && counter.value <= counter.target) ? counter.target + 1 : 0x10000;
+        //collapse the whole periods, which the interrupt may span in repeat mode (each period flips the flag in toggle mode)
+        if(counter.value == 0 && ticks >= wrap)
+        {
+            //past the first period, only the parity of the number of periods changes the flags
+            uint64_t periods = ticks / wrap;
+            if(periods > 2)
+                periods = 2 + (periods & 1);
+            for(uint64_t i = 0; i < periods; i++)
+            {
+                //a target of 0 keeps the counter at 0, reaching it at every tick
+                if(wrap == 1 || counter.target != 0)
+                    reached_target(index);
+                if(wrap == 0x10000)
+                    reached_max(index);
+            }
+            ticks %= wrap;
+            continue;
+        }
+
+        uint64_t to_wrap = wrap - counter.value;
+        uint64_t to_target = counter.value < counter.target ? counter.target - counter.value : EVENT_NEVER;
+        uint64_t to_max = (wrap == 0x10000 && counter.value < 0xffff) ? 0xffff - counter.value : EVENT_NEVER;
+
+        uint64_t step = ticks;
+        if(to_wrap < step)
+            step = to_wrap;
+        if(to_target < step)
+            step = to_target;
+        if(to_max < step)
+            step = to_max;
+
+        ticks -= step;
+        counter.value = (counter.value + step) % wrap;
+        if(step == to_target)
+            reached_target(index);
+        if(step == to_max)
+            reached_max(index);
+    }
+}
+
+/**
+ * @brief Counts the ticks of the clock source of a counter between two points in time.
+ * 
+ * All sources are derived from the absolute cycle count, so the ticks of consecutive intervals add up exactly.
+ * 
+ * @param index Index of the counter
+ * @param from Start of the interval (cycle count)
+ * @param to End of the interval (cycle count)
+ * @return uint64_t Number of ticks
+ * 
+ * \b References:
+ * @ref source
+ */
+uint64_t Timers::source_ticks(int index, uint64_t from, uint64_t to)
+{
+    switch(source(index))
+    {
+        case TIMER_SOURCE_SYSCLK_DIV8:
+            return to / 8 - from / 8;
+        case TIMER_SOURCE_DOTCLOCK:
+            return to * 11 / 56 - from * 11 / 56;
+        case TIMER_SOURCE_HBLANK:
+        {
+            //number of hblank starts before the given time
+            auto hblanks = [](uint64_t time) -> uint64_t
+            {
+                return time > HBLANK_START ? (time - HBLANK_START - 1) / CYCLES_PER_SCANLINE + 1 : 0;
+            };
+            return hblanks(to) - hblanks(from);
+        }
+        default:
+            return to - from;
+    }
+}
+
+/**
+ * @brief Computes the number of ticks until a counter next reaches the given value.
+ * 
+ * @param index Index of the counter
+ * @param value Value to reach
+ * @return uint64_t Number of ticks (EVENT_NEVER if the value is never reached)
+ */
+uint64_t Timers::ticks_until(int index, uint16_t value)
+{
+    RootCounter& counter = counters[index];
+    bool reset = counter.mode & TIMER_MODE_RESET_AT_TARGET;
+    uint64_t current = counter.value;
+    uint64_t ticks = 0;
+    //at most: finish the current pass, then one full pass from 0
+    for(int pass = 0; pass < 2; pass++)
+    {
+        uint64_t wrap = (reset && current <= counter.target) ? counter.target + 1 : 0x10000;
+        if(value > current && value < wrap)
+            return ticks + (value - current);
+        ticks += wrap - current;
+        current = 0;
+    }
+    return EVENT_NEVER;
+}
+
+/**
+ * @brief Marks that a counter has reached its target.
+ * 
+ * @param index Index of the counter
+ * 
+ * \b References:
+ * @ref trigger_irq
+ */
+void Timers::reached_target(int index)
+{
+    counters[index].mode |= TIMER_MODE_REACHED_TARGET;
+    if(counters[index].mode & TIMER_MODE_IRQ_AT_TARGET)
+        trigger_irq(index);
+}
+
+/**
+ * @brief Marks that a counter has reached 0xffff.
+ * 
+ * @param index Index of the counter
+ * 
+ * \b References:
+ * @ref trigger_irq
+ */
+void Timers::reached_max(int index)
+{
+    counters[index].mode |= TIMER_MODE_REACHED_MAX;
+    if(counters[index].mode & TIMER_MODE_IRQ_AT_MAX)
+        trigger_irq(index);
+}
+
+/**
+ * @brief Raises the interrupt of a counter.
+ * 
+ * In one-shot mode the interrupt is only raised once after the mode is written. In toggle mode the interrupt flag (bit 10 of the mode) is inverted and the interrupt is only raised when it goes low. In pulse mode the flag only goes low for a few cycles, so it always reads back as 1.
+ * 
+ * @param index Index of the counter
+ * 
+ * \b References:
+ * @ref Bus::raise_irq
+ */
+void Timers::trigger_irq(int index)
+{
+    RootCounter& counter = counters[index];
+    if(!(counter.mode & TIMER_MODE_IRQ_REPEAT) && counter.irq_fired)
+        return;
+    counter.irq_fired = true;
+
+    if(counter.mode & TIMER_MODE_IRQ_TOGGLE)
+    {
+        counter.mode ^= TIMER_MODE_IRQ_FLAG;
+        if(counter.mode & TIMER_MODE_IRQ_FLAG)
+            return;
+    }
+    bus->raise_irq(IRQ(IRQ_TIMER0 + index));
+}
+
+/**
+ * @brief Schedules the event for the next interrupt of a counter.
+ * 
+ * The time is a lower bound assuming the counter is never paused. If the counter was paused or reset in between, the event finds that the interrupt is not due yet and schedules itself again.
+ * 
+ * @param index Index of the counter
+ * 
+ * \b References:
+ * @ref ticks_until
+ * @ref Bus::schedule_event
+ * @ref Bus::cancel_event
+ */
+void Timers::schedule_irq(int index)
+{
+    RootCounter& counter = counters[index];
+    Event event = Event(EVENT_TIMER0 + index);
+
+    bool armed = (counter.mode & TIMER_MODE_IRQ_REPEAT) || !counter.irq_fired;
+    bool stopped = index == 2 && (counter.mode & TIMER_MODE_SYNC_ENABLE) && (((counter.mode >> 1) & 3) == 0 || ((counter.mode >> 1) & 3) == 3);
+    uint64_t ticks = EVENT_NEVER;
+    if(armed && !stopped)
+    {
+        if(counter.mode & TIMER_MODE_IRQ_AT_TARGET)
+        {
+            uint64_t to_target = ticks_until(index, counter.target);
+            ticks = to_target < ticks ? to_target : ticks;
+        }
+        if(counter.mode & TIMER_MODE_IRQ_AT_MAX)
+        {
+            uint64_t to_max = ticks_until(index, 0xffff);
+            ticks = to_max < ticks ? to_max : ticks;
+        }
+    }
+    if(ticks == EVENT_NEVER)
+    {
+        bus->cancel_event(event);
+        return;
+    }
+
+    uint64_t cycles;
+    switch(source(index))
+    {
+        case TIMER_SOURCE_SYSCLK_DIV8:
+            cycles = ticks * 8 - 7;
+            break;
+        case TIMER_SOURCE_DOTCLOCK:
+            cycles = ticks * 56 / 11;
+            cycles = cycles > 5 ? cycles - 5 : 1;
+            break;
+        case TIMER_SOURCE_HBLANK:
+            cycles = (ticks - 1) * CYCLES_PER_SCANLINE + 1;
+            break;
+        default:
+            cycles = ticks;
+            break;
+    }
+    bus->schedule_event(event, bus->get_cycles() + cycles);
+}
+
+/**
+ * @brief Returns the clock source selected in the mode of a counter.
+ * 
+ * Clock sources (bits [9:8] of the mode): \n
+ * - \b Counter 0: 0, 2 = system clock; 1, 3 = dotclock \n
+ * - \b Counter 1: 0, 2 = system clock; 1, 3 = hblank \n
+ * - \b Counter 2: 0, 1 = system clock; 2, 3 = system clock / 8 \n
+ * 
+ * @param index Index of the counter
+ * @return TimerSource Clock source
+ */
+TimerSource Timers::source(int index)
+{
+    uint32_t clock = (counters[index].mode >> 8) & 3;
+    switch(index)
+    {
+        case 0:
+            return (clock & 1) ? TIMER_SOURCE_DOTCLOCK : TIMER_SOURCE_SYSCLK;
+        case 1:
+            return (clock & 1) ? TIMER_SOURCE_HBLANK : TIMER_SOURCE_SYSCLK;
+        default:
+            return (clock & 2) ? TIMER_SOURCE_SYSCLK_DIV8 : TIMER_SOURCE_SYSCLK;
+    }
+}
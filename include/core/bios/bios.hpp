@@ -1,30 +1,44 @@
 #ifndef BIOS_HPP
 #define BIOS_HPP
 
+#include <stddef.h>
 #include <stdint.h>
 #include <string>
-#include <vector>
+
+#include <core/memory/arena.hpp>
+#include <core/memory/cow_memory.hpp>
 
 #define BIOS_SIZE 512 * 1024
 
 /**
  * @brief Class to emulate the BIOS.
  * 
- * Implements the BIOS of the PSX.
+ * Implements the BIOS of the PSX. The image lives in the arena of the machine, and is shared with the machines forked from it.
  */
 class BIOS
 {
 public:
-    BIOS(std::string path);
+    BIOS(Arena& arena, std::string path);
+    BIOS(Arena& arena, BIOS& parent);
+    static size_t arena_size();
     uint32_t read32_cpu(uint32_t offset);
     uint8_t read8_cpu(uint32_t offset);
 
+    /**
+     * @brief Returns the host address of a byte of the BIOS.
+     * 
+     * Used by the Bus to map the BIOS into its page table.
+     * @param offset Offset in the BIOS
+     * @return const uint8_t* Host address
+     */
+    const uint8_t* get_host(uint32_t offset) { return data.read_ptr(offset); }
+
 private:
     /**
      * @brief Data of the BIOS.
      * 
      */
-    std::vector<uint8_t> data;
+    CowMemory data;
 };
 
 #endif
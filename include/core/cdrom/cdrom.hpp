@@ -0,0 +1,314 @@
+#ifndef CDROM_HPP
+#define CDROM_HPP
+
+#include <stdint.h>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <core/cdrom/disc_reader.hpp>
+
+#define CDROM_FIFO_SIZE 16
+
+#define CDROM_STATUS_PRMEMPT 0x08
+#define CDROM_STATUS_PRMWRDY 0x10
+#define CDROM_STATUS_RSLRRDY 0x20
+#define CDROM_STATUS_DRQSTS 0x40
+#define CDROM_STATUS_BUSYSTS 0x80
+
+#define CDROM_STAT_ERROR 0x01
+#define CDROM_STAT_MOTOR 0x02
+#define CDROM_STAT_SEEK_ERROR 0x04
+#define CDROM_STAT_ID_ERROR 0x08
+#define CDROM_STAT_SHELL_OPEN 0x10
+#define CDROM_STAT_READING 0x20
+#define CDROM_STAT_SEEKING 0x40
+#define CDROM_STAT_PLAYING 0x80
+
+#define CDROM_MODE_CDDA 0x01
+#define CDROM_MODE_AUTOPAUSE 0x02
+#define CDROM_MODE_REPORT 0x04
+#define CDROM_MODE_XA_FILTER 0x08
+#define CDROM_MODE_IGNORE 0x10
+#define CDROM_MODE_SECTOR_SIZE 0x20
+#define CDROM_MODE_XA_ADPCM 0x40
+#define CDROM_MODE_DOUBLE_SPEED 0x80
+
+#define CDROM_REQUEST_BFRD 0x80
+
+#define CDROM_INT_ACK_MASK 0x1f
+#define CDROM_INT_CLEAR_PARAMS 0x40
+
+/**
+ * @brief Timings in CPU cycles.
+ * 
+ * A sector takes 1/75s at single speed and 1/150s at double speed. The delay of the first response is an average of the delays measured on hardware.
+ */
+#define CDROM_CYCLES_PER_SECOND 33868800
+#define CDROM_READ_CYCLES_SINGLE (CDROM_CYCLES_PER_SECOND / 75)
+#define CDROM_READ_CYCLES_DOUBLE (CDROM_CYCLES_PER_SECOND / 150)
+#define CDROM_FIRST_RESPONSE_CYCLES 25000
+#define CDROM_INIT_RESPONSE_CYCLES 80000
+#define CDROM_SECOND_RESPONSE_CYCLES 20000
+#define CDROM_SEEK_CYCLES 100000
+#define CDROM_READ_RETRY_CYCLES 4000
+
+class Bus;
+
+/**
+ * @brief Interrupts (responses) of the CD-ROM controller.
+ * 
+ */
+enum CDROMInterrupt
+{
+    CDROM_INT_NONE = 0,
+    CDROM_INT_DATA_READY = 1,
+    CDROM_INT_COMPLETE = 2,
+    CDROM_INT_ACKNOWLEDGE = 3,
+    CDROM_INT_DATA_END = 4,
+    CDROM_INT_ERROR = 5
+};
+
+/**
+ * @brief Commands of the CD-ROM controller.
+ * 
+ */
+enum CDROMCommand
+{
+    CDROM_CMD_GETSTAT = 0x01,
+    CDROM_CMD_SETLOC = 0x02,
+    CDROM_CMD_PLAY = 0x03,
+    CDROM_CMD_READN = 0x06,
+    CDROM_CMD_STOP = 0x08,
+    CDROM_CMD_PAUSE = 0x09,
+    CDROM_CMD_INIT = 0x0a,
+    CDROM_CMD_MUTE = 0x0b,
+    CDROM_CMD_DEMUTE = 0x0c,
+    CDROM_CMD_SETFILTER = 0x0d,
+    CDROM_CMD_SETMODE = 0x0e,
+    CDROM_CMD_GETPARAM = 0x0f,
+    CDROM_CMD_GETLOCL = 0x10,
+    CDROM_CMD_GETLOCP = 0x11,
+    CDROM_CMD_GETTN = 0x13,
+    CDROM_CMD_GETTD = 0x14,
+    CDROM_CMD_SEEKL = 0x15,
+    CDROM_CMD_SEEKP = 0x16,
+    CDROM_CMD_TEST = 0x19,
+    CDROM_CMD_GETID = 0x1a,
+    CDROM_CMD_READS = 0x1b,
+    CDROM_CMD_READTOC = 0x1e
+};
+
+/**
+ * @brief States of the drive mechanism.
+ * 
+ */
+enum DriveState
+{
+    DRIVE_IDLE,
+    DRIVE_SEEKING,
+    DRIVE_READING
+};
+
+/**
+ * @brief Structure to store an interrupt and its response bytes.
+ * 
+ */
+struct CDROMResponse
+{
+    /**
+     * @brief Interrupt raised with the response
+     * 
+     */
+    CDROMInterrupt irq;
+
+    /**
+     * @brief Bytes pushed to the response FIFO
+     * 
+     */
+    std::vector<uint8_t> data;
+};
+
+/**
+ * @brief Class to emulate the CD-ROM controller.
+ * 
+ * Implements the four index-banked registers, the parameter, response and data FIFOs and the command set used by the BIOS and games. Commands run from scheduled events: the first response (INT3) after a short delay, and the second response (INT2) or the sectors (INT1) from the drive event. Responses that become ready while an interrupt is still unacknowledged are queued, like on hardware.
+ * 
+ * Sectors come from a DiscReader, which reads ahead on its own thread. If a sector has not been read yet when the drive reaches it, the drive retries shortly after instead of waiting for the file.
+ * 
+ * TODO: Implement CD audio playback, XA-ADPCM decoding and the sector filters.
+ */
+class CDROM
+{
+public:
+    CDROM();
+    CDROM(CDROM& parent);
+
+    /**
+     * @brief Connects Bus to the CDROM.
+     * 
+     * Used by the constructor of Bus to connect the CDROM to the Bus.
+     * @param bus Pointer to the bus structure
+     */
+    void connectBus(Bus* bus) { this->bus = bus; }
+
+    /**
+     * @brief Sets whether the drive waits for the disc image instead of retrying later.
+     * 
+     * @param enabled Whether sectors are read synchronously
+     */
+    void set_deterministic(bool enabled) { deterministic = enabled; }
+
+    void insert_disc(std::unique_ptr<Disc> disc, uint32_t read_ahead = DEFAULT_READ_AHEAD);
+
+    uint8_t read8_cpu(uint32_t offset);
+    void write8_cpu(uint32_t offset, uint8_t data);
+    uint32_t read_data32();
+
+    void handle_command_event();
+    void handle_drive_event();
+
+private:
+    void write_command(uint8_t command);
+    void execute_command();
+    void finish_command();
+    void push_response(CDROMInterrupt irq, std::vector<uint8_t> data);
+    void deliver(CDROMResponse& r);
+    void acknowledge(uint8_t bits);
+    void load_data_fifo();
+    void start_reading();
+    void deliver_sector();
+    uint8_t stat();
+    uint64_t read_cycles();
+
+private:
+    /**
+     * @brief Pointer to the Bus object
+     * 
+     */
+    Bus* bus;
+
+    /**
+     * @brief Reader of the inserted disc, nullptr if there is no disc
+     * 
+     * The machines forked from this one have their own reader over the same image.
+     */
+    std::unique_ptr<DiscReader> reader;
+
+    /**
+     * @brief Bank selected by the index register (0 - 3)
+     * 
+     */
+    uint8_t index;
+
+    /**
+     * @brief Interrupt enable register
+     * 
+     */
+    uint8_t int_enable;
+
+    /**
+     * @brief Interrupt flag register
+     * 
+     */
+    uint8_t int_flag;
+
+    /**
+     * @brief Parameter FIFO
+     * 
+     */
+    std::deque<uint8_t> params;
+
+    /**
+     * @brief Response FIFO
+     * 
+     */
+    std::deque<uint8_t> response;
+
+    /**
+     * @brief Responses waiting for the current interrupt to be acknowledged
+     * 
+     */
+    std::deque<CDROMResponse> queued;
+
+    /**
+     * @brief Data FIFO, filled from the sector buffer when BFRD is set
+     * 
+     */
+    std::vector<uint8_t> data_fifo;
+
+    /**
+     * @brief Read position in the data FIFO
+     * 
+     */
+    uint32_t data_index;
+
+    /**
+     * @brief Command waiting for its first response
+     * 
+     */
+    uint8_t command;
+
+    /**
+     * @brief Whether a command is waiting for its first response
+     * 
+     */
+    bool busy;
+
+    /**
+     * @brief Command waiting for its second response from the drive, 0 if none
+     * 
+     */
+    uint8_t second_command;
+
+    /**
+     * @brief Mode register set with Setmode
+     * 
+     */
+    uint8_t mode;
+
+    /**
+     * @brief State of the drive
+     * 
+     */
+    DriveState state;
+
+    /**
+     * @brief Target of the last Setloc, relative to 00:02:00
+     * 
+     */
+    uint32_t seek_target;
+
+    /**
+     * @brief Whether Setloc was issued since the last seek
+     * 
+     */
+    bool seek_pending;
+
+    /**
+     * @brief Sector under the drive head, relative to 00:02:00
+     * 
+     */
+    uint32_t position;
+
+    /**
+     * @brief Last sector read from the disc
+     * 
+     */
+    uint8_t sector[CD_SECTOR_SIZE];
+
+    /**
+     * @brief Whether the drive motor is on
+     * 
+     */
+    bool motor_on;
+
+    /**
+     * @brief Whether sectors are read synchronously, so the timing never depends on the host
+     * 
+     */
+    bool deterministic;
+};
+
+#endif
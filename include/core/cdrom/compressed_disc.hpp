@@ -0,0 +1,185 @@
+#ifndef COMPRESSED_DISC_HPP
+#define COMPRESSED_DISC_HPP
+
+#include <stdint.h>
+#include <condition_variable>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <core/cdrom/disc.hpp>
+#include <core/cdrom/thread_pool.hpp>
+
+#define CDZ_MAGIC "WPSXCDZ"
+#define CDZ_VERSION 1
+#define CDZ_DEFAULT_HUNK_SECTORS 8
+#define CDZ_DEFAULT_CACHE_HUNKS 256
+#define CDZ_PREFETCH_HUNKS 8
+
+#define CDZ_HUNK_STORED 0x1
+
+/**
+ * @brief Compression methods of the hunks of a compressed disc image.
+ * 
+ */
+enum CDZCompression
+{
+    CDZ_COMPRESSION_ZLIB = 0,
+    CDZ_COMPRESSION_ZSTD = 1
+};
+
+/**
+ * @brief Structure to store the location of a hunk in a compressed disc image.
+ * 
+ */
+struct CDZHunk
+{
+    /**
+     * @brief Offset of the compressed hunk in the file
+     * 
+     */
+    uint64_t offset;
+
+    /**
+     * @brief Size of the compressed hunk
+     * 
+     */
+    uint32_t size;
+
+    /**
+     * @brief CDZ_HUNK_STORED if the hunk did not compress and is stored as is
+     * 
+     */
+    uint32_t flags;
+};
+
+/**
+ * @brief Structure to store a decoded hunk in the cache.
+ * 
+ */
+struct CachedHunk
+{
+    /**
+     * @brief Raw sectors of the hunk, shared with readers that are still copying from it
+     * 
+     */
+    std::shared_ptr<std::vector<uint8_t>> data;
+
+    /**
+     * @brief Whether the hunk has been decoded (false while a worker is decoding it)
+     * 
+     */
+    bool ready;
+
+    /**
+     * @brief Position of the hunk in the LRU list
+     * 
+     */
+    std::list<uint32_t>::iterator lru;
+};
+
+/**
+ * @brief Disc image made of compressed hunks of raw sectors with an index (.cdz).
+ * 
+ * The image stores the sectors of the disc from 00:02:00 (pregaps included) in hunks of a fixed number of sectors that are compressed independently, so any sector can be reached by decoding a single hunk.
+ * 
+ * File layout (little endian): header (magic, version, sectors per hunk, sector count, track count, compression), track table, hunk index, hunk data.
+ * 
+ * Decoded hunks are kept in an LRU cache. Reading a sector queues the decoding of the following hunks on a thread pool, so sequential reads are served from the cache and scale with the number of cores.
+ */
+class CompressedDisc : public Disc
+{
+public:
+    CompressedDisc(std::string path, uint32_t cache_hunks = CDZ_DEFAULT_CACHE_HUNKS, unsigned int threads = 0);
+    ~CompressedDisc();
+
+    bool read_sector(uint32_t lba, uint8_t* out) override;
+
+    static void create(Disc& source, std::string path, uint32_t hunk_sectors = CDZ_DEFAULT_HUNK_SECTORS, CDZCompression compression = CDZ_COMPRESSION_ZLIB, unsigned int threads = 0);
+
+private:
+    std::shared_ptr<std::vector<uint8_t>> get_hunk(uint32_t hunk);
+    void prefetch(uint32_t hunk);
+    std::shared_ptr<std::vector<uint8_t>> decode(uint32_t hunk);
+    void insert(uint32_t hunk, std::shared_ptr<std::vector<uint8_t>> data);
+    void evict();
+
+private:
+    /**
+     * @brief Compressed image
+     * 
+     */
+    std::ifstream file;
+
+    /**
+     * @brief Protects the file
+     * 
+     */
+    std::mutex file_mutex;
+
+    /**
+     * @brief Number of sectors of a hunk
+     * 
+     */
+    uint32_t hunk_sectors;
+
+    /**
+     * @brief Number of sectors of the disc
+     * 
+     */
+    uint32_t sectors;
+
+    /**
+     * @brief Compression method of the hunks
+     * 
+     */
+    CDZCompression compression;
+
+    /**
+     * @brief Hunk index
+     * 
+     */
+    std::vector<CDZHunk> hunks;
+
+    /**
+     * @brief Decoded (or being decoded) hunks
+     * 
+     */
+    std::unordered_map<uint32_t, CachedHunk> cache;
+
+    /**
+     * @brief Hunks of the cache from the most to the least recently used
+     * 
+     */
+    std::list<uint32_t> lru;
+
+    /**
+     * @brief Maximum number of decoded hunks kept
+     * 
+     */
+    uint32_t cache_hunks;
+
+    /**
+     * @brief Protects cache and lru
+     * 
+     */
+    std::mutex cache_mutex;
+
+    /**
+     * @brief Signalled when a hunk has been decoded
+     * 
+     */
+    std::condition_variable decoded;
+
+    /**
+     * @brief Workers decoding the prefetched hunks, destroyed first
+     * 
+     */
+    std::unique_ptr<ThreadPool> pool;
+};
+
+#endif
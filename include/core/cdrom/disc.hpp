@@ -0,0 +1,149 @@
+#ifndef DISC_HPP
+#define DISC_HPP
+
+#include <stdint.h>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define CD_SECTOR_SIZE 2352
+#define CD_DATA_SIZE 2048
+#define CD_SECTORS_PER_SECOND 75
+#define CD_PREGAP_SECTORS 150
+
+/**
+ * @brief Structure to store a track of a disc image.
+ * 
+ */
+struct Track
+{
+    /**
+     * @brief Track number (1 - 99)
+     * 
+     */
+    uint8_t number;
+
+    /**
+     * @brief Whether the track contains CD audio
+     * 
+     */
+    bool audio;
+
+    /**
+     * @brief First sector of the track (index 01), relative to 00:02:00
+     * 
+     */
+    uint32_t start;
+
+    /**
+     * @brief Number of sectors of the track, pregap of the next track included
+     * 
+     */
+    uint32_t length;
+
+    /**
+     * @brief Index of the file holding the data of the track
+     * 
+     */
+    uint32_t file;
+
+    /**
+     * @brief Sector of the file that corresponds to the start of the track
+     * 
+     */
+    uint32_t file_sector;
+
+    /**
+     * @brief Number of sectors of the track stored in the file, the rest reads as zeros
+     * 
+     */
+    uint32_t file_length;
+};
+
+/**
+ * @brief Base class of the disc image formats.
+ * 
+ * Presents the image as a sequence of raw 2352 byte sectors addressed from 00:02:00. The images are not thread safe, they are only accessed by the threads of the DiscReaders, one at a time (see SharedDisc).
+ */
+class Disc
+{
+public:
+    virtual ~Disc() {}
+
+    /**
+     * @brief Reads a raw sector of the disc.
+     * 
+     * @param lba Sector to read, relative to 00:02:00
+     * @param out Buffer of CD_SECTOR_SIZE bytes
+     * @return true The sector was read
+     * @return false The sector is outside of the disc
+     */
+    virtual bool read_sector(uint32_t lba, uint8_t* out) = 0;
+
+    uint32_t sector_count();
+    const std::vector<Track>& get_tracks() { return tracks; }
+    const Track* find_track(uint32_t lba);
+
+protected:
+    /**
+     * @brief Tracks of the disc, sorted by start sector
+     * 
+     */
+    std::vector<Track> tracks;
+};
+
+/**
+ * @brief Disc image made of a CUE sheet and one or more raw (2352 bytes per sector) BIN files.
+ * 
+ */
+class BinCueDisc : public Disc
+{
+public:
+    BinCueDisc(std::string cue_path);
+
+    bool read_sector(uint32_t lba, uint8_t* out) override;
+
+private:
+    void add_file(std::string path);
+
+private:
+    /**
+     * @brief BIN files referenced by the CUE sheet
+     * 
+     */
+    std::vector<std::ifstream> files;
+
+    /**
+     * @brief Number of sectors of each BIN file
+     * 
+     */
+    std::vector<uint32_t> file_sectors;
+};
+
+/**
+ * @brief Disc image made of 2048 byte user data sectors.
+ * 
+ * Sync, header and subheader of the raw sectors are synthesized as Mode 2 Form 1. EDC and ECC are left as zero.
+ */
+class IsoDisc : public Disc
+{
+public:
+    IsoDisc(std::string path);
+
+    bool read_sector(uint32_t lba, uint8_t* out) override;
+
+private:
+    /**
+     * @brief ISO file
+     * 
+     */
+    std::ifstream file;
+};
+
+std::unique_ptr<Disc> open_disc(std::string path);
+
+uint8_t to_bcd(uint8_t value);
+uint8_t from_bcd(uint8_t value);
+
+#endif
@@ -0,0 +1,148 @@
+#ifndef DISC_READER_HPP
+#define DISC_READER_HPP
+
+#include <stdint.h>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <core/cdrom/disc.hpp>
+
+#define DEFAULT_READ_AHEAD 64
+
+/**
+ * @brief Structure to store a sector of the read-ahead cache.
+ * 
+ */
+struct CachedSector
+{
+    /**
+     * @brief Sector stored in the slot
+     * 
+     */
+    uint32_t lba;
+
+    /**
+     * @brief Whether the slot holds a sector
+     * 
+     */
+    bool valid;
+
+    /**
+     * @brief Raw sector data
+     * 
+     */
+    uint8_t data[CD_SECTOR_SIZE];
+};
+
+/**
+ * @brief Structure to share a disc image between the readers of forked machines.
+ * 
+ */
+struct SharedDisc
+{
+    /**
+     * @brief Disc image
+     * 
+     */
+    std::unique_ptr<Disc> disc;
+
+    /**
+     * @brief Held by a worker while it reads a sector, the images are not thread safe
+     * 
+     */
+    std::mutex mutex;
+};
+
+/**
+ * @brief Class to read sectors of a disc image on a worker thread.
+ * 
+ * The worker keeps the window of sectors [head, head + read_ahead) in an in-memory cache, where head follows the last sector requested by the emulation thread. The emulation thread only ever copies sectors out of the cache, so it never waits for file I/O; the mutex is held by the worker only while a sector that has already been read is stored.
+ * 
+ * The cache is direct mapped (slot = lba % capacity) with room for the window and as many sectors behind it, so short backward seeks (retries, loops of streamed audio) usually hit.
+ * 
+ * A forked machine gets its own reader, with its own window, cache and worker, over the image of its parent. Machines running in parallel then never move each other's window.
+ */
+class DiscReader
+{
+public:
+    DiscReader(std::unique_ptr<Disc> disc, uint32_t read_ahead = DEFAULT_READ_AHEAD);
+    DiscReader(DiscReader& parent);
+    ~DiscReader();
+
+    void seek(uint32_t lba);
+    bool read(uint32_t lba, uint8_t* out);
+    void read_wait(uint32_t lba, uint8_t* out);
+    void set_read_ahead(uint32_t sectors);
+
+    /**
+     * @brief Returns the disc image being read.
+     * 
+     * Only the metadata of the image (tracks, size) may be used from the emulation thread.
+     * @return Disc* Pointer to the disc image
+     */
+    Disc* get_disc() { return image->disc.get(); }
+
+private:
+    void worker();
+    bool next_missing(uint32_t& lba);
+
+private:
+    /**
+     * @brief Disc image, shared with the readers forked from this one and only read from the worker threads
+     * 
+     */
+    std::shared_ptr<SharedDisc> image;
+
+    /**
+     * @brief Sector cache
+     * 
+     */
+    std::vector<CachedSector> cache;
+
+    /**
+     * @brief First sector of the read-ahead window
+     * 
+     */
+    uint32_t head;
+
+    /**
+     * @brief Number of sectors of the read-ahead window
+     * 
+     */
+    uint32_t read_ahead;
+
+    /**
+     * @brief Set to stop the worker thread
+     * 
+     */
+    bool stop;
+
+    /**
+     * @brief Protects the cache, head, read_ahead and stop
+     * 
+     */
+    std::mutex mutex;
+
+    /**
+     * @brief Wakes up the worker when the window moves
+     * 
+     */
+    std::condition_variable wake;
+
+    /**
+     * @brief Wakes up the readers waiting for a sector when the worker has read one
+     * 
+     */
+    std::condition_variable filled;
+
+    /**
+     * @brief Worker thread
+     * 
+     */
+    std::thread thread;
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Class to run tasks on a fixed set of worker threads.
+ * 
+ * Tasks are run in the order they are submitted. Pending tasks are dropped when the pool is destroyed.
+ */
+class ThreadPool
+{
+public:
+    ThreadPool(unsigned int threads = 0);
+    ~ThreadPool();
+
+    void submit(std::function<void()> task);
+
+    /**
+     * @brief Returns the number of worker threads.
+     * 
+     * @return unsigned int Number of worker threads
+     */
+    unsigned int size() { return workers.size(); }
+
+private:
+    void worker();
+
+private:
+    /**
+     * @brief Worker threads
+     * 
+     */
+    std::vector<std::thread> workers;
+
+    /**
+     * @brief Tasks waiting for a worker
+     * 
+     */
+    std::deque<std::function<void()>> tasks;
+
+    /**
+     * @brief Set to stop the workers
+     * 
+     */
+    bool stop;
+
+    /**
+     * @brief Protects tasks and stop
+     * 
+     */
+    std::mutex mutex;
+
+    /**
+     * @brief Wakes up a worker when a task is submitted
+     * 
+     */
+    std::condition_variable wake;
+};
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef COVERAGE_HPP
+#define COVERAGE_HPP
+
+#include <stdint.h>
+#include <string>
+
+#define COVERAGE_RAM_SIZE 0x200000
+#define COVERAGE_BIOS_START 0x1fc00000
+#define COVERAGE_BIOS_SIZE 0x80000
+
+#define COVERAGE_RAM_BYTES (COVERAGE_RAM_SIZE / 4 / 8)
+#define COVERAGE_BIOS_BYTES (COVERAGE_BIOS_SIZE / 4 / 8)
+
+#define COVERAGE_MAGIC "WPSXCOV1"
+#define COVERAGE_MAGIC_SIZE 8
+
+/**
+ * @brief Class to record which words of RAM and BIOS have been executed.
+ * 
+ * Holds one bit per 4-byte word. The CPU sets the bit of every instruction it executes when the emulator is built with WOLPSX_COVERAGE and a coverage map is attached to the Bus.
+ * 
+ * Maps are saved as the magic, then the RAM bits, then the BIOS bits, bit n of byte i covering word i * 8 + n. Maps from separate runs are merged by ORing them.
+ */
+class CodeCoverage
+{
+public:
+    CodeCoverage();
+
+    /**
+     * @brief Marks the word at the given address as executed.
+     * 
+     * Addresses outside RAM and BIOS are ignored.
+     * 
+     * @param addr Virtual address of the instruction
+     */
+    void mark(uint32_t addr)
+    {
+        uint32_t phys = addr & 0x1fffffff;
+        if(phys < COVERAGE_RAM_SIZE)
+            ram[phys >> 5] |= 1 << ((phys >> 2) & 7);
+        else if(phys - COVERAGE_BIOS_START < COVERAGE_BIOS_SIZE)
+            bios[(phys - COVERAGE_BIOS_START) >> 5] |= 1 << ((phys >> 2) & 7);
+    }
+
+    bool is_covered(uint32_t addr);
+    uint32_t count_ram();
+    uint32_t count_bios();
+    void clear();
+    void merge(const CodeCoverage& other);
+    void save(const std::string& path);
+    void load(const std::string& path);
+
+private:
+    /**
+     * @brief Bits of the words of RAM
+     * 
+     */
+    uint8_t ram[COVERAGE_RAM_BYTES];
+
+    /**
+     * @brief Bits of the words of BIOS
+     * 
+     */
+    uint8_t bios[COVERAGE_BIOS_BYTES];
+};
+
+#endif
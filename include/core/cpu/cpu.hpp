@@ -2,12 +2,57 @@
 #define CPU_HPP
 
 #include <stdint.h>
-#include <map>
 #include <string>
 #include <queue>
 
+#include <core/monitor/monitor.hpp>
+#include <core/coverage/coverage.hpp>
+
+#define LOOKUP_SIZE 64
+
+#define ICACHE_LINES 256
+#define ICACHE_LINE_WORDS 4
+
+#define CACHE_CTRL_TAG_TEST 0x00000004
+#define CACHE_CTRL_ICACHE_ENABLE 0x00000800
+
+#define COP0_STATUS_ISOLATE_CACHE 0x00010000
+
+#define DCIC_HIT_ANY 0x00000001
+#define DCIC_HIT_CODE 0x00000002
+#define DCIC_HIT_DATA 0x00000004
+#define DCIC_HIT_READ 0x00000008
+#define DCIC_HIT_WRITE 0x00000010
+#define DCIC_MASTER 0xc0800000
+#define DCIC_CODE_ENABLE 0x01000000
+#define DCIC_DATA_ENABLE 0x02000000
+#define DCIC_READ_ENABLE 0x04000000
+#define DCIC_WRITE_ENABLE 0x08000000
+#define DCIC_WRITABLE 0xff80f03f
+
+#define CYCLES_CACHED_FETCH 1
+#define CYCLES_UNCACHED_FETCH 4
+#define CODE_PAGE_SIZE 0x1000
+
+#define CYCLES_MAX_FETCH (CYCLES_UNCACHED_FETCH + ICACHE_LINE_WORDS - 1)
+
+#define IDLE_LOOP_MAX_INSTRUCTIONS 8
+#define IDLE_LOOP_CACHE_SIZE 64
+
 class Bus;
 
+/**
+ * @brief Exception codes stored in bits [6:2] of the COP0 cause register.
+ * 
+ */
+enum ExceptionCode
+{
+    EXCEPTION_INTERRUPT = 0x00,
+    EXCEPTION_SYSCALL = 0x08,
+    EXCEPTION_BREAK = 0x09,
+    EXCEPTION_OVERFLOW = 0x0c
+};
+
 /**
  * @brief Structure to access different parts of an instruction by value
  * 
@@ -136,6 +181,88 @@ struct RegisterLoad
     RegisterLoad(uint32_t reg, uint32_t data, uint32_t delay): reg(reg), data(data), delay(delay) {}
 };
 
+/**
+ * @brief Structure to store a line of the instruction cache.
+ * 
+ */
+struct ICacheLine
+{
+    /**
+     * @brief Bits [30:12] of the address cached in the line
+     * 
+     */
+    uint32_t tag;
+
+    /**
+     * @brief Valid bit of each word of the line
+     * 
+     */
+    uint32_t valid;
+
+    /**
+     * @brief Cached instructions
+     * 
+     */
+    uint32_t data[ICACHE_LINE_WORDS];
+};
+
+/**
+ * @brief Pairs of instructions executed together in one dispatch.
+ * 
+ */
+enum FusedIdiom
+{
+    FUSION_LUI_ORI,
+    FUSION_LUI_ADDIU,
+    FUSION_LUI_LOAD,
+    FUSION_LUI_STORE,
+    FUSION_COMPARE_BRANCH,
+    FUSION_COUNT
+};
+
+/**
+ * @brief Result of the analysis of a short backward loop.
+ * 
+ */
+enum IdleLoopResult
+{
+    IDLE_LOOP_NONE,
+    IDLE_LOOP_UNSAFE,
+    IDLE_LOOP_IDLE
+};
+
+/**
+ * @brief Structure to store the result of the analysis of a backward branch.
+ * 
+ */
+struct IdleLoopEntry
+{
+    /**
+     * @brief Address of the branch closing the loop
+     * 
+     */
+    uint32_t branch_addr;
+
+    /**
+     * @brief Address of the first instruction of the loop
+     * 
+     */
+    uint32_t target;
+
+    /**
+     * @brief Branch instruction, used to notice code replaced at the same address
+     * 
+     */
+    uint32_t ins;
+
+    /**
+     * @brief Whether the body of the loop can be idle
+     * 
+     * Cleared when the body writes memory or carries state from one iteration to the next, so that busy loops are only analysed once.
+     */
+    bool candidate;
+};
+
 /**
  * @brief Structure to store and transfer the state of the CPU for debugging purposes.
  * 
@@ -154,6 +281,7 @@ struct CPUState
     uint32_t reg_cop0_bdam;
     uint32_t reg_cop0_bpcm;
     uint32_t reg_cop0_cause;
+    uint32_t reg_cop0_epc;
 
     Instruction ins_current;
     Instruction ins_next;
@@ -165,11 +293,22 @@ struct CPUState
  * @brief Class to emulate the CPU.
  * 
  * Implements the CPU of the PSX (The MIPS R3000A CPU).
+ * 
+ * Fetches from KUSEG and KSEG0 go through the 4KB instruction cache when it is enabled in the cache control register. Memory is read through a host pointer to the current code page rather than through the Bus. While the cache is isolated (bit 16 of the status register) the store instructions are swapped in the lookup table for variants that write to the cache instead of the Bus.
+ * 
+ * Common compiler idioms (LUI followed by ORI, ADDIU, a load or a store using the upper half it built, and a compare followed by a branch on its result) are executed as one fused dispatch when the Bus allows two instructions before its next event (see execute_fused).
+ * 
+ * When idle loop detection is enabled, taken backward branches closing a short loop are checked for polling loops (see check_idle_loop). The Bus then skips to its next scheduled event instead of running the loop.
+ * 
+ * The memory interface is a template parameter, so the calls of the instruction handlers to it can be inlined. Besides the CPU accessors (read32_cpu to write8_cpu), it provides side_effect_free and code_page. The emulator uses CPU, the instantiation on Bus; the tests use a mock that records the accesses. The definitions are in core/cpu/impl and are instantiated explicitly in core/cpu/cpu.cpp.
+ * 
+ * @tparam BusT Memory interface
  */
-class CPU
+template<typename BusT>
+class CPUCore
 {
 public:
-    CPU();
+    CPUCore();
 
     /**
      * @brief Connects Bus to the CPU.
@@ -177,13 +316,116 @@ public:
      * Used by the constructor of Bus to connect the CPU to the Bus.
      * @param bus Pointer to the bus structure
      */
-    void connectBus(Bus* bus) { this->bus = bus; }
+    void connectBus(BusT* bus) { this->bus = bus; }
 
     void clock();
+    void set_irq(bool active);
+
+    /**
+     * @brief Returns the value of the cache control register.
+     * 
+     * @return uint32_t Cache control register
+     */
+    uint32_t get_cache_control() { return cache_control; }
+
+    /**
+     * @brief Sets the value of the cache control register.
+     * 
+     * Used by the Bus when software writes to 0xfffe0130.
+     * @param value New value of the register
+     */
+    void set_cache_control(uint32_t value) { cache_control = value; }
+
+    /**
+     * @brief Returns the cost of the last instruction fetch.
+     * 
+     * Used by the cycle model of the Bus, where cached fetches are cheaper than uncached ones.
+     * @return uint32_t Number of cycles
+     */
+    uint32_t get_fetch_cycles() { return fetch_cycles; }
+
+    /**
+     * @brief Enables or disables the idle loop detection.
+     * 
+     * @param enabled Whether polling loops should be detected
+     */
+    void set_idle_skip(bool enabled) { idle_skip = enabled; }
+
+    /**
+     * @brief Sets the coverage map the executed instructions are marked in.
+     * 
+     * Only used when built with WOLPSX_COVERAGE.
+     * @param coverage Map to mark, nullptr to stop marking
+     */
+    void set_coverage(CodeCoverage* coverage) { this->coverage = coverage; }
+
+    /**
+     * @brief Returns whether the last instruction closed an iteration of an idle loop.
+     * 
+     * Used by the Bus to skip to the next scheduled event, since nothing the loop reads can change before then.
+     * @return true The CPU is spinning in an idle loop
+     * @return false The CPU is doing work
+     */
+    bool in_idle_loop() { return idle_loop; }
+
+    /**
+     * @brief Allows or forbids the next clock to execute a fused pair of instructions.
+     * 
+     * Set by the Bus before every clock: a pair may only run when no event can become due after its first instruction.
+     * @param allowed Whether a fused pair may be executed
+     */
+    void set_fusion_window(bool allowed) { fusion_window = allowed; }
+
+    /**
+     * @brief Returns the number of instructions executed by the last clock.
+     * 
+     * @return uint32_t 2 after a fused pair, 1 otherwise
+     */
+    uint32_t get_executed() { return executed; }
+
+    /**
+     * @brief Returns how many times an idiom has been fused since reset.
+     * 
+     * @param idiom Idiom to query
+     * @return uint64_t Number of fused pairs
+     */
+    uint64_t get_fusion_count(FusedIdiom idiom) { return fusion_counts[idiom]; }
+
+    /**
+     * @brief Returns the address of the next instruction to execute (the one already fetched).
+     * 
+     * @return uint32_t Address of the instruction
+     */
+    uint32_t get_next_ins_addr() { return ir_next_addr; }
+
+    /**
+     * @brief Returns the address of the instruction being executed.
+     * 
+     * @return uint32_t Address of the instruction
+     */
+    uint32_t get_ins_addr() { return ir_addr; }
+
+    void flush_code_page();
+    void invalidate_code(uint32_t addr, uint32_t size);
+    void invalidate_fetched(uint32_t phys);
+    void jump_to(uint32_t addr);
 
 private:
     void load_next_ins();
     void decode_and_execute();
+    void mark_coverage();
+
+    uint32_t fetch(uint32_t addr);
+    uint32_t read_code(uint32_t addr);
+    const uint8_t* code_page_lookup(uint32_t addr);
+    void cache_store(uint32_t addr, uint32_t data);
+    void update_store_lookup();
+
+    bool execute_fused();
+
+    void check_idle_loop(uint32_t target);
+    IdleLoopResult analyse_loop(uint32_t target, uint32_t length);
+    bool side_effect_free(uint32_t addr);
 
     uint32_t read32(uint32_t addr);
     void write32(uint32_t addr, uint32_t data);
@@ -197,7 +439,7 @@ private:
      * @brief Pointer to the Bus object
      * 
      */
-    Bus* bus;
+    BusT* bus;
 
     /**
      * @brief Queue to store the loads to the general purpose registers.
@@ -212,6 +454,19 @@ private:
      */
     uint32_t pc = 0;
 
+    /**
+     * @brief Address of the instruction in the instruction register.
+     * 
+     */
+    uint32_t ir_addr;
+
+    /**
+     * @brief Address of the instruction in ir_next.
+     * 
+     * Differs from ir_addr + 4 only when the current instruction is in the delay slot of a taken branch.
+     */
+    uint32_t ir_next_addr;
+
     /**
      * @brief Instruction register
      * 
@@ -272,9 +527,9 @@ private:
     uint32_t cop0_bda;
 
     /**
-     * @brief COP0 breakpoint exception register (hardware)
+     * @brief COP0 breakpoint control register (DCIC)
      * 
-     * TODO: Figure out what exactly this does.
+     * Bits [31:30] and 23 are the master enables, 24 enables the execution breakpoint, 25 the data breakpoint for reads (26) and writes (27). Bits [4:0] are set by the hardware on a hit. Jump breakpoints (bits 28-29 and 12-13) are not emulated.
      */
     uint32_t cop0_dcic;
 
@@ -298,70 +553,177 @@ private:
      */
     uint32_t cop0_cause;
 
+    /**
+     * @brief COP0 exception program counter
+     * 
+     * Address to return to after an exception has been handled.
+     */
+    uint32_t cop0_epc;
+
+    /**
+     * @brief Whether an interrupt should be taken before the next instruction.
+     * 
+     * Cached value of the interrupt condition of the cause and status registers. Only recomputed when one of them changes.
+     */
+    bool irq_active;
+
+    /**
+     * @brief Whether the hardware breakpoints are armed by DCIC.
+     * 
+     */
+    bool debug_armed;
+
+    /**
+     * @brief Whether a data breakpoint was hit by the last instruction, the exception is taken before the next one.
+     * 
+     */
+    bool break_pending;
+
+    /**
+     * @brief Whether the next instruction must go through execute_checked (interrupt, armed breakpoints or pending break).
+     * 
+     * The only condition checked by clock, so that software without interrupts pending or breakpoints armed pays for a single branch.
+     */
+    bool attention;
+
+    /**
+     * @brief Instruction cache
+     * 
+     */
+    ICacheLine icache[ICACHE_LINES];
+
+    /**
+     * @brief Cache control register (0xfffe0130)
+     * 
+     */
+    uint32_t cache_control;
+
+    /**
+     * @brief Number of cycles taken by the last instruction fetch.
+     * 
+     */
+    uint32_t fetch_cycles;
+
+    /**
+     * @brief Coverage map marked with every executed instruction, nullptr if none
+     * 
+     */
+    CodeCoverage* coverage;
+
+    /**
+     * @brief Address of the code page of the last uncached fetch
+     * 
+     */
+    uint32_t code_start;
+
+    /**
+     * @brief Size of the code page, 0 if it is not backed by host memory
+     * 
+     */
+    uint32_t code_size;
+
+    /**
+     * @brief Host memory backing the code page
+     * 
+     */
+    const uint8_t* code_host;
+
+    /**
+     * @brief Whether idle loop detection is enabled
+     * 
+     */
+    bool idle_skip;
+
+    /**
+     * @brief Whether the last instruction closed an iteration of an idle loop
+     * 
+     */
+    bool idle_loop;
+
+    /**
+     * @brief Results of the analysis of recent backward branches, indexed by the address of the branch
+     * 
+     */
+    IdleLoopEntry idle_loops[IDLE_LOOP_CACHE_SIZE];
+
+    /**
+     * @brief Whether the current clock may execute a fused pair
+     * 
+     */
+    bool fusion_window;
+
+    /**
+     * @brief Number of instructions executed by the last clock
+     * 
+     */
+    uint32_t executed;
+
+    /**
+     * @brief Number of fused pairs executed for each idiom
+     * 
+     */
+    uint64_t fusion_counts[FUSION_COUNT];
+
 private:
     void branch(uint32_t offset);
+    void exception(ExceptionCode code, bool debug = false);
+    void update_irq_active();
+    void update_debug_armed();
+    void execute_checked();
+    bool data_break(uint32_t addr, bool write);
     void set_reg(uint8_t reg, uint32_t data);
     uint32_t get_reg(uint8_t reg);
     void load_regs();
     void conf_ins_lookup();
-    void conf_mnemonic_lookup();
 
 public:
     void show_regs();
     void reset();
     CPUState* get_state(CPUState* cpu_state);
     void set_state(CPUState* cpu_state);
+    void publish_state(StateMonitor* monitor);
     void clock_nofetch();
 
 private:
     /**
-     * @brief Lookup table for instructions
+     * @brief Lookup table for instructions, indexed by opcode. Unmapped entries hold RESERVED.
      * 
      */
-    std::map<uint8_t, void (CPU::*)()> lookup_op;
+    void (CPUCore::*lookup_op[LOOKUP_SIZE])();
 
     /**
      * @brief Lookup table for special instructions (opcode = 0b000000)
      * 
      */
-    std::map<uint8_t, void (CPU::*)()> lookup_special;
+    void (CPUCore::*lookup_special[LOOKUP_SIZE])();
 
     /**
      * @brief Lookup table for cop0 instructions (opcode = 0b010000)
      * 
      */
-    std::map<uint8_t, void (CPU::*)()> lookup_cop0;
+    void (CPUCore::*lookup_cop0[LOOKUP_SIZE])();
 
     /**
      * @brief Lookup table for cop1 instructions (opcode = 0b010001)
      * 
      */
-    std::map<uint8_t, void (CPU::*)()> lookup_cop2;
-
-    /**
-     * @brief Lookup table for the mnemonics of instructions.
-     * 
-     */
-    std::map<uint8_t, std::string> lookup_mnemonic_op;
-
-    /**
-     * @brief Lookup table for the mnemonics of special instructions.
-     * 
-     */
-    std::map<uint8_t, std::string> lookup_mnemonic_special;
+    void (CPUCore::*lookup_cop2[LOOKUP_SIZE])();
 
     void LUI();
     void ORI();
     void SW();
+    void SW_ISOLATED();
     void ADDIU();
     void J();
     void BNE();
     void ADDI();
     void LW();
     void SH();
+    void SH_ISOLATED();
     void JAL();
     void ANDI();
     void SB();
+    void SB_ISOLATED();
     void LB();
     void BEQ();
     void BGTZ();
@@ -397,12 +759,21 @@ private:
     void COP0();
     void MTC0();
     void MFC0();
+    void RFE();
 
     void COP1();
 
     void COP2();
 
     void COP3();
+
+    void RESERVED();
 };
 
-#endif
\ No newline at end of file
+/**
+ * @brief The CPU of the emulator, on the Bus.
+ * 
+ */
+using CPU = CPUCore<Bus>;
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef CPU_IMPL_HPP
+#define CPU_IMPL_HPP
+
+//Definitions of the members of CPUCore, for the translation units that instantiate it on a memory interface:
+//core/cpu/cpu.cpp for the Bus and the CPU tests for their mock.
+
+#include <core/cpu/cpu.hpp>
+
+#include <core/cpu/impl/cpu.hpp>
+#include <core/cpu/impl/cpu_conf.hpp>
+#include <core/cpu/impl/cpu_utils.hpp>
+#include <core/cpu/impl/cpu_rw.hpp>
+#include <core/cpu/impl/cpu_cache.hpp>
+#include <core/cpu/impl/cpu_idle.hpp>
+#include <core/cpu/impl/cpu_fusion.hpp>
+#include <core/cpu/impl/ins.hpp>
+#include <core/cpu/impl/ins_special.hpp>
+#include <core/cpu/impl/ins_cop0.hpp>
+#include <core/cpu/impl/ins_cop2.hpp>
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef DISASSEMBLER_HPP
+#define DISASSEMBLER_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define DISASM_BUFFER_SIZE 64
+
+/**
+ * @brief Operand layout of an instruction, selects how the fields are formatted.
+ * 
+ */
+enum DisasmFormat
+{
+    DISASM_INVALID = 0,
+    DISASM_NONE,
+    DISASM_RD_RS_RT,
+    DISASM_RD_RT_SA,
+    DISASM_RD_RT_RS,
+    DISASM_RS,
+    DISASM_RD,
+    DISASM_RD_RS,
+    DISASM_RS_RT,
+    DISASM_RT_RS_IMM,
+    DISASM_RT_RS_UIMM,
+    DISASM_RT_UIMM,
+    DISASM_RS_RT_BRANCH,
+    DISASM_RS_BRANCH,
+    DISASM_BRANCH,
+    DISASM_JUMP,
+    DISASM_RT_MEM,
+    DISASM_COP_MEM,
+    DISASM_CODE,
+    DISASM_RT_COP0,
+    DISASM_RT_COP,
+    DISASM_COP_COMMAND,
+    DISASM_GTE,
+    DISASM_GTE_MVMVA,
+    DISASM_SPECIAL,
+    DISASM_REGIMM,
+    DISASM_COP
+};
+
+/**
+ * @brief Entry of an instruction format table.
+ * 
+ * The mnemonic is padded to 8 characters so that it is copied with a single fixed-size move. A length of 0 marks an invalid encoding.
+ * 
+ */
+struct DisasmEntry
+{
+    char mnemonic[8];
+    uint8_t length;
+    DisasmFormat format;
+};
+
+size_t disassemble(uint32_t ins, uint32_t addr, char* buffer, size_t size);
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef CPU_IMPL_CPU_HPP
+#define CPU_IMPL_CPU_HPP
+
+#include <iostream>
+#include <sstream>
+
+#include <core/cpu/cpu.hpp>
+
+/**
+ * @brief Construct a new CPU object
+ * 
+ * Sets the initial values of the registers and the initializes the opcode lookup tables.
+ * 
+ * \b References:
+ * @ref reset
+ * @ref conf_ins_lookup
+ */
+template<typename BusT>
+CPUCore<BusT>::CPUCore()
+{
+    idle_skip = false;
+    fusion_window = false;
+    coverage = nullptr;
+    reset();
+    conf_ins_lookup();
+}
+
+/**
+ * @brief Clocks the CPU once.
+ * 
+ * Executes the load_next_ins and decode_and_execute functions. Implements the load delay by copying the output registers to the input registers after the instruction is executed.
+ * If an interrupt is active, or the hardware breakpoints are armed, the instruction goes through execute_checked. Otherwise, if the Bus allows it, the instruction is executed together with the next one when they form a fused idiom.
+ * 
+ * \b References:
+ * @ref load_next_ins
+ * @ref execute_checked
+ * @ref execute_fused
+ * @ref decode_and_execute
+ * @ref load_regs
+ */
+template<typename BusT>
+void CPUCore<BusT>::clock()
+{
+    idle_loop = false;
+    executed = 1;
+    load_next_ins();
+
+    if(attention)
+        execute_checked();
+    else if(!fusion_window || !execute_fused())
+        decode_and_execute();
+
+    load_regs();
+}
+
+/**
+ * @brief Looks up and executes the appropriate coprocessor 1 instruction. (UNUSED)
+ * 
+ */
+template<typename BusT>
+void CPUCore<BusT>::COP1()
+{
+    //Not used in PSX
+}
+
+/**
+ * @brief Looks up and executes the appropriate coprocessor 3 instruction. (UNUSED)
+ * 
+ */
+template<typename BusT>
+void CPUCore<BusT>::COP3()
+{
+    //Not used in PSX
+}
+
+/**
+ * @brief Handles an instruction that is not mapped in the lookup tables.
+ * 
+ * TODO: Raise the reserved instruction exception once every instruction is implemented.
+ * 
+ * @throw std::runtime_error Always
+ */
+template<typename BusT>
+void CPUCore<BusT>::RESERVED()
+{
+    std::stringstream ss;
+    ss << "Unhandled instruction: " << std::hex << ir;
+    throw std::runtime_error(ss.str());
+}
+
+#endif
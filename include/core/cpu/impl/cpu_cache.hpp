@@ -0,0 +1,155 @@
+#ifndef CPU_IMPL_CPU_CACHE_HPP
+#define CPU_IMPL_CPU_CACHE_HPP
+
+#include <core/cpu/cpu.hpp>
+
+/**
+ * @brief Fetches the instruction at the given address.
+ * 
+ * Fetches from KUSEG and KSEG0 are served from the instruction cache when it is enabled. A miss fills the line from the missing word to the end of the line, like the hardware. KSEG1 and KSEG2 are never cached.
+ * Also records the cost of the fetch for the cycle model of the Bus.
+ * 
+ * @param addr Address of the instruction
+ * @return uint32_t Instruction
+ * 
+ * \b References:
+ * @ref read_code
+ * @ref icache
+ * @ref cache_control
+ */
+template<typename BusT>
+uint32_t CPUCore<BusT>::fetch(uint32_t addr)
+{
+    if(!(cache_control & CACHE_CTRL_ICACHE_ENABLE) || addr >= 0xa0000000)
+    {
+        fetch_cycles = CYCLES_UNCACHED_FETCH;
+        return read_code(addr);
+    }
+
+    ICacheLine& line = icache[(addr >> 4) % ICACHE_LINES];
+    uint32_t word = (addr >> 2) % ICACHE_LINE_WORDS;
+    uint32_t tag = addr & 0x7ffff000;
+    if(line.tag == tag && (line.valid >> word) & 1)
+    {
+        fetch_cycles = CYCLES_CACHED_FETCH;
+        return line.data[word];
+    }
+
+    if(line.tag != tag)
+    {
+        line.tag = tag;
+        line.valid = 0;
+    }
+    for(uint32_t i = word; i < ICACHE_LINE_WORDS; i++)
+    {
+        line.data[i] = read_code((addr & ~0xf) | (i << 2));
+        line.valid |= 1 << i;
+    }
+    fetch_cycles = CYCLES_UNCACHED_FETCH + ICACHE_LINE_WORDS - 1 - word;
+    return line.data[word];
+}
+
+/**
+ * @brief Reads an instruction word from memory.
+ * 
+ * Keeps a host pointer to the page of the last fetch, so sequential code is read directly from RAM or BIOS without going through the Bus. The page is looked up again only when the address leaves it, for example on a jump. Pages the Bus does not back with host memory, and unaligned addresses, are read through the Bus.
+ * 
+ * @param addr Address of the instruction
+ * @return uint32_t Instruction
+ * 
+ * \b References:
+ * @ref code_page_lookup
+ * @ref read32
+ */
+template<typename BusT>
+uint32_t CPUCore<BusT>::read_code(uint32_t addr)
+{
+    if(addr - code_start >= code_size)
+    {
+        code_start = addr & ~(CODE_PAGE_SIZE - 1);
+        code_host = code_page_lookup(addr);
+        code_size = code_host ? CODE_PAGE_SIZE : 0;
+    }
+    if(code_size && !(addr & 3))
+        return *(const uint32_t*)(code_host + (addr - code_start));
+    return read32(addr);
+}
+
+/**
+ * @brief Forgets the cached code page.
+ * 
+ * Called by the Bus whenever its page table changes.
+ */
+template<typename BusT>
+void CPUCore<BusT>::flush_code_page()
+{
+    code_start = 0;
+    code_size = 0;
+    code_host = nullptr;
+}
+
+/**
+ * @brief Drops the copies of a word of code the CPU already fetched, after a debugger wrote it.
+ * 
+ * Invalidates the word in the instruction cache, and fetches the next instruction again if it is the word written. Guest stores do not need this, the hardware does not snoop them either.
+ * 
+ * @param phys Physical address of the word
+ * 
+ * \b References:
+ * @ref icache
+ * @ref fetch
+ */
+template<typename BusT>
+void CPUCore<BusT>::invalidate_fetched(uint32_t phys)
+{
+    ICacheLine& line = icache[(phys >> 4) % ICACHE_LINES];
+    if(line.tag == (phys & 0x1ffff000))
+        line.valid &= ~(1 << ((phys >> 2) % ICACHE_LINE_WORDS));
+    if(((ir_next_addr & 0x1fffffff) >> 2) == (phys >> 2))
+        ir_next = fetch(ir_next_addr);
+}
+
+/**
+ * @brief Handles a store while the cache is isolated.
+ * 
+ * In tag test mode (bit 2 of the cache control register) the store invalidates the line it maps to, which is how the BIOS flushes the cache. Otherwise it writes the cached word.
+ * 
+ * @param addr Address of the store
+ * @param data Data stored
+ * 
+ * \b References:
+ * @ref icache
+ * @ref cache_control
+ */
+template<typename BusT>
+void CPUCore<BusT>::cache_store(uint32_t addr, uint32_t data)
+{
+    ICacheLine& line = icache[(addr >> 4) % ICACHE_LINES];
+    if(cache_control & CACHE_CTRL_TAG_TEST)
+    {
+        line.tag = addr & 0x7ffff000;
+        line.valid = 0;
+        return;
+    }
+    line.data[(addr >> 2) % ICACHE_LINE_WORDS] = data;
+}
+
+/**
+ * @brief Selects the store instructions matching the cache isolation bit of the status register.
+ * 
+ * Called only when the bit changes, so the store instructions never check it.
+ * 
+ * \b References:
+ * @ref cop0_status
+ * @ref lookup_op
+ */
+template<typename BusT>
+void CPUCore<BusT>::update_store_lookup()
+{
+    bool isolated = cop0_status & COP0_STATUS_ISOLATE_CACHE;
+    lookup_op[0b101011] = isolated ? &CPUCore::SW_ISOLATED : &CPUCore::SW;
+    lookup_op[0b101001] = isolated ? &CPUCore::SH_ISOLATED : &CPUCore::SH;
+    lookup_op[0b101000] = isolated ? &CPUCore::SB_ISOLATED : &CPUCore::SB;
+}
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef CPU_IMPL_CPU_CONF_HPP
+#define CPU_IMPL_CPU_CONF_HPP
+
+#include <core/cpu/cpu.hpp>
+
+/**
+ * @brief Resets the CPU to its initial state.
+ * 
+ * Sets all the general purpose registers (except the zero register) to 0xdeadbeef, the HI and LO registers to 0xdeadbeef, the PC to 0xbfc00000, and the coprocessor 0 registers to 0x00000000.
+ * 
+ */
+template<typename BusT>
+void CPUCore<BusT>::reset()
+{
+    regs[0] = 0;
+    for(int i = 1; i < 32; i++)
+        regs[i] = 0xdeadbeef;
+    hi = 0xdeadbeef;
+    lo = 0xdeadbeef;
+
+    pc = 0xbfc00000;
+
+    cop0_bda = 0x00000000;
+    cop0_bpcm = 0x00000000;
+    cop0_bpc = 0x00000000;
+    cop0_dcic = 0x00000000;
+    cop0_bdam = 0x00000000;
+    cop0_status = 0x00000000;
+    cop0_cause = 0x00000000;
+    cop0_epc = 0x00000000;
+    irq_active = false;
+    debug_armed = false;
+    break_pending = false;
+    attention = false;
+
+    for(ICacheLine& line : icache)
+    {
+        line.tag = 0;
+        line.valid = 0;
+    }
+    cache_control = 0;
+    fetch_cycles = CYCLES_UNCACHED_FETCH;
+    flush_code_page();
+
+    idle_loop = false;
+    executed = 1;
+    for(uint64_t& count : fusion_counts)
+        count = 0;
+    for(IdleLoopEntry& entry : idle_loops)
+    {
+        entry.branch_addr = 0xffffffff;
+        entry.candidate = false;
+    }
+
+    ins = Instruction(0x00000000);
+    ir = 0x00000000;
+    ir_next = 0x00000000;
+    ir_addr = pc;
+    ir_next_addr = pc;
+
+    update_store_lookup();
+}
+
+/**
+ * @brief Configures the instruction lookup table.
+ * 
+ * The tables are fixed arrays inside the CPU, so they live in the arena of the machine and dispatch is one indexed load. Unmapped entries hold RESERVED.
+ */
+template<typename BusT>
+void CPUCore<BusT>::conf_ins_lookup()
+{
+    for(int i = 0; i < LOOKUP_SIZE; i++)
+    {
+        lookup_op[i] = &CPUCore::RESERVED;
+        lookup_special[i] = &CPUCore::RESERVED;
+        lookup_cop0[i] = &CPUCore::RESERVED;
+        lookup_cop2[i] = &CPUCore::RESERVED;
+    }
+
+    lookup_op[0b000000] = &CPUCore::SPECIAL;
+    lookup_op[0b010000] = &CPUCore::COP0;
+    lookup_op[0b010001] = &CPUCore::COP1;
+    lookup_op[0b010010] = &CPUCore::COP2;
+    lookup_op[0b010011] = &CPUCore::COP3;
+
+    lookup_op[0b001111] = &CPUCore::LUI;
+    lookup_op[0b001101] = &CPUCore::ORI;
+    lookup_op[0b101011] = &CPUCore::SW;
+    lookup_op[0b001001] = &CPUCore::ADDIU;
+    lookup_op[0b000010] = &CPUCore::J;
+    lookup_op[0b000101] = &CPUCore::BNE;
+    lookup_op[0b001000] = &CPUCore::ADDI;
+    lookup_op[0b100011] = &CPUCore::LW;
+    lookup_op[0b101001] = &CPUCore::SH;
+    lookup_op[0b000011] = &CPUCore::JAL;
+    lookup_op[0b001100] = &CPUCore::ANDI;
+    lookup_op[0b101000] = &CPUCore::SB;
+    lookup_op[0b100000] = &CPUCore::LB;
+    lookup_op[0b000100] = &CPUCore::BEQ;
+    lookup_op[0b000111] = &CPUCore::BGTZ;
+    lookup_op[0b000110] = &CPUCore::BLEZ;
+    lookup_op[0b100100] = &CPUCore::LBU;
+    lookup_op[0b000001] = &CPUCore::BLGE;
+    lookup_op[0b001010] = &CPUCore::SLTI;
+    lookup_op[0b001011] = &CPUCore::SLTIU;
+
+    lookup_special[0b000000] = &CPUCore::SLL;
+    lookup_special[0b100101] = &CPUCore::OR;
+    lookup_special[0b101011] = &CPUCore::SLTU;
+    lookup_special[0b100001] = &CPUCore::ADDU;
+    lookup_special[0b001000] = &CPUCore::JR;
+    lookup_special[0b100100] = &CPUCore::AND;
+    lookup_special[0b100000] = &CPUCore::ADD;
+    lookup_special[0b001001] = &CPUCore::JALR;
+    lookup_special[0b000011] = &CPUCore::SRA;
+    lookup_special[0b100011] = &CPUCore::SUBU;
+    lookup_special[0b011010] = &CPUCore::DIV;
+    lookup_special[0b010010] = &CPUCore::MFLO;
+    lookup_special[0b000010] = &CPUCore::SRL;
+    lookup_special[0b011011] = &CPUCore::DIVU;
+    lookup_special[0b010000] = &CPUCore::MFHI;
+    lookup_special[0b101010] = &CPUCore::SLT;
+
+    lookup_cop0[0b00100] = &CPUCore::MTC0;
+    lookup_cop0[0b00000] = &CPUCore::MFC0;
+    lookup_cop0[0b10000] = &CPUCore::RFE;
+}
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef CPU_IMPL_CPU_FUSION_HPP
+#define CPU_IMPL_CPU_FUSION_HPP
+
+#include <core/cpu/cpu.hpp>
+
+/**
+ * @brief Executes the instruction register and the next instruction in one dispatch if they form a fused idiom.
+ * 
+ * The recognised idioms are:
+ * - LUI followed by ORI or ADDIU on the register it wrote (32-bit constant);
+ * - LUI followed by LW, LB, LBU, SW, SH or SB based on the register it wrote (absolute address);
+ * - SLT, SLTU, SLTI or SLTIU followed by BEQ or BNE on the register it wrote.
+ * 
+ * Both instructions are called directly instead of through the lookup tables. The pipeline steps between them (load_regs and load_next_ins) are the same as for two separate clocks, so the load delay and branch delay slots behave exactly as without fusion. None of the first instructions can raise an exception or change the interrupt state, and stores are not fused while the cache is isolated, since they then go through the store variants of the lookup table.
+ * 
+ * @return true The pair was executed
+ * @return false The instruction register does not start an idiom, nothing was executed
+ * 
+ * \b References:
+ * @ref load_regs
+ * @ref load_next_ins
+ * @ref mark_coverage
+ * @ref fusion_counts
+ */
+template<typename BusT>
+bool CPUCore<BusT>::execute_fused()
+{
+    Instruction next(ir_next);
+    void (CPUCore::*first)();
+    void (CPUCore::*second)();
+    FusedIdiom idiom;
+
+    switch(ins.opcode())
+    {
+        case 0b001111:
+            if(next.rs() != ins.rt())
+                return false;
+            first = &CPUCore::LUI;
+            idiom = FUSION_LUI_LOAD;
+            switch(next.opcode())
+            {
+                case 0b001101: second = &CPUCore::ORI; idiom = FUSION_LUI_ORI; break;
+                case 0b001001: second = &CPUCore::ADDIU; idiom = FUSION_LUI_ADDIU; break;
+                case 0b100011: second = &CPUCore::LW; break;
+                case 0b100000: second = &CPUCore::LB; break;
+                case 0b100100: second = &CPUCore::LBU; break;
+                case 0b101011: second = &CPUCore::SW; idiom = FUSION_LUI_STORE; break;
+                case 0b101001: second = &CPUCore::SH; idiom = FUSION_LUI_STORE; break;
+                case 0b101000: second = &CPUCore::SB; idiom = FUSION_LUI_STORE; break;
+                default: return false;
+            }
+            if(idiom == FUSION_LUI_STORE && (cop0_status & COP0_STATUS_ISOLATE_CACHE))
+                return false;
+            break;
+        case 0b000000:
+        case 0b001010:
+        case 0b001011:
+        {
+            uint32_t dest;
+            switch(ins.opcode())
+            {
+                case 0b001010: first = &CPUCore::SLTI; dest = ins.rt(); break;
+                case 0b001011: first = &CPUCore::SLTIU; dest = ins.rt(); break;
+                default:
+                    if(ins.funct() == 0b101010) first = &CPUCore::SLT;
+                    else if(ins.funct() == 0b101011) first = &CPUCore::SLTU;
+                    else return false;
+                    dest = ins.rd();
+                    break;
+            }
+            if(next.opcode() == 0b000100) second = &CPUCore::BEQ;
+            else if(next.opcode() == 0b000101) second = &CPUCore::BNE;
+            else return false;
+            if(dest == 0 || (next.rs() != dest && next.rt() != dest))
+                return false;
+            idiom = FUSION_COMPARE_BRANCH;
+            break;
+        }
+        default:
+            return false;
+    }
+
+    mark_coverage();
+    (this->*first)();
+    load_regs();
+
+    uint32_t first_fetch_cycles = fetch_cycles;
+    load_next_ins();
+    fetch_cycles += first_fetch_cycles;
+
+    mark_coverage();
+    (this->*second)();
+    executed = 2;
+    fusion_counts[idiom]++;
+    return true;
+}
+
+#endif
@@ -0,0 +1,259 @@
+#ifndef CPU_IMPL_CPU_IDLE_HPP
+#define CPU_IMPL_CPU_IDLE_HPP
+
+#include <core/cpu/cpu.hpp>
+
+/**
+ * @brief Checks whether the taken backward branch in the instruction register closes an idle loop.
+ * 
+ * Loops of at most IDLE_LOOP_MAX_INSTRUCTIONS instructions (delay slot included) are analysed. The result is cached per branch, so a busy loop is only analysed the first time it is taken, while a candidate loop is checked again on every iteration because the addresses it reads depend on the registers. The code of a busy loop is marked on the Bus, so that the verdict is dropped when the loop is overwritten.
+ * 
+ * @param target Address of the first instruction of the loop
+ * 
+ * \b References:
+ * @ref analyse_loop
+ * @ref idle_loops
+ * @ref Bus::mark_code
+ */
+template<typename BusT>
+void CPUCore<BusT>::check_idle_loop(uint32_t target)
+{
+    uint32_t length = ((ir_addr - target) >> 2) + 2;
+    if(length > IDLE_LOOP_MAX_INSTRUCTIONS)
+        return;
+
+    IdleLoopEntry& entry = idle_loops[(ir_addr >> 2) % IDLE_LOOP_CACHE_SIZE];
+    if(entry.branch_addr != ir_addr || entry.ins != ir)
+    {
+        entry.branch_addr = ir_addr;
+        entry.target = target;
+        entry.ins = ir;
+        entry.candidate = true;
+    }
+    if(!entry.candidate)
+        return;
+
+    IdleLoopResult result = analyse_loop(target, length);
+    if(result == IDLE_LOOP_NONE)
+    {
+        entry.candidate = false;
+        bus->mark_code(target, length << 2);
+    }
+    idle_loop = result == IDLE_LOOP_IDLE;
+}
+
+/**
+ * @brief Drops the cached verdicts of the busy loops overwritten by a write to RAM.
+ * 
+ * Called back by the RAM when a page marked by check_idle_loop is written. The page has been unmarked, so it is marked again for the busy loops it still holds. Candidate loops are analysed on every iteration and need nothing.
+ * 
+ * @param addr Physical address of the write
+ * @param size Size of the write in bytes
+ * 
+ * \b References:
+ * @ref idle_loops
+ * @ref Bus::mark_code
+ */
+template<typename BusT>
+void CPUCore<BusT>::invalidate_code(uint32_t addr, uint32_t size)
+{
+    uint32_t page = addr & ~(CODE_PAGE_SIZE - 1);
+    for(IdleLoopEntry& entry : idle_loops)
+    {
+        if(entry.branch_addr == 0xffffffff || entry.candidate)
+            continue;
+        uint32_t start = entry.target & 0x1fffffff;
+        uint32_t end = (entry.branch_addr & 0x1fffffff) + 8;
+        if(addr < end && addr + size > start)
+            entry.branch_addr = 0xffffffff;
+        else if(page < end && page + CODE_PAGE_SIZE > start)
+            bus->mark_code(entry.target, end - start);
+    }
+}
+
+/**
+ * @brief Decides whether running the loop again can change anything before the next event.
+ * 
+ * The loop is idle when it has no side effects and every iteration computes the same values from the same memory:
+ * - only loads, ALU instructions without overflow traps and branches are allowed, so nothing is stored;
+ * - a register written by the loop must be written before it is read in the same iteration, so no state is carried between iterations;
+ * - the address of every load must be known (from registers the loop does not write, or constants built in the loop) and reading it must have no side effect.
+ * 
+ * The value loaded by an instruction is not visible to the next one (load delay), which would read the value of the previous iteration, so such a read rejects the loop too.
+ * 
+ * @param target Address of the first instruction of the loop
+ * @param length Number of instructions in the loop, including the delay slot of the branch
+ * @return IdleLoopResult IDLE_LOOP_NONE if the loop can never be idle, IDLE_LOOP_UNSAFE if it reads from an address with side effects this time, IDLE_LOOP_IDLE otherwise
+ * 
+ * \b References:
+ * @ref read32
+ * @ref get_reg
+ * @ref side_effect_free
+ */
+template<typename BusT>
+IdleLoopResult CPUCore<BusT>::analyse_loop(uint32_t target, uint32_t length)
+{
+    Instruction body[IDLE_LOOP_MAX_INSTRUCTIONS];
+    uint32_t written = 0;
+    for(uint32_t i = 0; i < length; i++)
+    {
+        body[i] = Instruction(read32(target + (i << 2)));
+        Instruction& ins = body[i];
+        switch(ins.opcode())
+        {
+            case 0b000000:
+                switch(ins.funct())
+                {
+                    case 0x00: case 0x02: case 0x03: case 0x04: case 0x06: case 0x07:
+                    case 0x21: case 0x23: case 0x24: case 0x25: case 0x26: case 0x27:
+                    case 0x2a: case 0x2b:
+                        written |= 1u << ins.rd();
+                        break;
+                    default:
+                        return IDLE_LOOP_NONE;
+                }
+                break;
+            case 0b001001: case 0b001010: case 0b001011: case 0b001100: case 0b001101:
+            case 0b001110: case 0b001111:
+            case 0b100000: case 0b100001: case 0b100011: case 0b100100: case 0b100101:
+                written |= 1u << ins.rt();
+                break;
+            case 0b000001: case 0b000100: case 0b000101: case 0b000110: case 0b000111:
+                //BLTZAL and BGEZAL write the return address
+                if(i == length - 1 || (ins.opcode() == 0b000001 && (ins.ins & 0x00100000)))
+                    return IDLE_LOOP_NONE;
+                break;
+            case 0b000010:
+                if(i != length - 2)
+                    return IDLE_LOOP_NONE;
+                break;
+            default:
+                return IDLE_LOOP_NONE;
+        }
+    }
+    if(body[length - 2].ins != ir)
+        return IDLE_LOOP_NONE;
+    written &= ~1;
+
+    uint32_t defined = 0;
+    uint32_t known = 0;
+    uint32_t values[32] = {0};
+    uint32_t pending = 0;
+    IdleLoopResult result = IDLE_LOOP_IDLE;
+
+    //value of a register during the iteration, if it is known
+    auto value = [&](uint32_t reg, uint32_t& out) {
+        if(reg == 0 || !(written & (1u << reg)))
+        {
+            out = get_reg(reg);
+            return true;
+        }
+        out = values[reg];
+        return ((known >> reg) & 1) != 0;
+    };
+
+    for(uint32_t i = 0; i < length; i++)
+    {
+        Instruction& ins = body[i];
+        uint32_t op = ins.opcode();
+        bool special = op == 0b000000;
+        bool shift_imm = special && ins.funct() <= 0x03;
+        bool single = (op >= 0b001001 && op <= 0b001110) || op >= 0b100000 || op == 0b000001 || op == 0b000110 || op == 0b000111;
+
+        uint32_t sources = 0;
+        if(op == 0b000010 || op == 0b001111)
+            sources = 0;
+        else if(shift_imm)
+            sources = 1u << ins.rt();
+        else if(single)
+            sources = 1u << ins.rs();
+        else
+            sources = (1u << ins.rs()) | (1u << ins.rt());
+        sources &= ~1;
+
+        if(sources & pending)
+            return IDLE_LOOP_NONE;
+        if(sources & written & ~defined)
+            return IDLE_LOOP_NONE;
+        defined |= pending;
+        pending = 0;
+
+        uint32_t rs, rt;
+        bool rs_known = value(ins.rs(), rs);
+        bool rt_known = value(ins.rt(), rt);
+        uint32_t imm_se = int32_t(int16_t(ins.imm()));
+
+        if(op >= 0b100000)
+        {
+            if(!rs_known)
+                return IDLE_LOOP_NONE;
+            if(!side_effect_free(rs + imm_se))
+                result = IDLE_LOOP_UNSAFE;
+            if(ins.rt() != 0)
+            {
+                pending = 1u << ins.rt();
+                known &= ~pending;
+            }
+            continue;
+        }
+
+        uint32_t dest;
+        uint32_t data = 0;
+        bool data_known;
+        if(special)
+        {
+            dest = ins.rd();
+            data_known = (shift_imm || rs_known) && rt_known;
+            switch(ins.funct())
+            {
+                case 0x00: data = rt << ins.shamt(); break;
+                case 0x02: data = rt >> ins.shamt(); break;
+                case 0x03: data = int32_t(rt) >> ins.shamt(); break;
+                case 0x04: data = rt << (rs & 0x1f); break;
+                case 0x06: data = rt >> (rs & 0x1f); break;
+                case 0x07: data = int32_t(rt) >> (rs & 0x1f); break;
+                case 0x21: data = rs + rt; break;
+                case 0x23: data = rs - rt; break;
+                case 0x24: data = rs & rt; break;
+                case 0x25: data = rs | rt; break;
+                case 0x26: data = rs ^ rt; break;
+                case 0x27: data = ~(rs | rt); break;
+                case 0x2a: data = int32_t(rs) < int32_t(rt); break;
+                case 0x2b: data = rs < rt; break;
+            }
+        }
+        else if(op >= 0b001001 && op <= 0b001111)
+        {
+            dest = ins.rt();
+            data_known = rs_known || op == 0b001111;
+            switch(op)
+            {
+                case 0b001001: data = rs + imm_se; break;
+                case 0b001010: data = int32_t(rs) < int32_t(imm_se); break;
+                case 0b001011: data = rs < imm_se; break;
+                case 0b001100: data = rs & ins.imm(); break;
+                case 0b001101: data = rs | ins.imm(); break;
+                case 0b001110: data = rs ^ ins.imm(); break;
+                case 0b001111: data = ins.imm() << 16; break;
+            }
+        }
+        else
+        {
+            //branches and jumps do not write registers
+            continue;
+        }
+
+        if(dest == 0)
+            continue;
+        defined |= 1u << dest;
+        values[dest] = data;
+        if(data_known)
+            known |= 1u << dest;
+        else
+            known &= ~(1u << dest);
+    }
+
+    return result;
+}
+
+#endif
@@ -1,5 +1,7 @@
+#ifndef CPU_IMPL_CPU_RW_HPP
+#define CPU_IMPL_CPU_RW_HPP
+
 #include <core/cpu/cpu.hpp>
-#include <core/interconnect/bus.hpp>
 
 /**
  * @brief Read a 32 bit word from the bus.
@@ -10,7 +12,8 @@
  * \b References:
  * @ref Bus::read32_cpu
  */
-uint32_t CPU::read32(uint32_t addr)
+template<typename BusT>
+uint32_t CPUCore<BusT>::read32(uint32_t addr)
 {
     return bus->read32_cpu(addr);
 }
@@ -24,7 +27,8 @@ uint32_t CPU::read32(uint32_t addr)
  * \b References:
  * @ref Bus::write32_cpu
  */
-void CPU::write32(uint32_t addr, uint32_t data)
+template<typename BusT>
+void CPUCore<BusT>::write32(uint32_t addr, uint32_t data)
 {
     bus->write32_cpu(addr, data);
 }
@@ -38,7 +42,8 @@ void CPU::write32(uint32_t addr, uint32_t data)
  * \b References:
  * @ref Bus::read16_cpu
  */
-uint16_t CPU::read16(uint32_t addr)
+template<typename BusT>
+uint16_t CPUCore<BusT>::read16(uint32_t addr)
 {
     return bus->read16_cpu(addr);
 }
@@ -52,7 +57,8 @@ uint16_t CPU::read16(uint32_t addr)
  * \b References
  * @ref Bus::write16_cpu
  */
-void CPU::write16(uint32_t addr, uint16_t data)
+template<typename BusT>
+void CPUCore<BusT>::write16(uint32_t addr, uint16_t data)
 {
     return bus->write16_cpu(addr, data);
 }
@@ -66,7 +72,8 @@ void CPU::write16(uint32_t addr, uint16_t data)
  * \b References
  * @ref Bus::read8_cpu
  */
-uint8_t CPU::read8(uint32_t addr)
+template<typename BusT>
+uint8_t CPUCore<BusT>::read8(uint32_t addr)
 {
     return bus->read8_cpu(addr);
 }
@@ -80,7 +87,40 @@ uint8_t CPU::read8(uint32_t addr)
  * \b References
  * @ref Bus::write8_cpu
  */
-void CPU::write8(uint32_t addr, uint8_t data)
+template<typename BusT>
+void CPUCore<BusT>::write8(uint32_t addr, uint8_t data)
 {
     return bus->write8_cpu(addr, data);
-}
\ No newline at end of file
+}
+/**
+ * @brief Checks whether reading the given address has no side effect.
+ * 
+ * @param addr Address to check
+ * @return true Reading the address only returns data
+ * @return false Reading the address changes the state of a device
+ * 
+ * \b References:
+ * @ref Bus::side_effect_free
+ */
+template<typename BusT>
+bool CPUCore<BusT>::side_effect_free(uint32_t addr)
+{
+    return bus->side_effect_free(addr);
+}
+
+/**
+ * @brief Looks up the host memory backing a code page.
+ * 
+ * @param addr Address in the page
+ * @return const uint8_t* Host pointer to the start of the page, nullptr if the page is not backed by host memory
+ * 
+ * \b References:
+ * @ref Bus::code_page
+ */
+template<typename BusT>
+const uint8_t* CPUCore<BusT>::code_page_lookup(uint32_t addr)
+{
+    return bus->code_page(addr);
+}
+
+#endif
@@ -0,0 +1,453 @@
+#ifndef CPU_IMPL_CPU_UTILS_HPP
+#define CPU_IMPL_CPU_UTILS_HPP
+
+#include <iostream>
+#include <sstream>
+#include <core/cpu/cpu.hpp>
+#include <core/logging/logging.hpp>
+#include <queue>
+
+/**
+ * @brief Load the next instruction into the instruction register
+ * 
+ * Fetches the instruction at the address given by the program counter and increments the program counter by 4.
+ * 
+ * \b References:
+ * @ref fetch
+ */
+template<typename BusT>
+void CPUCore<BusT>::load_next_ins()
+{
+    ir = ir_next;
+    ir_addr = ir_next_addr;
+    ir_next = fetch(pc);
+    ir_next_addr = pc;
+    ins = Instruction(ir);
+    pc += 4;
+}
+
+/**
+ * @brief Decodes and executes the instruction in the instruction register.
+ * 
+ * Uses the opcode to lookup the instruction in the opcode lookup table and executes the appropriate function.
+ * 
+ * @throw std::runtime_error if the instruction is not mapped in the opcode lookup table.
+ * 
+ * \b References:
+ * @ref mark_coverage
+ * @ref RESERVED
+ */
+template<typename BusT>
+void CPUCore<BusT>::decode_and_execute()
+{
+    mark_coverage();
+    (this->*lookup_op[ins.opcode()])();
+}
+
+/**
+ * @brief Marks the instruction in the instruction register in the coverage map, when one is attached.
+ * 
+ * Called as the instruction is executed rather than fetched, so that instructions fetched but discarded by an exception are not marked. Does nothing unless built with WOLPSX_COVERAGE.
+ * 
+ * \b References:
+ * @ref CodeCoverage::mark
+ */
+template<typename BusT>
+void CPUCore<BusT>::mark_coverage()
+{
+#ifdef WOLPSX_COVERAGE
+    if(coverage)
+        coverage->mark(ir_addr);
+#endif
+}
+
+/**
+ * @brief Branches to the given offset.
+ * 
+ * The offset is multiplied by 4 before branching. Backward branches are checked for idle loops.
+ * @param offset Offset to branch to
+ * 
+ * \b References:
+ * @ref check_idle_loop
+ */
+template<typename BusT>
+void CPUCore<BusT>::branch(uint32_t offset)
+{
+    pc -= 4; //undo pc increment to point to next instruction
+    uint32_t multiplied = offset << 2;
+    if((multiplied & 0x80000000) != (offset & 0x80000000))
+    {
+        LOG_ERROR(LOG_CPU, "Branch offset 0x{:x} overflowed at 0x{:x}", offset, ir_addr);
+    }
+    pc += multiplied;
+
+    if(idle_skip && pc <= ir_addr)
+        check_idle_loop(pc);
+}
+
+/**
+ * @brief Enters the exception handler.
+ * 
+ * Saves the address of the instruction in the instruction register to EPC (or the address of the branch if it is in a delay slot), stores the exception code in the cause register, pushes the interrupt enable/mode stack in the status register and jumps to the handler selected by the BEV bit.
+ * The instruction in the instruction register is not executed.
+ * 
+ * Hardware breakpoints (debug) use their own handler, 0x80000040 or 0xbfc00140.
+ * 
+ * @param code Exception code
+ * @param debug Whether the exception comes from a hardware breakpoint
+ * 
+ * \b References:
+ * @ref cop0_epc
+ * @ref cop0_cause
+ * @ref cop0_status
+ * @ref update_irq_active
+ * @ref fetch
+ */
+template<typename BusT>
+void CPUCore<BusT>::exception(ExceptionCode code, bool debug)
+{
+    cop0_epc = ir_addr;
+    cop0_cause = (cop0_cause & ~0x8000007c) | (code << 2);
+    //the instruction is in the delay slot of a taken branch
+    if(ir_next_addr != ir_addr + 4)
+    {
+        cop0_epc -= 4;
+        cop0_cause |= 0x80000000;
+    }
+
+    //push the KU/IE stack
+    uint32_t mode = cop0_status & 0x3f;
+    cop0_status = (cop0_status & ~0x3f) | ((mode << 2) & 0x3f);
+
+    //BEV selects the handler in the BIOS
+    if(debug)
+        pc = (cop0_status & 0x00400000) ? 0xbfc00140 : 0x80000040;
+    else
+        pc = (cop0_status & 0x00400000) ? 0xbfc00180 : 0x80000080;
+
+    //refill the pipeline from the handler
+    ir_next = fetch(pc);
+    ir_next_addr = pc;
+    pc += 4;
+
+    update_irq_active();
+}
+
+/**
+ * @brief Recomputes whether an interrupt should be taken.
+ * 
+ * An interrupt is taken when IEc is set and any pending interrupt in the cause register is enabled in the status register.
+ * 
+ * \b References:
+ * @ref cop0_status
+ * @ref cop0_cause
+ */
+template<typename BusT>
+void CPUCore<BusT>::update_irq_active()
+{
+    irq_active = (cop0_status & 0x1) && (cop0_status & cop0_cause & 0x700);
+    attention = irq_active || debug_armed || break_pending;
+}
+
+/**
+ * @brief Recomputes whether the hardware breakpoints are armed.
+ * 
+ * Called when DCIC changes. While they are armed, every instruction goes through execute_checked instead of the fast dispatch.
+ * 
+ * \b References:
+ * @ref cop0_dcic
+ * @ref update_irq_active
+ */
+template<typename BusT>
+void CPUCore<BusT>::update_debug_armed()
+{
+    bool master = (cop0_dcic & DCIC_MASTER) == DCIC_MASTER;
+    bool data = (cop0_dcic & DCIC_DATA_ENABLE) && (cop0_dcic & (DCIC_READ_ENABLE | DCIC_WRITE_ENABLE));
+    debug_armed = master && ((cop0_dcic & DCIC_CODE_ENABLE) || data);
+    update_irq_active();
+}
+
+/**
+ * @brief Executes the instruction in the instruction register on the checking path.
+ * 
+ * Takes, in order, a break left pending by a data breakpoint, an interrupt, or an execution breakpoint on the instruction. Otherwise checks the address of a load or store against the data breakpoint and executes the instruction. A data breakpoint hit lets the access complete and takes the exception before the next instruction, so that returning from the handler does not repeat the access.
+ * 
+ * \b References:
+ * @ref exception
+ * @ref data_break
+ * @ref decode_and_execute
+ */
+template<typename BusT>
+void CPUCore<BusT>::execute_checked()
+{
+    if(break_pending)
+    {
+        break_pending = false;
+        update_irq_active();
+        exception(EXCEPTION_BREAK, true);
+        return;
+    }
+    if(irq_active)
+    {
+        exception(EXCEPTION_INTERRUPT);
+        return;
+    }
+    if(!debug_armed)
+    {
+        decode_and_execute();
+        return;
+    }
+
+    if((cop0_dcic & DCIC_CODE_ENABLE) && ((ir_addr ^ cop0_bpc) & cop0_bpcm) == 0)
+    {
+        cop0_dcic |= DCIC_HIT_ANY | DCIC_HIT_CODE;
+        exception(EXCEPTION_BREAK, true);
+        return;
+    }
+
+    uint8_t opcode = ins.opcode();
+    //loads, stores, LWC2 and SWC2
+    if((opcode >= 0b100000 && opcode <= 0b101110) || opcode == 0b110010 || opcode == 0b111010)
+    {
+        uint32_t addr = get_reg(ins.rs()) + uint32_t(int32_t(int16_t(ins.imm())));
+        if(data_break(addr, opcode & 0b001000))
+        {
+            break_pending = true;
+            update_irq_active();
+        }
+    }
+    decode_and_execute();
+}
+
+/**
+ * @brief Checks an access against the data breakpoint and records a hit in DCIC.
+ * 
+ * @param addr Address of the access
+ * @param write Whether the access is a store
+ * @return true The breakpoint was hit
+ * @return false The access does not match
+ */
+template<typename BusT>
+bool CPUCore<BusT>::data_break(uint32_t addr, bool write)
+{
+    uint32_t enable = write ? DCIC_WRITE_ENABLE : DCIC_READ_ENABLE;
+    if(!(cop0_dcic & DCIC_DATA_ENABLE) || !(cop0_dcic & enable) || ((addr ^ cop0_bda) & cop0_bdam) != 0)
+        return false;
+    cop0_dcic |= DCIC_HIT_ANY | DCIC_HIT_DATA | (write ? DCIC_HIT_WRITE : DCIC_HIT_READ);
+    return true;
+}
+
+/**
+ * @brief Sets the hardware interrupt line of the CPU.
+ * 
+ * Used by the Bus to forward the output of the interrupt controller to bit 10 of the cause register.
+ * 
+ * @param active Whether the interrupt controller has an unmasked interrupt pending
+ * 
+ * \b References:
+ * @ref update_irq_active
+ */
+template<typename BusT>
+void CPUCore<BusT>::set_irq(bool active)
+{
+    if(active)
+        cop0_cause |= 0x400;
+    else
+        cop0_cause &= ~0x400;
+    update_irq_active();
+}
+
+/**
+ * @brief Sets the value of the given register from the general purpose registers.
+ * 
+ * @param reg Register to set
+ * @param data Value to set the register to
+ */
+template<typename BusT>
+void CPUCore<BusT>::set_reg(uint8_t reg, uint32_t data)
+{
+    // gpreg_out[reg] = data;
+    // gpreg_out[0] = 0; // $zero register
+    load_queue.push(RegisterLoad(reg, data));
+}
+
+/**
+ * @brief Gets the value of the given register from the general purpose registers.
+ * 
+ * @param reg Register to get the value of
+ * @return uint32_t Value of the register
+ */
+template<typename BusT>
+uint32_t CPUCore<BusT>::get_reg(uint8_t reg)
+{
+    // return gpreg_in[reg];
+    return regs[reg];
+}
+
+/**
+ * @brief Loads the registers from the load queue.
+ * 
+ * Decrements the delay of each load in the load queue. If the delay is 0, the data is written to the register.
+ */
+template<typename BusT>
+void CPUCore<BusT>::load_regs()
+{
+    uint8_t num_loads = load_queue.size();
+    for(int i = 0; i < num_loads; i++)
+    {
+        RegisterLoad load = load_queue.front();
+        load_queue.pop();
+        load.delay--;
+        if(load.delay == 0xffffffff)
+            regs[load.reg] = load.data;
+        else
+            load_queue.push(load);
+    }
+    regs[0] = 0; // $zero register
+}
+
+/**
+ * @brief Shows the values of the registers.
+ * 
+ * Used for debugging.
+ */
+template<typename BusT>
+void CPUCore<BusT>::show_regs()
+{
+    std::cout << "Registers:\n";
+    for(int i = 0; i < 32; i++)
+    {
+        std::cout << "R" << i << ": " << std::hex << regs[i] << "\t";
+        if(i % 4 == 3)
+            std::cout << "\n";
+    }
+    std::cout << "HI: " << std::hex << hi << "\tLO: " << std::hex << lo << "\n";
+
+}
+
+/**
+ * @brief Returns the state of the CPU as a CPUState object.
+ * 
+ * Ownership of the returned object is transferred to the caller.
+ * 
+ * @return CPUState* 
+ */
+template<typename BusT>
+CPUState* CPUCore<BusT>::get_state(CPUState* cpu_state)
+{
+    for(int i = 0; i < 32; i++)
+    {
+        cpu_state->reg_gen[i] = regs[i];
+    }
+    cpu_state->reg_hi = hi;
+    cpu_state->reg_lo = lo;
+
+    cpu_state->program_counter = pc;
+    
+    cpu_state->reg_cop0_status = cop0_status;
+    cpu_state->reg_cop0_bda = cop0_bda;
+    cpu_state->reg_cop0_bpc = cop0_bpc;
+    cpu_state->reg_cop0_dcic = cop0_dcic;
+    cpu_state->reg_cop0_bdam = cop0_bdam;
+    cpu_state->reg_cop0_bpcm = cop0_bpcm;
+    cpu_state->reg_cop0_cause = cop0_cause;
+    cpu_state->reg_cop0_epc = cop0_epc;
+
+    cpu_state->ins_current = ins;
+    cpu_state->ins_next = Instruction(ir_next);
+
+    cpu_state->load_queue = load_queue;
+
+    return cpu_state;
+}
+
+/**
+ * @brief Stores the registers of the CPU in a publication of a state monitor.
+ * 
+ * Unlike get_state, nothing is copied besides the registers, so it is cheap enough for every frame.
+ * 
+ * @param monitor Monitor with a publication in progress
+ * 
+ * \b References:
+ * @ref StateMonitor::publish_word
+ */
+template<typename BusT>
+void CPUCore<BusT>::publish_state(StateMonitor* monitor)
+{
+    for(int i = 0; i < 32; i++)
+        monitor->publish_word(MONITOR_REG_GEN + i, regs[i]);
+    monitor->publish_word(MONITOR_REG_HI, hi);
+    monitor->publish_word(MONITOR_REG_LO, lo);
+    monitor->publish_word(MONITOR_PC, pc);
+    monitor->publish_word(MONITOR_COP0_STATUS, cop0_status);
+    monitor->publish_word(MONITOR_COP0_CAUSE, cop0_cause);
+    monitor->publish_word(MONITOR_COP0_EPC, cop0_epc);
+}
+
+/**
+ * @brief Sets the state of the CPU from a CPUState object.
+ * 
+ * @param cpu_state CPUState object to set the state from
+ */
+template<typename BusT>
+void CPUCore<BusT>::set_state(CPUState* cpu_state)
+{
+    for(int i = 0; i < 32; i++)
+    {
+        regs[i] = cpu_state->reg_gen[i];
+    }
+    hi = cpu_state->reg_hi;
+    lo = cpu_state->reg_lo;
+
+    pc = cpu_state->program_counter;
+
+    cop0_status = cpu_state->reg_cop0_status;
+    cop0_bda = cpu_state->reg_cop0_bda;
+    cop0_bpc = cpu_state->reg_cop0_bpc;
+    cop0_dcic = cpu_state->reg_cop0_dcic;
+    cop0_bdam = cpu_state->reg_cop0_bdam;
+    cop0_bpcm = cpu_state->reg_cop0_bpcm;
+    cop0_cause = cpu_state->reg_cop0_cause;
+    cop0_epc = cpu_state->reg_cop0_epc;
+    update_debug_armed();
+    update_store_lookup();
+
+    ins = cpu_state->ins_current;
+    ir = ins.ins;
+    ir_next = cpu_state->ins_next.ins;
+
+    load_queue = cpu_state->load_queue;
+}
+
+/**
+ * @brief Refills the pipeline from the given address.
+ * 
+ * Used by debuggers to change the program counter. A pending branch is dropped.
+ * 
+ * @param addr Address of the next instruction to execute
+ * 
+ * \b References:
+ * @ref fetch
+ */
+template<typename BusT>
+void CPUCore<BusT>::jump_to(uint32_t addr)
+{
+    pc = addr;
+    ir_next = fetch(pc);
+    ir_next_addr = pc;
+    pc += 4;
+}
+
+/**
+ * @brief Clocks the CPU without fetching the next instruction.
+ * 
+ * Used for debugging and testing purposes.
+ */
+template<typename BusT>
+void CPUCore<BusT>::clock_nofetch()
+{
+    decode_and_execute();
+    load_regs();
+}
+
+#endif
@@ -1,3 +1,6 @@
+#ifndef CPU_IMPL_INS_HPP
+#define CPU_IMPL_INS_HPP
+
 #include <core/cpu/cpu.hpp>
 #include <iostream>
 #include <sstream>
@@ -10,7 +13,8 @@
  * @ref Instruction::rt
  * @ref Instruction::imm
  */
-void CPU::LUI()
+template<typename BusT>
+void CPUCore<BusT>::LUI()
 {
     set_reg(ins.rt(), ins.imm() << 16);
 }
@@ -24,7 +28,8 @@ void CPU::LUI()
  * @ref Instruction::rs
  * @ref Instruction::imm
  */
-void CPU::ORI() //Bitwise OR Immediate
+template<typename BusT>
+void CPUCore<BusT>::ORI() //Bitwise OR Immediate
 {
     set_reg(ins.rt(), get_reg(ins.rs()) | ins.imm());
 }
@@ -32,7 +37,7 @@ void CPU::ORI() //Bitwise OR Immediate
 /**
  * @brief Store Word
  * 
- * TODO: Implement Cache
+ * Used while the cache is not isolated, see SW_ISOLATED.
  * 
  * \b References:
  * @ref set_reg
@@ -40,25 +45,41 @@ void CPU::ORI() //Bitwise OR Immediate
  * @ref write_32
  * @ref Instruction::rt
  * @ref Instruction::rs
- * @ref cop0_status
  */
-void CPU::SW()
+template<typename BusT>
+void CPUCore<BusT>::SW()
 {
-    //if cache is isolated
-    if(cop0_status & 0x00010000)
+    uint32_t offset = ins.imm();
+    //pad offset with bit at 16th position
+    if(offset & 0x8000)
     {
-        //TODO: Implement Cache
-        std::cout << "Ignoring SW as cache is isolated.\n";
-        return;
+        offset |= 0xffff0000;
     }
+    write32(get_reg(ins.rs()) + offset, get_reg(ins.rt()));
+}
 
+/**
+ * @brief Store Word while the cache is isolated
+ * 
+ * Swapped into the lookup table in place of SW while bit 16 of the status register is set. The store goes to the instruction cache and never reaches the Bus.
+ * 
+ * \b References:
+ * @ref Instruction::imm
+ * @ref Instruction::rs
+ * @ref Instruction::rt
+ * @ref get_reg
+ * @ref cache_store
+ */
+template<typename BusT>
+void CPUCore<BusT>::SW_ISOLATED()
+{
     uint32_t offset = ins.imm();
     //pad offset with bit at 16th position
     if(offset & 0x8000)
     {
         offset |= 0xffff0000;
     }
-    write32(get_reg(ins.rs()) + offset, get_reg(ins.rt()));
+    cache_store(get_reg(ins.rs()) + offset, get_reg(ins.rt()));
 }
 
 /**
@@ -72,7 +93,8 @@ void CPU::SW()
  * @ref Instruction::imm
  * 
  */
-void CPU::ADDIU()
+template<typename BusT>
+void CPUCore<BusT>::ADDIU()
 {
     uint32_t data_se = ins.imm();
     //pad offset with bit at 16th position
@@ -90,10 +112,15 @@ void CPU::ADDIU()
  * 
  * \b References:
  * @ref Instruction::addr
+ * @ref check_idle_loop
  */
-void CPU::J()
+template<typename BusT>
+void CPUCore<BusT>::J()
 {
     pc = ((pc - 4) & 0xf0000000) | (ins.addr() << 2);
+
+    if(idle_skip && pc <= ir_addr)
+        check_idle_loop(pc);
 }
 
 /**
@@ -106,7 +133,8 @@ void CPU::J()
  * @ref get_reg
  * @ref branch
  */
-void CPU::BNE()
+template<typename BusT>
+void CPUCore<BusT>::BNE()
 {
     uint32_t offset = ins.imm();
     //pad offset with bit at 16th position
@@ -134,7 +162,8 @@ void CPU::BNE()
  * @ref get_reg
  * @ref set_reg
  */
-void CPU::ADDI()
+template<typename BusT>
+void CPUCore<BusT>::ADDI()
 {
     uint32_t extended_imm = ins.imm();
     //pad offset with bit at 16th position
@@ -170,7 +199,8 @@ void CPU::ADDI()
  * @ref RegisterLoad
  * 
  */
-void CPU::LW()
+template<typename BusT>
+void CPUCore<BusT>::LW()
 {
     uint32_t offset = ins.imm();
     //pad offset with bit at 16th position
@@ -185,7 +215,7 @@ void CPU::LW()
 /**
  * @brief Store Halfword
  * 
- * TODO: Implement Cache
+ * Used while the cache is not isolated, see SH_ISOLATED.
  * 
  * \b References:
  * @ref Instruction::imm
@@ -193,26 +223,42 @@ void CPU::LW()
  * @ref Instruction::rt
  * @ref get_reg
  * @ref write16
- * @ref cop0_status
  * 
  */
-void CPU::SH()
+template<typename BusT>
+void CPUCore<BusT>::SH()
 {
-    //if cache is isolated
-    if(cop0_status & 0x00010000)
+    uint32_t offset = ins.imm();
+    //pad offset with bit at 16th position
+    if(offset & 0x8000)
     {
-        //TODO: Implement Cache
-        std::cout << "Ignoring SH as cache is isolated.\n";
-        return;
+        offset |= 0xffff0000;
     }
+    write16(get_reg(ins.rs()) + offset, get_reg(ins.rt()) & 0xffff);
+}
 
+/**
+ * @brief Store Halfword while the cache is isolated
+ * 
+ * Swapped into the lookup table in place of SH while bit 16 of the status register is set. The store goes to the instruction cache and never reaches the Bus.
+ * 
+ * \b References:
+ * @ref Instruction::imm
+ * @ref Instruction::rs
+ * @ref Instruction::rt
+ * @ref get_reg
+ * @ref cache_store
+ */
+template<typename BusT>
+void CPUCore<BusT>::SH_ISOLATED()
+{
     uint32_t offset = ins.imm();
     //pad offset with bit at 16th position
     if(offset & 0x8000)
     {
         offset |= 0xffff0000;
     }
-    write16(get_reg(ins.rs()) + offset, get_reg(ins.rt()) & 0xffff);
+    cache_store(get_reg(ins.rs()) + offset, get_reg(ins.rt()) & 0xffff);
 }
 
 /**
@@ -225,7 +271,8 @@ void CPU::SH()
  * @ref set_reg
  * 
  */
-void CPU::JAL()
+template<typename BusT>
+void CPUCore<BusT>::JAL()
 {
     // std::cout << "Jumped to: " << std::hex << ((pc & 0xf0000000) | (ins.addr() << 2)) << "\n"; //REMOVE
     // uint32_t ra = pc + 4;
@@ -245,7 +292,8 @@ void CPU::JAL()
  * @ref set_reg
  * 
  */
-void CPU::ANDI()
+template<typename BusT>
+void CPUCore<BusT>::ANDI()
 {
     uint32_t data = ins.imm() & get_reg(ins.rs());
     set_reg(ins.rt(), data);
@@ -254,7 +302,7 @@ void CPU::ANDI()
 /**
  * @brief Store Byte
  *
- * TODO: Implement Cache
+ * Used while the cache is not isolated, see SB_ISOLATED.
  * 
  * \b References:
  * @ref Instruction::imm
@@ -262,26 +310,42 @@ void CPU::ANDI()
  * @ref Instruction::rt
  * @ref get_reg
  * @ref write8
- * @ref cop0_status
  * 
  */
-void CPU::SB()
+template<typename BusT>
+void CPUCore<BusT>::SB()
 {
-    //if cache is isolated
-    if(cop0_status & 0x00010000)
+    uint32_t offset = ins.imm();
+    //pad offset with bit at 16th position
+    if(offset & 0x8000)
     {
-        //TODO: Implement Cache
-        std::cout << "Ignoring SB as cache is isolated.\n";
-        return;
+        offset |= 0xffff0000;
     }
+    write8(get_reg(ins.rs()) + offset, get_reg(ins.rt()) & 0xff);
+}
 
+/**
+ * @brief Store Byte while the cache is isolated
+ * 
+ * Swapped into the lookup table in place of SB while bit 16 of the status register is set. The store goes to the instruction cache and never reaches the Bus.
+ * 
+ * \b References:
+ * @ref Instruction::imm
+ * @ref Instruction::rs
+ * @ref Instruction::rt
+ * @ref get_reg
+ * @ref cache_store
+ */
+template<typename BusT>
+void CPUCore<BusT>::SB_ISOLATED()
+{
     uint32_t offset = ins.imm();
     //pad offset with bit at 16th position
     if(offset & 0x8000)
     {
         offset |= 0xffff0000;
     }
-    write8(get_reg(ins.rs()) + offset, get_reg(ins.rt()) & 0xff);
+    cache_store(get_reg(ins.rs()) + offset, get_reg(ins.rt()) & 0xff);
 }
 
 /**
@@ -298,7 +362,8 @@ void CPU::SB()
  * @ref RegisterLoad
  * 
  */
-void CPU::LB()
+template<typename BusT>
+void CPUCore<BusT>::LB()
 {
     uint32_t offset = ins.imm();
     //pad offset with bit at 16th position
@@ -326,7 +391,8 @@ void CPU::LB()
  * @ref branch
  * 
  */
-void CPU::BEQ()
+template<typename BusT>
+void CPUCore<BusT>::BEQ()
 {
     uint32_t offset = ins.imm();
     //pad offset with bit at 16th position
@@ -350,7 +416,8 @@ void CPU::BEQ()
  * @ref branch
  * 
  */
-void CPU::BGTZ()
+template<typename BusT>
+void CPUCore<BusT>::BGTZ()
 {
     uint32_t offset = ins.imm();
     //pad offset with bit at 16th position
@@ -374,7 +441,8 @@ void CPU::BGTZ()
  * @ref branch
  * 
  */
-void CPU::BLEZ()
+template<typename BusT>
+void CPUCore<BusT>::BLEZ()
 {
     uint32_t offset = ins.imm();
     //pad offset with bit at 16th position
@@ -402,7 +470,8 @@ void CPU::BLEZ()
  * @ref RegisterLoad
  * 
  */
-void CPU::LBU()
+template<typename BusT>
+void CPUCore<BusT>::LBU()
 {
     uint32_t offset = ins.imm();
     //pad offset with bit at 16th position
@@ -424,7 +493,8 @@ void CPU::LBU()
  * @ref BGEZ
  * 
  */
-void CPU::BLGE() //Choose between BLTZAL, BGEZAL, BLTZ, BGEZ
+template<typename BusT>
+void CPUCore<BusT>::BLGE() //Choose between BLTZAL, BGEZAL, BLTZ, BGEZ
 {
     //check if the 16th bit of the instruction is set
     if(ir & 0x00010000)
@@ -455,7 +525,8 @@ void CPU::BLGE() //Choose between BLTZAL, BGEZAL, BLTZ, BGEZ
  * @ref branch
  * 
  */
-void CPU::BLTZ()
+template<typename BusT>
+void CPUCore<BusT>::BLTZ()
 {
     uint32_t offset = ins.imm();
     //pad offset with bit at 16th position
@@ -478,7 +549,8 @@ void CPU::BLTZ()
  * @ref set_reg
  * 
  */
-void CPU::BLTZAL()
+template<typename BusT>
+void CPUCore<BusT>::BLTZAL()
 {
     uint32_t offset = ins.imm();
     //pad offset with bit at 16th position
@@ -505,7 +577,8 @@ void CPU::BLTZAL()
  * @ref branch
  * 
  */
-void CPU::BGEZ()
+template<typename BusT>
+void CPUCore<BusT>::BGEZ()
 {
     uint32_t offset = ins.imm();
     //pad offset with bit at 16th position
@@ -528,7 +601,8 @@ void CPU::BGEZ()
  * @ref set_reg
  * 
  */
-void CPU::BGEZAL()
+template<typename BusT>
+void CPUCore<BusT>::BGEZAL()
 {
     uint32_t offset = ins.imm();
     //pad offset with bit at 16th position
@@ -556,7 +630,8 @@ void CPU::BGEZAL()
  * @ref set_reg
  * 
  */
-void CPU::SLTI()
+template<typename BusT>
+void CPUCore<BusT>::SLTI()
 {
     uint32_t imm_se = ins.imm();
     //pad offset with bit at 16th position
@@ -578,7 +653,8 @@ void CPU::SLTI()
  * @ref set_reg
  * 
  */
-void CPU::SLTIU()
+template<typename BusT>
+void CPUCore<BusT>::SLTIU()
 {
     uint32_t arg = ins.imm();
     //pad argument with bit at 16th position
@@ -587,4 +663,6 @@ void CPU::SLTIU()
 
     uint32_t val = (get_reg(ins.rs()) < arg);
     set_reg(ins.rt(), val);
-}
\ No newline at end of file
+}
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef CPU_IMPL_INS_COP0_HPP
+#define CPU_IMPL_INS_COP0_HPP
+
+#include <core/cpu/cpu.hpp>
+#include <sstream>
+#include <iostream>
+
+/**
+ * @brief Looks up and executes the appropriate coprocessor 0 instruction.
+ * 
+ * @throw std::runtime_error if the instruction is not mapped in the lookup_cop0 table.
+ * 
+ * \b References:
+ * @ref RESERVED
+ */
+template<typename BusT>
+void CPUCore<BusT>::COP0()
+{
+    (this->*lookup_cop0[ins.rs()])();
+}
+
+/**
+ * @brief Move to Coprocessor 0
+ * 
+ * Writes to the breakpoint registers (BPC, BDA, DCIC, BDAM, BPCM) re-arm the hardware breakpoints. JUMPDEST (6) is read-only.
+ * 
+ * @throw std::runtime_error if an unhandled register is written to. (Not one of the following: status, cause, bda, bpcm, bpc, dcic, bdam, jumpdest).
+ * 
+ * \b References:
+ * @ref Instruction::rd
+ * @ref Instruction::rt
+ * @ref cop0_status
+ * @ref cop0_cause
+ * @ref get_reg
+ * @ref set_reg
+ * @ref update_irq_active
+ * @ref update_debug_armed
+ * @ref update_store_lookup
+ */
+template<typename BusT>
+void CPUCore<BusT>::MTC0()
+{
+    switch(ins.rd())
+    {
+        case 12:
+        {
+            uint32_t changed = cop0_status ^ get_reg(ins.rt());
+            cop0_status = get_reg(ins.rt());
+            update_irq_active();
+            if(changed & COP0_STATUS_ISOLATE_CACHE)
+                update_store_lookup();
+            break;
+        }
+        case 3:
+            cop0_bpc = get_reg(ins.rt());
+            break;
+        case 5:
+            cop0_bda = get_reg(ins.rt());
+            break;
+        case 6:
+            break;
+        case 7:
+            cop0_dcic = get_reg(ins.rt()) & DCIC_WRITABLE;
+            update_debug_armed();
+            break;
+        case 9:
+            cop0_bdam = get_reg(ins.rt());
+            break;
+        case 11:
+            cop0_bpcm = get_reg(ins.rt());
+            break;
+        case 13:
+            //only the software interrupt bits [9:8] are writable
+            cop0_cause = (cop0_cause & ~0x300) | (get_reg(ins.rt()) & 0x300);
+            update_irq_active();
+            break;
+        default:
+            //throw unhandled instruction error
+            std::stringstream ss;
+            ss << "Unhandled COP0 register (MTC0): " << ins.rd();
+            throw std::runtime_error(ss.str());
+    }
+}
+
+/**
+ * @brief Move From Coprocessor 0
+ * 
+ * @throw std::runtime_error if an unhandled register is read from. (Not one of the following: bpc, bda, dcic, bdam, bpcm, status, cause, epc).
+ * 
+ * \b References:
+ * @ref Instruction::rd
+ * @ref Instruction::rt
+ * @ref cop0_bpc
+ * @ref cop0_bda
+ * @ref cop0_dcic
+ * @ref cop0_bdam
+ * @ref cop0_bpcm
+ * @ref cop0_status
+ * @ref cop0_cause
+ * @ref cop0_epc
+ * @ref set_reg
+ * @ref RegisterLoad
+ * 
+ */
+template<typename BusT>
+void CPUCore<BusT>::MFC0()
+{
+    switch(ins.rd())
+    {
+        case 3: //BPC
+            load_queue.push(RegisterLoad(ins.rt(), cop0_bpc, 1));
+            break;
+        case 5: //BDA
+            load_queue.push(RegisterLoad(ins.rt(), cop0_bda, 1));
+            break;
+        case 7: //DCIC
+            load_queue.push(RegisterLoad(ins.rt(), cop0_dcic, 1));
+            break;
+        case 9: //BDAM
+            load_queue.push(RegisterLoad(ins.rt(), cop0_bdam, 1));
+            break;
+        case 11: //BPCM
+            load_queue.push(RegisterLoad(ins.rt(), cop0_bpcm, 1));
+            break;
+        case 12: //Status
+            load_queue.push(RegisterLoad(ins.rt(), cop0_status, 1));
+            break;
+        case 13: //Cause
+            load_queue.push(RegisterLoad(ins.rt(), cop0_cause, 1));
+            break;
+        case 14: //EPC
+            load_queue.push(RegisterLoad(ins.rt(), cop0_epc, 1));
+            break;
+        default:
+            //throw unhandled instruction error
+            std::stringstream ss;
+            ss << "Unhandled COP0 register (MFC0): " << ins.rd();
+            throw std::runtime_error(ss.str());
+    }
+}
+
+/**
+ * @brief Return From Exception
+ * 
+ * Pops the KU/IE stack of the status register.
+ * 
+ * \b References:
+ * @ref cop0_status
+ * @ref update_irq_active
+ */
+template<typename BusT>
+void CPUCore<BusT>::RFE()
+{
+    uint32_t mode = cop0_status & 0x3f;
+    cop0_status = (cop0_status & ~0xf) | (mode >> 2);
+    update_irq_active();
+}
+
+#endif
@@ -1,9 +1,15 @@
+#ifndef CPU_IMPL_INS_COP2_HPP
+#define CPU_IMPL_INS_COP2_HPP
+
 #include <core/cpu/cpu.hpp>
 
 /**
  * @brief Looks up and executes the appropriate coprocessor 2 (Graphics) instruction.
  * 
  */
-void CPU::COP2()
+template<typename BusT>
+void CPUCore<BusT>::COP2()
 {
-}   
\ No newline at end of file
+}
+
+#endif
@@ -1,23 +1,22 @@
+#ifndef CPU_IMPL_INS_SPECIAL_HPP
+#define CPU_IMPL_INS_SPECIAL_HPP
+
 #include <sstream>
 
-#include "core/cpu/cpu.hpp"
+#include <core/cpu/cpu.hpp>
 
 /**
  * @brief Looks up and executes the appropriate SPECIAL instruction.
  * 
  * @throw std::runtime_error if the instruction is not mapped in the lookup_special table.
+ * 
+ * \b References:
+ * @ref RESERVED
  */
-void CPU::SPECIAL()
+template<typename BusT>
+void CPUCore<BusT>::SPECIAL()
 {
-    if(lookup_special.find(ins.funct()) != lookup_special.end())
-    {
-        (this->*lookup_special[ins.funct()])();
-        return;
-    }
-    //throw unhandled instruction error
-    std::stringstream ss;
-    ss << "Unhandled instruction (SPECIAL): " << std::hex << ir;
-    throw std::runtime_error(ss.str());
+    (this->*lookup_special[ins.funct()])();
 }
 
 /**
@@ -29,7 +28,8 @@ void CPU::SPECIAL()
  * @ref Instruction::rt
  * @ref Instruction::shamt
  */
-void CPU::SLL()
+template<typename BusT>
+void CPUCore<BusT>::SLL()
 {
     set_reg(ins.rd(), get_reg(ins.rt()) << ins.shamt());
 }
@@ -44,7 +44,8 @@ void CPU::SLL()
  * @ref Instruction::rs
  * @ref Instruction::rt
  */
-void CPU::OR()
+template<typename BusT>
+void CPUCore<BusT>::OR()
 {
     set_reg(ins.rd(), get_reg(ins.rs()) | get_reg(ins.rt()));
 }
@@ -60,7 +61,8 @@ void CPU::OR()
  * @ref set_reg
  * 
  */
-void CPU::SLTU()
+template<typename BusT>
+void CPUCore<BusT>::SLTU()
 {
     set_reg(ins.rd(), get_reg(ins.rs()) < get_reg(ins.rt()));
 }
@@ -76,7 +78,8 @@ void CPU::SLTU()
  * @ref set_reg
  * 
  */
-void CPU::ADDU()
+template<typename BusT>
+void CPUCore<BusT>::ADDU()
 {
     set_reg(ins.rd(), get_reg(ins.rs()) + get_reg(ins.rt()));
 }
@@ -89,7 +92,8 @@ void CPU::ADDU()
  * @ref get_reg
  * 
  */
-void CPU::JR()
+template<typename BusT>
+void CPUCore<BusT>::JR()
 {
     // std::cout << "Jumped to: " << std::hex << get_reg(ins.rs()) << "\n"; //REMOVE
     pc = get_reg(ins.rs());
@@ -106,7 +110,8 @@ void CPU::JR()
  * @ref set_reg
  * 
  */
-void CPU::AND()
+template<typename BusT>
+void CPUCore<BusT>::AND()
 {
     set_reg(ins.rd(), get_reg(ins.rs()) & get_reg(ins.rt()));
 }
@@ -127,7 +132,8 @@ void CPU::AND()
  * @ref set_reg
  * 
  */
-void CPU::ADD()
+template<typename BusT>
+void CPUCore<BusT>::ADD()
 {
     uint32_t extended_op1 = get_reg(ins.rt());
     uint32_t extended_op2 = get_reg(ins.rs());
@@ -157,7 +163,8 @@ void CPU::ADD()
  * @ref set_reg
  * 
  */
-void CPU::JALR()
+template<typename BusT>
+void CPUCore<BusT>::JALR()
 {
     // uint32_t ra = pc + 4;
     uint32_t ra = pc;
@@ -175,7 +182,8 @@ void CPU::JALR()
  * @ref set_reg
  * 
  */
-void CPU::SRA()
+template<typename BusT>
+void CPUCore<BusT>::SRA()
 {
     uint32_t data = get_reg(ins.rt());
     uint32_t shamt = ins.shamt();
@@ -199,7 +207,8 @@ void CPU::SRA()
  * @ref set_reg
  * 
  */
-void CPU::SUBU()
+template<typename BusT>
+void CPUCore<BusT>::SUBU()
 {
     set_reg(ins.rd(), get_reg(ins.rs()) - get_reg(ins.rt()));
 }
@@ -217,7 +226,8 @@ void CPU::SUBU()
  * @ref hi
  * 
  */
-void CPU::DIV()
+template<typename BusT>
+void CPUCore<BusT>::DIV()
 {
     uint32_t op1 = get_reg(ins.rs());
     uint32_t op2 = get_reg(ins.rt());
@@ -259,7 +269,8 @@ void CPU::DIV()
  * @ref lo
  * 
  */
-void CPU::MFLO()
+template<typename BusT>
+void CPUCore<BusT>::MFLO()
 {
     set_reg(ins.rd(), lo);
 }
@@ -274,7 +285,8 @@ void CPU::MFLO()
  * @ref set_reg
  * 
  */
-void CPU::SRL()
+template<typename BusT>
+void CPUCore<BusT>::SRL()
 {
     uint32_t data = get_reg(ins.rt()) >> ins.shamt();
     set_reg(ins.rd(), data);
@@ -293,7 +305,8 @@ void CPU::SRL()
  * @ref hi
  * 
  */
-void CPU::DIVU()
+template<typename BusT>
+void CPUCore<BusT>::DIVU()
 {
     uint32_t op1 = get_reg(ins.rs());
     uint32_t op2 = get_reg(ins.rt());
@@ -323,7 +336,8 @@ void CPU::DIVU()
  * @ref hi
  * 
  */
-void CPU::MFHI()
+template<typename BusT>
+void CPUCore<BusT>::MFHI()
 {
     set_reg(ins.rd(), hi);
 }
@@ -339,9 +353,12 @@ void CPU::MFHI()
  * @ref set_reg
  * 
  */
-void CPU::SLT()
+template<typename BusT>
+void CPUCore<BusT>::SLT()
 {
     int32_t op1 = get_reg(ins.rs());
     int32_t op2 = get_reg(ins.rt());
     set_reg(ins.rd(), op1 < op2);
-}
\ No newline at end of file
+}
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef GDB_STUB_HPP
+#define GDB_STUB_HPP
+
+#include <stdint.h>
+#include <functional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <core/interconnect/bus.hpp>
+
+#define GDB_REGISTER_COUNT 72
+#define GDB_REG_STATUS 32
+#define GDB_REG_LO 33
+#define GDB_REG_HI 34
+#define GDB_REG_BADVADDR 35
+#define GDB_REG_CAUSE 36
+#define GDB_REG_PC 37
+#define GDB_POLL_INTERVAL 0x10000
+#define GDB_PACKET_SIZE 0x4000
+
+#define GDB_SIGINT 2
+#define GDB_SIGTRAP 5
+#define GDB_SIGSEGV 11
+
+/**
+ * @brief Class to implement the GDB remote serial protocol on top of a Bus.
+ * 
+ * Handles the payloads of the packets; framing and the transport (a socket in tools/gdbserver.cpp) are left to the caller. Supports register and memory reads and writes, single-step, continue, breakpoints (Z0/Z1) and watchpoints on RAM (Z2-Z4, see Bus::add_watchpoint).
+ * 
+ * The machine runs in the loop of resume, so plain emulation (Bus::clock called by the host) never checks breakpoints. The loop itself only checks a byte per page of the next instruction, and looks the breakpoint up only when the page holds one. Fusion is disabled on those pages, so that a breakpoint on the second instruction of a pair is not stepped over.
+ * 
+ * Registers are numbered as GDB expects them for the R3000: r0-r31, status, lo, hi, badvaddr, cause, pc, then the (absent) floating point registers.
+ */
+class GDBStub
+{
+public:
+    GDBStub(Bus* bus);
+
+    std::string handle_packet(const std::string& packet);
+    std::string interrupt();
+
+    /**
+     * @brief Sets the function polled while the machine runs to know whether the debugger asked to stop (Ctrl-C).
+     * 
+     * @param check Returns true to stop, called every GDB_POLL_INTERVAL instructions
+     */
+    void set_interrupt_check(std::function<bool()> check) { interrupt_check = check; }
+
+    /**
+     * @brief Returns whether the debugger sent a kill packet.
+     * 
+     * @return true The session is over
+     * @return false The session goes on
+     */
+    bool is_killed() { return killed; }
+
+    /**
+     * @brief Returns the error that stopped the machine with SIGSEGV.
+     * 
+     * @return std::string Message of the exception thrown by the emulator, empty if none
+     */
+    std::string get_last_error() { return error; }
+
+    static std::string frame(const std::string& payload);
+
+private:
+    std::string stop_reply(int signal);
+    std::string watch_reply(const WatchHit& hit);
+    std::string resume(bool step);
+    std::string read_registers();
+    std::string write_registers(const std::string& args);
+    std::string read_register(const std::string& args);
+    std::string write_register(const std::string& args);
+    std::string read_memory(const std::string& args);
+    std::string write_memory(const std::string& args);
+    std::string breakpoint(bool insert, const std::string& args);
+    std::string query(const std::string& packet);
+
+    uint32_t get_register(uint32_t index, CPUState& state);
+    void set_register(uint32_t index, uint32_t value, CPUState& state);
+
+    /**
+     * @brief Returns the index of the page holding the given address in breakpoint_pages.
+     * 
+     * @param addr Address
+     * @return uint32_t Index of the page, the same for the mirrors of an address in KUSEG, KSEG0 and KSEG1
+     */
+    static uint32_t page_index(uint32_t addr) { return (addr & 0x1fffffff) >> PAGE_SHIFT; }
+
+private:
+    /**
+     * @brief Pointer to the machine being debugged
+     * 
+     */
+    Bus* bus;
+
+    /**
+     * @brief Addresses of the breakpoints
+     * 
+     */
+    std::set<uint32_t> breakpoints;
+
+    /**
+     * @brief Number of breakpoints in every page
+     * 
+     */
+    std::vector<uint16_t> breakpoint_pages;
+
+    /**
+     * @brief Function polled while running to stop on request of the debugger
+     * 
+     */
+    std::function<bool()> interrupt_check;
+
+    /**
+     * @brief Signal of the last stop, reported by the ? packet
+     * 
+     */
+    int last_signal;
+
+    /**
+     * @brief Whether the debugger sent a kill packet
+     * 
+     */
+    bool killed;
+
+    /**
+     * @brief Message of the last exception thrown by the emulator
+     * 
+     */
+    std::string error;
+};
+
+#endif
@@ -0,0 +1,148 @@
+#ifndef DMA_HPP
+#define DMA_HPP
+
+#include <stdint.h>
+
+#define DMA_CHANNEL_COUNT 7
+
+#define DMA_REG_MADR 0x0
+#define DMA_REG_BCR 0x4
+#define DMA_REG_CHCR 0x8
+#define DMA_REG_DPCR 0x70
+#define DMA_REG_DICR 0x74
+
+#define DMA_CHCR_FROM_RAM 0x00000001
+#define DMA_CHCR_BACKWARD 0x00000002
+#define DMA_CHCR_SYNC_MASK 0x00000600
+#define DMA_CHCR_SYNC_SHIFT 9
+#define DMA_CHCR_START 0x01000000
+#define DMA_CHCR_TRIGGER 0x10000000
+
+#define DMA_DICR_FORCE 0x00008000
+#define DMA_DICR_ENABLE_SHIFT 16
+#define DMA_DICR_MASTER_ENABLE 0x00800000
+#define DMA_DICR_FLAG_SHIFT 24
+#define DMA_DICR_MASTER_FLAG 0x80000000
+
+#define DMA_DPCR_RESET 0x07654321
+
+class Bus;
+
+/**
+ * @brief DMA channels, numbered by their position in the register file.
+ * 
+ */
+enum DMAChannel
+{
+    DMA_MDEC_IN = 0,
+    DMA_MDEC_OUT = 1,
+    DMA_GPU = 2,
+    DMA_CDROM = 3,
+    DMA_SPU = 4,
+    DMA_PIO = 5,
+    DMA_OTC = 6
+};
+
+/**
+ * @brief Synchronization modes of a DMA channel.
+ * 
+ */
+enum DMASync
+{
+    DMA_SYNC_MANUAL = 0,
+    DMA_SYNC_BLOCK = 1,
+    DMA_SYNC_LINKED_LIST = 2
+};
+
+/**
+ * @brief Structure to store the registers of a DMA channel.
+ * 
+ */
+struct DMAChannelState
+{
+    /**
+     * @brief Base address register (MADR)
+     * 
+     */
+    uint32_t madr;
+
+    /**
+     * @brief Block control register (BCR)
+     * 
+     */
+    uint32_t bcr;
+
+    /**
+     * @brief Channel control register (CHCR)
+     * 
+     */
+    uint32_t chcr;
+};
+
+/**
+ * @brief Class to emulate the DMA controller.
+ * 
+ * Implements the registers of the seven channels, DPCR and DICR. A transfer runs as a single bulk copy as soon as the channel is started and the device can take or provide its data; otherwise the channel stays active until the device requests it again (see Bus::dma_request), so for example MDEC output is transferred once a macroblock has been decoded. Transfers take no emulated time.
+ * 
+ * TODO: Implement the GPU (linked list) and SPU channels, and transfer timing.
+ */
+class DMA
+{
+public:
+    DMA();
+
+    /**
+     * @brief Connects Bus to the DMA.
+     * 
+     * Used by the constructor of Bus to connect the DMA to the Bus.
+     * @param bus Pointer to the bus structure
+     */
+    void connectBus(Bus* bus) { this->bus = bus; }
+
+    uint32_t read32_cpu(uint32_t offset);
+    void write32_cpu(uint32_t offset, uint32_t data);
+
+    void request(DMAChannel channel);
+
+private:
+    bool active(DMAChannel channel);
+    void run(DMAChannel channel);
+    void transfer_to_device(DMAChannel channel, uint32_t words);
+    bool transfer_from_device(DMAChannel channel, uint32_t words);
+    void clear_ordering_table(uint32_t words);
+    void finish(DMAChannel channel);
+    void update_irq();
+
+private:
+    /**
+     * @brief Pointer to the Bus object
+     * 
+     */
+    Bus* bus;
+
+    /**
+     * @brief Registers of the channels
+     * 
+     */
+    DMAChannelState channels[DMA_CHANNEL_COUNT];
+
+    /**
+     * @brief Control register (DPCR)
+     * 
+     */
+    uint32_t dpcr;
+
+    /**
+     * @brief Interrupt register (DICR), master flag excluded
+     * 
+     */
+    uint32_t dicr;
+
+    /**
+     * @brief Whether the master interrupt flag is set
+     * 
+     */
+    bool irq_flag;
+};
+
+#endif
@@ -2,7 +2,17 @@
 #define BUS_HPP
 
 #include <stdint.h>
+#include <memory>
 #include <string>
+#include <vector>
+
+#include <core/interrupt/interrupt.hpp>
+#include <core/scheduler/scheduler.hpp>
+#include <core/dma/dma.hpp>
+#include <core/sio/sio.hpp>
+#include <core/cpu/cpu.hpp>
+#include <core/memory/ram.hpp>
+#include <core/memory/arena.hpp>
 
 #define BIOS_RANGE 0x1fc00000, 0x1fc7ffff
 #define MEM_CTRL_RANGE 0x1f801000, 0x1f801023
@@ -14,10 +24,78 @@
 #define EXPANSION1_RANGE 0x1f000000, 0x1f7fffff
 #define INTERRUPT_RANGE 0x1f801070, 0x1f801077
 #define TIMER_RANGE 0x1f801100, 0x1f801131
+#define CDROM_RANGE 0x1f801800, 0x1f801803
+#define DMA_RANGE 0x1f801080, 0x1f8010ff
+#define MDEC_RANGE 0x1f801820, 0x1f801827
+#define SIO0_RANGE 0x1f801040, 0x1f80104f
+
+#define RAM_SIZE (2 * 1024 * 1024)
+
+#define SCRATCHPAD_START 0x1f800000
+#define SCRATCHPAD_SIZE 0x400
+
+#define PAGE_SHIFT 12
+#define PAGE_SIZE (1 << PAGE_SHIFT)
+#define PAGE_MASK (PAGE_SIZE - 1)
+#define PAGE_COUNT (0x20000000 >> PAGE_SHIFT)
+#define KSEG2_START 0xc0000000
+
+#define CYCLES_PER_INSTRUCTION 2
 
-class CPU;
 class BIOS;
-class RAM;
+class InterruptController;
+class Timers;
+class SPU;
+class AudioSink;
+class CDROM;
+class MDEC;
+
+/**
+ * @brief Accesses a watchpoint reacts to.
+ * 
+ */
+enum WatchType
+{
+    WATCH_READ = 1,
+    WATCH_WRITE = 2,
+    WATCH_ACCESS = 3
+};
+
+/**
+ * @brief What happens when a watchpoint is hit.
+ * 
+ */
+enum WatchAction
+{
+    WATCH_LOG,
+    WATCH_STOP
+};
+
+/**
+ * @brief Structure to store a watchpoint on a range of RAM.
+ * 
+ */
+struct Watchpoint
+{
+    uint32_t start; //offset in RAM (inclusive)
+    uint32_t end; //offset in RAM (exclusive)
+    WatchType type;
+    WatchAction action;
+};
+
+/**
+ * @brief Structure to report the access that hit a watchpoint.
+ * 
+ */
+struct WatchHit
+{
+    uint32_t pc; //address of the instruction
+    uint32_t addr; //address accessed
+    uint32_t size;
+    bool write;
+    uint32_t old_value;
+    uint32_t new_value; //same as old_value for reads
+};
 
 /**
  * @brief Structure to store a range of addresses to allow easy checking.
@@ -73,27 +151,247 @@ struct Range
  * @brief Class to implement the Bus.
  * 
  * Implements the Bus of the PSX. This is the central class that glues all the other components together. All communication between components (classes) is done through this class.
+ * 
+ * CPU accesses are served in order of frequency: the scratchpad first, then a page table of 4KB host pages covering the RAM and the BIOS, and only then the chain of I/O ranges.
+ * 
+ * When the CPU reports an idle loop, the global cycle count jumps to the next scheduled event, since the loop cannot observe anything different until then.
+ * 
+ * All the state of the machine comes from one arena owned by the Bus: the CPU first, then the page tables, the RAM, the BIOS and the other components. The hot state is contiguous, and destroying the Bus destroys the components and frees the machine in one go.
+ * 
+ * In deterministic mode the emulation depends only on the starting state and the controller input of each frame: events due at the same cycle are handled in the fixed order of the Event enum, and nothing waits on or polls the host.
+ * 
+ * A machine can be forked into children that share its RAM, BIOS and sound RAM copy-on-write, 4KB page by 4KB page. Shared pages are only mapped for reading in the page table, so the first write to one goes through the I/O path to the RAM, which copies it.
+ * 
+ * Watchpoints remove the pages they cover from the page table, so only the accesses to those pages reach the RAM through the I/O path, where they are checked. Accesses to other pages are as fast as without watchpoints. Only CPU accesses to RAM are watched (not the scratchpad or DMA).
  */
 class Bus
 {
 public:
     Bus(std::string bios_path);
+    std::unique_ptr<Bus> fork();
+
+    /**
+     * @brief Reads a 32-bit word from the given address
+     * 
+     * Inlined into the CPU, aligned scratchpad and page table hits never leave the instruction handler.
+     * @param addr Address to read from
+     * @return uint32_t Data read from the address
+     */
+    uint32_t read32_cpu(uint32_t addr)
+    {
+        if(!(addr & 3))
+        {
+            if(in_scratchpad(addr)) return *(uint32_t*)&scratchpad[addr & (SCRATCHPAD_SIZE - 1)];
+            if(uint8_t* host = page_lookup(read_pages, addr)) return *(uint32_t*)host;
+        }
+        return read32_io(addr);
+    }
+
+    /**
+     * @brief Writes a 32-bit word to the given address
+     * 
+     * @param addr Address to write to
+     * @param data Data to write
+     */
+    void write32_cpu(uint32_t addr, uint32_t data)
+    {
+        if(!(addr & 3))
+        {
+            if(in_scratchpad(addr)) { *(uint32_t*)&scratchpad[addr & (SCRATCHPAD_SIZE - 1)] = data; return; }
+            if(uint8_t* host = page_lookup(write_pages, addr)) { *(uint32_t*)host = data; check_code_store(host, 4); return; }
+        }
+        write32_io(addr, data);
+    }
+
+    /**
+     * @brief Reads a 16-bit word from the given address
+     * 
+     * @param addr Address to read from
+     * @return uint16_t Data read from the address
+     */
+    uint16_t read16_cpu(uint32_t addr)
+    {
+        if(!(addr & 1))
+        {
+            if(in_scratchpad(addr)) return *(uint16_t*)&scratchpad[addr & (SCRATCHPAD_SIZE - 1)];
+            if(uint8_t* host = page_lookup(read_pages, addr)) return *(uint16_t*)host;
+        }
+        return read16_io(addr);
+    }
 
-    uint32_t read32_cpu(uint32_t addr);
-    void write32_cpu(uint32_t addr, uint32_t data);
+    /**
+     * @brief Writes a 16-bit word to the given address
+     * 
+     * @param addr Address to write to
+     * @param data Data to write
+     */
+    void write16_cpu(uint32_t addr, uint16_t data)
+    {
+        if(!(addr & 1))
+        {
+            if(in_scratchpad(addr)) { *(uint16_t*)&scratchpad[addr & (SCRATCHPAD_SIZE - 1)] = data; return; }
+            if(uint8_t* host = page_lookup(write_pages, addr)) { *(uint16_t*)host = data; check_code_store(host, 2); return; }
+        }
+        write16_io(addr, data);
+    }
 
-    uint16_t read16_cpu(uint32_t addr);
-    void write16_cpu(uint32_t addr, uint16_t data);
+    /**
+     * @brief Reads a 8-bit word from the given address
+     * 
+     * @param addr Address to read from
+     * @return uint8_t Data read from the address
+     */
+    uint8_t read8_cpu(uint32_t addr)
+    {
+        if(in_scratchpad(addr)) return scratchpad[addr & (SCRATCHPAD_SIZE - 1)];
+        if(uint8_t* host = page_lookup(read_pages, addr)) return *host;
+        return read8_io(addr);
+    }
 
-    uint8_t read8_cpu(uint32_t addr);
-    void write8_cpu(uint32_t addr, uint8_t data);
+    /**
+     * @brief Writes a 8-bit word to the given address
+     * 
+     * @param addr Address to write to
+     * @param data Data to write
+     */
+    void write8_cpu(uint32_t addr, uint8_t data)
+    {
+        if(in_scratchpad(addr)) { scratchpad[addr & (SCRATCHPAD_SIZE - 1)] = data; return; }
+        if(uint8_t* host = page_lookup(write_pages, addr)) { *host = data; check_code_store(host, 1); return; }
+        write8_io(addr, data);
+    }
 
     void clock();
 
+    void raise_irq(IRQ irq);
+
+    uint64_t get_cycles();
+    void schedule_event(Event event, uint64_t time);
+    void cancel_event(Event event);
+
+    void set_audio_sink(AudioSink* sink);
+    void load_disc(std::string path, uint32_t read_ahead);
+    void set_cycle_model(bool enabled);
+    bool get_cycle_model();
+    void set_deterministic(bool enabled);
+    uint64_t get_frame_count();
+    void run_frame();
+    PadState& get_pad(uint32_t port);
+    void set_pad_buttons(uint32_t port, uint16_t buttons);
+    uint16_t get_pad_buttons(uint32_t port);
+    void set_pad_type(uint32_t port, PadType type);
+    PadType get_pad_type(uint32_t port);
+    void set_pad_poll_callback(std::function<void(uint32_t, PadState&)> callback);
+    void set_idle_skip(bool enabled);
+    uint64_t get_idle_cycles();
+    void set_fusion(bool enabled);
+    uint64_t get_fusion_count(FusedIdiom idiom);
+
+    CPUState* get_cpu_state(CPUState* state);
+    void set_cpu_state(CPUState* state);
+    uint32_t get_cpu_pc();
+    void set_cpu_pc(uint32_t addr);
+    bool read8_debug(uint32_t addr, uint8_t* data);
+    bool write8_debug(uint32_t addr, uint8_t data);
+
+    void add_watchpoint(uint32_t addr, uint32_t size, WatchType type, WatchAction action);
+    void remove_watchpoint(uint32_t addr, uint32_t size, WatchType type);
+
+    /**
+     * @brief Returns the last hit of a stopping watchpoint, once.
+     * 
+     * Polled by the host after clock to stop the emulation.
+     * @param hit Output hit
+     * @return true A stopping watchpoint was hit since the last call
+     * @return false No hit
+     */
+    bool take_watch_hit(WatchHit* hit)
+    {
+        if(!watch_stopped) return false;
+        watch_stopped = false;
+        *hit = watch_hit;
+        return true;
+    }
+    void set_monitor(StateMonitor* monitor);
+    void set_coverage(CodeCoverage* coverage);
+    void publish_state();
+    const uint8_t* get_ram_data();
+    uint32_t get_ram_size();
+    uint32_t get_shared_ram_pages();
+
+    bool side_effect_free(uint32_t addr);
+    const uint8_t* code_page(uint32_t addr);
+    void mark_code(uint32_t addr, uint32_t size);
+
+    uint32_t read32_dma(uint32_t addr);
+    void write32_dma(uint32_t addr, uint32_t data);
+    uint32_t dma_device_ready(DMAChannel channel);
+    void dma_device_read(DMAChannel channel, uint32_t* data, uint32_t count);
+    void dma_device_write(DMAChannel channel, const uint32_t* data, uint32_t count);
+    void dma_request(DMAChannel channel);
+
 private:
+    Bus(Bus* parent);
+    void connect_components();
+
+    /**
+     * @brief Checks if the given address is in the scratchpad
+     * 
+     * The scratchpad is the data cache of the CPU and is only reachable through KUSEG and KSEG0.
+     * @param addr Address to check
+     * @return true Address is in the scratchpad
+     * @return false Address is not in the scratchpad
+     */
+    static bool in_scratchpad(uint32_t addr) { return (addr & 0x7ffffc00) == SCRATCHPAD_START; }
+
+    /**
+     * @brief Looks up the host memory backing the given address in a page table
+     * 
+     * @param pages Page table to use (read_pages or write_pages)
+     * @param addr Address to look up
+     * @return uint8_t* Pointer to the byte at the address, nullptr if the page is not mapped
+     */
+    static uint8_t* page_lookup(uint8_t* const* pages, uint32_t addr)
+    {
+        if(addr >= KSEG2_START) return nullptr;
+        uint8_t* page = pages[(addr & 0x1fffffff) >> PAGE_SHIFT];
+        return page ? page + (addr & PAGE_MASK) : nullptr;
+    }
+
+    /**
+     * @brief Reports a store through the page table to the RAM if it hit a page holding cached code.
+     * 
+     * Only RAM is mapped writable in the page table.
+     * @param host Host address written
+     * @param size Size of the store in bytes
+     */
+    void check_code_store(const uint8_t* host, uint32_t size)
+    {
+        uint32_t offset = uint32_t(host - ram->get_data());
+        if(ram->is_code(offset)) ram->code_written(offset, size);
+    }
+
+    uint32_t read32_io(uint32_t addr);
+    void write32_io(uint32_t addr, uint32_t data);
+    uint16_t read16_io(uint32_t addr);
+    void write16_io(uint32_t addr, uint16_t data);
+    uint8_t read8_io(uint32_t addr);
+    void write8_io(uint32_t addr, uint8_t data);
+
+    void map_pages();
+    void map_ram_page(uint32_t page);
+    void watch_access(uint32_t addr, uint32_t offset, uint32_t size, bool write, uint32_t data);
     uint32_t region_mask(uint32_t addr);
+    void update_irq();
+    void handle_event(Event event);
 
 private:
+    /**
+     * @brief Arena every component and table of the machine is allocated from, destroyed after all the other members
+     * 
+     */
+    Arena arena;
+
     /**
      * @brief Pointer to the CPU object
      * 
@@ -112,6 +410,126 @@ private:
      */
     RAM *ram;
 
+    /**
+     * @brief Pointer to the InterruptController object
+     * 
+     */
+    InterruptController* interrupt;
+
+    /**
+     * @brief Pointer to the Timers object
+     * 
+     */
+    Timers* timers;
+
+    /**
+     * @brief Pointer to the SPU object
+     * 
+     */
+    SPU* spu;
+
+    /**
+     * @brief Pointer to the CDROM object
+     * 
+     */
+    CDROM* cdrom;
+
+    /**
+     * @brief Pointer to the DMA object
+     * 
+     */
+    DMA* dma;
+
+    /**
+     * @brief Pointer to the MDEC object
+     * 
+     */
+    MDEC* mdec;
+
+    /**
+     * @brief Pointer to the SIO0 object
+     * 
+     */
+    SIO0* sio0;
+
+    /**
+     * @brief Pointer to the Scheduler object
+     * 
+     */
+    Scheduler* scheduler;
+
+    /**
+     * @brief Scratchpad (1KB data cache used as fast RAM)
+     * 
+     */
+    uint8_t scratchpad[SCRATCHPAD_SIZE];
+
+    /**
+     * @brief Host page for every readable 4KB page of the physical address space, nullptr for I/O and unmapped pages
+     * 
+     */
+    uint8_t** read_pages;
+
+    /**
+     * @brief Host page for every writable 4KB page of the physical address space, nullptr for I/O, read-only and unmapped pages
+     * 
+     */
+    uint8_t** write_pages;
+
+    /**
+     * @brief Whether instructions are timed by the cost of their fetch
+     * 
+     */
+    bool cycle_model;
+
+    /**
+     * @brief Whether the emulation is independent of the host (see set_deterministic)
+     * 
+     */
+    bool deterministic;
+
+    /**
+     * @brief Number of vblanks since reset
+     * 
+     */
+    uint64_t frames;
+
+    /**
+     * @brief Number of cycles skipped while the CPU was spinning in idle loops
+     * 
+     */
+    uint64_t idle_cycles;
+
+    /**
+     * @brief Whether the CPU may execute fused pairs of instructions
+     * 
+     */
+    bool fusion;
+
+    /**
+     * @brief Monitor the state is published to at every frame, nullptr if none
+     * 
+     */
+    StateMonitor* monitor;
+
+    /**
+     * @brief Watchpoints on RAM
+     * 
+     */
+    std::vector<Watchpoint> watchpoints;
+
+    /**
+     * @brief Last hit of a stopping watchpoint
+     * 
+     */
+    WatchHit watch_hit;
+
+    /**
+     * @brief Whether watch_hit has not been taken yet
+     * 
+     */
+    bool watch_stopped;
+
     /**
      * @brief Range of the BIOS
      * 
@@ -171,6 +589,30 @@ private:
      * 
      */
     Range timer_range = Range(TIMER_RANGE);
+
+    /**
+     * @brief Range of the CD-ROM Registers
+     * 
+     */
+    Range cdrom_range = Range(CDROM_RANGE);
+
+    /**
+     * @brief Range of the DMA Registers
+     * 
+     */
+    Range dma_range = Range(DMA_RANGE);
+
+    /**
+     * @brief Range of the MDEC Registers
+     * 
+     */
+    Range mdec_range = Range(MDEC_RANGE);
+
+    /**
+     * @brief Range of the SIO0 (controller and memory card port) Registers
+     * 
+     */
+    Range sio0_range = Range(SIO0_RANGE);
 };
 
 #endif
\ No newline at end of file
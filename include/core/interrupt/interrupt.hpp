@@ -0,0 +1,75 @@
+#ifndef INTERRUPT_HPP
+#define INTERRUPT_HPP
+
+#include <stdint.h>
+
+#define I_STAT_OFFSET 0x0
+#define I_MASK_OFFSET 0x4
+
+/**
+ * @brief Interrupt lines of the PSX, numbered by their bit in I_STAT/I_MASK.
+ * 
+ */
+enum IRQ
+{
+    IRQ_VBLANK = 0,
+    IRQ_GPU = 1,
+    IRQ_CDROM = 2,
+    IRQ_DMA = 3,
+    IRQ_TIMER0 = 4,
+    IRQ_TIMER1 = 5,
+    IRQ_TIMER2 = 6,
+    IRQ_SIO0 = 7,
+    IRQ_SIO1 = 8,
+    IRQ_SPU = 9,
+    IRQ_LIGHTPEN = 10
+};
+
+/**
+ * @brief Class to emulate the Interrupt Controller.
+ * 
+ * Implements the I_STAT and I_MASK registers of the PSX. The combined interrupt output (connected to bit 10 of the COP0 cause register) is only recomputed when a device raises a line or when software writes one of the registers, so polling the registers is cheap.
+ */
+class InterruptController
+{
+public:
+    InterruptController();
+
+    uint32_t read32_cpu(uint32_t offset);
+    void write32_cpu(uint32_t offset, uint32_t data);
+
+    void raise(IRQ irq);
+
+    /**
+     * @brief Returns whether any unmasked interrupt is pending.
+     * 
+     * @return true An unmasked interrupt is pending
+     * @return false No unmasked interrupt is pending
+     */
+    bool pending() { return is_pending; }
+
+private:
+    void update();
+
+private:
+    /**
+     * @brief Interrupt status register (I_STAT)
+     * 
+     * A bit is set when the corresponding device raises its interrupt line and is acknowledged by writing 0 to it.
+     */
+    uint16_t i_stat;
+
+    /**
+     * @brief Interrupt mask register (I_MASK)
+     * 
+     */
+    uint16_t i_mask;
+
+    /**
+     * @brief Cached value of (I_STAT & I_MASK) != 0
+     * 
+     */
+    bool is_pending;
+};
+
+#endif
@@ -0,0 +1,316 @@
+#ifndef LOGGING_HPP
+#define LOGGING_HPP
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#define LOG_RING_SIZE 4096
+#define LOG_MAX_ARGS 4
+#define LOG_DRAIN_INTERVAL_MS 10
+
+/**
+ * @brief Severity of a log message.
+ * 
+ */
+enum LogLevel
+{
+    LOG_LEVEL_TRACE,
+    LOG_LEVEL_DEBUG,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_ERROR,
+    LOG_LEVEL_NONE
+};
+
+/**
+ * @brief Minimum level of the messages compiled in. Calls below it are removed entirely, arguments included.
+ * 
+ * Set through the WOLPSX_LOG_LEVEL CMake cache variable.
+ */
+#ifndef WOLPSX_LOG_MIN_LEVEL
+#define WOLPSX_LOG_MIN_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+/**
+ * @brief Subsystem a log message comes from. Each one has its own runtime level.
+ * 
+ */
+enum LogCategory
+{
+    LOG_CPU,
+    LOG_BUS,
+    LOG_DMA,
+    LOG_MDEC,
+    LOG_CDROM,
+    LOG_SPU,
+    LOG_TIMER,
+    LOG_INTERRUPT,
+    LOG_CATEGORY_COUNT
+};
+
+/**
+ * @brief Type of a LogArg.
+ * 
+ */
+enum LogArgType
+{
+    LOG_ARG_UNSIGNED,
+    LOG_ARG_SIGNED,
+    LOG_ARG_STRING
+};
+
+/**
+ * @brief Structure to store an argument of a log message until it is formatted.
+ * 
+ * Integers (and enums) are stored by value. Strings are stored by pointer, so they must outlive the message (string literals).
+ */
+struct LogArg
+{
+    LogArgType type;
+
+    union
+    {
+        uint64_t u;
+        int64_t i;
+        const char* s;
+    };
+
+    /**
+     * @brief Construct a new LogArg object
+     * 
+     */
+    LogArg() : type(LOG_ARG_UNSIGNED), u(0) {}
+
+    /**
+     * @brief Construct a new LogArg object from an integer, enum or string literal
+     * 
+     * @param value Value of the argument
+     */
+    template<typename T>
+    LogArg(T value)
+    {
+        if constexpr(std::is_convertible_v<T, const char*>)
+        {
+            type = LOG_ARG_STRING;
+            s = value;
+        }
+        else if constexpr(std::is_enum_v<T> || std::is_signed_v<T>)
+        {
+            type = LOG_ARG_SIGNED;
+            i = int64_t(value);
+        }
+        else
+        {
+            type = LOG_ARG_UNSIGNED;
+            u = uint64_t(value);
+        }
+    }
+};
+
+/**
+ * @brief Structure to store a log message in the ring.
+ * 
+ */
+struct LogEntry
+{
+    /**
+     * @brief Sequence number used to hand the slot over between producers and the consumer
+     * 
+     */
+    std::atomic<uint64_t> sequence;
+
+    LogLevel level;
+    LogCategory category;
+
+    /**
+     * @brief Format string (string literal), "{}" is replaced by an argument, "{:x}" by an argument in hexadecimal
+     * 
+     */
+    const char* format;
+
+    uint32_t arg_count;
+    LogArg args[LOG_MAX_ARGS];
+};
+
+/**
+ * @brief Class to implement the logger.
+ * 
+ * Messages are pushed unformatted (format string and arguments) to a bounded lock-free ring and formatted and written by a background thread, so a log call on the emulation thread costs a few stores and never blocks. When the ring is full messages are dropped and counted.
+ * 
+ * Use the LOG_* macros rather than calling log directly: they remove calls below WOLPSX_LOG_MIN_LEVEL at compile time and check the runtime level of the category before evaluating the arguments.
+ */
+class Logger
+{
+public:
+    static Logger& get();
+    ~Logger();
+
+    /**
+     * @brief Checks if messages of a level are enabled for a category.
+     * 
+     * @param category Category of the message
+     * @param level Level of the message
+     * @return true The message should be logged
+     * @return false The message is filtered out
+     */
+    bool enabled(LogCategory category, LogLevel level) { return level >= levels[category].load(std::memory_order_relaxed); }
+
+    void set_level(LogCategory category, LogLevel level);
+    void set_level(LogLevel level);
+    void set_output(std::ostream* output);
+    void flush();
+
+    /**
+     * @brief Pushes a message to the ring.
+     * 
+     * @param level Level of the message
+     * @param category Category of the message
+     * @param format Format string (string literal)
+     * @param args Arguments (integers, enums or string literals)
+     */
+    template<typename... Args>
+    void log(LogLevel level, LogCategory category, const char* format, Args... args)
+    {
+        static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "Too many arguments for a log message");
+        LogArg list[LOG_MAX_ARGS] = {LogArg(args)...};
+        push(level, category, format, list, sizeof...(Args));
+    }
+
+    /**
+     * @brief Pushes the last message allowed by LOG_LIMIT.
+     * 
+     * @param level Level of the message
+     * @param category Category of the message
+     * @param note Whether to add a note that further messages are suppressed
+     * @param format Format string (string literal)
+     * @param args Arguments (integers, enums or string literals)
+     */
+    template<typename... Args>
+    void log_last(LogLevel level, LogCategory category, bool note, const char* format, Args... args)
+    {
+        log(level, category, format, args...);
+        if(note) log(level, category, "Suppressing further messages: {}", format);
+    }
+
+    static std::string format(const char* format, const LogArg* args, uint32_t count);
+
+private:
+    Logger();
+    void push(LogLevel level, LogCategory category, const char* format, const LogArg* args, uint32_t count);
+    void drain();
+    void run();
+
+private:
+    /**
+     * @brief Ring of messages waiting to be formatted
+     * 
+     */
+    std::unique_ptr<LogEntry[]> ring;
+
+    /**
+     * @brief Position of the next message pushed
+     * 
+     */
+    std::atomic<uint64_t> head;
+
+    /**
+     * @brief Position of the next message drained (guarded by drain_mutex)
+     * 
+     */
+    uint64_t tail;
+
+    /**
+     * @brief Number of messages dropped because the ring was full
+     * 
+     */
+    std::atomic<uint64_t> dropped;
+
+    /**
+     * @brief Runtime level of each category
+     * 
+     */
+    std::atomic<int> levels[LOG_CATEGORY_COUNT];
+
+    /**
+     * @brief Stream the messages are written to (guarded by drain_mutex)
+     * 
+     */
+    std::ostream* output;
+
+    /**
+     * @brief Mutex held while draining the ring
+     * 
+     */
+    std::mutex drain_mutex;
+
+    /**
+     * @brief Mutex and condition variable used to stop the background thread
+     * 
+     */
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stop;
+
+    /**
+     * @brief Background thread formatting and writing the messages
+     * 
+     */
+    std::thread thread;
+};
+
+/**
+ * @brief Logs a message if its level is compiled in and enabled for its category.
+ * 
+ */
+#define LOG(level, category, ...) \
+    do \
+    { \
+        if constexpr((level) >= WOLPSX_LOG_MIN_LEVEL) \
+        { \
+            if(Logger::get().enabled(category, level)) \
+                Logger::get().log(level, category, __VA_ARGS__); \
+        } \
+    } while(0)
+
+/**
+ * @brief Logs a message only the first count times this call site is reached with the level enabled, then notes that further messages are suppressed.
+ * 
+ * Meant for unhandled registers and similar messages that software can trigger on every access.
+ */
+#define LOG_LIMIT(count, level, category, ...) \
+    do \
+    { \
+        if constexpr((level) >= WOLPSX_LOG_MIN_LEVEL) \
+        { \
+            static std::atomic<uint32_t> log_site_count(0); \
+            if(log_site_count.load(std::memory_order_relaxed) < (count) && Logger::get().enabled(category, level)) \
+            { \
+                uint32_t log_site_index = log_site_count.fetch_add(1, std::memory_order_relaxed); \
+                if(log_site_index + 1 < (count)) \
+                    Logger::get().log(level, category, __VA_ARGS__); \
+                else if(log_site_index + 1 == (count)) \
+                    Logger::get().log_last(level, category, (count) > 1, __VA_ARGS__); \
+            } \
+        } \
+    } while(0)
+
+/**
+ * @brief Logs a message only the first time this call site is reached with the level enabled.
+ * 
+ */
+#define LOG_ONCE(level, category, ...) LOG_LIMIT(1, level, category, __VA_ARGS__)
+
+#define LOG_TRACE(category, ...) LOG(LOG_LEVEL_TRACE, category, __VA_ARGS__)
+#define LOG_DEBUG(category, ...) LOG(LOG_LEVEL_DEBUG, category, __VA_ARGS__)
+#define LOG_INFO(category, ...) LOG(LOG_LEVEL_INFO, category, __VA_ARGS__)
+#define LOG_WARN(category, ...) LOG(LOG_LEVEL_WARN, category, __VA_ARGS__)
+#define LOG_ERROR(category, ...) LOG(LOG_LEVEL_ERROR, category, __VA_ARGS__)
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef MDEC_HPP
+#define MDEC_HPP
+
+#include <stdint.h>
+#include <vector>
+
+#define MDEC_REG_DATA 0x0
+#define MDEC_REG_CONTROL 0x4
+
+#define MDEC_CMD_DECODE 1
+#define MDEC_CMD_SET_QUANT 2
+#define MDEC_CMD_SET_SCALE 3
+
+#define MDEC_CONTROL_RESET 0x80000000
+#define MDEC_CONTROL_DATA_IN_REQUEST 0x40000000
+#define MDEC_CONTROL_DATA_OUT_REQUEST 0x20000000
+
+#define MDEC_STATUS_OUT_EMPTY 0x80000000
+#define MDEC_STATUS_IN_FULL 0x40000000
+#define MDEC_STATUS_BUSY 0x20000000
+#define MDEC_STATUS_DATA_IN_REQUEST 0x10000000
+#define MDEC_STATUS_DATA_OUT_REQUEST 0x08000000
+
+class Bus;
+
+/**
+ * @brief Output formats of the decode command.
+ * 
+ */
+enum MDECDepth
+{
+    MDEC_DEPTH_4BIT = 0,
+    MDEC_DEPTH_8BIT = 1,
+    MDEC_DEPTH_24BIT = 2,
+    MDEC_DEPTH_15BIT = 3
+};
+
+/**
+ * @brief Class to emulate the MDEC (Macroblock Decoder).
+ * 
+ * Implements the command and control registers, the quantization and scale tables and the decode command: run length decoding, dequantization, IDCT and YUV to RGB conversion of 16x16 macroblocks (or 8x8 monochrome blocks). Data is normally transferred in bulk by DMA channels 0 and 1.
+ * 
+ * A decode command is executed once all of its parameter words have been received, and its output is made available to DMA channel 1 at once. The IDCT and the colour conversion use SSE2 when available; the scalar fallback gives the same results.
+ */
+class MDEC
+{
+public:
+    MDEC();
+
+    /**
+     * @brief Connects Bus to the MDEC.
+     * 
+     * Used by the constructor of Bus to connect the MDEC to the Bus.
+     * @param bus Pointer to the bus structure
+     */
+    void connectBus(Bus* bus) { this->bus = bus; }
+
+    uint32_t read32_cpu(uint32_t offset);
+    void write32_cpu(uint32_t offset, uint32_t data);
+
+    void write_data(const uint32_t* data, uint32_t count);
+    void read_data(uint32_t* data, uint32_t count);
+
+    /**
+     * @brief Returns the number of output words waiting to be read.
+     * 
+     * @return uint32_t Number of words in the output FIFO
+     */
+    uint32_t output_words() { return (output.size() - output_index) / 4; }
+
+private:
+    void reset();
+    void write_word(uint32_t data);
+    void start_command(uint32_t command);
+    void execute_command();
+    void decode_macroblocks();
+    bool decode_block(int16_t* block, const uint8_t* quant, uint32_t& index);
+    void set_scale_table(const int16_t* table);
+
+    void idct(int16_t* block);
+    void output_color(const int16_t* blocks);
+    void output_mono(const int16_t* block);
+
+private:
+    /**
+     * @brief Pointer to the Bus object
+     * 
+     */
+    Bus* bus;
+
+    /**
+     * @brief Command being received
+     * 
+     */
+    uint32_t command;
+
+    /**
+     * @brief Number of parameter words left to receive for the command
+     * 
+     */
+    uint32_t remaining;
+
+    /**
+     * @brief Parameter words of the command
+     * 
+     */
+    std::vector<uint32_t> params;
+
+    /**
+     * @brief Output FIFO (bytes)
+     * 
+     */
+    std::vector<uint8_t> output;
+
+    /**
+     * @brief Read position in the output FIFO
+     * 
+     */
+    uint32_t output_index;
+
+    /**
+     * @brief Value of the control register bits 29 and 30 (DMA requests enabled)
+     * 
+     */
+    uint32_t control;
+
+    /**
+     * @brief Luminance quantization table
+     * 
+     */
+    uint8_t quant_y[64];
+
+    /**
+     * @brief Colour quantization table
+     * 
+     */
+    uint8_t quant_uv[64];
+
+    /**
+     * @brief Scale table as uploaded (IDCT basis, 1.15 fixed point)
+     * 
+     */
+    int16_t scale[64];
+
+    /**
+     * @brief Scale table divided by 8, used by the scalar IDCT
+     * 
+     */
+    int16_t idct_table[64];
+
+    /**
+     * @brief Scale table divided by 8 with the rows interleaved in pairs for SIMD multiply-add.
+     * 
+     * Entry [p][x * 2 + i] holds idct_table[(2p + i) * 8 + x].
+     */
+    alignas(16) int16_t idct_pairs[4][16];
+};
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#define ARENA_ALIGNMENT 64
+
+/**
+ * @brief Returns the space taken in an arena by an array of objects.
+ * 
+ * Every allocation starts on a cache line, so the size is rounded up to ARENA_ALIGNMENT.
+ * @param count Number of objects
+ * @return size_t Size in bytes
+ */
+template<typename T>
+constexpr size_t arena_size(size_t count = 1)
+{
+    return (sizeof(T) * count + ARENA_ALIGNMENT - 1) & ~size_t(ARENA_ALIGNMENT - 1);
+}
+
+/**
+ * @brief Class to allocate the state of a machine from a single block of memory.
+ * 
+ * The block is mapped zeroed from the OS when the arena is constructed and handed out in cache-line-aligned pieces, in order, so objects created one after the other are adjacent in memory. Nothing is freed before the arena: its destructor destroys the objects it created in reverse order and frees the block.
+ */
+class Arena
+{
+public:
+    Arena(size_t capacity);
+    ~Arena();
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t size);
+
+    /**
+     * @brief Constructs an object in the arena.
+     * 
+     * The object is destroyed with the arena.
+     * @param args Arguments of the constructor
+     * @return T* Constructed object
+     */
+    template<typename T, typename... Args>
+    T* create(Args&&... args)
+    {
+        static_assert(alignof(T) <= ARENA_ALIGNMENT, "Over-aligned type");
+        void* memory = allocate(sizeof(T));
+        if(!std::is_trivially_destructible<T>::value)
+            destructors.reserve(destructors.size() + 1);
+        T* object = new(memory) T(std::forward<Args>(args)...);
+        if(!std::is_trivially_destructible<T>::value)
+            destructors.push_back({object, [](void* p) { static_cast<T*>(p)->~T(); }});
+        return object;
+    }
+
+    /**
+     * @brief Allocates a zeroed array of trivial objects in the arena.
+     * 
+     * @param count Number of objects
+     * @return T* First object
+     */
+    template<typename T>
+    T* create_array(size_t count)
+    {
+        static_assert(std::is_trivial<T>::value, "Arrays are not constructed");
+        return static_cast<T*>(allocate(sizeof(T) * count));
+    }
+
+    size_t get_used();
+    size_t get_capacity();
+
+private:
+    /**
+     * @brief Structure to store how to destroy an object of the arena.
+     * 
+     */
+    struct Destructor
+    {
+        void* object;
+        void (*destroy)(void*);
+    };
+
+    /**
+     * @brief Memory mapped from the OS, aligned on a page
+     * 
+     */
+    uint8_t* block;
+
+    /**
+     * @brief Size of the usable memory in bytes
+     * 
+     */
+    size_t capacity;
+
+    /**
+     * @brief Number of bytes handed out
+     * 
+     */
+    size_t used;
+
+    /**
+     * @brief Objects to destroy, in order of construction
+     * 
+     */
+    std::vector<Destructor> destructors;
+};
+
+#endif
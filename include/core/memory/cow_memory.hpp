@@ -0,0 +1,125 @@
+#ifndef COW_MEMORY_HPP
+#define COW_MEMORY_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+
+#include <core/memory/arena.hpp>
+
+#define COW_PAGE_SHIFT 12
+#define COW_PAGE_SIZE (1 << COW_PAGE_SHIFT)
+#define COW_PAGE_MASK (COW_PAGE_SIZE - 1)
+
+/**
+ * @brief Structure to store a page shared between forked machines.
+ * 
+ * Never written once shared, freed by the last machine releasing it.
+ */
+struct CowPage
+{
+    std::atomic<uint32_t> refs;
+    uint8_t data[COW_PAGE_SIZE];
+};
+
+/**
+ * @brief Class to hold guest memory that forked machines share copy-on-write.
+ * 
+ * Each 4KB page is either private, in the storage of the machine taken from its arena, or shared, in a refcounted CowPage. Forking shares every page of the parent with the child. The private pages of the parent are copied into new shared pages once, so forking a machine again, or forking its children, only bumps refcounts. A write to a shared page copies it back into the private storage first and reports the page to the unshare callback, so the owner can update the host pointers it keeps.
+ */
+class CowMemory
+{
+public:
+    CowMemory(Arena& arena, uint32_t size);
+    ~CowMemory();
+    CowMemory(const CowMemory&) = delete;
+    CowMemory& operator=(const CowMemory&) = delete;
+
+    static size_t arena_size(uint32_t size);
+
+    /**
+     * @brief Returns the host address of a byte, to read it.
+     * 
+     * @param offset Offset of the byte
+     * @return const uint8_t* Host address, in a shared page or in the private storage
+     */
+    const uint8_t* read_ptr(uint32_t offset) { return pages[offset >> COW_PAGE_SHIFT] + (offset & COW_PAGE_MASK); }
+
+    /**
+     * @brief Returns the host address of a byte, to write it.
+     * 
+     * The page of the byte is made private first if it is shared.
+     * @param offset Offset of the byte
+     * @return uint8_t* Host address in the private storage
+     */
+    uint8_t* write_ptr(uint32_t offset)
+    {
+        if(shared[offset >> COW_PAGE_SHIFT]) unshare(offset >> COW_PAGE_SHIFT);
+        return data + offset;
+    }
+
+    /**
+     * @brief Checks whether the page of a byte is shared.
+     * 
+     * @param offset Offset of the byte
+     * @return true Writes to the page must go through write_ptr
+     * @return false The page is in the private storage
+     */
+    bool is_shared(uint32_t offset) { return shared[offset >> COW_PAGE_SHIFT] != nullptr; }
+
+    /**
+     * @brief Returns the private storage.
+     * 
+     * Only the bytes of private pages are current.
+     * @return uint8_t* First byte of the storage
+     */
+    uint8_t* get_data() { return data; }
+
+    /**
+     * @brief Sets the function called when a shared page is made private.
+     * 
+     * @param callback Function taking the index of the page
+     */
+    void set_unshare_callback(std::function<void(uint32_t)> callback) { unshare_callback = callback; }
+
+    const uint8_t* flatten();
+    void fork_from(CowMemory& parent);
+    uint32_t count_shared();
+
+private:
+    void unshare(uint32_t page);
+    static void release(CowPage* page);
+
+    /**
+     * @brief Private storage, one slot per page
+     * 
+     */
+    uint8_t* data;
+
+    /**
+     * @brief Size of the memory in bytes
+     * 
+     */
+    uint32_t size;
+
+    /**
+     * @brief Host address of every page, in the private storage or in a shared page
+     * 
+     */
+    uint8_t** pages;
+
+    /**
+     * @brief Shared page of every page, nullptr if private
+     * 
+     */
+    CowPage** shared;
+
+    /**
+     * @brief Function called when a shared page is made private
+     * 
+     */
+    std::function<void(uint32_t)> unshare_callback;
+};
+
+#endif
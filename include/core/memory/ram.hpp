@@ -1,31 +1,128 @@
 #ifndef RAM_H
 #define RAM_H
 
+#include <stddef.h>
 #include <stdint.h>
-#include <vector>
+#include <functional>
+
+#include <core/memory/arena.hpp>
+#include <core/memory/cow_memory.hpp>
+
+#define RAM_CODE_PAGE_SHIFT 12
 
 /**
  * @brief Class to emulate the RAM.
  * 
- * Implements the RAM of the PSX.
+ * Implements the RAM of the PSX. The memory lives in the arena of the machine, and is shared copy-on-write with the machines forked from it.
+ * 
+ * Execution engines that cache guest code mark the 4KB pages it comes from. A write to a marked page, through the CPU or DMA, clears the mark and reports the written range to the code write callback, which invalidates what the write replaced and marks the page again if it still holds cached code.
  */
 class RAM
 {
 public:
-    RAM(uint32_t size);
+    RAM(Arena& arena, uint32_t size);
+    RAM(Arena& arena, RAM& parent);
+    static size_t arena_size(uint32_t size);
     uint32_t read32_cpu(uint32_t offset);
     void write32_cpu(uint32_t offset, uint32_t data);
     uint16_t read16_cpu(uint32_t offset);
     void write16_cpu(uint32_t offset, uint16_t data);
     uint8_t read8_cpu(uint32_t offset);
     void write8_cpu(uint32_t offset, uint8_t data);
+
+    /**
+     * @brief Returns the private storage of the RAM.
+     * 
+     * Used by the Bus to map the private pages writable into its page table. Only the bytes of pages that are not shared are current.
+     * @return uint8_t* Pointer to the first byte
+     */
+    uint8_t* get_data() { return memory.get_data(); }
+
+    /**
+     * @brief Returns the host address of a byte of the RAM, to read it.
+     * 
+     * @param offset Offset in the RAM
+     * @return const uint8_t* Host address
+     */
+    const uint8_t* get_host(uint32_t offset) { return memory.read_ptr(offset); }
+
+    /**
+     * @brief Checks whether the page of the given offset is shared with another machine.
+     * 
+     * @param offset Offset in the RAM
+     * @return true Writes must go through the write functions, which copy the page
+     * @return false Writes may go to get_data
+     */
+    bool is_shared(uint32_t offset) { return memory.is_shared(offset); }
+
+    /**
+     * @brief Returns the whole RAM as one block.
+     * 
+     * @return const uint8_t* Pointer to the first byte, valid until the next write
+     */
+    const uint8_t* get_contents() { return memory.flatten(); }
+
+    /**
+     * @brief Sets the function called when a shared page is copied on a write.
+     * 
+     * @param callback Function taking the index of the 4KB page
+     */
+    void set_unshare_callback(std::function<void(uint32_t)> callback) { memory.set_unshare_callback(callback); }
+
+    /**
+     * @brief Returns the number of 4KB pages shared with other machines.
+     * 
+     * @return uint32_t Number of pages
+     */
+    uint32_t count_shared_pages() { return memory.count_shared(); }
+
+    void mark_code(uint32_t offset, uint32_t size);
+
+    /**
+     * @brief Checks whether the page of the given offset holds cached code.
+     * 
+     * The only check on the store fast path of the Bus.
+     * @param offset Offset in the RAM
+     * @return true Writes to the page must be reported with code_written
+     * @return false The page holds no cached code
+     */
+    bool is_code(uint32_t offset) { return code_pages[offset >> RAM_CODE_PAGE_SHIFT]; }
+
+    void code_written(uint32_t offset, uint32_t size);
+
+    /**
+     * @brief Sets the function called when a page holding cached code is written.
+     * 
+     * @param callback Function taking the offset and size of the write
+     */
+    void set_code_write_callback(std::function<void(uint32_t, uint32_t)> callback) { code_write_callback = callback; }
+
 private:
+    static uint32_t code_page_count(uint32_t size);
 
     /**
      * @brief Data of the RAM.
      * 
      */
-    std::vector<uint8_t> data;
+    CowMemory memory;
+
+    /**
+     * @brief Size of the RAM in bytes
+     * 
+     */
+    uint32_t size;
+
+    /**
+     * @brief Whether each 4KB page holds cached code
+     * 
+     */
+    uint8_t* code_pages;
+
+    /**
+     * @brief Function called on writes to pages holding cached code
+     * 
+     */
+    std::function<void(uint32_t, uint32_t)> code_write_callback;
 };
 
 #endif
\ No newline at end of file
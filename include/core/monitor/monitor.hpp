@@ -0,0 +1,140 @@
+#ifndef MONITOR_HPP
+#define MONITOR_HPP
+
+#include <stdint.h>
+#include <atomic>
+
+#define MONITOR_RAM_WORDS 1024
+#define MONITOR_MAX_REGIONS 16
+#define MONITOR_READ_ATTEMPTS 16
+
+class RAM;
+
+/**
+ * @brief Index of the published words of the machine state.
+ * 
+ */
+enum MonitorWord
+{
+    MONITOR_REG_GEN = 0,
+    MONITOR_REG_HI = 32,
+    MONITOR_REG_LO,
+    MONITOR_PC,
+    MONITOR_COP0_STATUS,
+    MONITOR_COP0_CAUSE,
+    MONITOR_COP0_EPC,
+    MONITOR_CYCLES_LOW,
+    MONITOR_CYCLES_HIGH,
+    MONITOR_WORD_COUNT
+};
+
+/**
+ * @brief Structure to hold a consistent copy of the published state.
+ * 
+ */
+struct MonitorSnapshot
+{
+    uint32_t reg_gen[32];
+    uint32_t reg_hi;
+    uint32_t reg_lo;
+    uint32_t program_counter;
+    uint32_t reg_cop0_status;
+    uint32_t reg_cop0_cause;
+    uint32_t reg_cop0_epc;
+    uint64_t cycles;
+
+    /**
+     * @brief Number of publications so far, 0 if nothing was published yet
+     * 
+     */
+    uint32_t publication;
+
+    /**
+     * @brief Watched RAM regions, one after the other in the order they were added
+     * 
+     */
+    uint8_t ram[MONITOR_RAM_WORDS * 4];
+};
+
+/**
+ * @brief Class to publish the machine state to monitoring threads.
+ * 
+ * The emulation thread publishes at frame boundaries (or whenever the host asks the Bus to). Other threads read through a sequence lock: the writer makes the sequence odd, stores the words and makes it even again. A reader copies the words between two reads of the sequence and retries if it changed, so the writer never waits for readers. The words are relaxed atomics, which compile to plain loads and stores.
+ * 
+ * RAM regions are added with watch before the emulation starts.
+ */
+class StateMonitor
+{
+public:
+    StateMonitor();
+
+    uint32_t watch(uint32_t addr, uint32_t size);
+
+    /**
+     * @brief Starts a publication, readers retry until end_publish.
+     * 
+     */
+    void begin_publish()
+    {
+        sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    /**
+     * @brief Stores a word of the state during a publication.
+     * 
+     * @param index Index of the word
+     * @param data Value of the word
+     */
+    void publish_word(uint32_t index, uint32_t data) { words[index].store(data, std::memory_order_relaxed); }
+
+    void publish_ram(RAM& ram);
+
+    /**
+     * @brief Ends a publication.
+     * 
+     */
+    void end_publish() { sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    bool read(MonitorSnapshot* snapshot);
+
+private:
+    /**
+     * @brief Sequence of the lock, odd while a publication is in progress
+     * 
+     */
+    std::atomic<uint32_t> sequence;
+
+    /**
+     * @brief Published words of the state, indexed by MonitorWord
+     * 
+     */
+    std::atomic<uint32_t> words[MONITOR_WORD_COUNT];
+
+    /**
+     * @brief Published words of the watched RAM regions
+     * 
+     */
+    std::atomic<uint32_t> ram_words[MONITOR_RAM_WORDS];
+
+    /**
+     * @brief Start (in RAM) and size of the watched regions, in words
+     * 
+     */
+    uint32_t region_start[MONITOR_MAX_REGIONS];
+    uint32_t region_size[MONITOR_MAX_REGIONS];
+
+    /**
+     * @brief Number of watched regions
+     * 
+     */
+    uint32_t region_count;
+
+    /**
+     * @brief Total number of watched words
+     * 
+     */
+    uint32_t watched_words;
+};
+
+#endif
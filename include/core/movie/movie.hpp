@@ -0,0 +1,96 @@
+#ifndef MOVIE_HPP
+#define MOVIE_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <core/interconnect/bus.hpp>
+
+#define MOVIE_MAGIC "WPSXMOV1"
+#define MOVIE_MAGIC_SIZE 8
+#define MOVIE_VERSION 2
+
+#define MOVIE_FLAG_CYCLE_MODEL 1
+
+/**
+ * @brief Structure to store the input and the result of one frame of a movie.
+ * 
+ */
+struct MovieFrame
+{
+    PadState pads[PAD_PORT_COUNT]; //input during the frame
+    uint64_t ram_hash; //hash of the RAM at the end of the frame
+};
+
+/**
+ * @brief Class to record and replay sessions as controller input.
+ * 
+ * A movie holds the starting state of the machine and, for every frame, the input of each controller and a hash of the RAM at the vblank that ends the frame. The machine runs in deterministic mode, so replaying the input from the same starting state reproduces the session, and the hashes find the first frame where a replay diverges.
+ * 
+ * Movies start from power-on: the starting state is the BIOS, the disc and the controllers plugged in, identified by a hash of the BIOS, the path of the disc and the pad types, and checked against a hash of the RAM. Input set by a pad poll callback is not recorded.
+ * 
+ * File format (little-endian): the magic, the version and the flags (uint32), the pad type of each port (uint8), the BIOS and start hashes (uint64), the length of the disc path (uint32) and the path, the number of frames (uint64), then per frame the buttons (uint16) and the sticks (4 uint8) of each port and the RAM hash (uint64).
+ */
+class Movie
+{
+public:
+    Movie();
+
+    void start(Bus& bus, const std::string& disc_path);
+    void record_frame(Bus& bus, const PadState* pads);
+    void start_replay(Bus& bus);
+    bool replay_frame(Bus& bus, uint64_t frame);
+
+    uint64_t get_frame_count();
+    const MovieFrame& get_frame(uint64_t frame);
+    const std::string& get_disc_path();
+
+    void save(const std::string& path);
+    void load(const std::string& path);
+
+    static uint64_t hash(const uint8_t* data, size_t size);
+    static uint64_t hash_ram(Bus& bus);
+
+private:
+    static uint64_t hash_bios(Bus& bus);
+
+    /**
+     * @brief Settings of the machine the movie was recorded with (MOVIE_FLAG_*)
+     * 
+     */
+    uint32_t flags;
+
+    /**
+     * @brief Controller plugged into each port
+     * 
+     */
+    PadType pad_types[PAD_PORT_COUNT];
+
+    /**
+     * @brief Hash of the BIOS image
+     * 
+     */
+    uint64_t bios_hash;
+
+    /**
+     * @brief Hash of the RAM at power-on
+     * 
+     */
+    uint64_t start_hash;
+
+    /**
+     * @brief Path of the disc image, empty if there is none
+     * 
+     */
+    std::string disc_path;
+
+    /**
+     * @brief Recorded frames
+     * 
+     */
+    std::vector<MovieFrame> frames;
+};
+
+#endif
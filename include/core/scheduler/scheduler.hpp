@@ -0,0 +1,92 @@
+#ifndef SCHEDULER_HPP
+#define SCHEDULER_HPP
+
+#include <stdint.h>
+
+#define EVENT_NEVER UINT64_MAX
+
+/**
+ * @brief Events that can be scheduled on the global timeline.
+ * 
+ * Every event can be scheduled at most once at a time. Scheduling an already scheduled event moves it.
+ */
+enum Event
+{
+    EVENT_VBLANK,
+    EVENT_TIMER0,
+    EVENT_TIMER1,
+    EVENT_TIMER2,
+    EVENT_SPU,
+    EVENT_CDROM_COMMAND,
+    EVENT_CDROM_DRIVE,
+    EVENT_SIO0,
+    EVENT_COUNT
+};
+
+/**
+ * @brief Class to implement the Scheduler.
+ * 
+ * Keeps the global cycle count of the system and the time at which each event is due. Components derive their state from the cycle count on demand and only schedule an event when something has to happen at a specific time (for example an interrupt), so nothing has to be updated on every cycle.
+ */
+class Scheduler
+{
+public:
+    Scheduler();
+
+    /**
+     * @brief Returns the current cycle count.
+     * 
+     * @return uint64_t Number of CPU cycles since reset
+     */
+    uint64_t now() { return cycles; }
+
+    /**
+     * @brief Advances the global cycle count.
+     * 
+     * @param cycles Number of CPU cycles elapsed
+     */
+    void advance(uint32_t cycles) { this->cycles += cycles; }
+
+    /**
+     * @brief Checks if any event is due.
+     * 
+     * @return true At least one event is due
+     * @return false No event is due
+     */
+    bool event_due() { return cycles >= next_event_time; }
+
+    /**
+     * @brief Returns the time of the earliest scheduled event.
+     * 
+     * @return uint64_t Cycle count of the next event (EVENT_NEVER if nothing is scheduled)
+     */
+    uint64_t next_event() { return next_event_time; }
+
+    void schedule(Event event, uint64_t time);
+    void cancel(Event event);
+    Event pop_event();
+
+private:
+    void update_next_event();
+
+private:
+    /**
+     * @brief Number of CPU cycles since reset
+     * 
+     */
+    uint64_t cycles;
+
+    /**
+     * @brief Time at which each event is due (EVENT_NEVER if not scheduled)
+     * 
+     */
+    uint64_t event_time[EVENT_COUNT];
+
+    /**
+     * @brief Cached minimum of event_time
+     * 
+     */
+    uint64_t next_event_time;
+};
+
+#endif
@@ -0,0 +1,282 @@
+#ifndef SIO_HPP
+#define SIO_HPP
+
+#include <stdint.h>
+#include <functional>
+
+#define PAD_PORT_COUNT 2
+
+#define SIO_REG_DATA 0x0
+#define SIO_REG_STAT 0x4
+#define SIO_REG_MODE 0x8
+#define SIO_REG_CTRL 0xa
+#define SIO_REG_BAUD 0xe
+
+#define SIO_STAT_TX_READY 0x0001
+#define SIO_STAT_RX_NOT_EMPTY 0x0002
+#define SIO_STAT_TX_FINISHED 0x0004
+#define SIO_STAT_ACK_LEVEL 0x0080
+#define SIO_STAT_IRQ 0x0200
+
+#define SIO_CTRL_TX_ENABLE 0x0001
+#define SIO_CTRL_SELECT 0x0002
+#define SIO_CTRL_ACKNOWLEDGE 0x0010
+#define SIO_CTRL_RESET 0x0040
+#define SIO_CTRL_ACK_IRQ_ENABLE 0x1000
+#define SIO_CTRL_PORT 0x2000
+
+#define SIO_DEFAULT_BAUD 0x88
+
+/**
+ * @brief First bytes of a transfer, selecting the device that answers it.
+ * 
+ */
+#define SIO_ADDRESS_PAD 0x01
+#define SIO_ADDRESS_MEMCARD 0x81
+
+/**
+ * @brief Buttons of the PadState, a set bit for a pressed button.
+ * 
+ * The pad sends them inverted (a cleared bit for a pressed button), in the same order.
+ */
+#define PAD_BUTTON_SELECT 0x0001
+#define PAD_BUTTON_L3 0x0002
+#define PAD_BUTTON_R3 0x0004
+#define PAD_BUTTON_START 0x0008
+#define PAD_BUTTON_UP 0x0010
+#define PAD_BUTTON_RIGHT 0x0020
+#define PAD_BUTTON_DOWN 0x0040
+#define PAD_BUTTON_LEFT 0x0080
+#define PAD_BUTTON_L2 0x0100
+#define PAD_BUTTON_R2 0x0200
+#define PAD_BUTTON_L1 0x0400
+#define PAD_BUTTON_R1 0x0800
+#define PAD_BUTTON_TRIANGLE 0x1000
+#define PAD_BUTTON_CIRCLE 0x2000
+#define PAD_BUTTON_CROSS 0x4000
+#define PAD_BUTTON_SQUARE 0x8000
+
+#define PAD_AXIS_RIGHT_X 0
+#define PAD_AXIS_RIGHT_Y 1
+#define PAD_AXIS_LEFT_X 2
+#define PAD_AXIS_LEFT_Y 3
+#define PAD_AXIS_COUNT 4
+#define PAD_AXIS_CENTER 0x80
+
+/**
+ * @brief Pad IDs.
+ * 
+ * The high nibble is the type, the low nibble the number of halfwords of data that follow.
+ */
+#define PAD_ID_DIGITAL 0x41
+#define PAD_ID_ANALOG 0x73
+#define PAD_ID_CONFIG 0xf3
+
+class Bus;
+
+/**
+ * @brief Controllers that can be plugged into a port.
+ * 
+ */
+enum PadType
+{
+    PAD_NONE,
+    PAD_DIGITAL,
+    PAD_ANALOG
+};
+
+/**
+ * @brief Structure to store the input of a controller.
+ * 
+ * Written by the host, read by the pad when the game polls it.
+ */
+struct PadState
+{
+    /**
+     * @brief Pressed buttons (PAD_BUTTON_*)
+     * 
+     */
+    uint16_t buttons;
+
+    /**
+     * @brief Position of the sticks (PAD_AXIS_*), 0x00 left/up to 0xff right/down
+     * 
+     */
+    uint8_t axes[PAD_AXIS_COUNT];
+};
+
+/**
+ * @brief Structure to store the state of the controller plugged into a port.
+ * 
+ */
+struct PadDevice
+{
+    /**
+     * @brief Type of controller
+     * 
+     */
+    PadType type;
+
+    /**
+     * @brief Whether an analog pad sends its sticks (it sends only the buttons otherwise)
+     * 
+     */
+    bool analog;
+
+    /**
+     * @brief Whether an analog pad is in configuration mode
+     * 
+     */
+    bool config;
+
+    /**
+     * @brief ID sent in the current transfer (PAD_ID_*)
+     * 
+     */
+    uint8_t id;
+
+    /**
+     * @brief Command of the current transfer
+     * 
+     */
+    uint8_t command;
+
+    /**
+     * @brief First parameter byte of the command
+     * 
+     */
+    uint8_t param;
+};
+
+/**
+ * @brief Class to emulate SIO0, the serial port of the controllers and memory cards.
+ * 
+ * Implements the data, status, mode, control and baud rate registers, and the digital pad and analog pad (DualShock) protocols. A byte written to the data register is exchanged with the device of the selected port, which answers it one transfer time later, raising IRQ7 when it acknowledges the byte and the interrupt is enabled.
+ * 
+ * No memory card is emulated: the card slots never acknowledge, which games see as empty slots.
+ * 
+ * The input of each pad is a PadState the host writes directly, costing a few stores per frame and no call. A poll callback can instead fill it on demand at every poll of a pad.
+ */
+class SIO0
+{
+public:
+    SIO0();
+
+    /**
+     * @brief Connects Bus to the SIO0.
+     * 
+     * Used by the constructor of Bus to connect the SIO0 to the Bus.
+     * @param bus Pointer to the bus structure
+     */
+    void connectBus(Bus* bus) { this->bus = bus; }
+
+    uint32_t read32_cpu(uint32_t offset);
+    void write32_cpu(uint32_t offset, uint32_t data);
+
+    void handle_event();
+
+    PadState& get_pad(uint32_t port);
+    void set_pad_type(uint32_t port, PadType type);
+    PadType get_pad_type(uint32_t port);
+    void set_poll_callback(std::function<void(uint32_t, PadState&)> callback);
+
+private:
+    void reset();
+    void write_ctrl(uint16_t data);
+    void start_transfer(uint8_t data);
+    uint8_t pad_transfer(uint32_t port, uint8_t data, bool& ack);
+    uint8_t pad_config_reply(PadDevice& pad, uint32_t index);
+
+private:
+    /**
+     * @brief Pointer to the Bus object
+     * 
+     */
+    Bus* bus;
+
+    /**
+     * @brief Input of the pad of each port
+     * 
+     */
+    PadState pads[PAD_PORT_COUNT];
+
+    /**
+     * @brief Controller plugged into each port
+     * 
+     */
+    PadDevice devices[PAD_PORT_COUNT];
+
+    /**
+     * @brief Called with the port and its input when a pad is polled, if set
+     * 
+     */
+    std::function<void(uint32_t, PadState&)> poll_callback;
+
+    /**
+     * @brief Status register, without the transfer flags
+     * 
+     */
+    uint32_t stat;
+
+    /**
+     * @brief Mode register
+     * 
+     */
+    uint16_t mode;
+
+    /**
+     * @brief Control register
+     * 
+     */
+    uint16_t ctrl;
+
+    /**
+     * @brief Baud rate reload register, a transfer takes 8 times this value in cycles
+     * 
+     */
+    uint16_t baud;
+
+    /**
+     * @brief Last byte received
+     * 
+     */
+    uint8_t rx_data;
+
+    /**
+     * @brief Whether rx_data has not been read yet
+     * 
+     */
+    bool rx_full;
+
+    /**
+     * @brief Whether a transfer is in progress
+     * 
+     */
+    bool transferring;
+
+    /**
+     * @brief Byte the device answers the transfer in progress with
+     * 
+     */
+    uint8_t reply;
+
+    /**
+     * @brief Whether the device acknowledges the transfer in progress
+     * 
+     */
+    bool reply_ack;
+
+    /**
+     * @brief Device addressed by the first byte since the port was selected (SIO_ADDRESS_*, 0 if none)
+     * 
+     */
+    uint8_t address;
+
+    /**
+     * @brief Number of bytes exchanged since the port was selected
+     * 
+     */
+    uint32_t step;
+};
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef AUDIO_SINK_HPP
+#define AUDIO_SINK_HPP
+
+#include <stdint.h>
+#include <fstream>
+#include <string>
+
+#define AUDIO_SAMPLE_RATE 44100
+
+/**
+ * @brief Interface for the consumers of the audio produced by the SPU.
+ * 
+ * Samples are delivered in blocks of interleaved 16-bit stereo frames (left, right).
+ */
+class AudioSink
+{
+public:
+    virtual ~AudioSink() {}
+
+    /**
+     * @brief Consumes a block of audio.
+     * 
+     * @param samples Interleaved stereo samples (2 * frames values)
+     * @param frames Number of stereo frames in the block
+     */
+    virtual void write(const int16_t* samples, uint32_t frames) = 0;
+};
+
+/**
+ * @brief Audio sink that discards all audio.
+ * 
+ * Used when no audio output is needed (for example in headless runs).
+ */
+class NullAudioSink : public AudioSink
+{
+public:
+    void write(const int16_t* samples, uint32_t frames) override;
+};
+
+/**
+ * @brief Audio sink that writes all audio to a 16-bit stereo WAV file.
+ * 
+ */
+class WavAudioSink : public AudioSink
+{
+public:
+    WavAudioSink(std::string path);
+    ~WavAudioSink();
+
+    void write(const int16_t* samples, uint32_t frames) override;
+
+private:
+    void write_header();
+
+private:
+    /**
+     * @brief Output file
+     * 
+     */
+    std::ofstream file;
+
+    /**
+     * @brief Number of stereo frames written so far
+     * 
+     */
+    uint32_t frames_written;
+};
+
+#endif
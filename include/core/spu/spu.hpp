@@ -0,0 +1,259 @@
+#ifndef SPU_HPP
+#define SPU_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <core/spu/audio_sink.hpp>
+#include <core/memory/arena.hpp>
+#include <core/memory/cow_memory.hpp>
+
+#define SOUND_RAM_SIZE 512 * 1024
+#define SPU_VOICE_COUNT 24
+#define SPU_BLOCK_SIZE 32
+#define SPU_CYCLES_PER_SAMPLE 768
+#define SPU_CYCLES_PER_BLOCK (SPU_CYCLES_PER_SAMPLE * SPU_BLOCK_SIZE)
+
+#define SPU_REG_MAIN_VOL_L 0x180
+#define SPU_REG_MAIN_VOL_R 0x182
+#define SPU_REG_KON_LO 0x188
+#define SPU_REG_KON_HI 0x18a
+#define SPU_REG_KOFF_LO 0x18c
+#define SPU_REG_KOFF_HI 0x18e
+#define SPU_REG_PMON_LO 0x190
+#define SPU_REG_PMON_HI 0x192
+#define SPU_REG_ENDX_LO 0x19c
+#define SPU_REG_ENDX_HI 0x19e
+#define SPU_REG_IRQ_ADDRESS 0x1a4
+#define SPU_REG_TRANSFER_ADDRESS 0x1a6
+#define SPU_REG_TRANSFER_FIFO 0x1a8
+#define SPU_REG_SPUCNT 0x1aa
+#define SPU_REG_SPUSTAT 0x1ae
+
+#define SPUCNT_ENABLE 0x8000
+#define SPUCNT_UNMUTE 0x4000
+#define SPUCNT_IRQ_ENABLE 0x0040
+#define SPUSTAT_IRQ 0x0040
+
+#define ADPCM_FLAG_LOOP_END 0x1
+#define ADPCM_FLAG_LOOP_REPEAT 0x2
+#define ADPCM_FLAG_LOOP_START 0x4
+
+class Bus;
+
+/**
+ * @brief Phases of the ADSR envelope of a voice.
+ * 
+ */
+enum ADSRPhase
+{
+    ADSR_OFF,
+    ADSR_ATTACK,
+    ADSR_DECAY,
+    ADSR_SUSTAIN,
+    ADSR_RELEASE
+};
+
+/**
+ * @brief Structure to store the state of a single SPU voice.
+ * 
+ * The volumes of the voices are kept in the SPU so that they can be mixed with SIMD instructions.
+ */
+struct Voice
+{
+    /**
+     * @brief Start address of the sample in sound RAM (bytes)
+     * 
+     */
+    uint32_t start_address;
+
+    /**
+     * @brief Address jumped to at the end of a block with the loop end flag (bytes)
+     * 
+     */
+    uint32_t repeat_address;
+
+    /**
+     * @brief Address of the ADPCM block being played (bytes)
+     * 
+     */
+    uint32_t current_address;
+
+    /**
+     * @brief Sample rate register (0x1000 = 44100Hz)
+     * 
+     */
+    uint16_t pitch;
+
+    /**
+     * @brief Position in the decoded block. Bits [31:12] index the sample, bits [11:4] the interpolation weight.
+     * 
+     */
+    uint32_t pitch_counter;
+
+    /**
+     * @brief Last three samples of the previous block followed by the 28 samples of the current block
+     * 
+     */
+    int16_t decoded[32];
+
+    /**
+     * @brief Last two decoded samples, used by the ADPCM prediction filter
+     * 
+     */
+    int16_t adpcm_history[2];
+
+    /**
+     * @brief Flags of the current ADPCM block
+     * 
+     */
+    uint8_t block_flags;
+
+    /**
+     * @brief ADSR configuration (register 0x8 in the low half, register 0xA in the high half)
+     * 
+     */
+    uint32_t adsr;
+
+    /**
+     * @brief Current phase of the envelope
+     * 
+     */
+    ADSRPhase phase;
+
+    /**
+     * @brief Current envelope level (0 - 0x7fff)
+     * 
+     */
+    int16_t level;
+
+    /**
+     * @brief Number of samples until the envelope is stepped again
+     * 
+     */
+    uint32_t adsr_counter;
+};
+
+/**
+ * @brief Class to emulate the SPU (Sound Processing Unit).
+ * 
+ * Implements the 512KB sound RAM, the register file and the 24 ADPCM voices with their ADSR envelopes. Audio is produced in blocks of SPU_BLOCK_SIZE samples from a scheduled event instead of one sample at a time, so register writes take effect at block granularity.
+ * 
+ * TODO: Implement reverb, noise and CD audio input.
+ */
+class SPU
+{
+public:
+    SPU(Arena& arena);
+    SPU(Arena& arena, SPU& parent);
+    static size_t arena_size();
+
+    /**
+     * @brief Connects Bus to the SPU.
+     * 
+     * Used by the constructor of Bus to connect the SPU to the Bus.
+     * @param bus Pointer to the bus structure
+     */
+    void connectBus(Bus* bus) { this->bus = bus; }
+
+    /**
+     * @brief Sets the consumer of the audio produced by the SPU.
+     * 
+     * The sink is not owned by the SPU.
+     * @param sink Pointer to the audio sink
+     */
+    void connectSink(AudioSink* sink) { this->sink = sink; }
+
+    uint16_t read16_cpu(uint32_t offset);
+    void write16_cpu(uint32_t offset, uint16_t data);
+
+    void handle_event();
+    void render_block(int16_t* out);
+
+private:
+    void write_voice(uint32_t index, uint32_t reg, uint16_t data);
+    void key_on(uint32_t mask);
+    void key_off(uint32_t mask);
+    void check_irq(uint32_t address, uint32_t size);
+
+    void render_voice(uint32_t index);
+    void decode_block(uint32_t index);
+    void next_block(uint32_t index);
+    void step_envelope(uint32_t index);
+    void mix(int16_t* out);
+
+private:
+    /**
+     * @brief Pointer to the Bus object
+     * 
+     */
+    Bus* bus;
+
+    /**
+     * @brief Pointer to the audio sink
+     * 
+     */
+    AudioSink* sink;
+
+    /**
+     * @brief Sink used until another one is connected
+     * 
+     */
+    NullAudioSink null_sink;
+
+    /**
+     * @brief Sound RAM, shared copy-on-write with forked machines
+     * 
+     */
+    CowMemory sound_ram;
+
+    /**
+     * @brief Raw values of the registers (indexed by offset / 2)
+     * 
+     */
+    uint16_t regs[0x200];
+
+    /**
+     * @brief State of the voices
+     * 
+     */
+    Voice voices[SPU_VOICE_COUNT];
+
+    /**
+     * @brief Left volumes of the voices
+     * 
+     */
+    alignas(16) int16_t volume_left[SPU_VOICE_COUNT];
+
+    /**
+     * @brief Right volumes of the voices
+     * 
+     */
+    alignas(16) int16_t volume_right[SPU_VOICE_COUNT];
+
+    /**
+     * @brief Output of every voice for the current block, laid out sample by sample so that all voices of a sample are adjacent
+     * 
+     */
+    alignas(16) int16_t voice_output[SPU_BLOCK_SIZE][SPU_VOICE_COUNT];
+
+    /**
+     * @brief Voices that have reached a block with the loop end flag (ENDX)
+     * 
+     */
+    uint32_t endx;
+
+    /**
+     * @brief Current address of manual transfers to sound RAM (bytes)
+     * 
+     */
+    uint32_t transfer_address;
+
+    /**
+     * @brief Interrupt flag of SPUSTAT
+     * 
+     */
+    bool irq_flag;
+};
+
+#endif
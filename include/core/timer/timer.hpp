@@ -0,0 +1,136 @@
+#ifndef TIMER_HPP
+#define TIMER_HPP
+
+#include <stdint.h>
+
+/**
+ * @brief NTSC video timing in CPU cycles.
+ * 
+ * Used for the dotclock, hblank and vblank clock sources and sync modes. The video clock runs at 11/7 of the CPU clock.
+ */
+#define CYCLES_PER_SCANLINE 2172
+#define SCANLINES_PER_FRAME 263
+#define CYCLES_PER_FRAME (CYCLES_PER_SCANLINE * SCANLINES_PER_FRAME)
+#define HBLANK_START 1629
+#define VBLANK_START (240 * CYCLES_PER_SCANLINE)
+
+#define TIMER_REG_VALUE 0x0
+#define TIMER_REG_MODE 0x4
+#define TIMER_REG_TARGET 0x8
+
+#define TIMER_MODE_SYNC_ENABLE 0x0001
+#define TIMER_MODE_RESET_AT_TARGET 0x0008
+#define TIMER_MODE_IRQ_AT_TARGET 0x0010
+#define TIMER_MODE_IRQ_AT_MAX 0x0020
+#define TIMER_MODE_IRQ_REPEAT 0x0040
+#define TIMER_MODE_IRQ_TOGGLE 0x0080
+#define TIMER_MODE_IRQ_FLAG 0x0400
+#define TIMER_MODE_REACHED_TARGET 0x0800
+#define TIMER_MODE_REACHED_MAX 0x1000
+
+class Bus;
+
+/**
+ * @brief Clock sources selectable for the root counters.
+ * 
+ */
+enum TimerSource
+{
+    TIMER_SOURCE_SYSCLK,
+    TIMER_SOURCE_SYSCLK_DIV8,
+    TIMER_SOURCE_DOTCLOCK,
+    TIMER_SOURCE_HBLANK
+};
+
+/**
+ * @brief Structure to store the state of a single root counter.
+ * 
+ */
+struct RootCounter
+{
+    /**
+     * @brief Counter value at last_sync
+     * 
+     */
+    uint16_t value;
+
+    /**
+     * @brief Counter mode register
+     * 
+     */
+    uint16_t mode;
+
+    /**
+     * @brief Counter target register
+     * 
+     */
+    uint16_t target;
+
+    /**
+     * @brief Cycle count up to which value has been computed
+     * 
+     */
+    uint64_t last_sync;
+
+    /**
+     * @brief Whether the interrupt has fired since the mode was written (used in one-shot mode)
+     * 
+     */
+    bool irq_fired;
+
+    /**
+     * @brief Whether the counter is paused until the next blank (sync mode 3 of counters 0 and 1)
+     * 
+     */
+    bool waiting_for_blank;
+};
+
+/**
+ * @brief Class to emulate the Root Counters (Timers).
+ * 
+ * Implements the three root counters of the PSX. Counter values are not incremented every cycle: they are derived from the cycle count of the scheduler and the time of the last synchronization whenever they are accessed. Only the points where a counter raises an interrupt are scheduled as events.
+ */
+class Timers
+{
+public:
+    Timers();
+
+    /**
+     * @brief Connects Bus to the Timers.
+     * 
+     * Used by the constructor of Bus to connect the Timers to the Bus.
+     * @param bus Pointer to the bus structure
+     */
+    void connectBus(Bus* bus) { this->bus = bus; }
+
+    uint32_t read32_cpu(uint32_t offset);
+    void write32_cpu(uint32_t offset, uint32_t data);
+
+    void handle_event(int index);
+
+private:
+    void sync(int index);
+    void count(int index, uint64_t ticks);
+    uint64_t source_ticks(int index, uint64_t from, uint64_t to);
+    uint64_t ticks_until(int index, uint16_t value);
+    void reached_target(int index);
+    void reached_max(int index);
+    void trigger_irq(int index);
+    void schedule_irq(int index);
+    TimerSource source(int index);
+
+private:
+    /**
+     * @brief Pointer to the Bus object
+     * 
+     */
+    Bus* bus;
+
+    /**
+     * @brief State of the three root counters
+     * 
+     */
+    RootCounter counters[3];
+};
+
+#endif
@@ -2,17 +2,20 @@
 #include <iostream>
 
 #include <core/interconnect/bus.hpp>
+#include <core/cdrom/disc_reader.hpp>
 
 int main(int argc, char** argv)
 {
     if(argc < 2)
     {
-        std::cerr << "Usage: " << argv[0] << " <bios_path>" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " <bios_path> [disc_path]" << std::endl;
         return 1;
     }
     std::string bios_path = argv[1];
     Bus bus(bios_path);
+    if(argc > 2)
+        bus.load_disc(argv[2], DEFAULT_READ_AHEAD);
     while(true)
         bus.clock();
     return 0;
-} 
\ No newline at end of file
+}
@@ -0,0 +1,46 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <core/cdrom/disc.hpp>
+#include <core/cdrom/compressed_disc.hpp>
+
+int main(int argc, char** argv)
+{
+    if(argc < 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <input.cue|input.iso> <output.cdz> [--hunk <sectors>] [--threads <count>] [--zstd]" << std::endl;
+        return 1;
+    }
+
+    uint32_t hunk_sectors = CDZ_DEFAULT_HUNK_SECTORS;
+    unsigned int threads = 0;
+    CDZCompression compression = CDZ_COMPRESSION_ZLIB;
+    for(int i = 3; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--hunk") == 0 && i + 1 < argc)
+            hunk_sectors = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--zstd") == 0)
+            compression = CDZ_COMPRESSION_ZSTD;
+        else
+        {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    try
+    {
+        std::unique_ptr<Disc> disc = open_disc(argv[1]);
+        CompressedDisc::create(*disc, argv[2], hunk_sectors, compression, threads);
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <core/interconnect/bus.hpp>
+#include <core/cdrom/disc_reader.hpp>
+#include <core/coverage/coverage.hpp>
+
+#define DEFAULT_INSTRUCTIONS 100000000ULL
+
+/**
+ * @brief Prints the number of words covered in a map.
+ * 
+ * @param coverage Map to report
+ */
+static void report(CodeCoverage& coverage)
+{
+    std::cout << "RAM: " << coverage.count_ram() << " of " << COVERAGE_RAM_SIZE / 4 << " words\n"
+              << "BIOS: " << coverage.count_bios() << " of " << COVERAGE_BIOS_SIZE / 4 << " words" << std::endl;
+}
+
+/**
+ * @brief Runs a machine with a coverage map attached and saves the map.
+ * 
+ * @return int Exit code
+ */
+static int run(int argc, char** argv)
+{
+    if(argc < 4)
+    {
+        std::cerr << "Usage: " << argv[0] << " run <bios_path> <map_path> [--disc <path>] [--instructions <count>]" << std::endl;
+        return 1;
+    }
+
+    std::string disc_path;
+    uint64_t limit = DEFAULT_INSTRUCTIONS;
+    for(int i = 4; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--disc") == 0 && i + 1 < argc)
+            disc_path = argv[++i];
+        else if(strcmp(argv[i], "--instructions") == 0 && i + 1 < argc)
+            limit = strtoull(argv[++i], nullptr, 0);
+        else
+        {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    CodeCoverage* coverage = new CodeCoverage();
+    Bus* bus = new Bus(argv[2]);
+    if(!disc_path.empty())
+        bus->load_disc(disc_path, DEFAULT_READ_AHEAD);
+    bus->set_coverage(coverage);
+
+    uint64_t instructions = 0;
+    try
+    {
+        for(; instructions < limit; instructions++)
+            bus->clock();
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << "Stopped after " << instructions << " instructions: " << e.what() << std::endl;
+    }
+
+    delete bus;
+    coverage->save(argv[3]);
+    report(*coverage);
+    delete coverage;
+    return 0;
+}
+
+/**
+ * @brief Merges the maps of several runs into one.
+ * 
+ * @return int Exit code
+ */
+static int merge(int argc, char** argv)
+{
+    if(argc < 4)
+    {
+        std::cerr << "Usage: " << argv[0] << " merge <output_path> <map_path>..." << std::endl;
+        return 1;
+    }
+
+    CodeCoverage* merged = new CodeCoverage();
+    CodeCoverage* input = new CodeCoverage();
+    for(int i = 3; i < argc; i++)
+    {
+        input->load(argv[i]);
+        merged->merge(*input);
+    }
+    merged->save(argv[2]);
+    report(*merged);
+    delete input;
+    delete merged;
+    return 0;
+}
+
+/**
+ * @brief Records which code a machine executes, and merges the records of batch runs.
+ * 
+ * run executes a BIOS (and disc) for a number of instructions and saves the coverage map, merge ORs maps together, report prints the number of words covered.
+ */
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " run|merge|report ..." << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        if(strcmp(argv[1], "run") == 0)
+            return run(argc, argv);
+        if(strcmp(argv[1], "merge") == 0)
+            return merge(argc, argv);
+        if(strcmp(argv[1], "report") == 0 && argc == 3)
+        {
+            CodeCoverage* coverage = new CodeCoverage();
+            coverage->load(argv[2]);
+            report(*coverage);
+            delete coverage;
+            return 0;
+        }
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cerr << "Usage: " << argv[0] << " run|merge|report ..." << std::endl;
+    return 1;
+}
@@ -0,0 +1,104 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <core/cpu/disassembler.hpp>
+
+#define CHUNK_WORDS 4096
+#define LINE_SIZE (DISASM_BUFFER_SIZE + 20)
+
+/**
+ * @brief Pairs of hexadecimal digits of every byte value.
+ * 
+ */
+struct HexPairs
+{
+    char text[512];
+};
+
+static constexpr HexPairs make_hex_pairs()
+{
+    HexPairs pairs{};
+    const char digits[] = "0123456789abcdef";
+    for(int i = 0; i < 256; i++)
+    {
+        pairs.text[i * 2] = digits[i >> 4];
+        pairs.text[i * 2 + 1] = digits[i & 0xf];
+    }
+    return pairs;
+}
+
+static constexpr HexPairs hex_pairs = make_hex_pairs();
+
+/**
+ * @brief Writes a word as 8 hexadecimal digits.
+ * 
+ * @param p Output
+ * @param value Word to write
+ * @return char* End of the digits
+ */
+static inline char* put_word(char* p, uint32_t value)
+{
+    memcpy(p, &hex_pairs.text[(value >> 24) * 2], 2);
+    memcpy(p + 2, &hex_pairs.text[((value >> 16) & 0xff) * 2], 2);
+    memcpy(p + 4, &hex_pairs.text[((value >> 8) & 0xff) * 2], 2);
+    memcpy(p + 6, &hex_pairs.text[(value & 0xff) * 2], 2);
+    return p + 8;
+}
+
+/**
+ * @brief Disassembles a binary file of little-endian instruction words, one line per word.
+ * 
+ * The file is read and the text written in large chunks, so that gigabyte-scale traces and memory dumps are limited by the disassembler and not by I/O.
+ */
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <binary_path> [--base <address>]" << std::endl;
+        return 1;
+    }
+
+    uint32_t addr = 0;
+    for(int i = 2; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--base") == 0 && i + 1 < argc)
+            addr = strtoul(argv[++i], nullptr, 0);
+        else
+        {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    FILE* input = fopen(argv[1], "rb");
+    if(!input)
+    {
+        std::cerr << "Could not open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    std::vector<uint8_t> words(CHUNK_WORDS * 4);
+    std::vector<char> text(CHUNK_WORDS * LINE_SIZE);
+    size_t count;
+    while((count = fread(words.data(), 4, CHUNK_WORDS, input)) > 0)
+    {
+        char* p = text.data();
+        for(size_t i = 0; i < count; i++, addr += 4)
+        {
+            const uint8_t* b = &words[i * 4];
+            uint32_t ins = b[0] | (b[1] << 8) | (b[2] << 16) | (uint32_t(b[3]) << 24);
+            p = put_word(p, addr);
+            *p++ = ' ';
+            p = put_word(p, ins);
+            *p++ = ' ';
+            p += disassemble(ins, addr, p, DISASM_BUFFER_SIZE);
+            *p++ = '\n';
+        }
+        fwrite(text.data(), 1, p - text.data(), stdout);
+    }
+    fclose(input);
+    return 0;
+}
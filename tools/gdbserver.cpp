@@ -0,0 +1,201 @@
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <core/debug/gdb_stub.hpp>
+#include <core/cdrom/disc_reader.hpp>
+
+#define DEFAULT_PORT 3333
+#define GDB_INTERRUPT 0x03
+
+/**
+ * @brief Opens the listening socket.
+ * 
+ * @param port TCP port on localhost, used when path is empty
+ * @param path Path of a Unix socket
+ * @return int Listening socket, -1 on error
+ */
+static int open_listener(int port, const std::string& path)
+{
+    int fd;
+    if(path.empty())
+    {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if(fd < 0 || bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0)
+            return -1;
+    }
+    else
+    {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        unlink(path.c_str());
+        if(fd < 0 || bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0)
+            return -1;
+    }
+    if(listen(fd, 1) < 0)
+        return -1;
+    return fd;
+}
+
+/**
+ * @brief Checks without blocking whether the debugger sent an interrupt request.
+ * 
+ * Anything else sent while the machine runs is dropped, GDB only sends acknowledgements then.
+ * 
+ * @param fd Connection to the debugger
+ * @return true The debugger asked to stop
+ * @return false No request
+ */
+static bool poll_interrupt(int fd)
+{
+    pollfd request = {fd, POLLIN, 0};
+    while(poll(&request, 1, 0) > 0)
+    {
+        char c;
+        if(recv(fd, &c, 1, 0) <= 0)
+            return true;
+        if(c == GDB_INTERRUPT)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Serves one debugger connection.
+ * 
+ * @param fd Connection to the debugger
+ * @param stub Stub of the machine
+ */
+static void serve(int fd, GDBStub& stub)
+{
+    std::string buffer;
+    char chunk[4096];
+    while(!stub.is_killed())
+    {
+        ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+        if(received <= 0)
+            return;
+        buffer.append(chunk, received);
+
+        while(!buffer.empty())
+        {
+            if(buffer[0] == GDB_INTERRUPT)
+            {
+                buffer.erase(0, 1);
+                std::string reply = GDBStub::frame(stub.interrupt());
+                send(fd, reply.data(), reply.size(), 0);
+                continue;
+            }
+            if(buffer[0] != '$')
+            {
+                buffer.erase(0, 1); //acknowledgements
+                continue;
+            }
+            size_t hash = buffer.find('#');
+            if(hash == std::string::npos || buffer.size() < hash + 3)
+                break;
+
+            std::string payload = buffer.substr(1, hash - 1);
+            uint8_t checksum = strtoul(buffer.substr(hash + 1, 2).c_str(), nullptr, 16);
+            buffer.erase(0, hash + 3);
+            uint8_t sum = 0;
+            for(char c : payload)
+                sum += uint8_t(c);
+            if(sum != checksum)
+            {
+                send(fd, "-", 1, 0);
+                continue;
+            }
+            send(fd, "+", 1, 0);
+
+            std::string reply = GDBStub::frame(stub.handle_packet(payload));
+            if(!stub.get_last_error().empty() && (payload[0] == 'c' || payload[0] == 's'))
+                std::cerr << stub.get_last_error() << std::endl;
+            if(stub.is_killed())
+                return;
+            send(fd, reply.data(), reply.size(), 0);
+            if(payload == "D")
+                return;
+        }
+    }
+}
+
+/**
+ * @brief Runs a machine under the control of GDB.
+ * 
+ * Listens on localhost (or a Unix socket) for one debugger, and serves it until it detaches or kills the machine. Connect with "target remote localhost:3333".
+ */
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <bios_path> [--disc <path>] [--port <port> | --unix <path>]" << std::endl;
+        return 1;
+    }
+
+    std::string disc_path;
+    std::string unix_path;
+    int port = DEFAULT_PORT;
+    for(int i = 2; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--disc") == 0 && i + 1 < argc)
+            disc_path = argv[++i];
+        else if(strcmp(argv[i], "--port") == 0 && i + 1 < argc)
+            port = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--unix") == 0 && i + 1 < argc)
+            unix_path = argv[++i];
+        else
+        {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    Bus bus(argv[1]);
+    if(!disc_path.empty())
+        bus.load_disc(disc_path, DEFAULT_READ_AHEAD);
+    GDBStub stub(&bus);
+
+    int listener = open_listener(port, unix_path);
+    if(listener < 0)
+    {
+        std::cerr << "Cannot listen: " << strerror(errno) << std::endl;
+        return 1;
+    }
+    std::cout << "Waiting for GDB on " << (unix_path.empty() ? "localhost:" + std::to_string(port) : unix_path) << std::endl;
+
+    int fd = accept(listener, nullptr, nullptr);
+    close(listener);
+    if(fd < 0)
+    {
+        std::cerr << "Cannot accept: " << strerror(errno) << std::endl;
+        return 1;
+    }
+    int on = 1;
+    if(unix_path.empty())
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    stub.set_interrupt_check([fd]() { return poll_interrupt(fd); });
+
+    serve(fd, stub);
+    close(fd);
+    if(!unix_path.empty())
+        unlink(unix_path.c_str());
+    return 0;
+}
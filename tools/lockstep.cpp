@@ -0,0 +1,287 @@
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <core/interconnect/bus.hpp>
+#include <core/cdrom/disc_reader.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LOCKSTEP_SSE2
+#endif
+
+#define DEFAULT_INSTRUCTIONS 100000000ULL
+#define DEFAULT_HASH_INTERVAL 65536
+
+/**
+ * @brief Hashes a page of RAM.
+ * 
+ * Fletcher-style sums over four 32-bit lanes, so that moved data changes the hash as well as modified data. The SSE2 and scalar versions give the same result.
+ * 
+ * @param page Start of the page
+ * @return uint64_t Hash of the page
+ */
+static uint64_t hash_page(const uint8_t* page)
+{
+    uint32_t sum[4];
+    uint32_t weighted[4];
+#ifdef LOCKSTEP_SSE2
+    __m128i a = _mm_setzero_si128();
+    __m128i b = _mm_setzero_si128();
+    for(uint32_t i = 0; i < PAGE_SIZE; i += 16)
+    {
+        a = _mm_add_epi32(a, _mm_loadu_si128((const __m128i*)(page + i)));
+        b = _mm_add_epi32(b, a);
+    }
+    _mm_storeu_si128((__m128i*)sum, a);
+    _mm_storeu_si128((__m128i*)weighted, b);
+#else
+    for(int lane = 0; lane < 4; lane++)
+    {
+        sum[lane] = 0;
+        weighted[lane] = 0;
+    }
+    for(uint32_t i = 0; i < PAGE_SIZE; i += 16)
+    {
+        for(int lane = 0; lane < 4; lane++)
+        {
+            uint32_t word;
+            memcpy(&word, page + i + lane * 4, 4);
+            sum[lane] += word;
+            weighted[lane] += sum[lane];
+        }
+    }
+#endif
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for(int lane = 0; lane < 4; lane++)
+    {
+        hash = (hash ^ sum[lane]) * 0x100000001b3ULL;
+        hash = (hash ^ weighted[lane]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Hashes every page of the RAM of a machine.
+ * 
+ * @param bus Machine to hash
+ * @param hashes Output, one hash per page
+ */
+static void hash_ram(Bus& bus, std::vector<uint64_t>& hashes)
+{
+    const uint8_t* ram = bus.get_ram_data();
+    hashes.resize(bus.get_ram_size() / PAGE_SIZE);
+    for(size_t i = 0; i < hashes.size(); i++)
+        hashes[i] = hash_page(ram + i * PAGE_SIZE);
+}
+
+/**
+ * @brief Compares the pending register loads of two CPU states.
+ * 
+ * @param a Loads of the first state (copied, since a queue can only be read by popping)
+ * @param b Loads of the second state
+ * @return true The loads are the same
+ * @return false The loads differ
+ */
+static bool same_loads(std::queue<RegisterLoad> a, std::queue<RegisterLoad> b)
+{
+    if(a.size() != b.size())
+        return false;
+    for(; !a.empty(); a.pop(), b.pop())
+    {
+        const RegisterLoad& x = a.front();
+        const RegisterLoad& y = b.front();
+        if(x.reg != y.reg || x.data != y.data || x.delay != y.delay)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Checks whether two CPU states are the same.
+ * 
+ * @param a First state
+ * @param b Second state
+ * @return true The states are the same
+ * @return false The states differ
+ */
+static bool same_state(CPUState& a, CPUState& b)
+{
+    return memcmp(a.reg_gen, b.reg_gen, sizeof(a.reg_gen)) == 0 && a.reg_hi == b.reg_hi && a.reg_lo == b.reg_lo &&
+        a.program_counter == b.program_counter && a.reg_cop0_status == b.reg_cop0_status &&
+        a.reg_cop0_cause == b.reg_cop0_cause && a.reg_cop0_epc == b.reg_cop0_epc && a.reg_cop0_bda == b.reg_cop0_bda &&
+        a.reg_cop0_bpc == b.reg_cop0_bpc && a.reg_cop0_dcic == b.reg_cop0_dcic && a.reg_cop0_bdam == b.reg_cop0_bdam &&
+        a.reg_cop0_bpcm == b.reg_cop0_bpcm && a.ins_current.ins == b.ins_current.ins && a.ins_next.ins == b.ins_next.ins &&
+        same_loads(a.load_queue, b.load_queue);
+}
+
+/**
+ * @brief Lists the differences between the state of the reference machine and the machine under test.
+ * 
+ * @param ref State of the reference machine
+ * @param test State of the machine under test
+ * @return std::string One line per difference, empty if the states are the same
+ */
+static std::string compare_states(CPUState& ref, CPUState& test)
+{
+    std::stringstream ss;
+    ss << std::hex;
+    auto check = [&](const std::string& name, uint32_t a, uint32_t b) {
+        if(a != b)
+            ss << "  " << name << ": reference 0x" << a << ", test 0x" << b << "\n";
+    };
+
+    for(int i = 0; i < 32; i++)
+        check("r" + std::to_string(i), ref.reg_gen[i], test.reg_gen[i]);
+    check("hi", ref.reg_hi, test.reg_hi);
+    check("lo", ref.reg_lo, test.reg_lo);
+    check("pc", ref.program_counter, test.program_counter);
+    check("status", ref.reg_cop0_status, test.reg_cop0_status);
+    check("cause", ref.reg_cop0_cause, test.reg_cop0_cause);
+    check("epc", ref.reg_cop0_epc, test.reg_cop0_epc);
+    check("bda", ref.reg_cop0_bda, test.reg_cop0_bda);
+    check("bpc", ref.reg_cop0_bpc, test.reg_cop0_bpc);
+    check("dcic", ref.reg_cop0_dcic, test.reg_cop0_dcic);
+    check("bdam", ref.reg_cop0_bdam, test.reg_cop0_bdam);
+    check("bpcm", ref.reg_cop0_bpcm, test.reg_cop0_bpcm);
+    check("instruction", ref.ins_current.ins, test.ins_current.ins);
+    check("next instruction", ref.ins_next.ins, test.ins_next.ins);
+    if(!same_loads(ref.load_queue, test.load_queue))
+        ss << "  pending register loads differ\n";
+    return ss.str();
+}
+
+/**
+ * @brief Prints where the machines diverged.
+ * 
+ * @param instructions Number of instructions run by the reference machine
+ * @param cycles Cycle count of the reference machine
+ * @param last Last state on which the machines agreed
+ * @param test State of the machine under test
+ * @param details Differences found
+ */
+static void report(uint64_t instructions, uint64_t cycles, CPUState& last, CPUState& test, const std::string& details)
+{
+    std::cout << std::hex << std::setfill('0')
+              << "Divergence after " << std::dec << instructions << " instructions (cycle " << cycles << ")" << std::hex << "\n"
+              << "  last common pc: 0x" << std::setw(8) << last.program_counter
+              << ", instruction: 0x" << std::setw(8) << last.ins_current.ins << "\n"
+              << "  test pc: 0x" << std::setw(8) << test.program_counter
+              << ", instruction: 0x" << std::setw(8) << test.ins_current.ins << "\n"
+              << details << std::flush;
+}
+
+/**
+ * @brief Runs a reference machine (plain interpreter) and a machine under test (fused dispatch) in lockstep and compares them.
+ * 
+ * After every clock of the machine under test, the reference machine is clocked until it reaches the same cycle count, and the CPU states are compared. The RAM of both machines is compared by page hashes every hash interval. Idle loop skipping is disabled on both, since it changes the number of instructions run and not the engine.
+ * 
+ * New execution engines are checked by configuring them on the machine under test.
+ */
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <bios_path> [--disc <path>] [--instructions <count>] [--hash-interval <count>]" << std::endl;
+        return 1;
+    }
+
+    std::string disc_path;
+    uint64_t limit = DEFAULT_INSTRUCTIONS;
+    uint64_t hash_interval = DEFAULT_HASH_INTERVAL;
+    for(int i = 2; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--disc") == 0 && i + 1 < argc)
+            disc_path = argv[++i];
+        else if(strcmp(argv[i], "--instructions") == 0 && i + 1 < argc)
+            limit = strtoull(argv[++i], nullptr, 0);
+        else if(strcmp(argv[i], "--hash-interval") == 0 && i + 1 < argc)
+            hash_interval = strtoull(argv[++i], nullptr, 0);
+        else
+        {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+    if(hash_interval == 0)
+        hash_interval = 1;
+
+    Bus reference(argv[1]);
+    Bus test(argv[1]);
+    reference.set_idle_skip(false);
+    test.set_idle_skip(false);
+    reference.set_fusion(false);
+    if(!disc_path.empty())
+    {
+        reference.load_disc(disc_path, DEFAULT_READ_AHEAD);
+        test.load_disc(disc_path, DEFAULT_READ_AHEAD);
+    }
+
+    CPUState last;
+    CPUState ref_state;
+    CPUState test_state;
+    reference.get_cpu_state(&last);
+    std::vector<uint64_t> ref_hashes;
+    std::vector<uint64_t> test_hashes;
+
+    uint64_t instructions = 0;
+    uint64_t blocks = 0;
+    try
+    {
+        while(instructions < limit)
+        {
+            test.clock();
+            do
+            {
+                reference.clock();
+                instructions++;
+            } while(reference.get_cycles() < test.get_cycles());
+            blocks++;
+
+            reference.get_cpu_state(&ref_state);
+            test.get_cpu_state(&test_state);
+            std::string details;
+            if(!same_state(ref_state, test_state))
+                details = compare_states(ref_state, test_state);
+            if(reference.get_cycles() != test.get_cycles())
+            {
+                std::stringstream ss;
+                ss << "  cycles: reference " << reference.get_cycles() << ", test " << test.get_cycles() << "\n";
+                details += ss.str();
+            }
+            if(blocks % hash_interval == 0)
+            {
+                hash_ram(reference, ref_hashes);
+                hash_ram(test, test_hashes);
+                for(size_t page = 0; page < ref_hashes.size(); page++)
+                {
+                    if(ref_hashes[page] != test_hashes[page])
+                    {
+                        std::stringstream ss;
+                        ss << "  RAM page 0x" << std::hex << page * PAGE_SIZE << " differs (changed during the last " << std::dec << hash_interval << " blocks)\n";
+                        details += ss.str();
+                    }
+                }
+            }
+            if(!details.empty())
+            {
+                report(instructions, reference.get_cycles(), last, test_state, details);
+                return 2;
+            }
+            std::swap(last, ref_state);
+        }
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << "Stopped after " << instructions << " instructions at pc 0x" << std::hex << last.program_counter << ": " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << "No divergence in " << instructions << " instructions (" << blocks << " blocks)" << std::endl;
+    return 0;
+}
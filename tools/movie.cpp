@@ -0,0 +1,169 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include <core/interconnect/bus.hpp>
+#include <core/cdrom/disc_reader.hpp>
+#include <core/movie/movie.hpp>
+
+/**
+ * @brief Records a movie from power-on.
+ * 
+ * The input file holds one line per frame with the buttons of each port in hexadecimal (a set bit for a pressed button). Frames past the end of the file hold no button. The sticks stay centred.
+ * 
+ * @return int Exit code
+ */
+static int record(int argc, char** argv)
+{
+    if(argc < 4)
+    {
+        std::cerr << "Usage: " << argv[0] << " record <bios_path> <movie_path> --frames <count> [--disc <path>] [--input <path>] [--analog]" << std::endl;
+        return 1;
+    }
+
+    std::string disc_path;
+    std::string input_path;
+    uint64_t count = 0;
+    bool analog = false;
+    for(int i = 4; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            count = strtoull(argv[++i], nullptr, 0);
+        else if(strcmp(argv[i], "--disc") == 0 && i + 1 < argc)
+            disc_path = argv[++i];
+        else if(strcmp(argv[i], "--input") == 0 && i + 1 < argc)
+            input_path = argv[++i];
+        else if(strcmp(argv[i], "--analog") == 0)
+            analog = true;
+        else
+        {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    std::ifstream input;
+    if(!input_path.empty())
+    {
+        input.open(input_path);
+        if(!input)
+        {
+            std::cerr << "Could not open " << input_path << std::endl;
+            return 1;
+        }
+    }
+
+    Bus* bus = new Bus(argv[2]);
+    if(!disc_path.empty())
+        bus->load_disc(disc_path, DEFAULT_READ_AHEAD);
+    if(analog)
+        for(uint32_t port = 0; port < PAD_PORT_COUNT; port++)
+            bus->set_pad_type(port, PAD_ANALOG);
+    Movie* movie = new Movie();
+    movie->start(*bus, disc_path);
+
+    for(uint64_t frame = 0; frame < count; frame++)
+    {
+        PadState pads[PAD_PORT_COUNT];
+        for(uint32_t port = 0; port < PAD_PORT_COUNT; port++)
+        {
+            pads[port].buttons = 0;
+            for(int axis = 0; axis < PAD_AXIS_COUNT; axis++)
+                pads[port].axes[axis] = PAD_AXIS_CENTER;
+        }
+        std::string line;
+        if(input.is_open() && std::getline(input, line))
+        {
+            const char* p = line.c_str();
+            for(uint32_t port = 0; port < PAD_PORT_COUNT; port++)
+            {
+                char* end;
+                pads[port].buttons = strtoul(p, &end, 16);
+                p = end;
+            }
+        }
+        movie->record_frame(*bus, pads);
+    }
+
+    movie->save(argv[3]);
+    std::cout << "Recorded " << movie->get_frame_count() << " frames" << std::endl;
+    delete movie;
+    delete bus;
+    return 0;
+}
+
+/**
+ * @brief Replays a movie unthrottled and checks the RAM at the end of every frame.
+ * 
+ * @return int Exit code, 2 if the replay diverged
+ */
+static int replay(int argc, char** argv)
+{
+    if(argc != 4)
+    {
+        std::cerr << "Usage: " << argv[0] << " replay <bios_path> <movie_path>" << std::endl;
+        return 1;
+    }
+
+    Movie* movie = new Movie();
+    movie->load(argv[3]);
+    Bus* bus = new Bus(argv[2]);
+    if(!movie->get_disc_path().empty())
+        bus->load_disc(movie->get_disc_path(), DEFAULT_READ_AHEAD);
+    movie->start_replay(*bus);
+
+    int result = 0;
+    uint64_t frame = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(; frame < movie->get_frame_count(); frame++)
+    {
+        if(!movie->replay_frame(*bus, frame))
+        {
+            std::cerr << "Diverged at frame " << frame << std::endl;
+            result = 2;
+            break;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Replayed " << frame << " of " << movie->get_frame_count() << " frames";
+    if(seconds > 0)
+        std::cout << " (" << frame / seconds << " frames/s)";
+    std::cout << std::endl;
+    delete bus;
+    delete movie;
+    return result;
+}
+
+/**
+ * @brief Records sessions as controller input and replays them to check that the emulation still reproduces them.
+ * 
+ * record runs a BIOS (and disc) from power-on in deterministic mode and saves the input and a RAM hash of every frame, replay runs the movie as fast as possible and stops at the first frame whose RAM differs.
+ */
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " record|replay ..." << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        if(strcmp(argv[1], "record") == 0)
+            return record(argc, argv);
+        if(strcmp(argv[1], "replay") == 0)
+            return replay(argc, argv);
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cerr << "Usage: " << argv[0] << " record|replay ..." << std::endl;
+    return 1;
+}